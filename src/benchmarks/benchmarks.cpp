@@ -0,0 +1,35 @@
+#include "benchmarks.hpp"
+#include "utils/console.hpp"
+
+#include <utility>
+
+namespace benchmarks
+{
+namespace
+{
+    const std::pair<const char*, void(*)()> BENCHMARKS[] = {
+        {"mesh_processing", meshProcessing},
+        {"raycasts", raycasts},
+        {"broadphase", broadphase},
+        {"rigid_bodies", rigidBodies},
+    };
+} // namespace
+
+int run(const std::string& name)
+{
+    bool found = false;
+    for(const auto& [benchmarkName, function] : BENCHMARKS)
+    {
+        if(!name.empty() && name != benchmarkName) continue;
+        Console::log(std::string("Running ") + benchmarkName, "Benchmark");
+        function();
+        found = true;
+    }
+    if(!found)
+    {
+        Console::error("Unknown benchmark " + name, "Benchmark");
+        return -1;
+    }
+    return 0;
+}
+} // namespace benchmarks
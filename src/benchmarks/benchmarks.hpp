@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include <chrono>
+
+// Offline benchmarks, run with --benchmark [name] instead of the engine main loop
+namespace benchmarks
+{
+    // Runs the benchmark called name, or all of them when name is empty, returns the process exit code
+    int run(const std::string& name);
+
+    inline double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void meshProcessing();
+    void raycasts();
+    void broadphase();
+    void rigidBodies();
+} // namespace benchmarks
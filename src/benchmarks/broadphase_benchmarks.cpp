@@ -0,0 +1,81 @@
+#include "benchmarks.hpp"
+#include "physics/broadphase.hpp"
+#include "utils/console.hpp"
+#include "utils/thread_pool.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace benchmarks
+{
+namespace
+{
+    constexpr size_t BOX_COUNT = 10000;
+    constexpr size_t STEP_COUNT = 200;
+    constexpr float WORLD_SIZE = 250.0f;
+
+    // Unit boxes drifting at a constant velocity, speed is in world units per step
+    void benchmarkSpeed(float speed)
+    {
+        std::mt19937 random(5);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<glm::vec3> positions(BOX_COUNT);
+        std::vector<glm::vec3> velocities(BOX_COUNT);
+        std::vector<uint32_t> proxies(BOX_COUNT);
+        physics::Broadphase broadphase{};
+        for(size_t i = 0; i < BOX_COUNT; i++)
+        {
+            positions[i] = glm::vec3(unit(random), unit(random), unit(random)) * WORLD_SIZE;
+            velocities[i] = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) - 0.5f) * speed;
+            proxies[i] = broadphase.createProxy(positions[i], positions[i] + 1.0f, i);
+        }
+        broadphase.updatePairs();
+
+        double moveSeconds = 0.0;
+        double pairSeconds = 0.0;
+        size_t changedPairs = 0;
+        for(size_t step = 0; step < STEP_COUNT; step++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for(size_t i = 0; i < BOX_COUNT; i++)
+            {
+                positions[i] += velocities[i];
+                broadphase.moveProxy(proxies[i], positions[i], positions[i] + 1.0f, velocities[i]);
+            }
+            moveSeconds += secondsSince(start);
+            start = std::chrono::steady_clock::now();
+            broadphase.updatePairs();
+            pairSeconds += secondsSince(start);
+            changedPairs += broadphase.getBeganPairs().size() + broadphase.getEndedPairs().size();
+        }
+
+        // Every pair of overlapping fat boxes has to be known
+        size_t bruteForcePairs = 0;
+        const physics::DynamicTree& tree = broadphase.getTree();
+        for(size_t a = 0; a < BOX_COUNT; a++)
+        {
+            for(size_t b = a + 1; b < BOX_COUNT; b++)
+            {
+                bruteForcePairs += physics::DynamicTree::overlaps(tree.getFatMin(proxies[a]), tree.getFatMax(proxies[a]),
+                    tree.getFatMin(proxies[b]), tree.getFatMax(proxies[b]));
+            }
+        }
+
+        char line[200];
+        snprintf(line, sizeof(line), "  speed %5.2f  move %6.3f ms  pairs %6.3f ms  %zu pairs (%zu brute force)  %.1f changes/step  height %u",
+            speed, moveSeconds * 1000.0 / STEP_COUNT, pairSeconds * 1000.0 / STEP_COUNT, broadphase.getPairs().size(), bruteForcePairs,
+            static_cast<double>(changedPairs) / STEP_COUNT, tree.getHeight());
+        Console::log(line, "Benchmark");
+    }
+} // namespace
+
+void broadphase()
+{
+    Console::log(std::to_string(BOX_COUNT) + " moving boxes, " + std::to_string(ThreadPool::getGlobal().getThreadCount() + 1) + " threads", "Benchmark");
+    for(float speed : {0.01f, 0.05f, 0.2f})
+    {
+        benchmarkSpeed(speed);
+    }
+}
+} // namespace benchmarks
@@ -0,0 +1,231 @@
+#include "benchmarks.hpp"
+#include "core/mesh.hpp"
+#include "core/mesh_processing.hpp"
+#include "core/obj_importer.hpp"
+#include "utils/console.hpp"
+#include "utils/thread_pool.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+using namespace core;
+
+namespace benchmarks
+{
+namespace
+{
+    using Vertex = MeshData::Vertex;
+    using Triangle = MeshData::Triangle;
+
+    constexpr int ITERATIONS = 3;
+
+    float angleBetween(glm::vec3 v1, glm::vec3 v2)
+    {
+        return glm::acos(glm::clamp(glm::dot(v1, v2) / (glm::length(v1) * glm::length(v2)), -1.0f + 1e-6f, 1.0f - 1e-6f));
+    }
+
+    // The single threaded scalar implementation MeshProcessing replaced, kept as the baseline
+    void generateNormalsBaseline(std::vector<Vertex>& vertices, const std::vector<Triangle>& triangles)
+    {
+        for(Vertex& vertex : vertices)
+        {
+            vertex.normal = glm::vec3(0.0f);
+        }
+        for(const Triangle& triangle : triangles)
+        {
+            Vertex& v0 = vertices[triangle.v0];
+            Vertex& v1 = vertices[triangle.v1];
+            Vertex& v2 = vertices[triangle.v2];
+
+            glm::vec3 cross = glm::cross(v1.position - v0.position, v2.position - v0.position);
+            if(glm::length(cross) < 1e-6f)
+                continue;
+
+            glm::vec3 normal = glm::normalize(cross);
+            v0.normal += normal * angleBetween(v1.position - v0.position, v2.position - v0.position);
+            v1.normal += normal * angleBetween(v0.position - v1.position, v2.position - v1.position);
+            v2.normal += normal * angleBetween(v0.position - v2.position, v1.position - v2.position);
+        }
+        for(Vertex& vertex : vertices)
+        {
+            vertex.normal = glm::normalize(vertex.normal);
+        }
+    }
+
+    void generateTangentsBaseline(std::vector<Vertex>& vertices, const std::vector<Triangle>& triangles)
+    {
+        for(Vertex& vertex : vertices)
+        {
+            vertex.tangent = glm::vec4(0.0f);
+            vertex.bitangent = glm::vec3(0.0f);
+        }
+        for(const Triangle& triangle : triangles)
+        {
+            Vertex& v0 = vertices[triangle.v0];
+            Vertex& v1 = vertices[triangle.v1];
+            Vertex& v2 = vertices[triangle.v2];
+
+            glm::vec3 edge1 = v1.position - v0.position;
+            glm::vec3 edge2 = v2.position - v0.position;
+            if(glm::length(edge1) < 1e-6f || glm::length(edge2) < 1e-6f)
+                continue;
+
+            glm::vec2 deltaUV1 = v1.texCoord - v0.texCoord;
+            glm::vec2 deltaUV2 = v2.texCoord - v0.texCoord;
+            float f = (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
+            if(glm::abs(f) < 1e-9f)
+                continue;
+
+            glm::vec4 tangent = glm::vec4((deltaUV2.y * edge1 - deltaUV1.y * edge2) / f, 0.0f);
+            glm::vec3 bitangent = (-deltaUV2.x * edge1 + deltaUV1.x * edge2) / f;
+            v0.tangent += tangent;
+            v1.tangent += tangent;
+            v2.tangent += tangent;
+            v0.bitangent += bitangent;
+            v1.bitangent += bitangent;
+            v2.bitangent += bitangent;
+        }
+        for(Vertex& vertex : vertices)
+        {
+            glm::vec3 tangent = glm::normalize(glm::vec3(vertex.tangent));
+            vertex.bitangent = glm::normalize(vertex.bitangent);
+            tangent = glm::normalize(tangent - vertex.normal * glm::dot(vertex.normal, tangent));
+            vertex.bitangent = glm::normalize(vertex.bitangent - vertex.normal * glm::dot(vertex.normal, vertex.bitangent));
+            vertex.tangent = glm::vec4(tangent, 1.0f);
+            if(glm::dot(glm::cross(vertex.normal, tangent), vertex.bitangent) < 0.0f)
+            {
+                vertex.bitangent = vertex.bitangent * -1.0f;
+                vertex.tangent.w = -1.0f;
+            }
+        }
+    }
+
+    template<class Function>
+    double bestOf(const std::vector<Vertex>& source, std::vector<Vertex>& result, const Function& function)
+    {
+        double best = 1e30;
+        for(int i = 0; i < ITERATIONS; i++)
+        {
+            result = source;
+            auto start = std::chrono::steady_clock::now();
+            function(result);
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    // The baseline leaves NaNs where it normalized zero vectors, those vertices are skipped
+    float maxNormalError(const std::vector<Vertex>& a, const std::vector<Vertex>& b)
+    {
+        float error = 0.0f;
+        for(size_t i = 0; i < a.size(); i++)
+        {
+            if(std::isnan(b[i].normal.x)) continue;
+            error = std::max(error, glm::length(a[i].normal - b[i].normal));
+        }
+        return error;
+    }
+
+    float maxTangentError(const std::vector<Vertex>& a, const std::vector<Vertex>& b)
+    {
+        float error = 0.0f;
+        for(size_t i = 0; i < a.size(); i++)
+        {
+            if(std::isnan(b[i].tangent.x)) continue;
+            error = std::max(error, glm::length(glm::vec3(a[i].tangent) - glm::vec3(b[i].tangent)));
+        }
+        return error;
+    }
+
+    void report(const std::string& label, double seconds, double baselineSeconds, float error)
+    {
+        char line[160];
+        snprintf(line, sizeof(line), "  %-28s %8.2f ms  %5.2fx  max error %.2e", label.c_str(), seconds * 1000.0, baselineSeconds / seconds, error);
+        Console::log(line, "Benchmark");
+    }
+
+    void benchmarkMesh(const std::string& name, const std::vector<Vertex>& vertices, const std::vector<Triangle>& triangles)
+    {
+        Console::log(name + ": " + std::to_string(vertices.size()) + " vertices, " + std::to_string(triangles.size()) + " triangles, "
+            + std::to_string(ThreadPool::getGlobal().getThreadCount() + 1) + " threads", "Benchmark");
+
+        std::vector<Vertex> baseline{};
+        std::vector<Vertex> result{};
+        double baselineSeconds = bestOf(vertices, baseline, [&](std::vector<Vertex>& v) { generateNormalsBaseline(v, triangles); });
+        report("baseline", baselineSeconds, baselineSeconds, 0.0f);
+
+        const MeshProcessing::SimdLevel supported = MeshProcessing::getSupportedSimdLevel();
+        for(int level = 0; level <= static_cast<int>(supported); level++)
+        {
+            MeshProcessing::setSimdLevel(static_cast<MeshProcessing::SimdLevel>(level));
+            const std::string levelName = MeshProcessing::getSimdLevelName(MeshProcessing::getSimdLevel());
+            for(bool parallel : {false, true})
+            {
+                double seconds = bestOf(vertices, result, [&](std::vector<Vertex>& v) { MeshProcessing::generateNormals(v, triangles, NormalWeighting::ANGLE, parallel); });
+                report(levelName + (parallel ? " parallel" : " serial") + " angle", seconds, baselineSeconds, maxNormalError(result, baseline));
+            }
+        }
+        MeshProcessing::setSimdLevel(supported);
+
+        const std::string bestName = MeshProcessing::getSimdLevelName(supported);
+        double seconds = bestOf(vertices, result, [&](std::vector<Vertex>& v) { MeshProcessing::generateNormals(v, triangles, NormalWeighting::AREA); });
+        report(bestName + " parallel area", seconds, baselineSeconds, maxNormalError(result, baseline));
+
+        // Tangents are generated from the baseline normals so both sides see the same input
+        const std::vector<Vertex> withNormals = baseline;
+        std::vector<Vertex> baselineTangents{};
+        baselineSeconds = bestOf(withNormals, baselineTangents, [&](std::vector<Vertex>& v) { generateTangentsBaseline(v, triangles); });
+        report("baseline tangents", baselineSeconds, baselineSeconds, 0.0f);
+        seconds = bestOf(withNormals, result, [&](std::vector<Vertex>& v) { MeshProcessing::generateTangents(v, triangles); });
+        report("parallel tangents", seconds, baselineSeconds, maxTangentError(result, baselineTangents));
+    }
+
+    // Wavy grid with texture coordinates, (cells + 1)^2 vertices and 2 * cells^2 triangles
+    void createGrid(int cells, std::vector<Vertex>& vertices, std::vector<Triangle>& triangles)
+    {
+        vertices.resize(static_cast<size_t>(cells + 1) * (cells + 1));
+        triangles.clear();
+        triangles.reserve(static_cast<size_t>(cells) * cells * 2);
+        for(int x = 0; x <= cells; x++)
+        {
+            for(int z = 0; z <= cells; z++)
+            {
+                Vertex& vertex = vertices[x * (cells + 1) + z];
+                vertex.position = {x * 0.01f, std::sin(x * 0.05f) * std::cos(z * 0.03f), z * 0.01f};
+                vertex.texCoord = {x / static_cast<float>(cells), z / static_cast<float>(cells)};
+                if(x > 0 && z > 0)
+                {
+                    uint32_t i0 = (x - 1) * (cells + 1) + z - 1;
+                    uint32_t i1 = (x - 1) * (cells + 1) + z;
+                    uint32_t i2 = x * (cells + 1) + z;
+                    uint32_t i3 = x * (cells + 1) + z - 1;
+                    triangles.push_back({i0, i1, i2});
+                    triangles.push_back({i0, i2, i3});
+                }
+            }
+        }
+    }
+} // namespace
+
+void meshProcessing()
+{
+    MeshData* monkey = ObjectManager::Instantiate<MeshData>("Benchmark Monkey");
+    try
+    {
+        ObjImporter::load("internal/models/monkey_high_res.obj", *monkey);
+        benchmarkMesh("monkey_high_res.obj", monkey->vertices, monkey->triangles);
+    }
+    catch(const std::exception& exception)
+    {
+        Console::warn(std::string("Skipping monkey_high_res.obj: ") + exception.what(), "Benchmark");
+    }
+    ObjectManager::deleteObject(monkey->getInstanceID());
+
+    std::vector<Vertex> vertices{};
+    std::vector<Triangle> triangles{};
+    createGrid(2237, vertices, triangles); // ~10M triangles
+    benchmarkMesh("Grid", vertices, triangles);
+}
+} // namespace benchmarks
@@ -0,0 +1,213 @@
+#include "benchmarks.hpp"
+#include "core/mesh.hpp"
+#include "core/mesh_processing.hpp"
+#include "core/obj_importer.hpp"
+#include "physics/bvh.hpp"
+#include "utils/console.hpp"
+#include "utils/thread_pool.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <algorithm>
+
+using namespace core;
+
+namespace benchmarks
+{
+namespace
+{
+    constexpr size_t RAY_COUNT = 100000;
+    constexpr size_t VERIFIED_RAYS = 256; // Also checked against every triangle
+
+    // Rays from a box around the mesh towards points inside its bounds, most of them hit
+    std::vector<physics::Ray> createRays(const MeshData& mesh)
+    {
+        const MeshData::Bounds& bounds = mesh.getBounds();
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<physics::Ray> rays{};
+        rays.reserve(RAY_COUNT);
+        for(size_t i = 0; i < RAY_COUNT; i++)
+        {
+            glm::vec3 origin = bounds.center + glm::vec3(unit(random), unit(random), unit(random)) * bounds.radius * 3.0f;
+            glm::vec3 target = bounds.center + glm::vec3(unit(random), unit(random), unit(random)) * (bounds.max - bounds.min) * 0.5f;
+            rays.emplace_back(origin, glm::normalize(target - origin));
+        }
+        return rays;
+    }
+
+    // Spreads of PACKET_SIZE rays from one origin within a few degrees of each other, like a shotgun blast
+    std::vector<physics::Ray> createSpreadRays(const MeshData& mesh)
+    {
+        const MeshData::Bounds& bounds = mesh.getBounds();
+        std::mt19937 random(11);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<physics::Ray> rays{};
+        rays.reserve(RAY_COUNT);
+        while(rays.size() < RAY_COUNT)
+        {
+            glm::vec3 origin = bounds.center + glm::vec3(unit(random), unit(random), unit(random)) * bounds.radius * 3.0f;
+            glm::vec3 target = bounds.center + glm::vec3(unit(random), unit(random), unit(random)) * (bounds.max - bounds.min) * 0.5f;
+            glm::vec3 direction = glm::normalize(target - origin);
+            for(size_t lane = 0; lane < physics::PACKET_SIZE; lane++)
+            {
+                glm::vec3 jitter = glm::vec3(unit(random), unit(random), unit(random)) * 0.05f;
+                rays.emplace_back(origin, glm::normalize(direction + jitter));
+            }
+        }
+        return rays;
+    }
+
+    float closestHitBruteForce(const MeshData& mesh, const physics::Ray& ray, float maxDistance)
+    {
+        for(const MeshData::Triangle& triangle : mesh.triangles)
+        {
+            glm::vec3 p0 = mesh.vertices[triangle.v0].position;
+            glm::vec3 edge1 = mesh.vertices[triangle.v1].position - p0;
+            glm::vec3 edge2 = mesh.vertices[triangle.v2].position - p0;
+            glm::vec3 p = glm::cross(ray.direction, edge2);
+            float inverseDeterminant = 1.0f / glm::dot(edge1, p);
+            glm::vec3 s = ray.origin - p0;
+            float u = glm::dot(s, p) * inverseDeterminant;
+            glm::vec3 q = glm::cross(s, edge1);
+            float v = glm::dot(ray.direction, q) * inverseDeterminant;
+            float t = glm::dot(edge2, q) * inverseDeterminant;
+            if(u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f && t < maxDistance)
+            {
+                maxDistance = t;
+            }
+        }
+        return maxDistance;
+    }
+
+    void benchmarkMesh(const std::string& name, const MeshData& mesh)
+    {
+        Console::log(name + ": " + std::to_string(mesh.triangles.size()) + " triangles, "
+            + std::to_string(ThreadPool::getGlobal().getThreadCount() + 1) + " threads", "Benchmark");
+        char line[160];
+        for(bool parallel : {false, true})
+        {
+            auto start = std::chrono::steady_clock::now();
+            physics::MeshBvh bvh(mesh, parallel);
+            snprintf(line, sizeof(line), "  %-28s %8.2f ms  %zu nodes", parallel ? "parallel build" : "serial build",
+                secondsSince(start) * 1000.0, bvh.getBvh().getNodes().size());
+            Console::log(line, "Benchmark");
+        }
+
+        const physics::MeshBvh bvh(mesh);
+        const std::vector<physics::Ray> rays = createRays(mesh);
+        const std::vector<physics::Ray> spreadRays = createSpreadRays(mesh);
+        const float maxDistance = mesh.getBounds().radius * 10.0f;
+        std::vector<float> distances(rays.size());
+        std::vector<float> spreadDistances(spreadRays.size());
+
+        const MeshProcessing::SimdLevel supported = MeshProcessing::getSupportedSimdLevel();
+        for(int level = 0; level <= static_cast<int>(supported); level++)
+        {
+            MeshProcessing::setSimdLevel(static_cast<MeshProcessing::SimdLevel>(level));
+            size_t hitCount = 0;
+            auto start = std::chrono::steady_clock::now();
+            for(size_t i = 0; i < rays.size(); i++)
+            {
+                float distance = maxDistance;
+                physics::MeshBvh::Hit hit{};
+                hitCount += bvh.raycast(rays[i], distance, hit);
+                distances[i] = distance;
+            }
+            double seconds = secondsSince(start);
+
+            size_t mismatches = 0;
+            for(size_t i = 0; i < VERIFIED_RAYS; i++)
+            {
+                mismatches += std::abs(closestHitBruteForce(mesh, rays[i], maxDistance) - distances[i]) > 1e-4f * maxDistance;
+            }
+            snprintf(line, sizeof(line), "  %-28s %8.3f us/ray  %6.0f rays/ms  %zu hits  %zu/%zu mismatches",
+                (std::string(MeshProcessing::getSimdLevelName(MeshProcessing::getSimdLevel())) + " closest hit").c_str(),
+                seconds * 1e6 / rays.size(), rays.size() / (seconds * 1000.0), hitCount, mismatches, VERIFIED_RAYS);
+            Console::log(line, "Benchmark");
+
+            // The same spreads one ray at a time and as packets, packets have to find exactly the same hits
+            start = std::chrono::steady_clock::now();
+            for(size_t i = 0; i < spreadRays.size(); i++)
+            {
+                float distance = maxDistance;
+                physics::MeshBvh::Hit hit{};
+                bvh.raycast(spreadRays[i], distance, hit);
+                spreadDistances[i] = distance;
+            }
+            double singleSeconds = secondsSince(start);
+
+            mismatches = 0;
+            start = std::chrono::steady_clock::now();
+            for(size_t first = 0; first < spreadRays.size(); first += physics::PACKET_SIZE)
+            {
+                physics::RayPacket packet;
+                for(size_t lane = 0; lane < physics::PACKET_SIZE; lane++)
+                {
+                    physics::setPacketRay(packet, lane, spreadRays[first + lane], maxDistance);
+                }
+                physics::MeshBvh::Hit hits[physics::PACKET_SIZE];
+                bvh.raycastPacket(packet, (1u << physics::PACKET_SIZE) - 1, hits);
+                for(size_t lane = 0; lane < physics::PACKET_SIZE; lane++)
+                {
+                    mismatches += packet.maxDistance[lane] != spreadDistances[first + lane];
+                }
+            }
+            double packetSeconds = secondsSince(start);
+            snprintf(line, sizeof(line), "  %-28s %8.3f us/ray single  %8.3f us/ray packets  %zu mismatches",
+                (std::string(MeshProcessing::getSimdLevelName(MeshProcessing::getSimdLevel())) + " spreads").c_str(),
+                singleSeconds * 1e6 / spreadRays.size(), packetSeconds * 1e6 / spreadRays.size(), mismatches);
+            Console::log(line, "Benchmark");
+        }
+        MeshProcessing::setSimdLevel(supported);
+    }
+} // namespace
+
+void raycasts()
+{
+    MeshData* monkey = ObjectManager::Instantiate<MeshData>("Benchmark Monkey");
+    try
+    {
+        ObjImporter::load("internal/models/monkey_high_res.obj", *monkey);
+        monkey->recomputeBounds();
+        benchmarkMesh("monkey_high_res.obj", *monkey);
+    }
+    catch(const std::exception& exception)
+    {
+        Console::warn(std::string("Skipping monkey_high_res.obj: ") + exception.what(), "Benchmark");
+    }
+    ObjectManager::deleteObject(monkey->getInstanceID());
+
+    // Bumpy sphere of ~1M triangles
+    MeshData* sphere = ObjectManager::Instantiate<MeshData>("Benchmark Sphere");
+    constexpr int SEGMENTS = 700;
+    std::vector<MeshData::Vertex> vertices{};
+    std::vector<MeshData::Triangle> triangles{};
+    for(int i = 0; i <= SEGMENTS; i++)
+    {
+        for(int j = 0; j <= SEGMENTS; j++)
+        {
+            float theta = 3.14159265f * i / SEGMENTS;
+            float phi = 6.28318531f * j / SEGMENTS;
+            float radius = 1.0f + 0.05f * std::sin(theta * 23.0f) * std::cos(phi * 17.0f);
+            MeshData::Vertex vertex{};
+            vertex.position = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)) * radius;
+            vertices.push_back(vertex);
+            if(i > 0 && j > 0)
+            {
+                uint32_t i0 = (i - 1) * (SEGMENTS + 1) + j - 1;
+                uint32_t i1 = i0 + 1;
+                uint32_t i2 = i0 + SEGMENTS + 1;
+                uint32_t i3 = i2 + 1;
+                triangles.push_back({i0, i2, i1});
+                triangles.push_back({i1, i2, i3});
+            }
+        }
+    }
+    sphere->SetMesh(vertices, triangles);
+    benchmarkMesh("Sphere", *sphere);
+    ObjectManager::deleteObject(sphere->getInstanceID());
+}
+} // namespace benchmarks
@@ -0,0 +1,128 @@
+#include "benchmarks.hpp"
+#include "physics/rigid_body_world.hpp"
+#include "utils/console.hpp"
+#include "utils/thread_pool.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace benchmarks
+{
+namespace
+{
+    // 100 piles of 5 x 5 x 4 boxes, far enough apart that each pile settles as its own island
+    constexpr size_t PILE_COUNT = 100;
+    constexpr size_t PILE_SIDE = 5;
+    constexpr size_t PILE_LAYERS = 4;
+    constexpr float PILE_SPACING = 12.0f;
+    constexpr size_t STEP_COUNT = 300;
+    constexpr float STEP_TIME = 1.0f / 60.0f;
+
+    std::shared_ptr<const std::vector<physics::ConvexHull>> createBoxHull()
+    {
+        auto hulls = std::make_shared<std::vector<physics::ConvexHull>>(1);
+        physics::ConvexHull& hull = (*hulls)[0];
+        for(int i = 0; i < 8; i++)
+        {
+            hull.vertices.push_back(glm::vec3(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f));
+        }
+        return hulls;
+    }
+
+    // Same seed for every thread count, so the checksums have to match
+    void fillWorld(physics::RigidBodyWorld& world)
+    {
+        std::mt19937 random(5);
+        std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+        std::uniform_real_distribution<float> angle(-0.2f, 0.2f);
+        auto box = createBoxHull();
+
+        const size_t pilesPerRow = static_cast<size_t>(std::ceil(std::sqrt(static_cast<float>(PILE_COUNT))));
+        const float floorSize = pilesPerRow * PILE_SPACING;
+        physics::BodySettings floor{};
+        floor.type = physics::BodyType::STATIC;
+        floor.hulls = box;
+        floor.position = glm::vec3(floorSize * 0.5f, -0.5f, floorSize * 0.5f);
+        floor.scale = glm::vec3(floorSize, 1.0f, floorSize);
+        world.createBody(floor);
+
+        for(size_t pile = 0; pile < PILE_COUNT; pile++)
+        {
+            glm::vec3 corner((pile % pilesPerRow + 0.5f) * PILE_SPACING, 0.5f, (pile / pilesPerRow + 0.5f) * PILE_SPACING);
+            for(size_t layer = 0; layer < PILE_LAYERS; layer++)
+            {
+                for(size_t i = 0; i < PILE_SIDE * PILE_SIDE; i++)
+                {
+                    physics::BodySettings settings{};
+                    settings.hulls = box;
+                    settings.position = corner + glm::vec3((i % PILE_SIDE) * 1.1f + jitter(random), layer * 1.3f + 0.1f, (i / PILE_SIDE) * 1.1f + jitter(random));
+                    settings.rotation = glm::angleAxis(angle(random), glm::vec3(0.0f, 1.0f, 0.0f));
+                    world.createBody(settings);
+                }
+            }
+        }
+    }
+
+    void benchmarkThreads(uint32_t threadCount)
+    {
+        ThreadPool pool(threadCount - 1);
+        physics::RigidBodyWorld world{};
+        fillWorld(world);
+
+        double totalSeconds = 0.0;
+        double maxSeconds = 0.0;
+        double settledSeconds = 0.0;
+        uint32_t maxIslands = 0;
+        uint32_t maxContactPoints = 0;
+        for(size_t step = 0; step < STEP_COUNT; step++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            world.step(STEP_TIME, pool);
+            double seconds = secondsSince(start);
+            totalSeconds += seconds;
+            maxSeconds = std::max(maxSeconds, seconds);
+            if(step >= STEP_COUNT - 10)
+            {
+                settledSeconds += seconds;
+            }
+            maxIslands = std::max(maxIslands, world.getStats().islands);
+            maxContactPoints = std::max(maxContactPoints, world.getStats().contactPoints);
+        }
+
+        // Bitwise hash of every position, equal for every thread count when the solver is deterministic
+        uint64_t checksum = 14695981039346656037ull;
+        for(uint32_t body = 0; body < world.getBodyCount(); body++)
+        {
+            const glm::vec3& position = world.getPosition(body);
+            uint32_t bits[3];
+            memcpy(bits, &position, sizeof(bits));
+            for(uint32_t value : bits)
+            {
+                checksum = (checksum ^ value) * 1099511628211ull;
+            }
+        }
+
+        char line[200];
+        snprintf(line, sizeof(line), "  %2u threads  step %7.3f ms (max %7.3f, last 10 %6.3f)  %u islands  %u contacts  %u awake at the end  checksum %016llx",
+            threadCount, totalSeconds * 1000.0 / STEP_COUNT, maxSeconds * 1000.0, settledSeconds * 100.0, maxIslands, maxContactPoints,
+            world.getStats().awakeBodies, static_cast<unsigned long long>(checksum));
+        Console::log(line, "Benchmark");
+    }
+} // namespace
+
+void rigidBodies()
+{
+    const uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 2u);
+    Console::log(std::to_string(PILE_COUNT * PILE_SIDE * PILE_SIDE * PILE_LAYERS) + " boxes in " + std::to_string(PILE_COUNT) + " piles, "
+        + std::to_string(STEP_COUNT) + " steps", "Benchmark");
+    for(uint32_t threadCount = 2; threadCount < hardwareThreads; threadCount *= 2)
+    {
+        benchmarkThreads(threadCount);
+    }
+    benchmarkThreads(hardwareThreads);
+}
+} // namespace benchmarks
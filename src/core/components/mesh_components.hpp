@@ -1,8 +1,19 @@
+#pragma once
 #include "core/mesh.hpp"
 #include "graphics/buffers/material.hpp"
 
+namespace physics
+{
+    struct ConvexHull;
+}
+
 namespace core
 {
+struct MaterialComponent
+{
+    id_t materialID{};
+};
+
 struct MeshRenderer
 {
     MeshData mesh;
@@ -11,11 +22,26 @@ struct MeshRenderer
 
 };
 
+// Entities with a Transform and a MeshCollider get a body in the rigid body world of physicsModule, static unless they also have a RigidBody
 struct MeshCollider
 {
-    MeshData mesh;
-    // Physics material
-    // Convex hull generation
+    Mesh mesh;
+    uint32_t body = UINT32_MAX; // Managed by physics::Physics
+    // Convex hulls of the mesh in its local space, filled by physics::Physics on the first update with its hull settings
+    // Colliders with the same mesh share them
+    std::shared_ptr<const std::vector<physics::ConvexHull>> hulls{};
+    float friction = 0.5f;
+    float restitution = 0.0f;
+};
+
+// Makes a MeshCollider dynamic, physics::Physics then drives the Transform, which is treated as a root transform
+// Moving the Transform from elsewhere teleports the body
+struct RigidBody
+{
+    float mass = 1.0f;
+    // Read back after every physics update
+    glm::vec3 linearVelocity{};
+    glm::vec3 angularVelocity{};
 };
 
 } // namespace core
\ No newline at end of file
@@ -1,9 +1,154 @@
 #include "transform.hpp"
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include "utils/console.hpp"
 
 namespace core
 {
 
+Transform::~Transform()
+{
+    detachFromHierarchy();
+}
+
+Transform::Transform(const Transform& other) : 
+    position(other.position), rotation(other.rotation), scale(other.scale), localTransformationMatrix(other.localTransformationMatrix) {}
+
+Transform& Transform::operator=(const Transform& other)
+{
+    if(this == &other) return *this;
+    position = other.position;
+    rotation = other.rotation;
+    scale = other.scale;
+    localTransformationMatrix = other.localTransformationMatrix;
+    markDirty();
+    return *this;
+}
+
+Transform::Transform(Transform&& other) noexcept : 
+    position(other.position), rotation(other.rotation), scale(other.scale), localTransformationMatrix(other.localTransformationMatrix)
+{
+    takeHierarchyFrom(other);
+}
+
+Transform& Transform::operator=(Transform&& other) noexcept
+{
+    if(this == &other) return *this;
+    detachFromHierarchy();
+    position = other.position;
+    rotation = other.rotation;
+    scale = other.scale;
+    localTransformationMatrix = other.localTransformationMatrix;
+    takeHierarchyFrom(other);
+    return *this;
+}
+
+void Transform::takeHierarchyFrom(Transform& other)
+{
+    const bool linked = other.parent != nullptr || !other.children.empty();
+    parent = other.parent;
+    if(parent != nullptr)
+    {
+        std::replace(parent->children.begin(), parent->children.end(), &other, this);
+    }
+    children = std::move(other.children);
+    for(Transform* child : children)
+    {
+        child->parent = this;
+    }
+    other.parent = nullptr;
+    other.children.clear();
+
+    worldTransformationMatrix = other.worldTransformationMatrix;
+    worldDirty = other.worldDirty;
+    other.worldDirty = true;
+    // Moving a transform without a parent or children changes no links, e.g. the camera handed to the simulation every frame
+    if(linked)
+    {
+        hierarchyVersion++;
+    }
+}
+
+void Transform::detachFromHierarchy()
+{
+    if(parent == nullptr && children.empty()) return;
+
+    if(parent != nullptr)
+    {
+        std::erase(parent->children, this);
+        parent = nullptr;
+    }
+    for(Transform* child : children)
+    {
+        child->parent = nullptr;
+        child->markDirty();
+    }
+    children.clear();
+    markDirty();
+    hierarchyVersion++;
+}
+
+bool Transform::setParent(Transform* newParent)
+{
+    if(newParent == parent) return true;
+    if(newParent != nullptr && isDescendent(newParent))
+    {
+        Console::warn("Cannot parent a transform to itself or one of its descendents", "Transform");
+        return false;
+    }
+
+    if(parent != nullptr)
+    {
+        std::erase(parent->children, this);
+    }
+    parent = newParent;
+    if(parent != nullptr)
+    {
+        parent->children.push_back(this);
+    }
+    markDirty();
+    hierarchyVersion++;
+    return true;
+}
+
+void Transform::markDirty()
+{
+    if(worldDirty) return; // Descendents of a dirty transform are already dirty
+    worldDirty = true;
+    if(children.empty()) return;
+
+    thread_local std::vector<Transform*> stack{};
+    stack.assign(children.begin(), children.end());
+    while(!stack.empty())
+    {
+        Transform* transform = stack.back();
+        stack.pop_back();
+        if(transform->worldDirty) continue;
+        transform->worldDirty = true;
+        stack.insert(stack.end(), transform->children.begin(), transform->children.end());
+    }
+}
+
+void Transform::updateWorldMatrix() const
+{
+    // Collect the dirty ancestors and resolve them top-down, iteratively so deep hierarchies can't overflow the stack
+    thread_local std::vector<const Transform*> chain{};
+    chain.clear();
+    for(const Transform* transform = this; transform != nullptr && transform->worldDirty; transform = transform->parent)
+    {
+        chain.push_back(transform);
+    }
+
+    for(auto it = chain.rbegin(); it != chain.rend(); ++it)
+    {
+        const Transform* transform = *it;
+        transform->worldTransformationMatrix = transform->parent != nullptr 
+            ? transform->parent->worldTransformationMatrix * transform->localTransformationMatrix 
+            : transform->localTransformationMatrix;
+        transform->worldDirty = false;
+    }
+}
+
 void Transform::setPosition(glm::vec3 pos, bool refreshImmediate)
 {
     position = pos;
@@ -75,13 +220,16 @@ void Transform::recomputeMatrix()
     glm::mat4 scaling = glm::scale(glm::mat4(1.0f), scale);
 
     localTransformationMatrix = translation * rotationM * scaling;
+    markDirty();
 }
 
 bool Transform::isDescendent(Transform* other) const
 {
-    if(other == this) return true;
-    if(other == nullptr) return false;
-    return isDescendent(other->parent);
+    for(; other != nullptr; other = other->parent)
+    {
+        if(other == this) return true;
+    }
+    return false;
 }
 
 
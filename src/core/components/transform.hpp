@@ -3,6 +3,8 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <vector>
+#include <atomic>
 
 namespace core
 {
@@ -11,6 +13,15 @@ namespace core
     {
         public:
             Transform() : position(0.0f), rotation(glm::quat(1.0, 0.0, 0.0, 0.0)), scale(1.0f) {}
+            ~Transform();
+
+            // Copies only the local transform, the copy starts without a parent or children
+            Transform(const Transform& other);
+            // Assigns the local transform and keeps this transform's place in the hierarchy
+            Transform& operator=(const Transform& other);
+            // Takes over the other transform's parent and children
+            Transform(Transform&& other) noexcept;
+            Transform& operator=(Transform&& other) noexcept;
 
             void setPosition(glm::vec3 pos, bool refreshImmediate = true);
             void setRotation(glm::quat rot, bool refreshImmediate = true);
@@ -30,16 +41,14 @@ namespace core
             glm::quat getLocalRotation() const { return rotation; }
             glm::vec3 getLocalRotationEuler() const { return glm::eulerAngles(rotation); }
             glm::vec3 getLocalScale() const { return scale; }
-            glm::mat4 getTransform() const 
+            // World matrix, cached until this transform or one of its ancestors changes
+            const glm::mat4& getTransform() const 
             {
-                if(parent != nullptr && parent != this && !isDescendent(parent))
-                {
-                    return parent->getTransform() * localTransformationMatrix;
-                }
-                else
+                if(worldDirty)
                 {
-                    return localTransformationMatrix;
+                    updateWorldMatrix();
                 }
+                return worldTransformationMatrix;
             }
             glm::mat4 getLocalTransform() const { return localTransformationMatrix; }
 
@@ -60,13 +69,52 @@ namespace core
             void recomputeMatrix();
 
             // Tree structure
-            Transform *parent = nullptr;
+            // Returns false and leaves the hierarchy unchanged if newParent is this transform or one of its descendents
+            bool setParent(Transform* newParent);
+            Transform* getParent() const { return parent; }
+            const std::vector<Transform*>& getChildren() const { return children; }
             bool isDescendent(Transform* other) const;
+            bool isWorldDirty() const { return worldDirty; }
+
+            // Incremented whenever any parent link changes or a linked transform moves in memory
+            static uint64_t getHierarchyVersion() { return hierarchyVersion.load(std::memory_order_relaxed); }
         private:
+            void markDirty();
+            void updateWorldMatrix() const;
+            void detachFromHierarchy();
+            void takeHierarchyFrom(Transform& other);
+
+            Transform* parent = nullptr;
+            std::vector<Transform*> children{};
+            mutable glm::mat4 worldTransformationMatrix{1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1};
+            mutable bool worldDirty = true; // A dirty transform always has dirty descendents
+
+            inline static std::atomic<uint64_t> hierarchyVersion{0};
+            friend class TransformHierarchy;
+
             glm::vec3 position{};
             glm::quat rotation{1.0, 0.0, 0.0, 0.0};
             glm::vec3 scale{1.0, 1.0, 1.0};
             glm::mat4 localTransformationMatrix{1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1};
-            // glm::mat4 transformationMatrix{1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1};
+    };
+
+    // Draws the Transform of the same entity between its world matrices before and after the last simulation step
+    // Filled by Scene_t, entities with a RigidBody get one automatically
+    // Moves made outside of a step show up to one step late
+    struct InterpolatedTransform
+    {
+        glm::mat4 previous{1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1}; // World matrix at the start of the last step
+        glm::mat4 render{1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1};
+        bool captured = false; // Whether previous was set yet, the current matrix is drawn until then
+    };
+
+    // Turns the Transform of the same entity every simulation step, in radians per second
+    // Applied in the order yaw, pitch, then about axis
+    struct Spin
+    {
+        float yawSpeed = 0.0f;   // About the local up axis
+        float pitchSpeed = 0.0f; // About the local right axis
+        glm::vec3 axis{0.0f, 1.0f, 0.0f};
+        float axisSpeed = 0.0f;
     };
 } // namespace core
\ No newline at end of file
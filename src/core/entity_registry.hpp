@@ -0,0 +1,292 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <cstdint>
+#include <cassert>
+#include <utility>
+
+namespace core
+{
+    // Stable handle to an entity, the generation invalidates handles to destroyed entities whose index was reused
+    struct Entity
+    {
+        static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+        uint32_t index = INVALID_INDEX;
+        uint32_t generation = 0;
+
+        bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const Entity& other) const { return !(*this == other); }
+        explicit operator bool() const { return index != INVALID_INDEX; }
+    };
+
+    class ComponentPoolBase
+    {
+        public:
+            virtual ~ComponentPoolBase() = default;
+            virtual void remove(Entity entity) = 0;
+            virtual bool has(Entity entity) const = 0;
+            virtual size_t size() const = 0;
+    };
+
+    // Sparse set holding one component type in a packed array
+    // Components of a type are contiguous in memory, removal swaps the last component into the hole
+    template<class T>
+    class ComponentPool : public ComponentPoolBase
+    {
+        public:
+            template<class... Args>
+            T& add(Entity entity, Args&&... args)
+            {
+                if(entity.index >= sparse.size())
+                {
+                    sparse.resize(entity.index + 1, INVALID_DENSE);
+                }
+                assert(sparse[entity.index] == INVALID_DENSE && "Entity already has this component");
+                sparse[entity.index] = static_cast<uint32_t>(dense.size());
+                denseEntities.push_back(entity);
+                dense.emplace_back(std::forward<Args>(args)...);
+                return dense.back();
+            }
+
+            void remove(Entity entity) override
+            {
+                if(!has(entity)) return;
+                uint32_t denseIndex = sparse[entity.index];
+                uint32_t lastIndex = static_cast<uint32_t>(dense.size() - 1);
+                if(denseIndex != lastIndex)
+                {
+                    dense[denseIndex] = std::move(dense[lastIndex]);
+                    denseEntities[denseIndex] = denseEntities[lastIndex];
+                    sparse[denseEntities[denseIndex].index] = denseIndex;
+                }
+                dense.pop_back();
+                denseEntities.pop_back();
+                sparse[entity.index] = INVALID_DENSE;
+            }
+
+            bool has(Entity entity) const override
+            {
+                return entity.index < sparse.size() && sparse[entity.index] != INVALID_DENSE &&
+                    denseEntities[sparse[entity.index]] == entity;
+            }
+
+            T* tryGet(Entity entity) { return has(entity) ? &dense[sparse[entity.index]] : nullptr; }
+            const T* tryGet(Entity entity) const { return has(entity) ? &dense[sparse[entity.index]] : nullptr; }
+            T& get(Entity entity)
+            {
+                assert(has(entity) && "Entity does not have this component");
+                return dense[sparse[entity.index]];
+            }
+
+            void reserve(size_t count)
+            {
+                denseEntities.reserve(count);
+                dense.reserve(count);
+            }
+
+            // Packed views, components()[i] belongs to entities()[i]
+            std::span<T> components() { return dense; }
+            std::span<const T> components() const { return dense; }
+            std::span<const Entity> entities() const { return denseEntities; }
+            size_t size() const override { return dense.size(); }
+
+        private:
+            static constexpr uint32_t INVALID_DENSE = UINT32_MAX;
+
+            std::vector<uint32_t> sparse{}; // Entity index to dense index
+            std::vector<Entity> denseEntities{};
+            std::vector<T> dense{};
+    };
+
+    // Iterates every entity that has all of Ts, driven by the smallest of the pools
+    template<class... Ts>
+    class View
+    {
+        public:
+            View(ComponentPool<Ts>&... _pools) : pools(&_pools...) {}
+
+            // Calls function(Entity, Ts&...) for every matching entity
+            template<class Function>
+            void each(Function&& function)
+            {
+                // Single component views walk the packed arrays directly without any lookups
+                if constexpr (sizeof...(Ts) == 1)
+                {
+                    auto* pool = std::get<0>(pools);
+                    std::span<const Entity> entities = pool->entities();
+                    auto components = pool->components();
+                    for(size_t i = 0; i < entities.size(); i++)
+                    {
+                        function(entities[i], components[i]);
+                    }
+                }
+                else
+                {
+                    std::span<const Entity> entities = leadEntities(smallestPool());
+                    std::apply([&](auto*... pool)
+                    {
+                        for(size_t i = 0; i < entities.size(); i++)
+                        {
+                            Entity entity = entities[i];
+                            auto components = std::make_tuple(find(pool, i, entity)...);
+                            if(((std::get<Ts*>(components) != nullptr) && ...))
+                            {
+                                function(entity, *std::get<Ts*>(components)...);
+                            }
+                        }
+                    }, pools);
+                }
+            }
+
+            size_t sizeHint() const { return smallestPool()->size(); }
+
+        private:
+            // Pools filled in the same order share dense indices, which skips the sparse lookup
+            template<class T>
+            static T* find(ComponentPool<T>* pool, size_t denseIndex, Entity entity)
+            {
+                if(denseIndex < pool->size() && pool->entities()[denseIndex] == entity)
+                {
+                    return &pool->components()[denseIndex];
+                }
+                return pool->tryGet(entity);
+            }
+
+            ComponentPoolBase* smallestPool() const
+            {
+                ComponentPoolBase* smallest = nullptr;
+                std::apply([&](auto*... pool)
+                {
+                    ((smallest = (smallest == nullptr || pool->size() < smallest->size()) ? static_cast<ComponentPoolBase*>(pool) : smallest), ...);
+                }, pools);
+                return smallest;
+            }
+
+            std::span<const Entity> leadEntities(ComponentPoolBase* lead) const
+            {
+                std::span<const Entity> entities{};
+                std::apply([&](auto*... pool)
+                {
+                    ((static_cast<ComponentPoolBase*>(pool) == lead ? (entities = pool->entities(), 0) : 0), ...);
+                }, pools);
+                return entities;
+            }
+
+            std::tuple<ComponentPool<Ts>*...> pools;
+    };
+
+    // Owns entities and their components, one packed pool per component type
+    class EntityRegistry
+    {
+        public:
+            Entity create()
+            {
+                Entity entity{};
+                if(!freeIndices.empty())
+                {
+                    entity.index = freeIndices.back();
+                    freeIndices.pop_back();
+                }
+                else
+                {
+                    entity.index = static_cast<uint32_t>(generations.size());
+                    generations.push_back(0);
+                }
+                entity.generation = generations[entity.index];
+                aliveCount++;
+                return entity;
+            }
+
+            void destroy(Entity entity)
+            {
+                if(!isAlive(entity)) return;
+                for(std::unique_ptr<ComponentPoolBase>& pool : pools)
+                {
+                    if(pool) pool->remove(entity);
+                }
+                generations[entity.index]++;
+                freeIndices.push_back(entity.index);
+                aliveCount--;
+            }
+
+            bool isAlive(Entity entity) const
+            {
+                return entity.index < generations.size() && generations[entity.index] == entity.generation;
+            }
+
+            size_t getEntityCount() const { return aliveCount; }
+
+            // Reserves room for count entities in total, each listed component pool is reserved as well
+            template<class... Ts>
+            void reserve(size_t count)
+            {
+                generations.reserve(count);
+                (getPool<Ts>().reserve(count), ...);
+            }
+
+            template<class T, class... Args>
+            T& addComponent(Entity entity, Args&&... args)
+            {
+                assert(isAlive(entity) && "Cannot add a component to a destroyed entity");
+                return getPool<T>().add(entity, std::forward<Args>(args)...);
+            }
+
+            template<class T>
+            void removeComponent(Entity entity) { getPool<T>().remove(entity); }
+
+            template<class T>
+            bool hasComponent(Entity entity) const
+            {
+                const ComponentPool<T>* pool = findPool<T>();
+                return pool != nullptr && pool->has(entity);
+            }
+
+            template<class T>
+            T& getComponent(Entity entity) { return getPool<T>().get(entity); }
+
+            template<class T>
+            T* tryGetComponent(Entity entity) { return getPool<T>().tryGet(entity); }
+
+            template<class T>
+            ComponentPool<T>& getPool()
+            {
+                uint32_t typeID = getTypeID<T>();
+                if(typeID >= pools.size())
+                {
+                    pools.resize(typeID + 1);
+                }
+                if(!pools[typeID])
+                {
+                    pools[typeID] = std::make_unique<ComponentPool<T>>();
+                }
+                return *static_cast<ComponentPool<T>*>(pools[typeID].get());
+            }
+
+            template<class... Ts>
+            View<Ts...> view() { return View<Ts...>(getPool<Ts>()...); }
+
+        private:
+            template<class T>
+            const ComponentPool<T>* findPool() const
+            {
+                uint32_t typeID = getTypeID<T>();
+                return typeID < pools.size() ? static_cast<const ComponentPool<T>*>(pools[typeID].get()) : nullptr;
+            }
+
+            template<class T>
+            static uint32_t getTypeID()
+            {
+                static const uint32_t typeID = nextTypeID++;
+                return typeID;
+            }
+            inline static uint32_t nextTypeID = 0;
+
+            std::vector<uint32_t> generations{};
+            std::vector<uint32_t> freeIndices{};
+            size_t aliveCount = 0;
+            std::vector<std::unique_ptr<ComponentPoolBase>> pools{};
+    };
+} // namespace core
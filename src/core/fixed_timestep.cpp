@@ -0,0 +1,53 @@
+#include "fixed_timestep.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace core
+{
+FixedTimestep::FixedTimestep(double _stepTime, uint32_t _maxSteps) : stepTime(_stepTime), maxSteps(_maxSteps)
+{
+    if(stepTime <= 0.0 || maxSteps == 0)
+    {
+        throw std::runtime_error("Fixed timestep needs a positive step time and at least one step per frame");
+    }
+}
+
+uint32_t FixedTimestep::addStepCallback(StepCallback callback)
+{
+    uint32_t id = nextCallbackID++;
+    callbacks.push_back({id, std::move(callback)});
+    return id;
+}
+
+void FixedTimestep::removeStepCallback(uint32_t id)
+{
+    std::erase_if(callbacks, [id](const Callback& callback) { return callback.id == id; });
+}
+
+uint32_t FixedTimestep::advance(double frameTime)
+{
+    stats = {};
+    accumulator += std::max(frameTime, 0.0);
+    while(accumulator >= stepTime)
+    {
+        if(stats.steps == maxSteps)
+        {
+            // Keep the fraction of a step so the interpolation does not jump
+            double keep = std::fmod(accumulator, stepTime);
+            stats.droppedTime = accumulator - keep;
+            accumulator = keep;
+            break;
+        }
+        for(Callback& callback : callbacks)
+        {
+            callback.function(static_cast<float>(stepTime));
+        }
+        accumulator -= stepTime;
+        stepCount++;
+        stats.steps++;
+    }
+    return stats.steps;
+}
+} // namespace core
@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+namespace core
+{
+    // Runs the simulation in steps of a fixed length, however long the frames are
+    // Frame time is accumulated and every whole step in it is run through the step callbacks, in the order they were added
+    // The time left over is what the rendered state trails the simulated one by, see getAlpha
+    class FixedTimestep
+    {
+        public:
+            using StepCallback = std::function<void(float stepTime)>;
+
+            static constexpr double DEFAULT_STEP_TIME = 1.0 / 60.0;
+            // Frames that would need more steps drop the rest of their time, so a slow step cannot make the next frame
+            // even slower and the simulation falls behind real time instead
+            static constexpr uint32_t DEFAULT_MAX_STEPS = 4;
+
+            struct Stats
+            {
+                uint32_t steps = 0;
+                double droppedTime = 0.0; // Seconds skipped because of the step cap
+            };
+
+            explicit FixedTimestep(double _stepTime = DEFAULT_STEP_TIME, uint32_t _maxSteps = DEFAULT_MAX_STEPS);
+
+            // Returns an ID for removeStepCallback, neither may be called from inside a step
+            uint32_t addStepCallback(StepCallback callback);
+            void removeStepCallback(uint32_t id);
+
+            // Adds the frame time and runs the steps that are due, returns how many ran
+            uint32_t advance(double frameTime);
+            // Forgets the accumulated time, the next step is a whole step away
+            void reset() { accumulator = 0.0; }
+
+            // Fraction of a step the accumulated time is past the last step, in [0, 1)
+            // Rendering at this point between the states before and after the last step hides the step rate
+            float getAlpha() const { return static_cast<float>(accumulator / stepTime); }
+            double getStepTime() const { return stepTime; }
+            uint32_t getMaxSteps() const { return maxSteps; }
+            uint64_t getStepCount() const { return stepCount; }
+            // Of the last advance
+            const Stats& getStats() const { return stats; }
+
+        private:
+            struct Callback
+            {
+                uint32_t id;
+                StepCallback function;
+            };
+
+            double stepTime;
+            uint32_t maxSteps;
+            double accumulator = 0.0;
+            uint64_t stepCount = 0;
+            Stats stats{};
+            std::vector<Callback> callbacks{};
+            uint32_t nextCallbackID = 0;
+    };
+} // namespace core
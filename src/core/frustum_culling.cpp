@@ -0,0 +1,103 @@
+#include "frustum_culling.hpp"
+#include "frustum_culling_kernels.hpp"
+#include "mesh_processing.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FRUSTUM_CULLING_X86
+#endif
+
+namespace core
+{
+Frustum Frustum::fromViewProjection(const glm::mat4& viewProjection)
+{
+    // Every plane is the last row of the matrix plus or minus another row, glm stores the matrix by columns
+    const glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+    const glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+    const glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+    const glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+    Frustum frustum{};
+    frustum.planes[0] = row3 + row0;
+    frustum.planes[1] = row3 - row0;
+    frustum.planes[2] = row3 + row1;
+    frustum.planes[3] = row3 - row1;
+    frustum.planes[4] = row2;
+    frustum.planes[5] = row3 - row2;
+    for(glm::vec4& plane : frustum.planes)
+    {
+        float length = glm::length(glm::vec3(plane));
+        plane = length > 0.0f ? plane / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+    return frustum;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const
+{
+    for(const glm::vec4& plane : planes)
+    {
+        if(glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FrustumCuller::clear()
+{
+    centersX.clear();
+    centersY.clear();
+    centersZ.clear();
+    radii.clear();
+}
+
+void FrustumCuller::reserve(size_t count)
+{
+    centersX.reserve(count);
+    centersY.reserve(count);
+    centersZ.reserve(count);
+    radii.reserve(count);
+}
+
+uint32_t FrustumCuller::add(const glm::vec3& center, float radius)
+{
+    centersX.push_back(center.x);
+    centersY.push_back(center.y);
+    centersZ.push_back(center.z);
+    radii.push_back(radius);
+    return static_cast<uint32_t>(radii.size() - 1);
+}
+
+void FrustumCuller::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+    visible.resize(radii.size());
+    if(radii.empty())
+    {
+        return;
+    }
+
+    const float* planes = &frustum.planes[0].x;
+    size_t visibleCount = 0;
+    switch(MeshProcessing::getSimdLevel())
+    {
+#ifdef FRUSTUM_CULLING_X86
+        case MeshProcessing::SimdLevel::AVX2:
+            visibleCount = cullSpheresAvx2(centersX.data(), centersY.data(), centersZ.data(), radii.data(), radii.size(), planes, visible.data());
+            break;
+        case MeshProcessing::SimdLevel::SSE:
+            visibleCount = cullSpheresSse(centersX.data(), centersY.data(), centersZ.data(), radii.data(), radii.size(), planes, visible.data());
+            break;
+#endif
+        default:
+            for(size_t i = 0; i < radii.size(); i++)
+            {
+                if(frustum.intersectsSphere(glm::vec3(centersX[i], centersY[i], centersZ[i]), radii[i]))
+                {
+                    visible[visibleCount++] = static_cast<uint32_t>(i);
+                }
+            }
+            break;
+    }
+    visible.resize(visibleCount);
+}
+} // namespace core
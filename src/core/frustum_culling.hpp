@@ -0,0 +1,41 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace core
+{
+    // Six planes facing into the view volume, a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for every plane
+    struct Frustum
+    {
+        glm::vec4 planes[6]{}; // Left, right, bottom, top, near, far, normalized
+
+        // Gribb and Hartmann, for projections with depth in [0, 1]
+        static Frustum fromViewProjection(const glm::mat4& viewProjection);
+        bool intersectsSphere(const glm::vec3& center, float radius) const;
+    };
+
+    // Culls batches of bounding spheres against a frustum, 8 spheres per test with AVX2 and 4 with SSE
+    // Spheres are kept as structure of arrays so every plane test is a few multiply adds over whole registers
+    // The instruction set follows MeshProcessing::getSimdLevel
+    class FrustumCuller
+    {
+        public:
+            void clear();
+            void reserve(size_t count);
+            // Returns the index of the sphere, indices are assigned in order starting at 0 after every clear
+            uint32_t add(const glm::vec3& center, float radius);
+            size_t size() const { return radii.size(); }
+
+            // Replaces visible with the indices of the spheres intersecting the frustum, in ascending order
+            void cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+        private:
+            std::vector<float> centersX{};
+            std::vector<float> centersY{};
+            std::vector<float> centersZ{};
+            std::vector<float> radii{};
+    };
+} // namespace core
@@ -0,0 +1,32 @@
+// Built with -mavx2 (see CMakeLists.txt), only called after a runtime check for AVX2 support
+#include "frustum_culling_kernels.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace core
+{
+namespace
+{
+    struct Avx2Ops
+    {
+        using Vec = __m256;
+        static constexpr size_t WIDTH = 8;
+
+        static Vec load(const float* source) { return _mm256_loadu_ps(source); }
+        static Vec set(float value) { return _mm256_set1_ps(value); }
+        static Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+        static Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+        static Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+        static Vec greaterEqual(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+        static Vec bitAnd(Vec a, Vec b) { return _mm256_and_ps(a, b); }
+        static uint32_t moveMask(Vec a) { return static_cast<uint32_t>(_mm256_movemask_ps(a)); }
+    };
+} // namespace
+
+size_t cullSpheresAvx2(const float* x, const float* y, const float* z, const float* radius, size_t count, const float* planes, uint32_t* visible)
+{
+    return kernels::cullSpheres<Avx2Ops>(x, y, z, radius, count, planes, visible);
+}
+} // namespace core
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+// SIMD kernels used by FrustumCuller
+// Like mesh_processing_kernels.hpp this header must stay free of anything but intrinsics, the templates are instantiated
+// by translation units built with wider instruction sets
+#include <cstddef>
+#include <cstdint>
+
+namespace core
+{
+    // Tests count spheres stored as structure of arrays against six planes (xyz normal, w distance, 24 floats)
+    // Writes the index of every sphere that is not fully outside a plane to visible and returns how many were written
+    size_t cullSpheresSse(const float* x, const float* y, const float* z, const float* radius, size_t count, const float* planes, uint32_t* visible);
+    size_t cullSpheresAvx2(const float* x, const float* y, const float* z, const float* radius, size_t count, const float* planes, uint32_t* visible);
+
+    namespace kernels
+    {
+        template<class Ops>
+        size_t cullSpheres(const float* x, const float* y, const float* z, const float* radius, size_t count, const float* planes, uint32_t* visible)
+        {
+            using Vec = typename Ops::Vec;
+            constexpr size_t WIDTH = Ops::WIDTH;
+            Vec planeX[6], planeY[6], planeZ[6], planeW[6];
+            for(size_t plane = 0; plane < 6; plane++)
+            {
+                planeX[plane] = Ops::set(planes[plane * 4 + 0]);
+                planeY[plane] = Ops::set(planes[plane * 4 + 1]);
+                planeZ[plane] = Ops::set(planes[plane * 4 + 2]);
+                planeW[plane] = Ops::set(planes[plane * 4 + 3]);
+            }
+
+            size_t visibleCount = 0;
+            size_t first = 0;
+            for(; first + WIDTH <= count; first += WIDTH)
+            {
+                Vec centerX = Ops::load(x + first);
+                Vec centerY = Ops::load(y + first);
+                Vec centerZ = Ops::load(z + first);
+                Vec negativeRadius = Ops::sub(Ops::set(0.0f), Ops::load(radius + first));
+
+                // A sphere is culled once its center is further than its radius behind any plane
+                Vec inside = Ops::greaterEqual(Ops::add(Ops::add(Ops::add(Ops::mul(planeX[0], centerX), Ops::mul(planeY[0], centerY)),
+                    Ops::mul(planeZ[0], centerZ)), planeW[0]), negativeRadius);
+                for(size_t plane = 1; plane < 6; plane++)
+                {
+                    Vec distance = Ops::add(Ops::add(Ops::add(Ops::mul(planeX[plane], centerX), Ops::mul(planeY[plane], centerY)),
+                        Ops::mul(planeZ[plane], centerZ)), planeW[plane]);
+                    inside = Ops::bitAnd(inside, Ops::greaterEqual(distance, negativeRadius));
+                }
+
+                uint32_t mask = Ops::moveMask(inside);
+                for(size_t lane = 0; mask != 0; lane++, mask >>= 1)
+                {
+                    if(mask & 1)
+                    {
+                        visible[visibleCount++] = static_cast<uint32_t>(first + lane);
+                    }
+                }
+            }
+
+            for(; first < count; first++)
+            {
+                bool inside = true;
+                for(size_t plane = 0; plane < 6 && inside; plane++)
+                {
+                    const float* p = planes + plane * 4;
+                    inside = p[0] * x[first] + p[1] * y[first] + p[2] * z[first] + p[3] >= -radius[first];
+                }
+                if(inside)
+                {
+                    visible[visibleCount++] = static_cast<uint32_t>(first);
+                }
+            }
+            return visibleCount;
+        }
+    } // namespace kernels
+} // namespace core
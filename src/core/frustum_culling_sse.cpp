@@ -0,0 +1,31 @@
+#include "frustum_culling_kernels.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+
+namespace core
+{
+namespace
+{
+    struct SseOps
+    {
+        using Vec = __m128;
+        static constexpr size_t WIDTH = 4;
+
+        static Vec load(const float* source) { return _mm_loadu_ps(source); }
+        static Vec set(float value) { return _mm_set1_ps(value); }
+        static Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+        static Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+        static Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+        static Vec greaterEqual(Vec a, Vec b) { return _mm_cmpge_ps(a, b); }
+        static Vec bitAnd(Vec a, Vec b) { return _mm_and_ps(a, b); }
+        static uint32_t moveMask(Vec a) { return static_cast<uint32_t>(_mm_movemask_ps(a)); }
+    };
+} // namespace
+
+size_t cullSpheresSse(const float* x, const float* y, const float* z, const float* radius, size_t count, const float* planes, uint32_t* visible)
+{
+    return kernels::cullSpheres<SseOps>(x, y, z, radius, count, planes, visible);
+}
+} // namespace core
+#endif
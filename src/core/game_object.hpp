@@ -6,10 +6,17 @@
 #include "object.hpp"
 #include "components/transform.hpp"
 #include "components/mesh_components.hpp"
+#include "entity_registry.hpp"
 #include "utils/smart_reference.hpp"
 
 namespace core
 {
+    // Links a scene entity back to the GameObject that owns it
+    struct ObjectLink
+    {
+        id_t objectID{};
+    };
+
     class GameObject_t : public Object
     {
     public:
@@ -23,16 +30,24 @@ namespace core
         GameObject_t& operator=(GameObject_t&&) = delete;
 
         id_t get_id() const { return localID; }
-        Mesh mesh{};
 
-        Transform transform;
+        // Components live in the owning scene's registry, references are invalidated when more entities are created
+        Transform& getTransform() { return registry->getComponent<Transform>(entity); }
+        const Mesh& getMesh() { return registry->getComponent<Mesh>(entity); }
+        void setMesh(const Mesh& mesh) { registry->getComponent<Mesh>(entity) = mesh; }
+        id_t getMaterialID() { return registry->getComponent<MaterialComponent>(entity).materialID; }
+        void setMaterialID(id_t materialID) { registry->getComponent<MaterialComponent>(entity).materialID = materialID; }
         // MeshRenderer meshRenderer;
 
-        id_t materialID{};
+        Entity getEntity() const { return entity; }
     protected:
         GameObject_t(id_t newID) : Object(newID) {}
         id_t localID; // ID local to scene/prefab
         friend class ObjectManager;
+        friend class Scene_t;
+
+        EntityRegistry* registry = nullptr; // Set by the scene that created this object
+        Entity entity{};
     };
 
     class GameObject : public SmartRef<GameObject_t>
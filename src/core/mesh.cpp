@@ -1,32 +1,86 @@
 #include "mesh.hpp"
+#include "mesh_cache.hpp"
+#include "obj_importer.hpp"
+#include "mesh_processing.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
+#include "physics/bvh.hpp"
 #include "graphics/graphics.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
-#define TINYOBJLOADER_IMPLEMENTATION
-
-#include <tiny_obj_loader.h>
-#include <unordered_map>
-#include <array>
+#include <cstdio>
+#include <limits>
 
 #include "modules.hpp"
 
 namespace core
 {
 
+namespace
+{
+    // Inserts [begin, end) and merges it with every range it overlaps or touches
+    void addDirtyRange(std::vector<MeshData::DirtyRange>& ranges, uint32_t begin, uint32_t end)
+    {
+        if(begin >= end)
+        {
+            return;
+        }
+        auto first = std::lower_bound(ranges.begin(), ranges.end(), begin,
+            [](const MeshData::DirtyRange& range, uint32_t value) { return range.end < value; });
+        auto last = first;
+        while(last != ranges.end() && last->begin <= end)
+        {
+            begin = std::min(begin, last->begin);
+            end = std::max(end, last->end);
+            ++last;
+        }
+        first = ranges.erase(first, last);
+        ranges.insert(first, {begin, end});
+
+        if(ranges.size() > MeshData::MAX_DIRTY_RANGES)
+        {
+            size_t closest = 0;
+            for(size_t i = 1; i + 1 < ranges.size(); i++)
+            {
+                if(ranges[i + 1].begin - ranges[i].end < ranges[closest + 1].begin - ranges[closest].end)
+                {
+                    closest = i;
+                }
+            }
+            ranges[closest].end = ranges[closest + 1].end;
+            ranges.erase(ranges.begin() + closest + 1);
+        }
+    }
+} // namespace
+
 void MeshData::SetMesh(const std::vector<Vertex>& _vertices, const std::vector<uint32_t>& _indices)
 {
     vertices = _vertices;
-    for(uint32_t i = 0; i < _indices.size(); i += 3)
+    // Replaces the triangles, a trailing partial triangle is dropped
+    triangles.clear();
+    triangles.reserve(_indices.size() / 3);
+    for(size_t i = 0; i + 2 < _indices.size(); i += 3)
     {
         triangles.push_back({_indices[i], _indices[i + 1], _indices[i + 2]});
     }
+    lods.clear();
+    addDirtyRange(dirtyVertices, 0, static_cast<uint32_t>(vertices.size()));
+    addDirtyRange(dirtyTriangles, 0, static_cast<uint32_t>(triangles.size()));
+    recomputeBounds();
+    bvh.reset();
 }
 
 void MeshData::SetMesh(const std::vector<Vertex>& _vertices, const std::vector<Triangle>& _triangles)
 {
     vertices = _vertices;
     triangles = _triangles;
+    lods.clear();
+    addDirtyRange(dirtyVertices, 0, static_cast<uint32_t>(vertices.size()));
+    addDirtyRange(dirtyTriangles, 0, static_cast<uint32_t>(triangles.size()));
+    recomputeBounds();
+    bvh.reset();
     // createVertexBuffer();
     // if(useIndexBuffer)
     //     createIndexBuffer();
@@ -34,84 +88,95 @@ void MeshData::SetMesh(const std::vector<Vertex>& _vertices, const std::vector<T
 
 MeshData::~MeshData(){}
 
-float angleBetween(glm::vec3 v1, glm::vec3 v2)
+void MeshData::markVerticesDirty(uint32_t first, uint32_t count)
+{
+    addDirtyRange(dirtyVertices, first, first + count);
+    growBounds(first, std::min<uint32_t>(first + count, static_cast<uint32_t>(vertices.size())));
+    bvh.reset();
+}
+
+void MeshData::markTrianglesDirty(uint32_t first, uint32_t count)
+{
+    addDirtyRange(dirtyTriangles, first, first + count);
+    bvh.reset();
+}
+
+void MeshData::clearDirtyRanges()
+{
+    dirtyVertices.clear();
+    dirtyTriangles.clear();
+}
+
+void MeshData::recomputeBounds()
+{
+    bounds = {};
+    if(vertices.empty())
+    {
+        return;
+    }
+    bounds.min = glm::vec3(std::numeric_limits<float>::max());
+    bounds.max = glm::vec3(std::numeric_limits<float>::lowest());
+    MeshProcessing::computeBounds(vertices, 0, vertices.size(), bounds.min, bounds.max);
+    bounds.center = (bounds.min + bounds.max) * 0.5f;
+    bounds.radius = glm::sqrt(MeshProcessing::computeMaxDistanceSquared(vertices, 0, vertices.size(), bounds.center));
+}
+
+std::shared_ptr<const physics::MeshBvh> MeshData::getBvh()
 {
-    return glm::acos(glm::clamp(glm::dot(v1, v2) / (glm::length(v1) * glm::length(v2)), -1.0f + 1e-6f, 1.0f - 1e-6f));
+    if(bvh == nullptr || bvh->getTriangleCount() != triangles.size() || bvh->getVertexCount() != vertices.size())
+    {
+        bvh = std::make_shared<const physics::MeshBvh>(*this);
+    }
+    return bvh;
+}
+
+void MeshData::growBounds(uint32_t firstVertex, uint32_t lastVertex)
+{
+    if(firstVertex >= lastVertex)
+    {
+        return;
+    }
+    if(lastVertex - firstVertex == vertices.size())
+    {
+        recomputeBounds();
+        return;
+    }
+    // The sphere keeps its center, moving it would need every vertex to find the new radius
+    MeshProcessing::computeBounds(vertices, firstVertex, lastVertex, bounds.min, bounds.max);
+    float radiusSquared = MeshProcessing::computeMaxDistanceSquared(vertices, firstVertex, lastVertex, bounds.center);
+    bounds.radius = std::max(bounds.radius, glm::sqrt(radiusSquared));
 }
 
 Mesh::Mesh(std::vector<Vertex> &vertices, const std::string& objectName)
 {
-    ptr = ObjectManager::Instantiate<MeshData>(objectName);
+    reset(ObjectManager::Instantiate<MeshData>(objectName));
     ptr->SetMesh(vertices, std::vector<uint32_t>{});
     graphicsModule.setGraphicsMesh(*this);
 }
 
 Mesh::Mesh(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, const std::string& objectName)
 {
-    ptr = ObjectManager::Instantiate<MeshData>(objectName);
+    reset(ObjectManager::Instantiate<MeshData>(objectName));
     ptr->SetMesh(vertices, indices);
     graphicsModule.setGraphicsMesh(*this);
 }
 
 Mesh::Mesh(std::vector<Vertex> &vertices, std::vector<Triangle> &triangles, const std::string& objectName)
 {
-    ptr = ObjectManager::Instantiate<MeshData>(objectName);
+    reset(ObjectManager::Instantiate<MeshData>(objectName));
     ptr->SetMesh(vertices, triangles);
     graphicsModule.setGraphicsMesh(*this);
 }
 
-void Mesh::generateNormals()
+void Mesh::generateNormals(NormalWeighting weighting)
 {
     if(!ptr)
     {
         Console::error("Cannot generate normals as mesh pointer is null", "Mesh");
-    }
-
-    std::vector<Vertex> &vertices = ptr->vertices;
-    std::vector<Triangle> &triangles = ptr->triangles;
-    if(triangles.size() == 0)
-    {
         return;
     }
 
-    for(Vertex& vertex : vertices)
-    {
-        vertex.normal = glm::vec3(0.0f);
-    }
-    for(Triangle& triangle : triangles)
-    {
-        Vertex& v0 = vertices[triangle.v0];
-        Vertex& v1 = vertices[triangle.v1];
-        Vertex& v2 = vertices[triangle.v2];
-
-        glm::vec3 edge1 = v1.position - v0.position;
-        glm::vec3 edge2 = v2.position - v0.position;
-        
-        // if(glm::length(edge1) < 1e-6f || glm::length(edge2) < 1e-6f)
-        //     continue; // Degenerate triangle, just like me :(
-            
-        glm::vec3 cross = glm::cross(edge1, edge2);
-
-        if(glm::length(cross) < 1e-6f)
-            continue; // Degenerate triangle
-
-        glm::vec3 normal = glm::normalize(cross);
-
-        float angle0 = angleBetween(v1.position - v0.position, v2.position - v0.position);
-        float angle1 = angleBetween(v0.position - v1.position, v2.position - v1.position);
-        float angle2 = angleBetween(v0.position - v2.position, v1.position - v2.position);
-
-        // if(std::isnan(angle0) || std::isnan(angle1) || std::isnan(angle2))
-        //     continue;
-
-        v0.normal += normal * angle0;
-        v1.normal += normal * angle1;
-        v2.normal += normal * angle2;
-    }
-    for(Vertex& vertex : vertices)
-    {
-        vertex.normal = glm::normalize(vertex.normal);
-    }
+    MeshProcessing::generateNormals(ptr->vertices, ptr->triangles, weighting);
 }
 
 void Mesh::generateTangents()
@@ -119,74 +184,33 @@ void Mesh::generateTangents()
     if(!ptr)
     {
         Console::error("Cannot generate tangents as mesh pointer is null", "Mesh");
+        return;
     }
-
-    std::vector<Vertex> &vertices = ptr->vertices;
-    std::vector<Triangle> &triangles = ptr->triangles;
-    if(triangles.size() == 0)
+    if(ptr->triangles.size() == 0)
     {
         Console::error("Cannot generate tangents as there are no triangles defined", "Mesh");
         return;
     }
 
-    for(Vertex& vertex : vertices)
+    MeshProcessing::generateTangents(ptr->vertices, ptr->triangles);
+}
+
+void Mesh::generateLods(const std::vector<float>& ratios)
+{
+    if(!ptr)
     {
-        vertex.tangent = glm::vec4(0.0f);
-        vertex.bitangent = glm::vec3(0.0f);
+        Console::error("Cannot generate LODs as mesh pointer is null", "Mesh");
+        return;
     }
-    for(Triangle& triangle : triangles)
-    {
-        Vertex& v0 = vertices[triangle.v0];
-        Vertex& v1 = vertices[triangle.v1];
-        Vertex& v2 = vertices[triangle.v2];
-
-        glm::vec3 edge1 = v1.position - v0.position;
-        glm::vec3 edge2 = v2.position - v0.position;
-        
-
-        if(glm::length(edge1) < 1e-6f || glm::length(edge2) < 1e-6f)
-            continue; // Degenerate triangle
-
-        glm::vec2 deltaUV1 = v1.texCoord - v0.texCoord;
-        glm::vec2 deltaUV2 = v2.texCoord - v0.texCoord;
 
-        float f = (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
+    ptr->lods = MeshSimplifier::generateLods(ptr->vertices, ptr->triangles, ratios);
 
-        glm::vec3 tangent;
-        glm::vec3 bitangent;
-
-        if(glm::abs(f) < 1e-9f)
-            continue; // Degenerate UVs
-            
-        tangent = (deltaUV2.y * edge1 - deltaUV1.y * edge2) / f;
-        bitangent = (-deltaUV2.x * edge1 + deltaUV1.x * edge2) / f;
-
-        glm::vec4 tempTangent = glm::vec4(tangent, 0.0f);
-        v0.tangent += tempTangent;
-        v1.tangent += tempTangent;
-        v2.tangent += tempTangent;
-        v0.bitangent += bitangent;
-        v1.bitangent += bitangent;
-        v2.bitangent += bitangent;
-    }
-    for(Vertex& vertex : vertices)
+    std::string summary = std::to_string(ptr->triangles.size());
+    for(const MeshData::Lod& lod : ptr->lods)
     {
-        vertex.tangent = glm::normalize(vertex.tangent);
-        vertex.bitangent = glm::normalize(vertex.bitangent);
-
-        // Gram-Schmidt orthogonalize
-        glm::vec3 tempTangent = glm::vec3(vertex.tangent);
-        vertex.tangent = glm::vec4(glm::normalize(tempTangent - vertex.normal * glm::dot(vertex.normal, tempTangent)), 1.0f);
-        vertex.bitangent = glm::normalize(vertex.bitangent - vertex.normal * glm::dot(vertex.normal, vertex.bitangent));
-
-        // Calculate handedness
-        tempTangent = glm::vec3(vertex.tangent);
-        if(glm::dot(glm::cross(vertex.normal, tempTangent), vertex.bitangent) < 0.0f)
-        {
-            vertex.bitangent = vertex.bitangent * -1.0f;
-            vertex.tangent.w = -1.0f;
-        }
+        summary += " / " + std::to_string(lod.triangles.size());
     }
+    Console::log("Generated " + std::to_string(ptr->lods.size()) + " LODs for " + ptr->name + ": " + summary + " triangles", "Mesh");
 }
 
 Mesh Mesh::createCube(float edgeLength, const std::string& objectName)
@@ -346,8 +370,9 @@ Mesh Mesh::createGrid(int width, int length, glm::vec2 dimensions, const std::st
         }
     }
     
+    // Generated before the mesh is created so the uploaded vertices already have them
+    MeshProcessing::generateNormals(vertices, triangles);
     Mesh mesh = Mesh(vertices, triangles, objectName);
-    mesh.generateNormals();
     return mesh;
 }
 
@@ -386,109 +411,41 @@ Mesh Mesh::createSkybox(float size, const std::string& objectName)
 
 Mesh Mesh::loadObj(const std::string& filename, const std::string& objectName)
 {
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
-
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename.c_str()))
+    Mesh mesh(ObjectManager::Instantiate<MeshData>(objectName));
+    if(MeshCache::load(filename, *mesh))
     {
-        throw std::runtime_error(warn + err);
+        Console::log("Loaded cooked mesh " + MeshCache::getCookedPath(filename), "Mesh");
     }
-
-    std::vector<Vertex> vertices{};
-    std::vector<Triangle> triangles{};
-
-    // Define a key to identify unique vertex combinations
-    struct VertexKey {
-        int posIdx;
-        int normIdx;
-        int texIdx;
-        bool operator==(const VertexKey& other) const {
-            return posIdx == other.posIdx && normIdx == other.normIdx && texIdx == other.texIdx;
+    else
+    {
+        try
+        {
+            ObjImporter::load(filename, *mesh);
         }
-    };
-
-    // Hash function for VertexKey
-    struct VertexKeyHash {
-        size_t operator()(const VertexKey& k) const {
-            size_t h1 = std::hash<int>{}(k.posIdx);
-            size_t h2 = std::hash<int>{}(k.normIdx);
-            size_t h3 = std::hash<int>{}(k.texIdx);
-            return h1 ^ (h2 << 1) ^ (h3 << 2);
+        catch(...)
+        {
+            ObjectManager::deleteObject(mesh.getHandle());
+            throw;
         }
-    };
+        mesh.generateTangents(); // Not included in OBJ, so we must generate them
 
-    // Map from VertexKey to index in vertices vector
-    std::unordered_map<VertexKey, uint32_t, VertexKeyHash> vertexMap;
-
-    // Process each shape
-    for (const auto& shape : shapes) {
-        // Iterate over indices in steps of 3 (triangles)
-        for (size_t i = 0; i < shape.mesh.indices.size(); i += 3) {
-            std::array<uint32_t, 3> triIndices;
-
-            // Process each vertex of the triangle
-            for (int k = 0; k < 3; k++) {
-                tinyobj::index_t idx = shape.mesh.indices[i + k];
-                VertexKey key{idx.vertex_index, idx.normal_index, idx.texcoord_index};
-
-                // Check if this vertex combination exists
-                auto it = vertexMap.find(key);
-                if (it != vertexMap.end()) {
-                    triIndices[k] = it->second;
-                } else {
-                    // Create a new Vertex
-                    Vertex v;
-                    int posIdx = idx.vertex_index;
-                    v.position = {
-                        attrib.vertices[3 * posIdx],
-                        attrib.vertices[3 * posIdx + 1],
-                        attrib.vertices[3 * posIdx + 2]
-                    };
-
-                    int normIdx = idx.normal_index;
-                    if (normIdx >= 0) {
-                        v.normal = {
-                            attrib.normals[3 * normIdx],
-                            attrib.normals[3 * normIdx + 1],
-                            attrib.normals[3 * normIdx + 2]
-                        };
-                    }
-
-                    int texIdx = idx.texcoord_index;
-                    if (texIdx >= 0) {
-                        v.texCoord = {
-                            attrib.texcoords[2 * texIdx],
-                            attrib.texcoords[2 * texIdx + 1]
-                        };
-                    }
-
-                    if (3 * posIdx + 2 < attrib.colors.size()) {
-                        v.color = {
-                            attrib.colors[3 * posIdx],
-                            attrib.colors[3 * posIdx + 1],
-                            attrib.colors[3 * posIdx + 2]
-                        };
-                    }
-
-                    // Add to vertices and update map
-                    vertices.push_back(v);
-                    uint32_t newIndex = static_cast<uint32_t>(vertices.size() - 1);
-                    vertexMap[key] = newIndex;
-                    triIndices[k] = newIndex;
-                }
-            }
+        MeshOptimizer::Stats stats = MeshOptimizer::optimize(mesh->vertices, mesh->triangles);
+        char message[512];
+        snprintf(message, sizeof(message), "Optimized %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %zu clusters in %.1f ms", filename.c_str(),
+            stats.before.acmr, stats.after.acmr, stats.before.atvr, stats.after.atvr, stats.clusters, stats.seconds * 1000.0);
+        Console::log(message, "Mesh");
 
-            // Add the triangle
-            triangles.push_back({triIndices[0], triIndices[1], triIndices[2]});
+        mesh.generateLods();
+        if(MeshCache::cook(filename, *mesh))
+        {
+            Console::log("Cooked " + filename + " to " + MeshCache::getCookedPath(filename), "Mesh");
         }
     }
 
-    std::cout << "Loaded " << vertices.size() << " vertices and " << triangles.size() << " triangles\n";
-
-    Mesh mesh(vertices, triangles, objectName);
-    mesh.generateTangents(); // Not included in OBJ, so we must generate them
+    mesh->sourcePath = filename;
+    // Uploaded once the vertices are final, tangents included
+    mesh->recomputeBounds();
+    graphicsModule.setGraphicsMesh(mesh);
     return mesh;
 }
 
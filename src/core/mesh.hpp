@@ -12,8 +12,21 @@
 #include "utils/console.hpp"
 #include "utils/smart_reference.hpp"
 
+namespace physics
+{
+    class MeshBvh;
+}
+
 namespace core
 {
+    // How face normals are weighted when summed into vertex normals
+    // ANGLE weights by the corner angle (needs an acos per corner), AREA by the triangle area which is much cheaper
+    enum class NormalWeighting
+    {
+        ANGLE = 0,
+        AREA = 1
+    };
+
     class MeshData : public Object
     {
     public:
@@ -38,16 +51,65 @@ namespace core
             uint32_t v2;
         };
 
+        // Simplified version of the triangles indexing the same vertices
+        // error is the largest geometric deviation from the full mesh relative to half its bounding box diagonal
+        struct Lod
+        {
+            std::vector<Triangle> triangles{};
+            float error = 0.0f;
+        };
+
+        // Half open range of vertices or triangles changed since the last upload
+        struct DirtyRange
+        {
+            uint32_t begin;
+            uint32_t end;
+        };
+        // Past this many ranges the two closest ones are merged, scattered edits then upload a few unchanged elements too
+        static constexpr size_t MAX_DIRTY_RANGES = 16;
+
+        // Box and sphere containing every vertex position, the sphere is centered on the box
+        struct Bounds
+        {
+            glm::vec3 min{};
+            glm::vec3 max{};
+            glm::vec3 center{};
+            float radius = 0.0f;
+        };
+
         void SetMesh(const std::vector<Vertex>& _vertices, const std::vector<uint32_t>& _indices);
         void SetMesh(const std::vector<Vertex>& _vertices, const std::vector<Triangle>& _indices);
         ~MeshData();
 
+        // Edits made directly to vertices or triangles must be marked for Graphics::updateGraphicsMesh to upload them
+        // Elements appended past the uploaded size are picked up without being marked
+        // Marking vertices after moving them also grows the bounds to contain them
+        void markVerticesDirty(uint32_t first, uint32_t count);
+        void markTrianglesDirty(uint32_t first, uint32_t count);
+        const std::vector<DirtyRange>& getDirtyVertices() const { return dirtyVertices; }
+        const std::vector<DirtyRange>& getDirtyTriangles() const { return dirtyTriangles; }
+        void clearDirtyRanges();
+
+        const Bounds& getBounds() const { return bounds; }
+        // Bounds only grow with edits, this shrinks them back to fit, e.g. after a mesh was deformed a lot
+        void recomputeBounds();
+
+        // Collision BVH for physics queries, built on first use and again after the geometry was marked dirty or resized
+        // Not safe to call from several threads at once
+        std::shared_ptr<const physics::MeshBvh> getBvh();
+
         std::vector<Vertex> vertices{};
         std::vector<Triangle> triangles{};
+        std::vector<Lod> lods{}; // Coarser levels of detail, finest first, must be regenerated when the triangles change
+        std::string sourcePath{}; // File the mesh was loaded from, data cooked from it is stored next to it. Empty for generated meshes
 
     private:
         using Object::Object;
-        void loadModelFromObj(const std::string& filename); // TODO: Asset importer
+        std::vector<DirtyRange> dirtyVertices{}; // Sorted and disjoint
+        std::vector<DirtyRange> dirtyTriangles{};
+        Bounds bounds{};
+        std::shared_ptr<const physics::MeshBvh> bvh{};
+        void growBounds(uint32_t firstVertex, uint32_t lastVertex);
     };
 
     class Mesh : public SmartRef<MeshData>
@@ -62,8 +124,9 @@ namespace core
             Mesh(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, const std::string& objectName = "New Mesh");
             Mesh(std::vector<Vertex> &vertices, std::vector<Triangle> &triangles, const std::string& objectName = "New Mesh");
 
-            void generateNormals();
+            void generateNormals(NormalWeighting weighting = NormalWeighting::ANGLE);
             void generateTangents();
+            void generateLods(const std::vector<float>& ratios = {0.5f, 0.25f, 0.125f, 0.0625f}); // Target triangle ratios
 
             void PrintInfo() const
             {
@@ -79,7 +142,5 @@ namespace core
             static Mesh createGrid(int width, int length, glm::vec2 dimensions, const std::string& objectName = "Grid Mesh");
             static Mesh createSkybox(float size, const std::string& objectName = "Skybox Mesh");
             static Mesh loadObj(const std::string& filename, const std::string& objectName = "Obj Mesh"); // TODO: replace with loadFromFile
-        private:
-            void loadModelFromObj(const std::string& filename);
     };
 }
\ No newline at end of file
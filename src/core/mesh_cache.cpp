@@ -0,0 +1,264 @@
+#include "mesh_cache.hpp"
+#include "utils/mapped_file.hpp"
+#include "utils/console.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace core
+{
+static_assert(sizeof(MeshCache::Header) == 88, "Changing the cooked mesh header requires a version bump");
+static_assert(sizeof(MeshCache::LodEntry) == 16, "Changing the cooked LOD entries requires a version bump");
+
+namespace
+{
+    bool trianglesInRange(const std::vector<MeshData::Triangle>& triangles, uint32_t vertexCount)
+    {
+        return std::all_of(triangles.begin(), triangles.end(), [vertexCount](const MeshData::Triangle& triangle)
+        {
+            return triangle.v0 < vertexCount && triangle.v1 < vertexCount && triangle.v2 < vertexCount;
+        });
+    }
+} // namespace
+
+uint64_t MeshCache::hashBytes(const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for(size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool MeshCache::getSourceInfo(const std::string& path, SourceInfo& info)
+{
+    std::error_code error{};
+    uintmax_t size = std::filesystem::file_size(path, error);
+    if(error) return false;
+    std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(path, error);
+    if(error) return false;
+    info.size = size;
+    info.writeTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+    return true;
+}
+
+bool MeshCache::hashFile(const std::string& path, uint64_t& hash)
+{
+    MappedFile source{};
+    if(!source.open(path)) return false;
+    hash = hashBytes(source.data(), source.size());
+    return true;
+}
+
+bool MeshCache::checkSource(const std::string& sourcePath, const std::string& cookedPath, MappedFile& cooked, uint64_t sourceSize,
+    int64_t sourceWriteTime, uint64_t sourceHash, size_t writeTimeOffset, const std::string& category)
+{
+    SourceInfo source{};
+    if(!getSourceInfo(sourcePath, source) || (source.size == sourceSize && source.writeTime == sourceWriteTime))
+    {
+        return true;
+    }
+
+    // The source was touched, only re-cook if its contents actually changed
+    uint64_t hash = 0;
+    if(source.size != sourceSize || !hashFile(sourcePath, hash) || hash != sourceHash)
+    {
+        Console::log("Source of " + cookedPath + " changed, re-cooking", category);
+        return false;
+    }
+
+    cooked.close();
+    std::fstream file(cookedPath, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(writeTimeOffset);
+    file.write(reinterpret_cast<const char*>(&source.writeTime), sizeof(source.writeTime));
+    file.close();
+    return cooked.open(cookedPath);
+}
+
+bool MeshCache::writeCooked(const std::string& cookedPath, const std::vector<Blob>& blobs, const std::string& category)
+{
+    const std::string tempPath = cookedPath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if(!file.is_open())
+        {
+            Console::warn("Could not write " + cookedPath, category);
+            return false;
+        }
+        const char padding[BLOB_ALIGNMENT]{};
+        uint64_t offset = 0;
+        for(const Blob& blob : blobs)
+        {
+            while(offset < blob.offset)
+            {
+                uint64_t bytes = std::min<uint64_t>(blob.offset - offset, sizeof(padding));
+                file.write(padding, bytes);
+                offset += bytes;
+            }
+            file.write(static_cast<const char*>(blob.data), blob.size);
+            offset += blob.size;
+        }
+        if(!file)
+        {
+            Console::warn("Could not write " + cookedPath, category);
+            return false;
+        }
+    }
+
+    std::error_code error{};
+    std::filesystem::rename(tempPath, cookedPath, error);
+    if(error)
+    {
+        Console::warn("Could not replace " + cookedPath + ": " + error.message(), category);
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+bool MeshCache::load(const std::string& sourcePath, MeshData& mesh)
+{
+    const std::string cookedPath = getCookedPath(sourcePath);
+    if(!std::filesystem::is_regular_file(cookedPath)) return false;
+
+    MappedFile cooked{};
+    if(!cooked.open(cookedPath)) return false;
+
+    if(cooked.size() < sizeof(Header))
+    {
+        Console::warn("Cooked mesh " + cookedPath + " is truncated, re-cooking", "Mesh Cache");
+        return false;
+    }
+    Header header{};
+    memcpy(&header, cooked.data(), sizeof(Header));
+    if(memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.vertexStride != sizeof(MeshData::Vertex))
+    {
+        Console::log("Cooked mesh " + cookedPath + " is from an older format, re-cooking", "Mesh Cache");
+        return false;
+    }
+
+    const uint64_t vertexBytes = static_cast<uint64_t>(header.vertexCount) * sizeof(MeshData::Vertex);
+    const uint64_t triangleBytes = static_cast<uint64_t>(header.triangleCount) * sizeof(MeshData::Triangle);
+    const uint64_t lodTableOffset = alignOffset(header.triangleOffset + triangleBytes);
+    const uint64_t lodTableBytes = static_cast<uint64_t>(header.lodCount) * sizeof(LodEntry);
+    bool truncated = !blobFits(header.vertexOffset, vertexBytes, cooked.size()) || !blobFits(header.triangleOffset, triangleBytes, cooked.size())
+        || !blobFits(lodTableOffset, lodTableBytes, cooked.size());
+    std::vector<LodEntry> lodEntries{};
+    if(!truncated)
+    {
+        lodEntries.resize(header.lodCount);
+        memcpy(lodEntries.data(), cooked.data() + lodTableOffset, lodTableBytes);
+        for(const LodEntry& entry : lodEntries)
+        {
+            truncated |= !blobFits(entry.triangleOffset, static_cast<uint64_t>(entry.triangleCount) * sizeof(MeshData::Triangle), cooked.size());
+        }
+    }
+    if(truncated)
+    {
+        Console::warn("Cooked mesh " + cookedPath + " is truncated, re-cooking", "Mesh Cache");
+        return false;
+    }
+
+    if(!checkSource(sourcePath, cookedPath, cooked, header.sourceSize, header.sourceWriteTime, header.sourceHash, offsetof(Header, sourceWriteTime), "Mesh Cache"))
+    {
+        return false;
+    }
+
+    // Every index is checked before the mesh is touched, everything that reads the mesh, the GPU included, trusts them
+    std::vector<MeshData::Triangle> triangles(header.triangleCount);
+    memcpy(triangles.data(), cooked.data() + header.triangleOffset, triangleBytes);
+    bool inRange = trianglesInRange(triangles, header.vertexCount);
+    std::vector<MeshData::Lod> lods(header.lodCount);
+    for(size_t i = 0; i < lodEntries.size() && inRange; i++)
+    {
+        lods[i].error = lodEntries[i].error;
+        lods[i].triangles.resize(lodEntries[i].triangleCount);
+        memcpy(lods[i].triangles.data(), cooked.data() + lodEntries[i].triangleOffset, lodEntries[i].triangleCount * sizeof(MeshData::Triangle));
+        inRange = trianglesInRange(lods[i].triangles, header.vertexCount);
+    }
+    if(!inRange)
+    {
+        Console::warn("Cooked mesh " + cookedPath + " has indices past its vertices, re-cooking", "Mesh Cache");
+        return false;
+    }
+
+    mesh.vertices.resize(header.vertexCount);
+    memcpy(mesh.vertices.data(), cooked.data() + header.vertexOffset, vertexBytes);
+    mesh.triangles = std::move(triangles);
+    mesh.lods = std::move(lods);
+    return true;
+}
+
+bool MeshCache::cook(const std::string& sourcePath, const MeshData& mesh)
+{
+    const std::vector<MeshData::Vertex>& vertices = mesh.vertices;
+    const std::vector<MeshData::Triangle>& triangles = mesh.triangles;
+    const std::string cookedPath = getCookedPath(sourcePath);
+
+    Header header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.vertexStride = sizeof(MeshData::Vertex);
+    header.vertexCount = static_cast<uint32_t>(vertices.size());
+    header.triangleCount = static_cast<uint32_t>(triangles.size());
+    header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+
+    SourceInfo source{};
+    if(!getSourceInfo(sourcePath, source) || !hashFile(sourcePath, header.sourceHash))
+    {
+        Console::warn("Could not read source " + sourcePath + ", mesh was not cooked", "Mesh Cache");
+        return false;
+    }
+    header.sourceSize = source.size;
+    header.sourceWriteTime = source.writeTime;
+
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+    for(const MeshData::Vertex& vertex : vertices)
+    {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+    if(vertices.empty())
+    {
+        boundsMin = boundsMax = glm::vec3(0.0f);
+    }
+    memcpy(header.boundsMin, &boundsMin, sizeof(header.boundsMin));
+    memcpy(header.boundsMax, &boundsMax, sizeof(header.boundsMax));
+
+    const uint64_t vertexBytes = vertices.size() * sizeof(MeshData::Vertex);
+    const uint64_t triangleBytes = triangles.size() * sizeof(MeshData::Triangle);
+    header.vertexOffset = alignOffset(sizeof(Header));
+    header.triangleOffset = alignOffset(header.vertexOffset + vertexBytes);
+    const uint64_t lodTableOffset = alignOffset(header.triangleOffset + triangleBytes);
+    std::vector<LodEntry> lodEntries(mesh.lods.size());
+    uint64_t endOffset = lodTableOffset + lodEntries.size() * sizeof(LodEntry);
+    for(size_t i = 0; i < lodEntries.size(); i++)
+    {
+        lodEntries[i].triangleCount = static_cast<uint32_t>(mesh.lods[i].triangles.size());
+        lodEntries[i].error = mesh.lods[i].error;
+        lodEntries[i].triangleOffset = alignOffset(endOffset);
+        endOffset = lodEntries[i].triangleOffset + mesh.lods[i].triangles.size() * sizeof(MeshData::Triangle);
+    }
+
+    std::vector<Blob> blobs{
+        {0, &header, sizeof(Header)},
+        {header.vertexOffset, vertices.data(), vertexBytes},
+        {header.triangleOffset, triangles.data(), triangleBytes},
+        {lodTableOffset, lodEntries.data(), lodEntries.size() * sizeof(LodEntry)}
+    };
+    for(size_t i = 0; i < lodEntries.size(); i++)
+    {
+        blobs.push_back({lodEntries[i].triangleOffset, mesh.lods[i].triangles.data(), mesh.lods[i].triangles.size() * sizeof(MeshData::Triangle)});
+    }
+    return writeCooked(cookedPath, blobs, "Mesh Cache");
+}
+} // namespace core
@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "mesh.hpp"
+
+class MappedFile;
+
+namespace core
+{
+    // Cooked binary meshes (.vmesh) stored next to their source file
+    // Layout: Header | vertex blob (MeshData::Vertex) | index blob (MeshData::Triangle) | LodEntry per LOD | index blob per LOD
+    // Blobs are 16 byte aligned
+    class MeshCache
+    {
+        public:
+            static constexpr char MAGIC[4] = {'V', 'M', 'S', 'H'};
+            static constexpr uint32_t VERSION = 4; // Bump whenever the layout or the cooking process changes
+
+            struct Header
+            {
+                char magic[4];
+                uint32_t version;
+                uint32_t vertexStride; // sizeof(MeshData::Vertex) when cooked, a mismatch forces a re-cook
+                uint32_t vertexCount;
+                uint32_t triangleCount;
+                uint32_t lodCount;
+                uint64_t sourceSize;
+                int64_t sourceWriteTime;
+                uint64_t sourceHash; // Checked when the size or write time no longer match
+                float boundsMin[3];
+                float boundsMax[3];
+                uint64_t vertexOffset;
+                uint64_t triangleOffset;
+            };
+
+            // Follows the index blob, one per entry of MeshData::lods
+            struct LodEntry
+            {
+                uint32_t triangleCount;
+                float error;
+                uint64_t triangleOffset;
+            };
+
+            static std::string getCookedPath(const std::string& sourcePath) { return sourcePath + ".vmesh"; }
+
+            // Reads the cooked mesh for sourcePath if it exists and is up to date with the source
+            // If the source file is missing the cooked mesh is used as is
+            static bool load(const std::string& sourcePath, MeshData& mesh);
+            static bool cook(const std::string& sourcePath, const MeshData& mesh);
+
+            // FNV-1a, used for the source content hash
+            static uint64_t hashBytes(const void* data, size_t size);
+
+            // Shared with the other caches that are cooked from the same source files
+            struct SourceInfo
+            {
+                uint64_t size = 0;
+                int64_t writeTime = 0;
+            };
+            static bool getSourceInfo(const std::string& path, SourceInfo& info);
+            static bool hashFile(const std::string& path, uint64_t& hash);
+
+            // Cooked file layout and I/O, shared with the other caches as well
+            static constexpr uint64_t BLOB_ALIGNMENT = 16;
+            static uint64_t alignOffset(uint64_t offset) { return (offset + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT; }
+            // Written so corrupt offsets near UINT64_MAX cannot wrap around
+            static bool blobFits(uint64_t offset, uint64_t bytes, uint64_t fileSize) { return offset <= fileSize && bytes <= fileSize - offset; }
+
+            // Compares the source with the size, write time and content hash stored when cooking, a missing source counts as unchanged
+            // A source that was only touched gets its new write time stored at writeTimeOffset of the cooked file so the next load
+            // can skip hashing, cooked is reopened for that. Returns false if the source changed or the file could not be reopened
+            static bool checkSource(const std::string& sourcePath, const std::string& cookedPath, MappedFile& cooked, uint64_t sourceSize,
+                int64_t sourceWriteTime, uint64_t sourceHash, size_t writeTimeOffset, const std::string& category);
+
+            struct Blob
+            {
+                uint64_t offset;
+                const void* data;
+                uint64_t size;
+            };
+            // Writes the blobs, sorted by offset, with zero padding between them
+            // A temporary file is renamed over the cooked one, so an interrupted cook never leaves a half written file behind
+            static bool writeCooked(const std::string& cookedPath, const std::vector<Blob>& blobs, const std::string& category);
+    };
+} // namespace core
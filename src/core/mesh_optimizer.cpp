@@ -0,0 +1,345 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <numeric>
+
+namespace core
+{
+namespace
+{
+    using Vertex = MeshData::Vertex;
+    using Triangle = MeshData::Triangle;
+
+    constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    // FIFO post-transform cache simulated with timestamps, a vertex is cached while fewer than size misses happened since its own
+    class FifoCache
+    {
+        public:
+            FifoCache(size_t vertexCount, uint32_t size) : timestamps(vertexCount, 0), size(size), time(size + 1) {}
+
+            // Returns the number of vertices of the triangle that had to be transformed
+            uint32_t add(const Triangle& triangle)
+            {
+                return add(triangle.v0) + add(triangle.v1) + add(triangle.v2);
+            }
+
+            // Forgets everything without touching the timestamps
+            void flush() { time += size + 1; }
+
+        private:
+            uint32_t add(uint32_t vertex)
+            {
+                if(time - timestamps[vertex] > size)
+                {
+                    timestamps[vertex] = time++;
+                    return 1;
+                }
+                return 0;
+            }
+
+            std::vector<uint32_t> timestamps;
+            uint32_t size;
+            uint32_t time;
+    };
+
+    // Compressed vertex to triangle lists, the triangles of vertex v are triangles[offsets[v], offsets[v + 1])
+    struct Adjacency
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+    };
+
+    Adjacency buildAdjacency(const std::vector<Triangle>& triangles, size_t vertexCount)
+    {
+        Adjacency adjacency;
+        adjacency.offsets.assign(vertexCount + 1, 0);
+        adjacency.triangles.resize(triangles.size() * 3);
+
+        const uint32_t* indices = &triangles[0].v0;
+        for(size_t corner = 0; corner < triangles.size() * 3; corner++)
+        {
+            adjacency.offsets[indices[corner] + 1]++;
+        }
+        std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+        std::vector<uint32_t> cursors(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+        for(size_t corner = 0; corner < triangles.size() * 3; corner++)
+        {
+            adjacency.triangles[cursors[indices[corner]]++] = static_cast<uint32_t>(corner / 3);
+        }
+        return adjacency;
+    }
+} // namespace
+
+MeshOptimizer::Stats MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<Triangle>& triangles)
+{
+    Stats stats;
+    if(triangles.empty())
+    {
+        return stats;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    stats.before = analyzeVertexCache(triangles, vertices.size());
+
+    std::vector<uint32_t> clusters = optimizeVertexCache(triangles, vertices.size());
+    optimizeOverdraw(vertices, triangles, clusters);
+    optimizeVertexFetch(vertices, triangles);
+
+    stats.after = analyzeVertexCache(triangles, vertices.size());
+    stats.clusters = clusters.size();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexCache(std::vector<Triangle>& triangles, size_t vertexCount, uint32_t cacheSize)
+{
+    std::vector<uint32_t> clusters;
+    if(triangles.empty())
+    {
+        return clusters;
+    }
+
+    const Adjacency adjacency = buildAdjacency(triangles, vertexCount);
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for(size_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        liveTriangles[vertex] = adjacency.offsets[vertex + 1] - adjacency.offsets[vertex];
+    }
+
+    std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+    std::vector<bool> emitted(triangles.size(), false);
+    std::vector<uint32_t> deadEnds; // Recently used vertices, tried before falling back to the input order
+    std::vector<uint32_t> candidates;
+    std::vector<Triangle> output;
+    output.reserve(triangles.size());
+
+    uint32_t time = cacheSize + 1;
+    uint32_t cursor = 0;
+    uint32_t fanning = 0;
+    clusters.push_back(0);
+
+    while(fanning != INVALID_INDEX)
+    {
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for(uint32_t i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; i++)
+        {
+            uint32_t triangle = adjacency.triangles[i];
+            if(emitted[triangle])
+            {
+                continue;
+            }
+            emitted[triangle] = true;
+            output.push_back(triangles[triangle]);
+
+            for(uint32_t vertex : {triangles[triangle].v0, triangles[triangle].v1, triangles[triangle].v2})
+            {
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+                if(time - cacheTimestamps[vertex] > cacheSize)
+                {
+                    cacheTimestamps[vertex] = time++;
+                }
+            }
+        }
+
+        // Prefer the oldest one ring vertex that will still be cached once all its triangles are emitted
+        uint32_t next = INVALID_INDEX;
+        int64_t bestPriority = -1;
+        for(uint32_t vertex : candidates)
+        {
+            if(liveTriangles[vertex] == 0)
+            {
+                continue;
+            }
+            int64_t age = time - cacheTimestamps[vertex];
+            int64_t priority = age + 2 * static_cast<int64_t>(liveTriangles[vertex]) <= cacheSize ? age : 0;
+            if(priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        if(next == INVALID_INDEX)
+        {
+            while(!deadEnds.empty() && next == INVALID_INDEX)
+            {
+                uint32_t vertex = deadEnds.back();
+                deadEnds.pop_back();
+                if(liveTriangles[vertex] > 0)
+                {
+                    next = vertex;
+                }
+            }
+            while(next == INVALID_INDEX && cursor < vertexCount)
+            {
+                if(liveTriangles[cursor] > 0)
+                {
+                    next = cursor;
+                }
+                cursor++;
+            }
+            if(next != INVALID_INDEX && clusters.back() != output.size())
+            {
+                clusters.push_back(static_cast<uint32_t>(output.size()));
+            }
+        }
+        fanning = next;
+    }
+
+    triangles = std::move(output);
+    return clusters;
+}
+
+void MeshOptimizer::optimizeOverdraw(const std::vector<Vertex>& vertices, std::vector<Triangle>& triangles, const std::vector<uint32_t>& clusters, float threshold)
+{
+    if(triangles.empty() || clusters.empty())
+    {
+        return;
+    }
+
+    // Split every cluster as soon as its running ACMR is within threshold of the ACMR of the whole cluster, sorting many small
+    // clusters reduces overdraw far more than a few large ones and each split only costs one cache flush
+    std::vector<uint32_t> boundaries;
+    FifoCache cache(vertices.size(), ANALYSIS_CACHE_SIZE);
+    for(size_t cluster = 0; cluster < clusters.size(); cluster++)
+    {
+        const uint32_t begin = clusters[cluster];
+        const uint32_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : static_cast<uint32_t>(triangles.size());
+
+        cache.flush();
+        uint32_t clusterMisses = 0;
+        for(uint32_t triangle = begin; triangle < end; triangle++)
+        {
+            clusterMisses += cache.add(triangles[triangle]);
+        }
+        const float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+        cache.flush();
+        boundaries.push_back(begin);
+        uint32_t misses = 0;
+        for(uint32_t triangle = begin; triangle < end; triangle++)
+        {
+            misses += cache.add(triangles[triangle]);
+            if(triangle + 1 < end && static_cast<float>(misses) <= clusterThreshold * static_cast<float>(triangle + 1 - boundaries.back()))
+            {
+                boundaries.push_back(triangle + 1);
+                cache.flush();
+                misses = 0;
+            }
+        }
+    }
+    boundaries.push_back(static_cast<uint32_t>(triangles.size()));
+
+    // Clusters facing away from the mesh center are drawn first, they are the most likely to occlude the rest
+    struct Cluster
+    {
+        glm::vec3 centroid{};
+        glm::vec3 normal{};
+        float area = 0.0f;
+    };
+    const size_t clusterCount = boundaries.size() - 1;
+    std::vector<Cluster> sums(clusterCount);
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for(size_t cluster = 0; cluster < clusterCount; cluster++)
+    {
+        Cluster& sum = sums[cluster];
+        for(uint32_t triangle = boundaries[cluster]; triangle < boundaries[cluster + 1]; triangle++)
+        {
+            const glm::vec3& p0 = vertices[triangles[triangle].v0].position;
+            const glm::vec3& p1 = vertices[triangles[triangle].v1].position;
+            const glm::vec3& p2 = vertices[triangles[triangle].v2].position;
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+            sum.centroid += (p0 + p1 + p2) * (area / 3.0f);
+            sum.normal += normal;
+            sum.area += area;
+        }
+        meshCentroid += sum.centroid;
+        meshArea += sum.area;
+    }
+    if(meshArea > 0.0f)
+    {
+        meshCentroid /= meshArea;
+    }
+
+    std::vector<float> keys(clusterCount);
+    for(size_t cluster = 0; cluster < clusterCount; cluster++)
+    {
+        const Cluster& sum = sums[cluster];
+        glm::vec3 centroid = sum.area > 0.0f ? sum.centroid / sum.area : glm::vec3(0.0f);
+        float normalLength = glm::length(sum.normal);
+        keys[cluster] = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, sum.normal / normalLength) : 0.0f;
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+    std::vector<Triangle> output;
+    output.reserve(triangles.size());
+    for(uint32_t cluster : order)
+    {
+        output.insert(output.end(), triangles.begin() + boundaries[cluster], triangles.begin() + boundaries[cluster + 1]);
+    }
+    triangles = std::move(output);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<Triangle>& triangles)
+{
+    std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+    uint32_t nextVertex = 0;
+    for(Triangle& triangle : triangles)
+    {
+        for(uint32_t* index : {&triangle.v0, &triangle.v1, &triangle.v2})
+        {
+            if(remap[*index] == INVALID_INDEX)
+            {
+                remap[*index] = nextVertex++;
+            }
+            *index = remap[*index];
+        }
+    }
+    for(uint32_t& index : remap)
+    {
+        if(index == INVALID_INDEX)
+        {
+            index = nextVertex++;
+        }
+    }
+
+    std::vector<Vertex> output(vertices.size());
+    for(size_t vertex = 0; vertex < vertices.size(); vertex++)
+    {
+        output[remap[vertex]] = vertices[vertex];
+    }
+    vertices = std::move(output);
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::analyzeVertexCache(const std::vector<Triangle>& triangles, size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if(triangles.empty() || vertexCount == 0)
+    {
+        return stats;
+    }
+
+    FifoCache cache(vertexCount, cacheSize);
+    size_t transformed = 0;
+    for(const Triangle& triangle : triangles)
+    {
+        transformed += cache.add(triangle);
+    }
+    stats.acmr = static_cast<float>(transformed) / static_cast<float>(triangles.size());
+    stats.atvr = static_cast<float>(transformed) / static_cast<float>(vertexCount);
+    return stats;
+}
+
+} // namespace core
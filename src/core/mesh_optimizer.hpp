@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "mesh.hpp"
+
+namespace core
+{
+    // Reorders triangles and vertices for the GPU, none of the passes change the rendered result
+    // Triangles are reordered with Tipsify (Sander et al. 2007) for the post-transform cache, the resulting clusters are then
+    // sorted so outward facing surfaces are drawn first, and finally vertices are renumbered in first use order for fetching
+    class MeshOptimizer
+    {
+        public:
+            struct VertexCacheStats
+            {
+                float acmr = 0.0f; // Transformed vertices per triangle, 0.5 is the optimum for large regular meshes, 3 the worst
+                float atvr = 0.0f; // Transformed vertices per vertex, 1 is the optimum
+            };
+
+            struct Stats
+            {
+                VertexCacheStats before{};
+                VertexCacheStats after{};
+                size_t clusters = 0;
+                double seconds = 0.0;
+            };
+
+            static constexpr uint32_t ANALYSIS_CACHE_SIZE = 32; // FIFO size used for reporting, close to current GPUs
+            static constexpr uint32_t TIPSIFY_CACHE_SIZE = 16;  // Tipsify targets a slightly smaller cache so it degrades gracefully
+            static constexpr float OVERDRAW_THRESHOLD = 1.05f;  // Allowed ACMR increase when splitting clusters for overdraw sorting
+
+            // Runs all passes below in order
+            static Stats optimize(std::vector<MeshData::Vertex>& vertices, std::vector<MeshData::Triangle>& triangles);
+
+            // Returns the first triangle of every cluster, clusters start wherever Tipsify had to jump to a non adjacent vertex
+            static std::vector<uint32_t> optimizeVertexCache(std::vector<MeshData::Triangle>& triangles, size_t vertexCount, uint32_t cacheSize = TIPSIFY_CACHE_SIZE);
+            // Splits the clusters further where it costs little cache efficiency and sorts them front to back from the mesh center
+            static void optimizeOverdraw(const std::vector<MeshData::Vertex>& vertices, std::vector<MeshData::Triangle>& triangles, const std::vector<uint32_t>& clusters, float threshold = OVERDRAW_THRESHOLD);
+            // Unreferenced vertices are kept and moved to the end
+            static void optimizeVertexFetch(std::vector<MeshData::Vertex>& vertices, std::vector<MeshData::Triangle>& triangles);
+
+            static VertexCacheStats analyzeVertexCache(const std::vector<MeshData::Triangle>& triangles, size_t vertexCount, uint32_t cacheSize = ANALYSIS_CACHE_SIZE);
+    };
+} // namespace core
@@ -0,0 +1,352 @@
+#include "mesh_processing.hpp"
+#include "mesh_processing_kernels.hpp"
+#include "utils/thread_pool.hpp"
+
+#include <cstddef>
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MESH_PROCESSING_X86
+#endif
+
+namespace core
+{
+static_assert(sizeof(MeshData::Triangle) == 3 * sizeof(uint32_t), "Kernels read triangles as a flat index array");
+static_assert(sizeof(MeshData::Vertex) % sizeof(float) == 0, "Kernels address vertices in floats");
+
+namespace
+{
+    using Vertex = MeshData::Vertex;
+    using Triangle = MeshData::Triangle;
+
+    constexpr size_t MIN_TRIANGLES_PER_RANGE = 16384;
+    constexpr size_t MIN_VERTICES_PER_RANGE = 16384;
+    constexpr size_t SERIAL_BLOCK_SIZE = 1024; // Triangles per block, small enough that the vertices it touches are still cached when scattering
+    constexpr uint32_t MIN_GATHER_THREADS = 4; // Below this the serial corner list build costs more than it saves
+    constexpr size_t VERTEX_STRIDE = sizeof(Vertex) / sizeof(float);
+
+    MeshProcessing::SimdLevel simdLevel = MeshProcessing::getSupportedSimdLevel();
+
+    // Computes a record of recordSize floats per triangle with computeFaces(begin, end, records), then for every vertex
+    // calls reset(vertex), addCorner(vertex, record, corner) for each corner referencing it in triangle order and finish(vertex)
+    // Serially triangles are handled in small blocks that are computed and then scattered while still in cache
+    // In parallel the records are computed for the whole mesh, then each vertex gathers its corners through a compressed
+    // vertex to corner list, which needs no atomics or per thread copies and adds in the same order as the serial path
+    template<class ComputeFaces, class Reset, class AddCorner, class Finish>
+    void accumulateFaces(size_t vertexCount, const std::vector<Triangle>& triangles, size_t recordSize, bool parallel,
+        const ComputeFaces& computeFaces, const Reset& reset, const AddCorner& addCorner, const Finish& finish)
+    {
+        const uint32_t* indices = &triangles[0].v0;
+        const size_t triangleCount = triangles.size();
+        const size_t cornerCount = triangleCount * 3;
+        ThreadPool& threadPool = ThreadPool::getGlobal();
+
+        if(!parallel || threadPool.getThreadCount() + 1 < MIN_GATHER_THREADS || triangleCount <= MIN_TRIANGLES_PER_RANGE)
+        {
+            for(size_t vertex = 0; vertex < vertexCount; vertex++)
+            {
+                reset(vertex);
+            }
+            std::vector<float> records(SERIAL_BLOCK_SIZE * recordSize);
+            for(size_t begin = 0; begin < triangleCount; begin += SERIAL_BLOCK_SIZE)
+            {
+                size_t end = std::min(begin + SERIAL_BLOCK_SIZE, triangleCount);
+                computeFaces(begin, end, records.data());
+                for(size_t triangle = begin; triangle < end; triangle++)
+                {
+                    const float* record = &records[(triangle - begin) * recordSize];
+                    addCorner(indices[triangle * 3 + 0], record, 0);
+                    addCorner(indices[triangle * 3 + 1], record, 1);
+                    addCorner(indices[triangle * 3 + 2], record, 2);
+                }
+            }
+            for(size_t vertex = 0; vertex < vertexCount; vertex++)
+            {
+                finish(vertex);
+            }
+            return;
+        }
+
+        std::vector<float> records(triangleCount * recordSize);
+        threadPool.parallelFor(triangleCount, MIN_TRIANGLES_PER_RANGE, [&](size_t begin, size_t end)
+        {
+            computeFaces(begin, end, &records[begin * recordSize]);
+        });
+
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for(size_t corner = 0; corner < cornerCount; corner++)
+        {
+            offsets[indices[corner] + 1]++;
+        }
+        for(size_t vertex = 0; vertex < vertexCount; vertex++)
+        {
+            offsets[vertex + 1] += offsets[vertex];
+        }
+        std::vector<uint32_t> corners(cornerCount);
+        {
+            std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+            for(size_t corner = 0; corner < cornerCount; corner++)
+            {
+                corners[cursors[indices[corner]]++] = static_cast<uint32_t>(corner);
+            }
+        }
+
+        threadPool.parallelFor(vertexCount, MIN_VERTICES_PER_RANGE, [&](size_t begin, size_t end)
+        {
+            for(size_t vertex = begin; vertex < end; vertex++)
+            {
+                reset(vertex);
+                for(uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; i++)
+                {
+                    addCorner(vertex, &records[corners[i] / 3 * recordSize], corners[i] % 3);
+                }
+                finish(vertex);
+            }
+        });
+    }
+
+    // Same as glm::normalize but returns zero instead of NaN for zero length vectors, branchless so loops stay vectorizable
+    glm::vec3 safeNormalize(const glm::vec3& vector)
+    {
+        return vector * glm::inversesqrt(glm::max(glm::dot(vector, vector), std::numeric_limits<float>::min()));
+    }
+
+    float angleBetween(glm::vec3 v1, glm::vec3 v2)
+    {
+        return glm::acos(glm::clamp(glm::dot(v1, v2) / (glm::length(v1) * glm::length(v2)), -1.0f + 1e-6f, 1.0f - 1e-6f));
+    }
+
+    void computeFaceNormalsScalar(const std::vector<Vertex>& vertices, const std::vector<Triangle>& triangles, size_t begin, size_t end, float* faces, bool angleWeighted)
+    {
+        const size_t recordSize = angleWeighted ? 6 : 3;
+        for(size_t i = begin; i < end; i++)
+        {
+            float* record = faces + (i - begin) * recordSize;
+            const glm::vec3& p0 = vertices[triangles[i].v0].position;
+            const glm::vec3& p1 = vertices[triangles[i].v1].position;
+            const glm::vec3& p2 = vertices[triangles[i].v2].position;
+
+            glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+            if(glm::length(cross) < 1e-6f)
+            {
+                // Degenerate triangle
+                std::fill(record, record + recordSize, 0.0f);
+                continue;
+            }
+
+            glm::vec3 normal = angleWeighted ? glm::normalize(cross) : cross;
+            record[0] = normal.x;
+            record[1] = normal.y;
+            record[2] = normal.z;
+            if(angleWeighted)
+            {
+                record[3] = angleBetween(p1 - p0, p2 - p0);
+                record[4] = angleBetween(p0 - p1, p2 - p1);
+                record[5] = angleBetween(p0 - p2, p1 - p2);
+            }
+        }
+    }
+
+    void computeFaceTangentsScalar(const std::vector<Vertex>& vertices, const std::vector<Triangle>& triangles, size_t begin, size_t end, float* faces)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            float* record = faces + (i - begin) * 6;
+            std::fill(record, record + 6, 0.0f);
+
+            const Vertex& v0 = vertices[triangles[i].v0];
+            const Vertex& v1 = vertices[triangles[i].v1];
+            const Vertex& v2 = vertices[triangles[i].v2];
+
+            glm::vec3 edge1 = v1.position - v0.position;
+            glm::vec3 edge2 = v2.position - v0.position;
+            if(glm::length(edge1) < 1e-6f || glm::length(edge2) < 1e-6f)
+                continue; // Degenerate triangle
+
+            glm::vec2 deltaUV1 = v1.texCoord - v0.texCoord;
+            glm::vec2 deltaUV2 = v2.texCoord - v0.texCoord;
+            float f = (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
+            if(glm::abs(f) < 1e-9f)
+                continue; // Degenerate UVs
+
+            glm::vec3 tangent = (deltaUV2.y * edge1 - deltaUV1.y * edge2) / f;
+            glm::vec3 bitangent = (-deltaUV2.x * edge1 + deltaUV1.x * edge2) / f;
+            record[0] = tangent.x;
+            record[1] = tangent.y;
+            record[2] = tangent.z;
+            record[3] = bitangent.x;
+            record[4] = bitangent.y;
+            record[5] = bitangent.z;
+        }
+    }
+} // namespace
+
+void MeshProcessing::computeBounds(const std::vector<MeshData::Vertex>& vertices, size_t begin, size_t end, glm::vec3& min, glm::vec3& max)
+{
+    // Bound by memory bandwidth, large meshes are split over the pool and the partial boxes merged
+    std::mutex mutex;
+    const SimdLevel level = simdLevel;
+    ThreadPool::getGlobal().parallelFor(end > begin ? end - begin : 0, MIN_VERTICES_PER_RANGE * 4, [&](size_t rangeBegin, size_t rangeEnd)
+    {
+        glm::vec3 rangeMin(std::numeric_limits<float>::max());
+        glm::vec3 rangeMax(std::numeric_limits<float>::lowest());
+#ifdef MESH_PROCESSING_X86
+        if(level != SimdLevel::SCALAR)
+        {
+            computeBoundsSse(&vertices[begin + rangeBegin].position.x, VERTEX_STRIDE, rangeEnd - rangeBegin, &rangeMin.x, &rangeMax.x);
+        }
+        else
+#endif
+        {
+            for(size_t i = begin + rangeBegin; i < begin + rangeEnd; i++)
+            {
+                rangeMin = glm::min(rangeMin, vertices[i].position);
+                rangeMax = glm::max(rangeMax, vertices[i].position);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        min = glm::min(min, rangeMin);
+        max = glm::max(max, rangeMax);
+    });
+}
+
+float MeshProcessing::computeMaxDistanceSquared(const std::vector<MeshData::Vertex>& vertices, size_t begin, size_t end, const glm::vec3& center)
+{
+    std::mutex mutex;
+    float result = 0.0f;
+    const SimdLevel level = simdLevel;
+    ThreadPool::getGlobal().parallelFor(end > begin ? end - begin : 0, MIN_VERTICES_PER_RANGE * 4, [&](size_t rangeBegin, size_t rangeEnd)
+    {
+        float rangeResult = 0.0f;
+#ifdef MESH_PROCESSING_X86
+        if(level != SimdLevel::SCALAR)
+        {
+            rangeResult = computeMaxDistanceSquaredSse(&vertices[begin + rangeBegin].position.x, VERTEX_STRIDE, rangeEnd - rangeBegin, &center.x);
+        }
+        else
+#endif
+        {
+            for(size_t i = begin + rangeBegin; i < begin + rangeEnd; i++)
+            {
+                glm::vec3 offset = vertices[i].position - center;
+                rangeResult = std::max(rangeResult, glm::dot(offset, offset));
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        result = std::max(result, rangeResult);
+    });
+    return result;
+}
+
+MeshProcessing::SimdLevel MeshProcessing::getSupportedSimdLevel()
+{
+#if defined(MESH_PROCESSING_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init(); // Required when called during static initialization
+    return __builtin_cpu_supports("avx2") ? SimdLevel::AVX2 : SimdLevel::SSE;
+#elif defined(MESH_PROCESSING_X86)
+    return SimdLevel::SSE;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+MeshProcessing::SimdLevel MeshProcessing::getSimdLevel()
+{
+    return simdLevel;
+}
+
+void MeshProcessing::setSimdLevel(SimdLevel level)
+{
+    SimdLevel supported = getSupportedSimdLevel();
+    simdLevel = static_cast<int>(level) > static_cast<int>(supported) ? supported : level;
+}
+
+const char* MeshProcessing::getSimdLevelName(SimdLevel level)
+{
+    switch(level)
+    {
+        case SimdLevel::SCALAR: return "Scalar";
+        case SimdLevel::SSE: return "SSE";
+        case SimdLevel::AVX2: return "AVX2";
+    }
+    return "Unknown";
+}
+
+void MeshProcessing::generateNormals(std::vector<MeshData::Vertex>& vertices, const std::vector<MeshData::Triangle>& triangles, NormalWeighting weighting, bool parallel)
+{
+    if(triangles.empty() || vertices.empty())
+    {
+        return;
+    }
+
+    // Area weighting keeps the unnormalized cross product, whose length is twice the area, and needs no corner angles
+    const bool angleWeighted = weighting == NormalWeighting::ANGLE;
+    const SimdLevel level = simdLevel;
+    const float* positions = &vertices[0].position.x;
+    const uint32_t* indices = &triangles[0].v0;
+
+    accumulateFaces(vertices.size(), triangles, angleWeighted ? 6 : 3, parallel,
+        [&](size_t begin, size_t end, float* faces)
+        {
+            switch(level)
+            {
+#ifdef MESH_PROCESSING_X86
+                case SimdLevel::AVX2: computeFaceNormalsAvx2(positions, VERTEX_STRIDE, indices, begin, end, faces, angleWeighted); break;
+                case SimdLevel::SSE: computeFaceNormalsSse(positions, VERTEX_STRIDE, indices, begin, end, faces, angleWeighted); break;
+#endif
+                default: computeFaceNormalsScalar(vertices, triangles, begin, end, faces, angleWeighted); break;
+            }
+        },
+        [&](size_t vertex) { vertices[vertex].normal = glm::vec3(0.0f); },
+        [&](size_t vertex, const float* face, size_t corner)
+        {
+            glm::vec3 normal(face[0], face[1], face[2]);
+            vertices[vertex].normal += angleWeighted ? normal * face[3 + corner] : normal;
+        },
+        [&](size_t vertex) { vertices[vertex].normal = safeNormalize(vertices[vertex].normal); });
+}
+
+void MeshProcessing::generateTangents(std::vector<MeshData::Vertex>& vertices, const std::vector<MeshData::Triangle>& triangles, bool parallel)
+{
+    if(triangles.empty() || vertices.empty())
+    {
+        return;
+    }
+
+    // Tangents need no transcendentals and are bound by gathering the vertices, SIMD kernels measured slower than scalar
+    // The sums are kept in the tangent and bitangent of each vertex until they are orthogonalized
+    accumulateFaces(vertices.size(), triangles, 6, parallel,
+        [&](size_t begin, size_t end, float* faces) { computeFaceTangentsScalar(vertices, triangles, begin, end, faces); },
+        [&](size_t vertex)
+        {
+            vertices[vertex].tangent = glm::vec4(0.0f);
+            vertices[vertex].bitangent = glm::vec3(0.0f);
+        },
+        [&](size_t vertex, const float* face, size_t)
+        {
+            vertices[vertex].tangent += glm::vec4(face[0], face[1], face[2], 0.0f);
+            vertices[vertex].bitangent += glm::vec3(face[3], face[4], face[5]);
+        },
+        [&](size_t index)
+        {
+            // Gram-Schmidt orthogonalize
+            Vertex& vertex = vertices[index];
+            glm::vec3 tangent = safeNormalize(glm::vec3(vertex.tangent));
+            glm::vec3 bitangent = safeNormalize(vertex.bitangent);
+            tangent = safeNormalize(tangent - vertex.normal * glm::dot(vertex.normal, tangent));
+            bitangent = safeNormalize(bitangent - vertex.normal * glm::dot(vertex.normal, bitangent));
+
+            // Calculate handedness
+            float handedness = 1.0f;
+            if(glm::dot(glm::cross(vertex.normal, tangent), bitangent) < 0.0f)
+            {
+                bitangent = bitangent * -1.0f;
+                handedness = -1.0f;
+            }
+            vertex.tangent = glm::vec4(tangent, handedness);
+            vertex.bitangent = bitangent;
+        });
+}
+} // namespace core
@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+
+#include "mesh.hpp"
+
+namespace core
+{
+    // Normal, tangent and bounds computation for indexed triangle meshes
+    // Per triangle terms are computed on the thread pool (SIMD kernels for normals), each vertex then sums the terms of
+    // its corners in triangle order so the result does not depend on the thread count
+    class MeshProcessing
+    {
+        public:
+            enum class SimdLevel
+            {
+                SCALAR = 0, // Exact acos, matches the original single threaded implementation
+                SSE = 1,
+                AVX2 = 2
+            };
+
+            static void generateNormals(std::vector<MeshData::Vertex>& vertices, const std::vector<MeshData::Triangle>& triangles, NormalWeighting weighting = NormalWeighting::ANGLE, bool parallel = true);
+            // Uses the normals already stored in the vertices
+            static void generateTangents(std::vector<MeshData::Vertex>& vertices, const std::vector<MeshData::Triangle>& triangles, bool parallel = true);
+
+            // Grows min and max to contain the positions of vertices [begin, end)
+            static void computeBounds(const std::vector<MeshData::Vertex>& vertices, size_t begin, size_t end, glm::vec3& min, glm::vec3& max);
+            // Largest squared distance from center to the positions of vertices [begin, end)
+            static float computeMaxDistanceSquared(const std::vector<MeshData::Vertex>& vertices, size_t begin, size_t end, const glm::vec3& center);
+
+            static SimdLevel getSupportedSimdLevel();
+            static SimdLevel getSimdLevel();
+            // Limits the instruction set used, mainly for benchmarks, levels the CPU doesn't support are clamped
+            static void setSimdLevel(SimdLevel level);
+            static const char* getSimdLevelName(SimdLevel level);
+    };
+} // namespace core
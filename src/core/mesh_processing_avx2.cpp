@@ -0,0 +1,39 @@
+// Built with -mavx2 (see CMakeLists.txt), only called after a runtime check for AVX2 support
+#include "mesh_processing_kernels.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace core
+{
+namespace
+{
+    struct Avx2Ops
+    {
+        using Vec = __m256;
+        static constexpr size_t WIDTH = 8;
+
+        static Vec load(const float* source) { return _mm256_load_ps(source); }
+        static void store(float* destination, Vec value) { _mm256_store_ps(destination, value); }
+        static Vec set(float value) { return _mm256_set1_ps(value); }
+        static Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+        static Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+        static Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+        static Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+        static Vec sqrt(Vec a) { return _mm256_sqrt_ps(a); }
+        static Vec min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+        static Vec max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+        static Vec abs(Vec a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+        static Vec lessThan(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static Vec greaterEqual(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+        static Vec mask(Vec condition, Vec value) { return _mm256_and_ps(condition, value); }
+        static Vec select(Vec condition, Vec a, Vec b) { return _mm256_blendv_ps(b, a, condition); }
+    };
+} // namespace
+
+void computeFaceNormalsAvx2(const float* positions, size_t stride, const uint32_t* indices, size_t begin, size_t end, float* faces, bool angleWeighted)
+{
+    kernels::computeFaceNormals<Avx2Ops>(positions, stride, indices, begin, end, faces, angleWeighted);
+}
+} // namespace core
+#endif
@@ -0,0 +1,127 @@
+#pragma once
+// SIMD kernels used by MeshProcessing
+// Each instruction set gets its own translation unit that instantiates the templates with its Ops, this header
+// must therefore stay free of anything but intrinsics so those units can be built with wider instruction sets
+#include <cstddef>
+#include <cstdint>
+
+namespace core
+{
+    // Positions are read from an array of vertices, stride is the vertex size in floats
+    // Results for triangles [begin, end) are written to faces starting at faces[0], one record per triangle
+    // Records are the normalized face normal followed by the three corner angles when angleWeighted, otherwise just the
+    // unnormalized face normal (area weighted)
+    void computeFaceNormalsSse(const float* positions, size_t stride, const uint32_t* indices, size_t begin, size_t end, float* faces, bool angleWeighted);
+    void computeFaceNormalsAvx2(const float* positions, size_t stride, const uint32_t* indices, size_t begin, size_t end, float* faces, bool angleWeighted);
+    // Bounds of count positions, min and max hold xyz and are only grown
+    // Each position is loaded as 4 floats, so the float after the last position must be readable
+    void computeBoundsSse(const float* positions, size_t stride, size_t count, float* min, float* max);
+    float computeMaxDistanceSquaredSse(const float* positions, size_t stride, size_t count, const float* center);
+
+    namespace kernels
+    {
+        // acos with an absolute error below 7e-5 radians, from Abramowitz and Stegun 4.4.45
+        template<class Ops>
+        inline typename Ops::Vec approximateAcos(typename Ops::Vec x)
+        {
+            using Vec = typename Ops::Vec;
+            Vec negative = Ops::lessThan(x, Ops::set(0.0f));
+            x = Ops::abs(x);
+            Vec result = Ops::set(-0.0187293f);
+            result = Ops::add(Ops::mul(result, x), Ops::set(0.0742610f));
+            result = Ops::add(Ops::mul(result, x), Ops::set(-0.2121144f));
+            result = Ops::add(Ops::mul(result, x), Ops::set(1.5707288f));
+            result = Ops::mul(result, Ops::sqrt(Ops::sub(Ops::set(1.0f), x)));
+            return Ops::select(negative, Ops::sub(Ops::set(3.14159265f), result), result);
+        }
+
+        // Angle between two edges given their dot product and squared lengths, clamped like the scalar version
+        template<class Ops>
+        inline typename Ops::Vec edgeAngle(typename Ops::Vec dot, typename Ops::Vec lengthSquared0, typename Ops::Vec lengthSquared1)
+        {
+            typename Ops::Vec cosine = Ops::div(dot, Ops::sqrt(Ops::mul(lengthSquared0, lengthSquared1)));
+            cosine = Ops::min(Ops::max(cosine, Ops::set(-1.0f + 1e-6f)), Ops::set(1.0f - 1e-6f));
+            return approximateAcos<Ops>(cosine);
+        }
+
+        // Gathers one attribute of the three corners of WIDTH triangles into structure of arrays form
+        // Lanes past the end repeat the last triangle so every lane holds valid data
+        template<size_t WIDTH, size_t COMPONENTS>
+        inline void gatherCorners(const float* attributes, size_t stride, const uint32_t* indices, size_t first, size_t count, float (&lanes)[3 * COMPONENTS][WIDTH])
+        {
+            for(size_t lane = 0; lane < WIDTH; lane++)
+            {
+                size_t triangle = first + (lane < count ? lane : count - 1);
+                for(size_t corner = 0; corner < 3; corner++)
+                {
+                    const float* attribute = attributes + indices[triangle * 3 + corner] * stride;
+                    for(size_t component = 0; component < COMPONENTS; component++)
+                    {
+                        lanes[corner * COMPONENTS + component][lane] = attribute[component];
+                    }
+                }
+            }
+        }
+
+        template<class Ops>
+        void computeFaceNormals(const float* positions, size_t stride, const uint32_t* indices, size_t begin, size_t end, float* faces, bool angleWeighted)
+        {
+            using Vec = typename Ops::Vec;
+            constexpr size_t WIDTH = Ops::WIDTH;
+            alignas(32) float lanes[9][WIDTH];
+            alignas(32) float results[6][WIDTH];
+
+            for(size_t first = begin; first < end; first += WIDTH)
+            {
+                size_t count = end - first < WIDTH ? end - first : WIDTH;
+                gatherCorners<WIDTH, 3>(positions, stride, indices, first, count, lanes);
+
+                Vec ax = Ops::load(lanes[0]), ay = Ops::load(lanes[1]), az = Ops::load(lanes[2]);
+                Vec bx = Ops::load(lanes[3]), by = Ops::load(lanes[4]), bz = Ops::load(lanes[5]);
+                Vec cx = Ops::load(lanes[6]), cy = Ops::load(lanes[7]), cz = Ops::load(lanes[8]);
+
+                Vec e01x = Ops::sub(bx, ax), e01y = Ops::sub(by, ay), e01z = Ops::sub(bz, az);
+                Vec e02x = Ops::sub(cx, ax), e02y = Ops::sub(cy, ay), e02z = Ops::sub(cz, az);
+
+                Vec nx = Ops::sub(Ops::mul(e01y, e02z), Ops::mul(e01z, e02y));
+                Vec ny = Ops::sub(Ops::mul(e01z, e02x), Ops::mul(e01x, e02z));
+                Vec nz = Ops::sub(Ops::mul(e01x, e02y), Ops::mul(e01y, e02x));
+                Vec length = Ops::sqrt(Ops::add(Ops::add(Ops::mul(nx, nx), Ops::mul(ny, ny)), Ops::mul(nz, nz)));
+                Vec valid = Ops::greaterEqual(length, Ops::set(1e-6f)); // Degenerate triangles contribute nothing
+
+                if(angleWeighted)
+                {
+                    Vec inverseLength = Ops::div(Ops::set(1.0f), length);
+                    nx = Ops::mul(nx, inverseLength);
+                    ny = Ops::mul(ny, inverseLength);
+                    nz = Ops::mul(nz, inverseLength);
+
+                    Vec e12x = Ops::sub(cx, bx), e12y = Ops::sub(cy, by), e12z = Ops::sub(cz, bz);
+                    Vec length01 = Ops::add(Ops::add(Ops::mul(e01x, e01x), Ops::mul(e01y, e01y)), Ops::mul(e01z, e01z));
+                    Vec length02 = Ops::add(Ops::add(Ops::mul(e02x, e02x), Ops::mul(e02y, e02y)), Ops::mul(e02z, e02z));
+                    Vec length12 = Ops::add(Ops::add(Ops::mul(e12x, e12x), Ops::mul(e12y, e12y)), Ops::mul(e12z, e12z));
+                    Vec dot0 = Ops::add(Ops::add(Ops::mul(e01x, e02x), Ops::mul(e01y, e02y)), Ops::mul(e01z, e02z));
+                    Vec dot1 = Ops::sub(Ops::set(0.0f), Ops::add(Ops::add(Ops::mul(e01x, e12x), Ops::mul(e01y, e12y)), Ops::mul(e01z, e12z)));
+                    Vec dot2 = Ops::add(Ops::add(Ops::mul(e02x, e12x), Ops::mul(e02y, e12y)), Ops::mul(e02z, e12z));
+
+                    Ops::store(results[3], Ops::mask(valid, edgeAngle<Ops>(dot0, length01, length02)));
+                    Ops::store(results[4], Ops::mask(valid, edgeAngle<Ops>(dot1, length01, length12)));
+                    Ops::store(results[5], Ops::mask(valid, edgeAngle<Ops>(dot2, length02, length12)));
+                }
+                Ops::store(results[0], Ops::mask(valid, nx));
+                Ops::store(results[1], Ops::mask(valid, ny));
+                Ops::store(results[2], Ops::mask(valid, nz));
+
+                const size_t recordSize = angleWeighted ? 6 : 3;
+                for(size_t lane = 0; lane < count; lane++)
+                {
+                    float* record = faces + (first - begin + lane) * recordSize;
+                    for(size_t component = 0; component < recordSize; component++)
+                    {
+                        record[component] = results[component][lane];
+                    }
+                }
+            }
+        }
+    } // namespace kernels
+} // namespace core
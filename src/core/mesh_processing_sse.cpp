@@ -0,0 +1,110 @@
+#include "mesh_processing_kernels.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+
+namespace core
+{
+namespace
+{
+    // SSE2 is part of the x86-64 baseline so this path needs no runtime check
+    struct SseOps
+    {
+        using Vec = __m128;
+        static constexpr size_t WIDTH = 4;
+
+        static Vec load(const float* source) { return _mm_load_ps(source); }
+        static void store(float* destination, Vec value) { _mm_store_ps(destination, value); }
+        static Vec set(float value) { return _mm_set1_ps(value); }
+        static Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+        static Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+        static Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+        static Vec div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+        static Vec sqrt(Vec a) { return _mm_sqrt_ps(a); }
+        static Vec min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+        static Vec max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+        static Vec abs(Vec a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        static Vec lessThan(Vec a, Vec b) { return _mm_cmplt_ps(a, b); }
+        static Vec greaterEqual(Vec a, Vec b) { return _mm_cmpge_ps(a, b); }
+        static Vec mask(Vec condition, Vec value) { return _mm_and_ps(condition, value); } // Also clears NaNs from masked lanes
+        static Vec select(Vec condition, Vec a, Vec b) { return _mm_or_ps(_mm_and_ps(condition, a), _mm_andnot_ps(condition, b)); }
+    };
+} // namespace
+
+void computeFaceNormalsSse(const float* positions, size_t stride, const uint32_t* indices, size_t begin, size_t end, float* faces, bool angleWeighted)
+{
+    kernels::computeFaceNormals<SseOps>(positions, stride, indices, begin, end, faces, angleWeighted);
+}
+
+void computeBoundsSse(const float* positions, size_t stride, size_t count, float* min, float* max)
+{
+    // The fourth lane holds whatever follows the position and is dropped at the end
+    __m128 boundsMin = _mm_set_ps(0.0f, min[2], min[1], min[0]);
+    __m128 boundsMax = _mm_set_ps(0.0f, max[2], max[1], max[0]);
+    __m128 otherMin = boundsMin;
+    __m128 otherMax = boundsMax;
+    size_t i = 0;
+    for(; i + 2 <= count; i += 2) // Two chains so consecutive min and max do not wait on each other
+    {
+        __m128 position0 = _mm_loadu_ps(positions + i * stride);
+        __m128 position1 = _mm_loadu_ps(positions + (i + 1) * stride);
+        boundsMin = _mm_min_ps(boundsMin, position0);
+        boundsMax = _mm_max_ps(boundsMax, position0);
+        otherMin = _mm_min_ps(otherMin, position1);
+        otherMax = _mm_max_ps(otherMax, position1);
+    }
+    if(i < count)
+    {
+        __m128 position = _mm_loadu_ps(positions + i * stride);
+        boundsMin = _mm_min_ps(boundsMin, position);
+        boundsMax = _mm_max_ps(boundsMax, position);
+    }
+    alignas(16) float result[2][4];
+    _mm_store_ps(result[0], _mm_min_ps(boundsMin, otherMin));
+    _mm_store_ps(result[1], _mm_max_ps(boundsMax, otherMax));
+    for(size_t component = 0; component < 3; component++)
+    {
+        min[component] = result[0][component];
+        max[component] = result[1][component];
+    }
+}
+
+float computeMaxDistanceSquaredSse(const float* positions, size_t stride, size_t count, const float* center)
+{
+    // Four positions are transposed into x, y and z vectors so each lane holds the distance of one of them
+    const __m128 centerX = _mm_set1_ps(center[0]);
+    const __m128 centerY = _mm_set1_ps(center[1]);
+    const __m128 centerZ = _mm_set1_ps(center[2]);
+    __m128 maxDistance = _mm_setzero_ps();
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(positions + i * stride);
+        __m128 y = _mm_loadu_ps(positions + (i + 1) * stride);
+        __m128 z = _mm_loadu_ps(positions + (i + 2) * stride);
+        __m128 w = _mm_loadu_ps(positions + (i + 3) * stride);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        x = _mm_sub_ps(x, centerX);
+        y = _mm_sub_ps(y, centerY);
+        z = _mm_sub_ps(z, centerZ);
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        maxDistance = _mm_max_ps(maxDistance, distance);
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, maxDistance);
+    float result = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    result = result > lanes[2] ? result : lanes[2];
+    result = result > lanes[3] ? result : lanes[3];
+    for(; i < count; i++)
+    {
+        const float* position = positions + i * stride;
+        float x = position[0] - center[0];
+        float y = position[1] - center[1];
+        float z = position[2] - center[2];
+        float distance = x * x + y * y + z * z;
+        result = result > distance ? result : distance;
+    }
+    return result;
+}
+} // namespace core
+#endif
@@ -0,0 +1,452 @@
+#include "mesh_simplifier.hpp"
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace core
+{
+namespace
+{
+    using Vertex = MeshData::Vertex;
+    using Triangle = MeshData::Triangle;
+
+    constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+    constexpr double PASS_ERROR_BOUND = 1.5;
+
+    enum class VertexKind : uint8_t
+    {
+        MANIFOLD = 0, // Interior vertex with a single set of attributes, collapses anywhere
+        BORDER = 1,   // On one open border, collapses along it
+        SEAM = 2,     // Two attribute sets split along one seam, collapses along it moving both sides
+        LOCKED = 3    // Corners, border seams and non-manifold vertices never move
+    };
+
+    // Symmetric plane quadric, error(p) = p^T A p + 2 b^T p + c, stored with the summed weight so errors can be normalized
+    struct Quadric
+    {
+        double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double weight = 0;
+
+        static Quadric fromPlane(glm::dvec3 normal, double distance, double weight)
+        {
+            Quadric quadric;
+            quadric.a00 = weight * normal.x * normal.x;
+            quadric.a11 = weight * normal.y * normal.y;
+            quadric.a22 = weight * normal.z * normal.z;
+            quadric.a01 = weight * normal.x * normal.y;
+            quadric.a02 = weight * normal.x * normal.z;
+            quadric.a12 = weight * normal.y * normal.z;
+            quadric.b0 = weight * normal.x * distance;
+            quadric.b1 = weight * normal.y * distance;
+            quadric.b2 = weight * normal.z * distance;
+            quadric.c = weight * distance * distance;
+            quadric.weight = weight;
+            return quadric;
+        }
+
+        Quadric& operator+=(const Quadric& other)
+        {
+            a00 += other.a00; a11 += other.a11; a22 += other.a22;
+            a01 += other.a01; a02 += other.a02; a12 += other.a12;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+            return *this;
+        }
+
+        // Weighted mean squared distance of p to the planes
+        double evaluate(glm::dvec3 p) const
+        {
+            double rx = a00 * p.x + a01 * p.y + a02 * p.z + 2.0 * b0;
+            double ry = a01 * p.x + a11 * p.y + a12 * p.z + 2.0 * b1;
+            double rz = a02 * p.x + a12 * p.y + a22 * p.z + 2.0 * b2;
+            double error = rx * p.x + ry * p.y + rz * p.z + c;
+            return weight > 0.0 ? std::abs(error) / weight : 0.0;
+        }
+    };
+
+    struct Collapse
+    {
+        double error;
+        uint32_t from;
+        uint32_t to;
+    };
+
+    // Compressed lists of items per vertex, the items of v are items[offsets[v], offsets[v + 1])
+    struct Adjacency
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> items;
+
+        // keyOf(corner) picks the vertex a corner is listed under, itemOf(corner) what is stored for it
+        template<class KeyOf, class ItemOf>
+        void build(size_t vertexCount, size_t cornerCount, const KeyOf& keyOf, const ItemOf& itemOf)
+        {
+            offsets.assign(vertexCount + 1, 0);
+            items.resize(cornerCount);
+            for(size_t corner = 0; corner < cornerCount; corner++)
+            {
+                offsets[keyOf(corner) + 1]++;
+            }
+            std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+            std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+            for(size_t corner = 0; corner < cornerCount; corner++)
+            {
+                items[cursors[keyOf(corner)]++] = itemOf(corner);
+            }
+        }
+
+        bool contains(uint32_t vertex, uint32_t item) const
+        {
+            for(uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; i++)
+            {
+                if(items[i] == item) return true;
+            }
+            return false;
+        }
+    };
+
+    uint32_t nextCorner(size_t corner) { return static_cast<uint32_t>(corner - corner % 3 + (corner + 1) % 3); }
+
+    // Maps every vertex to the first referenced vertex sharing its position
+    std::vector<uint32_t> buildPositionRemap(const std::vector<Vertex>& vertices, const std::vector<bool>& referenced)
+    {
+        std::vector<uint32_t> order(vertices.size());
+        std::iota(order.begin(), order.end(), 0u);
+        auto less = [&](uint32_t a, uint32_t b)
+        {
+            const glm::vec3& pa = vertices[a].position;
+            const glm::vec3& pb = vertices[b].position;
+            if(pa.x != pb.x) return pa.x < pb.x;
+            if(pa.y != pb.y) return pa.y < pb.y;
+            if(pa.z != pb.z) return pa.z < pb.z;
+            if(referenced[a] != referenced[b]) return static_cast<bool>(referenced[a]);
+            return a < b;
+        };
+        std::sort(order.begin(), order.end(), less);
+
+        std::vector<uint32_t> remap(vertices.size());
+        for(size_t i = 0; i < order.size(); i++)
+        {
+            bool same = i > 0 && vertices[order[i]].position == vertices[order[i - 1]].position;
+            remap[order[i]] = same ? remap[order[i - 1]] : order[i];
+        }
+        return remap;
+    }
+
+    glm::dvec3 toDouble(const glm::vec3& v) { return glm::dvec3(v.x, v.y, v.z); }
+} // namespace
+
+std::vector<Triangle> MeshSimplifier::simplify(const std::vector<Vertex>& vertices, const std::vector<Triangle>& triangles, size_t targetTriangleCount, float* error)
+{
+    if(error != nullptr) *error = 0.0f;
+    if(triangles.size() <= targetTriangleCount || vertices.empty())
+    {
+        return triangles;
+    }
+
+    const size_t vertexCount = vertices.size();
+    std::vector<uint32_t> indices(&triangles[0].v0, &triangles[0].v0 + triangles.size() * 3);
+    std::vector<bool> referenced(vertexCount, false);
+    for(uint32_t index : indices)
+    {
+        referenced[index] = true;
+    }
+    const std::vector<uint32_t> position = buildPositionRemap(vertices, referenced);
+
+    // Wedges are the referenced vertices sharing one position, linked in a ring through nextWedge
+    std::vector<uint32_t> nextWedge(vertexCount);
+    std::vector<uint32_t> wedgeCount(vertexCount, 0);
+    std::iota(nextWedge.begin(), nextWedge.end(), 0u);
+    for(uint32_t vertex = 0; vertex < vertexCount; vertex++)
+    {
+        if(!referenced[vertex]) continue;
+        wedgeCount[position[vertex]]++;
+        if(position[vertex] != vertex)
+        {
+            std::swap(nextWedge[vertex], nextWedge[position[vertex]]);
+        }
+    }
+
+    // An edge is open if its reverse does not exist, open edges by position are borders while edges that are only open
+    // by index are seams
+    Adjacency edges;         // Outgoing edges by vertex
+    Adjacency positionEdges; // Outgoing edges by position
+    auto buildEdges = [&]()
+    {
+        const size_t cornerCount = indices.size();
+        edges.build(vertexCount, cornerCount, [&](size_t c) { return indices[c]; }, [&](size_t c) { return indices[nextCorner(c)]; });
+        positionEdges.build(vertexCount, cornerCount, [&](size_t c) { return position[indices[c]]; }, [&](size_t c) { return position[indices[nextCorner(c)]]; });
+    };
+    auto isBorder = [&](uint32_t a, uint32_t b) { return !positionEdges.contains(position[b], position[a]); };
+    auto isSeam = [&](uint32_t a, uint32_t b) { return !edges.contains(b, a) && !isBorder(a, b); };
+    buildEdges();
+
+    std::vector<VertexKind> kinds(vertexCount, VertexKind::MANIFOLD);
+    {
+        std::vector<uint32_t> borderOut(vertexCount, 0), borderIn(vertexCount, 0), seamOut(vertexCount, 0), seamIn(vertexCount, 0);
+        for(size_t corner = 0; corner < indices.size(); corner++)
+        {
+            uint32_t a = indices[corner], b = indices[nextCorner(corner)];
+            if(isBorder(a, b))
+            {
+                borderOut[position[a]]++;
+                borderIn[position[b]]++;
+            }
+            else if(isSeam(a, b))
+            {
+                seamOut[a]++;
+                seamIn[b]++;
+            }
+        }
+        for(uint32_t vertex = 0; vertex < vertexCount; vertex++)
+        {
+            uint32_t p = position[vertex];
+            if(wedgeCount[p] == 1)
+            {
+                if(borderOut[p] == 0 && borderIn[p] == 0) kinds[vertex] = VertexKind::MANIFOLD;
+                else if(borderOut[p] == 1 && borderIn[p] == 1) kinds[vertex] = VertexKind::BORDER;
+                else kinds[vertex] = VertexKind::LOCKED;
+            }
+            else if(wedgeCount[p] == 2 && borderOut[p] == 0 && borderIn[p] == 0 && seamOut[vertex] == 1 && seamIn[vertex] == 1
+                && seamOut[nextWedge[vertex]] == 1 && seamIn[nextWedge[vertex]] == 1)
+            {
+                kinds[vertex] = VertexKind::SEAM;
+            }
+            else
+            {
+                kinds[vertex] = VertexKind::LOCKED;
+            }
+        }
+    }
+
+    // Quadrics are kept per position, borders and seams add planes perpendicular to their faces to hold them in place
+    std::vector<Quadric> quadrics(vertexCount);
+    for(size_t triangle = 0; triangle < triangles.size(); triangle++)
+    {
+        glm::dvec3 p0 = toDouble(vertices[indices[triangle * 3 + 0]].position);
+        glm::dvec3 p1 = toDouble(vertices[indices[triangle * 3 + 1]].position);
+        glm::dvec3 p2 = toDouble(vertices[indices[triangle * 3 + 2]].position);
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        double area = glm::length(normal);
+        if(area <= 0.0) continue;
+        normal /= area;
+
+        Quadric quadric = Quadric::fromPlane(normal, -glm::dot(normal, p0), area);
+        for(size_t corner = 0; corner < 3; corner++)
+        {
+            quadrics[position[indices[triangle * 3 + corner]]] += quadric;
+        }
+
+        for(size_t corner = triangle * 3; corner < triangle * 3 + 3; corner++)
+        {
+            uint32_t a = indices[corner], b = indices[nextCorner(corner)];
+            if(!isBorder(a, b) && !isSeam(a, b)) continue;
+
+            glm::dvec3 pa = toDouble(vertices[a].position);
+            glm::dvec3 edge = toDouble(vertices[b].position) - pa;
+            double length = glm::length(edge);
+            glm::dvec3 edgeNormal = glm::cross(edge, normal);
+            if(length <= 0.0) continue;
+            edgeNormal /= glm::length(edgeNormal);
+
+            Quadric edgeQuadric = Quadric::fromPlane(edgeNormal, -glm::dot(edgeNormal, pa), length * length * BORDER_WEIGHT);
+            quadrics[position[a]] += edgeQuadric;
+            quadrics[position[b]] += edgeQuadric;
+        }
+    }
+
+    // Half of the bounding box diagonal, errors are reported relative to it
+    glm::vec3 boundsMin(std::numeric_limits<float>::max()), boundsMax(std::numeric_limits<float>::lowest());
+    for(const Vertex& vertex : vertices)
+    {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+    const double radius = std::max(0.5 * glm::length(toDouble(boundsMax - boundsMin)), 1e-12);
+
+    Adjacency vertexTriangles; // Triangles by position
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> locked(vertexCount);
+    double maxError = 0.0;
+    size_t triangleCount = triangles.size();
+
+    // Every pass collapses the cheapest edges whose neighbourhoods do not overlap, then rewrites the triangles
+    while(triangleCount > targetTriangleCount)
+    {
+        vertexTriangles.build(vertexCount, indices.size(), [&](size_t c) { return position[indices[c]]; }, [&](size_t c) { return static_cast<uint32_t>(c / 3); });
+
+        // One candidate per edge in its cheaper allowed direction, edges shared by two triangles are seen from the lower index
+        collapses.clear();
+        for(size_t corner = 0; corner < indices.size(); corner++)
+        {
+            uint32_t a = indices[corner], b = indices[nextCorner(corner)];
+            const bool hasTwin = edges.contains(b, a);
+            if(a > b && hasTwin) continue;
+            const bool border = !hasTwin && isBorder(a, b);
+            const bool seam = !hasTwin && !border;
+
+            Collapse best{std::numeric_limits<double>::max(), INVALID_INDEX, INVALID_INDEX};
+            for(int direction = 0; direction < 2; direction++)
+            {
+                uint32_t from = direction == 0 ? a : b;
+                uint32_t to = direction == 0 ? b : a;
+                VertexKind fromKind = kinds[from];
+                VertexKind toKind = kinds[to];
+                bool allowed = fromKind == VertexKind::MANIFOLD
+                    || (fromKind == VertexKind::BORDER && border && (toKind == VertexKind::BORDER || toKind == VertexKind::LOCKED))
+                    || (fromKind == VertexKind::SEAM && seam && (toKind == VertexKind::SEAM || toKind == VertexKind::LOCKED));
+                double collapseError = allowed ? quadrics[position[from]].evaluate(toDouble(vertices[to].position)) : best.error;
+                if(collapseError < best.error)
+                {
+                    best = {collapseError, from, to};
+                }
+            }
+            if(best.from != INVALID_INDEX)
+            {
+                collapses.push_back(best);
+            }
+        }
+        if(collapses.empty()) break;
+
+        // Locked neighbourhoods push the pass past the cheapest collapses, stop before the error grows too quickly and
+        // retry the skipped collapses in the next pass instead, only the candidates below that bound need sorting
+        auto byError = [](const Collapse& a, const Collapse& b) { return a.error < b.error; };
+        const size_t goal = triangleCount - targetTriangleCount;
+        auto goalCollapse = collapses.begin() + std::min(goal / 2, collapses.size() - 1);
+        std::nth_element(collapses.begin(), goalCollapse, collapses.end(), byError);
+        const double errorCutoff = goalCollapse->error * PASS_ERROR_BOUND;
+        auto candidatesEnd = std::partition(collapses.begin(), collapses.end(), [&](const Collapse& collapse) { return collapse.error <= errorCutoff; });
+        std::sort(collapses.begin(), candidatesEnd, byError);
+
+        std::iota(remap.begin(), remap.end(), 0u);
+        std::fill(locked.begin(), locked.end(), false);
+        size_t removed = 0;
+        for(auto candidate = collapses.begin(); candidate != candidatesEnd && removed < goal; candidate++)
+        {
+            const Collapse& collapse = *candidate;
+            const uint32_t fromPosition = position[collapse.from];
+            const uint32_t toPosition = position[collapse.to];
+            if(locked[fromPosition] || locked[toPosition]) continue;
+
+            // Reject collapses that flip a triangle, the other wedge of a seam follows the seam edge on its side
+            glm::dvec3 target = toDouble(vertices[collapse.to].position);
+            uint32_t otherWedge = INVALID_INDEX, otherTarget = INVALID_INDEX;
+            if(kinds[collapse.from] == VertexKind::SEAM)
+            {
+                otherWedge = nextWedge[collapse.from];
+            }
+            bool valid = true;
+            for(uint32_t i = vertexTriangles.offsets[fromPosition]; i < vertexTriangles.offsets[fromPosition + 1] && valid; i++)
+            {
+                const uint32_t* triangle = &indices[vertexTriangles.items[i] * 3];
+                bool hasTarget = false;
+                bool usesOtherWedge = false;
+                glm::dvec3 corners[3], moved[3];
+                for(size_t corner = 0; corner < 3; corner++)
+                {
+                    corners[corner] = moved[corner] = toDouble(vertices[triangle[corner]].position);
+                    hasTarget |= position[triangle[corner]] == toPosition;
+                    usesOtherWedge |= triangle[corner] == otherWedge;
+                    if(position[triangle[corner]] == fromPosition)
+                    {
+                        moved[corner] = target;
+                    }
+                }
+                if(usesOtherWedge && hasTarget)
+                {
+                    for(size_t corner = 0; corner < 3; corner++)
+                    {
+                        if(position[triangle[corner]] == toPosition) otherTarget = triangle[corner];
+                    }
+                }
+                if(hasTarget) continue; // Becomes degenerate and is removed
+
+                glm::dvec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                glm::dvec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+                valid = glm::dot(before, after) > 0.0;
+            }
+            if(!valid || (otherWedge != INVALID_INDEX && otherTarget == INVALID_INDEX)) continue;
+
+            remap[collapse.from] = collapse.to;
+            if(otherWedge != INVALID_INDEX)
+            {
+                remap[otherWedge] = otherTarget;
+            }
+            quadrics[toPosition] += quadrics[fromPosition];
+            maxError = std::max(maxError, collapse.error);
+            removed += kinds[collapse.from] == VertexKind::BORDER ? 1 : 2;
+
+            // Neighbours keep their position for the rest of the pass so the flip checks above stay valid
+            for(uint32_t i = vertexTriangles.offsets[fromPosition]; i < vertexTriangles.offsets[fromPosition + 1]; i++)
+            {
+                const uint32_t* triangle = &indices[vertexTriangles.items[i] * 3];
+                locked[position[triangle[0]]] = locked[position[triangle[1]]] = locked[position[triangle[2]]] = true;
+            }
+        }
+        if(removed == 0) break;
+
+        // Collapsed triangles end up with two corners at one position and are dropped
+        size_t written = 0;
+        for(size_t triangle = 0; triangle < triangleCount; triangle++)
+        {
+            uint32_t v0 = remap[indices[triangle * 3 + 0]];
+            uint32_t v1 = remap[indices[triangle * 3 + 1]];
+            uint32_t v2 = remap[indices[triangle * 3 + 2]];
+            if(position[v0] == position[v1] || position[v1] == position[v2] || position[v0] == position[v2]) continue;
+            indices[written * 3 + 0] = v0;
+            indices[written * 3 + 1] = v1;
+            indices[written * 3 + 2] = v2;
+            written++;
+        }
+        if(written == triangleCount) break;
+        triangleCount = written;
+        indices.resize(triangleCount * 3);
+        buildEdges();
+    }
+
+    if(error != nullptr) *error = static_cast<float>(std::sqrt(maxError) / radius);
+
+    std::vector<Triangle> result(triangleCount);
+    for(size_t triangle = 0; triangle < triangleCount; triangle++)
+    {
+        result[triangle] = {indices[triangle * 3 + 0], indices[triangle * 3 + 1], indices[triangle * 3 + 2]};
+    }
+    return result;
+}
+
+std::vector<MeshData::Lod> MeshSimplifier::generateLods(const std::vector<Vertex>& vertices, const std::vector<Triangle>& triangles, const std::vector<float>& ratios)
+{
+    std::vector<MeshData::Lod> lods;
+    const std::vector<Triangle>* previous = &triangles;
+    float previousError = 0.0f;
+    for(float ratio : ratios)
+    {
+        if(lods.size() >= MAX_LODS) break;
+
+        size_t target = static_cast<size_t>(static_cast<double>(triangles.size()) * ratio);
+        MeshData::Lod lod;
+        float error = 0.0f;
+        lod.triangles = simplify(vertices, *previous, target, &error);
+        if(lod.triangles.empty() || static_cast<float>(lod.triangles.size()) > static_cast<float>(previous->size()) * (1.0f - MIN_LOD_REDUCTION))
+        {
+            break;
+        }
+
+        // Errors of successive levels add up in the worst case
+        lod.error = previousError + error;
+        previousError = lod.error;
+        MeshOptimizer::optimizeVertexCache(lod.triangles, vertices.size());
+        lods.push_back(std::move(lod));
+        previous = &lods.back().triangles;
+    }
+    return lods;
+}
+
+} // namespace core
@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "mesh.hpp"
+
+namespace core
+{
+    // Quadric error edge collapse simplification (Garland and Heckbert 1997) that only rewrites the triangles
+    // Every collapse moves a vertex onto one of its neighbours, so all levels of detail index the original vertices
+    // Vertices sharing a position but not their attributes form UV or normal seams, seams and open borders only
+    // collapse along themselves so they keep their shape, anything more complex is locked
+    class MeshSimplifier
+    {
+        public:
+            static constexpr float BORDER_WEIGHT = 10.0f;     // Quadric weight of borders and seams relative to surfaces
+            static constexpr float MIN_LOD_REDUCTION = 0.1f;  // A level must remove at least this fraction of triangles
+            static constexpr size_t MAX_LODS = 7;             // Not counting the full mesh, the draw sort key holds 3 bits
+
+            // error receives the largest deviation from the input relative to half its bounding box diagonal
+            static std::vector<MeshData::Triangle> simplify(const std::vector<MeshData::Vertex>& vertices, const std::vector<MeshData::Triangle>& triangles,
+                size_t targetTriangleCount, float* error = nullptr);
+
+            // Each level is simplified from the previous one and optimized for the vertex cache
+            // Stops early once a level no longer reduces the triangle count by MIN_LOD_REDUCTION
+            static std::vector<MeshData::Lod> generateLods(const std::vector<MeshData::Vertex>& vertices, const std::vector<MeshData::Triangle>& triangles,
+                const std::vector<float>& ratios);
+    };
+} // namespace core
@@ -0,0 +1,288 @@
+#include "meshlet_builder.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace core
+{
+using Vertex = MeshData::Vertex;
+using Triangle = MeshData::Triangle;
+
+namespace
+{
+    constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+    // Favours triangles whose vertices have few triangles left, so meshlets do not leave small islands behind
+    constexpr float LIVE_TRIANGLE_WEIGHT = 0.2f;
+}
+
+std::vector<Meshlet> MeshletBuilder::build(const std::vector<Vertex>& vertices, std::vector<Triangle>& triangles, uint32_t maxVertices, uint32_t maxTriangles)
+{
+    std::vector<Meshlet> meshlets;
+    if(triangles.empty())
+    {
+        return meshlets;
+    }
+    meshlets.reserve(triangles.size() / maxTriangles + 1);
+
+    // Compressed vertex to triangle lists, the triangles of vertex v are adjacentTriangles[offsets[v], offsets[v + 1])
+    std::vector<uint32_t> offsets(vertices.size() + 1, 0);
+    std::vector<uint32_t> adjacentTriangles(triangles.size() * 3);
+    const uint32_t* indices = &triangles[0].v0;
+    for(size_t corner = 0; corner < triangles.size() * 3; corner++)
+    {
+        offsets[indices[corner] + 1]++;
+    }
+    for(size_t vertex = 0; vertex < vertices.size(); vertex++)
+    {
+        offsets[vertex + 1] += offsets[vertex];
+    }
+    std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+    for(size_t corner = 0; corner < triangles.size() * 3; corner++)
+    {
+        adjacentTriangles[cursors[indices[corner]]++] = static_cast<uint32_t>(corner / 3);
+    }
+
+    struct TriangleInfo
+    {
+        glm::vec3 centroid;
+        glm::vec3 normal; // Unit length, zero for degenerate triangles
+        float area;
+    };
+    std::vector<TriangleInfo> infos(triangles.size());
+    for(size_t triangle = 0; triangle < triangles.size(); triangle++)
+    {
+        const glm::vec3& p0 = vertices[triangles[triangle].v0].position;
+        const glm::vec3& p1 = vertices[triangles[triangle].v1].position;
+        const glm::vec3& p2 = vertices[triangles[triangle].v2].position;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(normal);
+        infos[triangle] = {(p0 + p1 + p2) / 3.0f, length > 0.0f ? normal / length : glm::vec3(0.0f), length * 0.5f};
+    }
+
+    // A vertex belongs to the current meshlet and a triangle is a candidate of it when their stamp matches the meshlet index
+    std::vector<uint32_t> vertexStamps(vertices.size(), INVALID_INDEX);
+    std::vector<uint32_t> candidateStamps(triangles.size(), INVALID_INDEX);
+    std::vector<bool> emitted(triangles.size(), false);
+    std::vector<uint32_t> candidates;
+    std::vector<Triangle> output;
+    output.reserve(triangles.size());
+
+    Meshlet current{};
+    uint32_t stamp = 0;
+    glm::vec3 centroidSum(0.0f);
+    glm::vec3 normalSum(0.0f);
+    float areaSum = 0.0f;
+    uint32_t cursor = 0;
+    std::vector<uint32_t> liveTriangles(vertices.size());
+    for(size_t vertex = 0; vertex < vertices.size(); vertex++)
+    {
+        liveTriangles[vertex] = offsets[vertex + 1] - offsets[vertex];
+    }
+
+    auto countNewVertices = [&](const Triangle& t)
+    {
+        return static_cast<uint32_t>(vertexStamps[t.v0] != stamp)
+            + (vertexStamps[t.v1] != stamp && t.v1 != t.v0)
+            + (vertexStamps[t.v2] != stamp && t.v2 != t.v0 && t.v2 != t.v1);
+    };
+
+    while(output.size() < triangles.size())
+    {
+        // Fewest new vertices first, then the triangle closest to the meshlet relative to its expected radius, best
+        // aligned with its average normal and with the fewest remaining neighbours
+        uint32_t next = INVALID_INDEX;
+        uint32_t bestNewVertices = 4;
+        float bestScore = std::numeric_limits<float>::max();
+        if(current.triangleCount > 0 && current.triangleCount < maxTriangles)
+        {
+            const glm::vec3 centroid = centroidSum / static_cast<float>(current.triangleCount);
+            const float normalLength = glm::length(normalSum);
+            const glm::vec3 averageNormal = normalLength > 0.0f ? normalSum / normalLength : glm::vec3(0.0f);
+            const float expectedRadius = glm::sqrt(areaSum / 3.14159265f) + std::numeric_limits<float>::min();
+            for(size_t i = 0; i < candidates.size();)
+            {
+                const uint32_t candidate = candidates[i];
+                if(emitted[candidate])
+                {
+                    candidates[i] = candidates.back();
+                    candidates.pop_back();
+                    continue;
+                }
+                i++;
+
+                uint32_t newVertices = countNewVertices(triangles[candidate]);
+                if(current.vertexCount + newVertices > maxVertices || newVertices > bestNewVertices)
+                {
+                    continue;
+                }
+                float score = glm::length(infos[candidate].centroid - centroid) / expectedRadius
+                    + CONE_WEIGHT * (1.0f - glm::dot(infos[candidate].normal, averageNormal))
+                    + LIVE_TRIANGLE_WEIGHT * static_cast<float>(liveTriangles[triangles[candidate].v0] + liveTriangles[triangles[candidate].v1] + liveTriangles[triangles[candidate].v2]);
+                if(newVertices < bestNewVertices || score < bestScore)
+                {
+                    next = candidate;
+                    bestNewVertices = newVertices;
+                    bestScore = score;
+                }
+            }
+        }
+
+        if(next == INVALID_INDEX)
+        {
+            // The meshlet is full or enclosed, the next one starts next to it in the most enclosed spot, which keeps
+            // neighbouring meshlets close in memory and fills the gaps between them first
+            if(current.triangleCount > 0)
+            {
+                uint32_t bestLive = std::numeric_limits<uint32_t>::max();
+                for(uint32_t candidate : candidates)
+                {
+                    const Triangle& t = triangles[candidate];
+                    uint32_t live = liveTriangles[t.v0] + liveTriangles[t.v1] + liveTriangles[t.v2];
+                    if(!emitted[candidate] && live < bestLive)
+                    {
+                        next = candidate;
+                        bestLive = live;
+                    }
+                }
+
+                meshlets.push_back(current);
+                current = {};
+                current.firstTriangle = static_cast<uint32_t>(output.size());
+                centroidSum = normalSum = glm::vec3(0.0f);
+                areaSum = 0.0f;
+                candidates.clear();
+                stamp++;
+            }
+            while(next == INVALID_INDEX)
+            {
+                if(!emitted[cursor])
+                {
+                    next = cursor;
+                }
+                cursor++;
+            }
+        }
+
+        const Triangle& triangle = triangles[next];
+        current.vertexCount += countNewVertices(triangle);
+        current.triangleCount++;
+        vertexStamps[triangle.v0] = vertexStamps[triangle.v1] = vertexStamps[triangle.v2] = stamp;
+        emitted[next] = true;
+        liveTriangles[triangle.v0]--;
+        liveTriangles[triangle.v1]--;
+        liveTriangles[triangle.v2]--;
+        output.push_back(triangle);
+        centroidSum += infos[next].centroid;
+        normalSum += infos[next].normal * infos[next].area;
+        areaSum += infos[next].area;
+
+        for(uint32_t vertex : {triangle.v0, triangle.v1, triangle.v2})
+        {
+            for(uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; i++)
+            {
+                uint32_t neighbour = adjacentTriangles[i];
+                if(!emitted[neighbour] && candidateStamps[neighbour] != stamp)
+                {
+                    candidateStamps[neighbour] = stamp;
+                    candidates.push_back(neighbour);
+                }
+            }
+        }
+    }
+    meshlets.push_back(current);
+
+    triangles = std::move(output);
+    for(Meshlet& meshlet : meshlets)
+    {
+        computeBounds(vertices, triangles, meshlet);
+    }
+    return meshlets;
+}
+
+void MeshletBuilder::computeBounds(const std::vector<Vertex>& vertices, const std::vector<Triangle>& triangles, Meshlet& meshlet)
+{
+    const uint32_t begin = meshlet.firstTriangle;
+    const uint32_t end = meshlet.firstTriangle + meshlet.triangleCount;
+
+    // Sphere around the bounding box, slightly larger than a minimal sphere but stable and cheap
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+    for(uint32_t triangle = begin; triangle < end; triangle++)
+    {
+        for(uint32_t index : {triangles[triangle].v0, triangles[triangle].v1, triangles[triangle].v2})
+        {
+            boundsMin = glm::min(boundsMin, vertices[index].position);
+            boundsMax = glm::max(boundsMax, vertices[index].position);
+        }
+    }
+    meshlet.center = (boundsMin + boundsMax) * 0.5f;
+    float radiusSquared = 0.0f;
+    for(uint32_t triangle = begin; triangle < end; triangle++)
+    {
+        for(uint32_t index : {triangles[triangle].v0, triangles[triangle].v1, triangles[triangle].v2})
+        {
+            glm::vec3 offset = vertices[index].position - meshlet.center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+    }
+    meshlet.radius = glm::sqrt(radiusSquared);
+
+    // Normal cone around the average face normal, its cutoff is taken from the normal furthest from the axis
+    glm::vec3 normalSum(0.0f);
+    for(uint32_t triangle = begin; triangle < end; triangle++)
+    {
+        const glm::vec3& p0 = vertices[triangles[triangle].v0].position;
+        glm::vec3 normal = glm::cross(vertices[triangles[triangle].v1].position - p0, vertices[triangles[triangle].v2].position - p0);
+        float length = glm::length(normal);
+        if(length > 0.0f)
+        {
+            normalSum += normal / length;
+        }
+    }
+
+    meshlet.coneApex = meshlet.center;
+    meshlet.coneAxis = glm::vec3(0.0f);
+    meshlet.coneCutoff = 1.0f;
+    float axisLength = glm::length(normalSum);
+    if(axisLength <= 0.0f)
+    {
+        return;
+    }
+    const glm::vec3 axis = normalSum / axisLength;
+
+    float minDot = 1.0f;
+    for(uint32_t triangle = begin; triangle < end; triangle++)
+    {
+        const glm::vec3& p0 = vertices[triangles[triangle].v0].position;
+        glm::vec3 normal = glm::cross(vertices[triangles[triangle].v1].position - p0, vertices[triangles[triangle].v2].position - p0);
+        float length = glm::length(normal);
+        if(length > 0.0f)
+        {
+            minDot = std::min(minDot, glm::dot(normal / length, axis));
+        }
+    }
+    meshlet.coneAxis = axis;
+
+    // Close to a hemisphere the apex moves towards infinity and the test rejects almost nothing
+    if(minDot <= 0.1f)
+    {
+        return;
+    }
+
+    // The apex is moved back along the axis until it lies behind every triangle plane
+    float maxT = 0.0f;
+    for(uint32_t triangle = begin; triangle < end; triangle++)
+    {
+        const glm::vec3& p0 = vertices[triangles[triangle].v0].position;
+        glm::vec3 normal = glm::cross(vertices[triangles[triangle].v1].position - p0, vertices[triangles[triangle].v2].position - p0);
+        float length = glm::length(normal);
+        if(length > 0.0f)
+        {
+            normal /= length;
+            maxT = std::max(maxT, glm::dot(meshlet.center - p0, normal) / glm::dot(axis, normal));
+        }
+    }
+    meshlet.coneApex = meshlet.center - axis * maxT;
+    meshlet.coneCutoff = glm::sqrt(1.0f - minDot * minDot);
+}
+} // namespace core
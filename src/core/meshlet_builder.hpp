@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "mesh.hpp"
+
+namespace core
+{
+    // Small cluster of consecutive triangles with the bounds needed to cull it as a whole
+    struct Meshlet
+    {
+        uint32_t firstTriangle = 0;
+        uint32_t triangleCount = 0;
+        uint32_t vertexCount = 0;   // Unique vertices referenced by the triangles
+
+        glm::vec3 center{};         // Bounding sphere
+        float radius = 0.0f;
+
+        // Every triangle faces away from a viewer at position p if dot(normalize(coneApex - p), coneAxis) >= coneCutoff
+        // A cutoff of 1 or more disables the test, which happens when the normals spread over more than a hemisphere
+        glm::vec3 coneApex{};
+        glm::vec3 coneAxis{};
+        float coneCutoff = 1.0f;
+    };
+
+    // Groups triangles into meshlets and reorders them so every meshlet is a contiguous range of the index buffer
+    // Meshlets grow greedily over shared vertices, preferring triangles that add no new vertex, then those that keep the
+    // meshlet compact and its normals aligned, tight spheres and narrow cones are what make the culling effective
+    // Each meshlet is seeded next to the previous one, so a cache optimized input keeps most of its locality
+    class MeshletBuilder
+    {
+        public:
+            static constexpr uint32_t MAX_VERTICES = 64;
+            static constexpr uint32_t MAX_TRIANGLES = 124;
+            static constexpr float CONE_WEIGHT = 0.5f; // Normal agreement relative to compactness when picking the next triangle
+
+            static std::vector<Meshlet> build(const std::vector<MeshData::Vertex>& vertices, std::vector<MeshData::Triangle>& triangles,
+                uint32_t maxVertices = MAX_VERTICES, uint32_t maxTriangles = MAX_TRIANGLES);
+
+            static void computeBounds(const std::vector<MeshData::Vertex>& vertices, const std::vector<MeshData::Triangle>& triangles, Meshlet& meshlet);
+    };
+} // namespace core
@@ -0,0 +1,454 @@
+#include "obj_importer.hpp"
+#include "utils/mapped_file.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/console.hpp"
+
+#include <vector>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+namespace core
+{
+namespace
+{
+    constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+    constexpr uint32_t SHARD_BITS = 6;
+    constexpr uint32_t SHARD_COUNT = 1u << SHARD_BITS;
+    constexpr size_t PARALLEL_RANGE = 64 * 1024; // Minimum corners per task in the per corner passes
+
+    // One triangle corner, attribute indices are 0 based with -1 for attributes the face didn't reference
+    struct Corner
+    {
+        int32_t position;
+        int32_t texCoord;
+        int32_t normal;
+
+        bool operator==(const Corner& other) const { return position == other.position && texCoord == other.texCoord && normal == other.normal; }
+    };
+
+    struct Chunk
+    {
+        const char* begin;
+        const char* end;
+        // Element counts from the counting pass, turned into offsets into the merged arrays before parsing
+        size_t positions = 0;
+        size_t texCoords = 0;
+        size_t normals = 0;
+        size_t triangles = 0;
+    };
+
+    uint64_t hashCorner(const Corner& corner)
+    {
+        uint64_t hash = static_cast<uint32_t>(corner.position) * 0x9E3779B97F4A7C15ull;
+        hash ^= static_cast<uint32_t>(corner.texCoord) * 0xC2B2AE3D27D4EB4Full;
+        hash ^= static_cast<uint32_t>(corner.normal) * 0x165667B19E3779F9ull;
+        hash ^= hash >> 29;
+        hash *= 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    const char* skipSpaces(const char* cursor, const char* end)
+    {
+        while(cursor < end && (*cursor == ' ' || *cursor == '\t')) cursor++;
+        return cursor;
+    }
+
+    const char* nextLine(const char* cursor, const char* end)
+    {
+        const void* newline = memchr(cursor, '\n', end - cursor);
+        return newline != nullptr ? static_cast<const char*>(newline) + 1 : end;
+    }
+
+    bool isLineEnd(const char* cursor, const char* end)
+    {
+        return cursor >= end || *cursor == '\n' || *cursor == '\r' || *cursor == '#';
+    }
+
+    const char* parseFloat(const char* cursor, const char* end, float& value)
+    {
+        cursor = skipSpaces(cursor, end);
+        if(cursor < end && *cursor == '+') cursor++; // from_chars rejects a leading plus
+        std::from_chars_result result = std::from_chars(cursor, end, value);
+        if(result.ec != std::errc())
+        {
+            throw std::runtime_error("Invalid number in OBJ file");
+        }
+        return result.ptr;
+    }
+
+    // Parses one index of a face corner, relative (negative) indices are resolved against count
+    const char* parseIndex(const char* cursor, const char* end, size_t count, int32_t& index)
+    {
+        int64_t value = 0;
+        std::from_chars_result result = std::from_chars(cursor, end, value);
+        if(result.ec != std::errc() || value == 0)
+        {
+            throw std::runtime_error("Invalid face index in OBJ file");
+        }
+        value = value > 0 ? value - 1 : static_cast<int64_t>(count) + value;
+        if(value < 0 || value >= static_cast<int64_t>(count))
+        {
+            throw std::runtime_error("Face index out of range in OBJ file");
+        }
+        index = static_cast<int32_t>(value);
+        return result.ptr;
+    }
+
+    // v, v/t, v//n or v/t/n
+    const char* parseCorner(const char* cursor, const char* end, const size_t counts[3], Corner& corner)
+    {
+        corner = {-1, -1, -1};
+        cursor = parseIndex(cursor, end, counts[0], corner.position);
+        if(cursor < end && *cursor == '/')
+        {
+            cursor++;
+            if(cursor < end && *cursor != '/')
+            {
+                cursor = parseIndex(cursor, end, counts[1], corner.texCoord);
+            }
+            if(cursor < end && *cursor == '/')
+            {
+                cursor = parseIndex(cursor + 1, end, counts[2], corner.normal);
+            }
+        }
+        return cursor;
+    }
+
+    size_t countFaceCorners(const char* cursor, const char* end)
+    {
+        size_t corners = 0;
+        while(true)
+        {
+            cursor = skipSpaces(cursor, end);
+            if(isLineEnd(cursor, end)) return corners;
+            corners++;
+            while(cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\n' && *cursor != '\r') cursor++;
+        }
+    }
+
+    void countChunk(Chunk& chunk)
+    {
+        for(const char* line = chunk.begin; line < chunk.end; line = nextLine(line, chunk.end))
+        {
+            const char* cursor = skipSpaces(line, chunk.end);
+            if(chunk.end - cursor < 2) continue;
+            if(cursor[0] == 'v')
+            {
+                if(cursor[1] == ' ' || cursor[1] == '\t') chunk.positions++;
+                else if(cursor[1] == 't') chunk.texCoords++;
+                else if(cursor[1] == 'n') chunk.normals++;
+            }
+            else if(cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t'))
+            {
+                size_t corners = countFaceCorners(cursor + 2, chunk.end);
+                if(corners >= 3) chunk.triangles += corners - 2;
+            }
+        }
+    }
+
+    struct Attributes
+    {
+        std::vector<glm::vec3> positions{};
+        std::vector<glm::vec3> colors{};
+        std::vector<glm::vec2> texCoords{};
+        std::vector<glm::vec3> normals{};
+        std::vector<Corner> corners{};
+    };
+
+    // Parses a chunk straight into the merged arrays, starting at the offsets stored in the chunk
+    void parseChunk(const Chunk& chunk, Attributes& attributes)
+    {
+        size_t counts[3] = {chunk.positions, chunk.texCoords, chunk.normals}; // Elements defined so far, for relative indices
+        size_t cornerIndex = chunk.triangles * 3;
+        std::vector<Corner> polygon{};
+
+        for(const char* line = chunk.begin; line < chunk.end; line = nextLine(line, chunk.end))
+        {
+            const char* cursor = skipSpaces(line, chunk.end);
+            if(chunk.end - cursor < 2) continue;
+
+            if(cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t'))
+            {
+                glm::vec3& position = attributes.positions[counts[0]];
+                cursor = parseFloat(cursor + 2, chunk.end, position.x);
+                cursor = parseFloat(cursor, chunk.end, position.y);
+                cursor = parseFloat(cursor, chunk.end, position.z);
+                // Optional trailing values, either r g b or w r g b
+                float extra[4];
+                size_t extraCount = 0;
+                cursor = skipSpaces(cursor, chunk.end);
+                while(extraCount < 4 && !isLineEnd(cursor, chunk.end))
+                {
+                    cursor = skipSpaces(parseFloat(cursor, chunk.end, extra[extraCount++]), chunk.end);
+                }
+                if(extraCount >= 3)
+                {
+                    const float* color = extra + (extraCount - 3);
+                    attributes.colors[counts[0]] = glm::vec3(color[0], color[1], color[2]);
+                }
+                counts[0]++;
+            }
+            else if(cursor[0] == 'v' && cursor[1] == 't')
+            {
+                glm::vec2& texCoord = attributes.texCoords[counts[1]++];
+                cursor = parseFloat(cursor + 2, chunk.end, texCoord.x);
+                cursor = skipSpaces(cursor, chunk.end);
+                texCoord.y = 0.0f;
+                if(!isLineEnd(cursor, chunk.end))
+                {
+                    parseFloat(cursor, chunk.end, texCoord.y);
+                }
+            }
+            else if(cursor[0] == 'v' && cursor[1] == 'n')
+            {
+                glm::vec3& normal = attributes.normals[counts[2]++];
+                cursor = parseFloat(cursor + 2, chunk.end, normal.x);
+                cursor = parseFloat(cursor, chunk.end, normal.y);
+                parseFloat(cursor, chunk.end, normal.z);
+            }
+            else if(cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t'))
+            {
+                polygon.clear();
+                cursor += 2;
+                while(true)
+                {
+                    cursor = skipSpaces(cursor, chunk.end);
+                    if(isLineEnd(cursor, chunk.end)) break;
+                    Corner corner{};
+                    cursor = parseCorner(cursor, chunk.end, counts, corner);
+                    polygon.push_back(corner);
+                }
+                // Fan triangulation, matching the counting pass
+                for(size_t i = 2; i < polygon.size(); i++)
+                {
+                    attributes.corners[cornerIndex++] = polygon[0];
+                    attributes.corners[cornerIndex++] = polygon[i - 1];
+                    attributes.corners[cornerIndex++] = polygon[i];
+                }
+            }
+        }
+    }
+
+    // Open addressing table from corner key to the index of the first corner with that key
+    // Keys are stored inline so probing never touches the corner array
+    class CornerTable
+    {
+        public:
+            // Meshes usually share each vertex between several corners, so the table starts smaller and grows
+            explicit CornerTable(size_t cornerCount)
+            {
+                size_t capacity = 16;
+                while(capacity < cornerCount / 2) capacity *= 2;
+                slots.assign(capacity, Slot{{}, EMPTY});
+                mask = capacity - 1;
+            }
+
+            // Returns the first corner inserted with the same key, or cornerIndex if it is new
+            uint32_t findOrInsert(const Corner& corner, uint32_t cornerIndex, uint64_t hash)
+            {
+                if((count + 1) * 10 > slots.size() * 7)
+                {
+                    grow();
+                }
+                size_t slot = hash & mask;
+                while(true)
+                {
+                    Slot& entry = slots[slot];
+                    if(entry.cornerIndex == EMPTY)
+                    {
+                        entry = {corner, cornerIndex};
+                        count++;
+                        return cornerIndex;
+                    }
+                    if(entry.key == corner)
+                    {
+                        return entry.cornerIndex;
+                    }
+                    slot = (slot + 1) & mask;
+                }
+            }
+
+        private:
+            struct Slot
+            {
+                Corner key;
+                uint32_t cornerIndex;
+            };
+
+            void grow()
+            {
+                std::vector<Slot> oldSlots = std::move(slots);
+                slots.assign(oldSlots.size() * 2, Slot{{}, EMPTY});
+                mask = slots.size() - 1;
+                for(const Slot& entry : oldSlots)
+                {
+                    if(entry.cornerIndex == EMPTY) continue;
+                    size_t slot = hashCorner(entry.key) & mask;
+                    while(slots[slot].cornerIndex != EMPTY) slot = (slot + 1) & mask;
+                    slots[slot] = entry;
+                }
+            }
+
+            static constexpr uint32_t EMPTY = UINT32_MAX;
+            std::vector<Slot> slots{};
+            size_t mask = 0;
+            size_t count = 0;
+    };
+} // namespace
+
+ObjImporter::Stats ObjImporter::load(const std::string& path, MeshData& mesh)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    ThreadPool& threadPool = ThreadPool::getGlobal();
+
+    MappedFile file{};
+    if(!file.open(path))
+    {
+        throw std::runtime_error("Could not open OBJ file: " + path);
+    }
+    const char* data = reinterpret_cast<const char*>(file.data());
+    const char* dataEnd = data + file.size();
+
+    // Split at line boundaries, a few chunks per thread so uneven chunks still balance out
+    size_t targetChunkCount = (threadPool.getThreadCount() + 1) * 4;
+    size_t chunkSize = std::max(MIN_CHUNK_SIZE, file.size() / targetChunkCount + 1);
+    std::vector<Chunk> chunks{};
+    for(const char* begin = data; begin < dataEnd;)
+    {
+        const char* end = begin + std::min<size_t>(chunkSize, dataEnd - begin);
+        end = end < dataEnd ? nextLine(end, dataEnd) : dataEnd;
+        chunks.push_back({begin, end});
+        begin = end;
+    }
+
+    threadPool.parallelFor(chunks.size(), 1, [&](size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; i++) countChunk(chunks[i]);
+    });
+
+    // Exclusive prefix sums turn the counts into each chunk's offsets
+    Chunk totals{};
+    for(Chunk& chunk : chunks)
+    {
+        size_t positions = chunk.positions, texCoords = chunk.texCoords, normals = chunk.normals, triangles = chunk.triangles;
+        chunk.positions = totals.positions;
+        chunk.texCoords = totals.texCoords;
+        chunk.normals = totals.normals;
+        chunk.triangles = totals.triangles;
+        totals.positions += positions;
+        totals.texCoords += texCoords;
+        totals.normals += normals;
+        totals.triangles += triangles;
+    }
+    if(totals.triangles * 3 >= UINT32_MAX)
+    {
+        throw std::runtime_error("OBJ file has too many triangles: " + path);
+    }
+
+    Attributes attributes{};
+    attributes.positions.resize(totals.positions);
+    attributes.colors.assign(totals.positions, glm::vec3(1.0f));
+    attributes.texCoords.resize(totals.texCoords);
+    attributes.normals.resize(totals.normals);
+    attributes.corners.resize(totals.triangles * 3);
+
+    threadPool.parallelFor(chunks.size(), 1, [&](size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; i++) parseChunk(chunks[i], attributes);
+    });
+
+    // Deduplicate corners, each shard of the hash space is handled by one task
+    // Corners are copied out by shard in their original order, so the first corner found for a key is the earliest one
+    const std::vector<Corner>& corners = attributes.corners;
+    const size_t cornerCount = corners.size();
+    auto getShard = [](const Corner& corner) { return static_cast<uint32_t>(hashCorner(corner) >> (64 - SHARD_BITS)); };
+
+    std::vector<uint32_t> shardOffsets(SHARD_COUNT + 1, 0);
+    for(const Corner& corner : corners) shardOffsets[getShard(corner) + 1]++;
+    for(uint32_t shard = 0; shard < SHARD_COUNT; shard++) shardOffsets[shard + 1] += shardOffsets[shard];
+
+    // Keys are copied along with their index so each shard is read sequentially
+    struct ShardEntry
+    {
+        Corner key;
+        uint32_t cornerIndex;
+    };
+    std::vector<ShardEntry> shardEntries(cornerCount);
+    {
+        std::vector<uint32_t> cursors(shardOffsets.begin(), shardOffsets.end() - 1);
+        for(uint32_t i = 0; i < cornerCount; i++)
+        {
+            shardEntries[cursors[getShard(corners[i])]++] = {corners[i], i};
+        }
+    }
+
+    std::vector<uint32_t> firstCorner(cornerCount);
+    threadPool.parallelFor(SHARD_COUNT, 1, [&](size_t begin, size_t end)
+    {
+        for(size_t shard = begin; shard < end; shard++)
+        {
+            CornerTable table(shardOffsets[shard + 1] - shardOffsets[shard]);
+            for(uint32_t i = shardOffsets[shard]; i < shardOffsets[shard + 1]; i++)
+            {
+                const ShardEntry& entry = shardEntries[i];
+                firstCorner[entry.cornerIndex] = table.findOrInsert(entry.key, entry.cornerIndex, hashCorner(entry.key));
+            }
+        }
+    });
+    shardEntries.clear();
+    shardEntries.shrink_to_fit();
+
+    // Vertices are numbered in order of first use
+    std::vector<uint32_t> vertexIndices(cornerCount);
+    uint32_t vertexCount = 0;
+    for(uint32_t i = 0; i < cornerCount; i++)
+    {
+        if(firstCorner[i] == i) vertexIndices[i] = vertexCount++;
+    }
+
+    std::vector<MeshData::Vertex>& vertices = mesh.vertices;
+    std::vector<MeshData::Triangle>& triangles = mesh.triangles;
+    vertices.assign(vertexCount, MeshData::Vertex{});
+    triangles.resize(totals.triangles);
+    threadPool.parallelFor(totals.triangles, PARALLEL_RANGE / 3, [&](size_t begin, size_t end)
+    {
+        for(size_t triangle = begin; triangle < end; triangle++)
+        {
+            uint32_t indices[3];
+            for(uint32_t k = 0; k < 3; k++)
+            {
+                uint32_t corner = static_cast<uint32_t>(triangle * 3 + k);
+                indices[k] = vertexIndices[firstCorner[corner]];
+                if(firstCorner[corner] != corner) continue;
+
+                // Only the first corner with a key writes the vertex
+                const Corner& source = corners[corner];
+                MeshData::Vertex& vertex = vertices[indices[k]];
+                vertex.position = attributes.positions[source.position];
+                vertex.color = attributes.colors[source.position];
+                if(source.normal >= 0) vertex.normal = attributes.normals[source.normal];
+                if(source.texCoord >= 0) vertex.texCoord = attributes.texCoords[source.texCoord];
+            }
+            triangles[triangle] = {indices[0], indices[1], indices[2]};
+        }
+    });
+
+    Stats stats{};
+    stats.bytes = file.size();
+    stats.chunks = chunks.size();
+    stats.vertices = vertices.size();
+    stats.triangles = triangles.size();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    char message[256];
+    snprintf(message, sizeof(message), "Imported %s: %zu vertices, %zu triangles, %.1f MB in %.1f ms (%.1f MB/s, %zu chunks)",
+        path.c_str(), stats.vertices, stats.triangles, stats.bytes / (1024.0 * 1024.0), stats.seconds * 1000.0,
+        stats.getMegabytesPerSecond(), stats.chunks);
+    Console::log(message, "OBJ Importer");
+    return stats;
+}
+} // namespace core
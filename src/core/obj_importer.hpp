@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+#include "mesh.hpp"
+
+namespace core
+{
+    // Parallel Wavefront OBJ parser
+    // The file is memory mapped and split into chunks at line boundaries, which are counted and then parsed on the thread pool
+    // Vertices are deduplicated by (position, texcoord, normal) in hash sharded tables, in first use order so the output
+    // does not depend on the thread count
+    class ObjImporter
+    {
+        public:
+            struct Stats
+            {
+                size_t bytes = 0;
+                size_t chunks = 0;
+                size_t vertices = 0;
+                size_t triangles = 0;
+                double seconds = 0.0;
+
+                double getMegabytesPerSecond() const { return seconds > 0.0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0; }
+            };
+
+            // Replaces the vertices and triangles of mesh, throws std::runtime_error if the file can't be read or is malformed
+            // Polygons are fan triangulated, tangents are left for the caller to generate
+            static Stats load(const std::string& path, MeshData& mesh);
+    };
+} // namespace core
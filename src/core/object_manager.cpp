@@ -2,19 +2,76 @@
 
 namespace core
 {
-id_t ObjectManager::currentID = 0;
-std::unordered_map<id_t, Object*> ObjectManager::objectIDDictionary{};
-std::vector<std::unique_ptr<Object>> ObjectManager::objectList{};
+std::vector<ObjectManager::TypePool> ObjectManager::pools{};
+SlotMap<ObjectManager::ObjectPtr> ObjectManager::objects{};
+std::thread::id ObjectManager::owningThread{};
 
-void ObjectManager::drawImGui()
+Object *ObjectManager::getObject(id_t objectID)
+{
+    ObjectPtr* obj = objects.get(objectID);
+    return obj != nullptr ? obj->get() : nullptr;
+}
+
+bool ObjectManager::deleteObject(id_t objID)
+{
+    assert(isOwningThread() && "Objects can only be deleted by the owning thread");
+    return objects.remove(objID);
+}
+
+void ObjectManager::captureListing(Listing& listing)
+{
+    listing.slotCount = objects.capacity();
+    listing.freeCount = objects.freeCount();
+    listing.pools.clear();
+    for(const TypePool& typePool : pools)
+    {
+        listing.pools.push_back({typePool.className, typePool.pool->getStats()});
+    }
+    // Entries are assigned in place so their names keep their memory from frame to frame
+    listing.objects.resize(objects.size());
+    size_t index = 0;
+    objects.forEach([&](id_t id, const ObjectPtr& obj)
+    {
+        Listing::Entry& entry = listing.objects[index++];
+        entry.id = id;
+        entry.className = obj->GetClassName();
+        entry.name = obj->name;
+    });
+}
+
+void ObjectManager::drawImGui(const Listing& listing)
 {
     ImGui::Begin("Internal Objects");
-    for(const std::unique_ptr<Object>& obj : objectList)
+    std::string summary = std::to_string(listing.objects.size()) + " live, " + std::to_string(listing.slotCount) + " slots, " + 
+        std::to_string(listing.freeCount) + " free";
+    ImGui::TextUnformatted(summary.c_str());
+    if(ImGui::BeginTable("Pools", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Type");
+        ImGui::TableSetupColumn("Live");
+        ImGui::TableSetupColumn("Peak");
+        ImGui::TableSetupColumn("Capacity");
+        ImGui::TableSetupColumn("Blocks");
+        ImGui::TableHeadersRow();
+        for(const Listing::Pool& pool : listing.pools)
+        {
+            const PoolAllocatorBase::Stats& stats = pool.stats;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(pool.className);
+            ImGui::TableNextColumn(); ImGui::Text("%zu", stats.liveCount);
+            ImGui::TableNextColumn(); ImGui::Text("%zu", stats.peakLiveCount);
+            ImGui::TableNextColumn(); ImGui::Text("%zu (%.1f KB)", stats.capacity, stats.capacity * stats.slotSize / 1024.0);
+            ImGui::TableNextColumn(); ImGui::Text("%zu", stats.blockCount);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Separator();
+    for(const Listing::Entry& entry : listing.objects)
     {
-        std::string className = obj->GetClassName();
-        std::string str = std::to_string(obj->instanceID) + " [" + className + "] " + obj->name;
+        std::string str = std::to_string(SlotMap<ObjectPtr>::getIndex(entry.id)) + ":" + 
+            std::to_string(SlotMap<ObjectPtr>::getGeneration(entry.id)) + " [" + entry.className + "] " + entry.name;
         ImGui::TextUnformatted(str.c_str());
     }
     ImGui::End();
 }
-} // namespace core
\ No newline at end of file
+} // namespace core
@@ -1,20 +1,50 @@
 #pragma once
 #include <vector>
-#include <unordered_map>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <thread>
+#include <cassert>
 #include "object.hpp"
 #include "engine_types.hpp"
+#include "utils/slot_map.hpp"
+#include "utils/pool_allocator.hpp"
+#include "utils/smart_reference.hpp"
 #include <imgui.h>
 
 namespace core
 {
     class AssetData; // Needed to ensure assets are not directly instantiated
     class AssetManager;
+    // Objects are created and deleted by a single owning thread, the simulation thread once it runs
+    // Lookups take no lock, other threads may only look up objects while the owning thread waits for them
     class ObjectManager
     {
         public:
+            // What the editor lists, captured by the owning thread so another thread can draw it
+            struct Listing
+            {
+                struct Pool
+                {
+                    const char* className;
+                    PoolAllocatorBase::Stats stats;
+                };
+                struct Entry
+                {
+                    id_t id;
+                    const char* className;
+                    std::string name;
+                };
+
+                size_t slotCount = 0;
+                size_t freeCount = 0;
+                std::vector<Pool> pools{};
+                std::vector<Entry> objects{};
+            };
+
+            // Returns nullptr if the object was deleted, even if its slot has since been reused
             static Object *getObject(id_t objectID);
+            static bool isAlive(id_t objectID) { return objects.contains(objectID); }
             // static Object *getObject(std::string objectName);
 
             template<class T>
@@ -24,26 +54,97 @@ namespace core
                 return InstantiateInternal<T>(name);
             }
 
-            static bool deleteObject(id_t objID); // TODO: Implement
+            // Creates count objects in one go, memory for all of them is reserved up front
+            template<class T>
+            static std::vector<T*> InstantiateBulk(size_t count, const std::string& name = "New Object")
+            {
+                static_assert(!std::is_base_of<AssetData, T>::value, "Assets must be instantiated via AssetManager");
+                getPool<T>().reserve(count);
+                objects.reserve(objects.capacity() - objects.freeCount() + count);
+                std::vector<T*> created{};
+                created.reserve(count);
+                for(size_t i = 0; i < count; i++)
+                {
+                    created.push_back(InstantiateInternal<T>(name));
+                }
+                return created;
+            }
+
+            // Destroys the object and invalidates its ID, returns false if it was already deleted
+            static bool deleteObject(id_t objID);
 
-            static void drawImGui();
+            // Hands creating and deleting objects to another thread, the previous owner must not use them afterwards
+            static void setOwningThread(std::thread::id thread) { owningThread = thread; }
+
+            static void captureListing(Listing& listing);
+            static void drawImGui(const Listing& listing);
         private:
+            // Returns an object's memory to the pool it was allocated from
+            struct ObjectDeleter
+            {
+                void (*destroy)(Object*) = nullptr;
+                void operator()(Object* obj) const { destroy(obj); }
+            };
+            using ObjectPtr = std::unique_ptr<Object, ObjectDeleter>;
+
             template<class T>
             static T *InstantiateInternal(const std::string& name = "New Object")
             {
                 static_assert(std::is_base_of<Object, T>::value, "Instantiated objects must derive from Object");
-                std::unique_ptr<T> t = std::unique_ptr<T>(new T(currentID++));
-                objectList.push_back(std::unique_ptr<Object>(std::move(t)));
-                T* objPtr = static_cast<T*>(objectList.back().get()); // New object is always at the end of the vector
+                assert(isOwningThread() && "Objects can only be created by the owning thread");
+                // The slot is reserved first since the object needs its handle as its instance ID
+                id_t newID = objects.insert(nullptr);
+                T* objPtr = new (getPool<T>().allocate()) T(newID);
+                *objects.get(newID) = ObjectPtr(objPtr, ObjectDeleter{&destroyPooled<T>});
                 objPtr->name = name;
-                objectIDDictionary[objPtr->getInstanceID()] = objPtr;
                 return objPtr;
             }
-            static id_t currentID;
-            static std::unordered_map<id_t, Object*> objectIDDictionary; // Easy accessing via index
+
+            template<class T>
+            static void destroyPooled(Object* obj)
+            {
+                T* typed = static_cast<T*>(obj);
+                typed->~T();
+                getPool<T>().deallocate(typed);
+            }
+
+            static bool isOwningThread() { return owningThread == std::thread::id() || owningThread == std::this_thread::get_id(); }
+
+            // One pool per instantiated type, created on first use
+            template<class T>
+            static PoolAllocator<T>& getPool()
+            {
+                static PoolAllocator<T>* pool = createPool<T>();
+                return *pool;
+            }
+
+            template<class T>
+            static PoolAllocator<T>* createPool()
+            {
+                PoolAllocator<T>* pool = new PoolAllocator<T>();
+                pools.push_back({T::className, std::unique_ptr<PoolAllocatorBase>(pool)});
+                return pool;
+            }
+
+            struct TypePool
+            {
+                const char* className;
+                std::unique_ptr<PoolAllocatorBase> pool;
+            };
+            // Declared before objects so the pools outlive every object during static destruction
+            static std::vector<TypePool> pools;
+
             // std::unordered_map<std::string, Object*> objectNameDictionary; // Easy accessing via index // TODO: Implement later to account for renaming
-            static std::vector<std::unique_ptr<Object>> objectList; // Where objects live in memory
+            static SlotMap<ObjectPtr> objects; // Instance IDs are slot map handles, the objects themselves live in the type pools
+            static std::thread::id owningThread; // Any thread until one is set
 
             friend class AssetManager;
     };
-} // namespace core
\ No newline at end of file
+} // namespace core
+
+// Lets SmartRef resolve object handles
+template<typename T>
+struct SmartRefResolver
+{
+    static T* resolve(id_t handle) { return static_cast<T*>(core::ObjectManager::getObject(handle)); }
+};
\ No newline at end of file
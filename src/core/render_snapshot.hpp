@@ -0,0 +1,59 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+#include "mesh.hpp"
+#include "graphics/camera.hpp"
+
+namespace core
+{
+    enum class PickType
+    {
+        NONE = 0,
+        OBJECT = 1, // Already picked by the render thread with the object ID pass
+        RAY = 2     // Picked by the simulation with a raycast
+    };
+
+    // What the render thread hands the simulation for one frame
+    struct FrameInput
+    {
+        double deltaTime = 0.0;
+        graphics::Camera camera{}; // The frame is culled and drawn with it
+        PickType pick = PickType::NONE;
+        glm::vec2 pickPixel{};
+        id_t pickedObject = -1;
+        glm::vec3 rayOrigin{};
+        glm::vec3 rayDirection{};
+        float rayLength = 0.0f;
+    };
+
+    // Everything one frame draws, filled by the simulation and recorded by the render thread while the simulation moves on
+    // Nothing in it points into the scene, so it stays valid however the scene changes afterwards
+    struct RenderSnapshot
+    {
+        // The mesh is only referenced by its ID, the render thread resolves its GraphicsMesh under Graphics::lockMeshes
+        struct Draw
+        {
+            id_t meshID;
+            MeshData::Bounds bounds; // Of the mesh when the snapshot was built, used for the LOD selection
+            id_t materialID;
+            id_t objectID; // -1 for entities without a GameObject
+            bool outlined;
+            glm::mat4 transform;
+        };
+
+        uint64_t frame = 0; // Counts from 1, 0 for the empty snapshots returned before the first frame was simulated
+        graphics::Camera camera{};
+        std::vector<Draw> draws{}; // Only the ones inside the camera frustum
+
+        // For the stats of the UI
+        uint32_t visible = 0;
+        uint32_t culled = 0;
+        uint32_t simulationSteps = 0;
+        double droppedTime = 0.0;
+        ObjectManager::Listing objects{};
+    };
+} // namespace core
@@ -1,8 +1,34 @@
 #include "scene.hpp"
 #include "modules.hpp"
 
+#include <algorithm>
+
 namespace core
 {
+namespace
+{
+    // Translation and scale are blended linearly and the rotation spherically, blending the matrices themselves would shrink spinning objects
+    glm::mat4 interpolateMatrix(const glm::mat4& from, const glm::mat4& to, float alpha)
+    {
+        glm::vec3 fromScale(glm::length(glm::vec3(from[0])), glm::length(glm::vec3(from[1])), glm::length(glm::vec3(from[2])));
+        glm::vec3 toScale(glm::length(glm::vec3(to[0])), glm::length(glm::vec3(to[1])), glm::length(glm::vec3(to[2])));
+        if(std::min(std::min(fromScale.x, fromScale.y), fromScale.z) <= 0.0f || std::min(std::min(toScale.x, toScale.y), toScale.z) <= 0.0f)
+        {
+            return to;
+        }
+        // Mirrored matrices keep the mirror in the scale so what is left is a rotation
+        if(glm::determinant(glm::mat3(from)) < 0.0f) fromScale.x = -fromScale.x;
+        if(glm::determinant(glm::mat3(to)) < 0.0f) toScale.x = -toScale.x;
+
+        glm::quat fromRotation = glm::quat_cast(glm::mat3(glm::vec3(from[0]) / fromScale.x, glm::vec3(from[1]) / fromScale.y, glm::vec3(from[2]) / fromScale.z));
+        glm::quat toRotation = glm::quat_cast(glm::mat3(glm::vec3(to[0]) / toScale.x, glm::vec3(to[1]) / toScale.y, glm::vec3(to[2]) / toScale.z));
+        glm::mat3 rotation = glm::mat3_cast(glm::slerp(fromRotation, toRotation, alpha));
+        glm::vec3 scale = glm::mix(fromScale, toScale, alpha);
+        return glm::mat4(glm::vec4(rotation[0] * scale.x, 0.0f), glm::vec4(rotation[1] * scale.y, 0.0f), glm::vec4(rotation[2] * scale.z, 0.0f),
+            glm::mix(from[3], to[3], alpha));
+    }
+} // namespace
+
 void Scene_t::loadScene()
 {
     std::cout << "Loading scene" << std::endl;
@@ -17,92 +43,169 @@ void Scene_t::loadScene()
     Mesh monkeyMesh = Mesh::loadObj("internal/models/monkey_high_res.obj", "Monkey Mesh");
     Mesh cubeMesh = Mesh::createCube(0.1f, "Cube");
 
-    GameObject obj{ObjectManager::Instantiate<GameObject_t>("Basic Monkey")};
-    GameObject obj2{ObjectManager::Instantiate<GameObject_t>("Floor")};
-    GameObject obj3{ObjectManager::Instantiate<GameObject_t>("Wireframe Monkey")};
+    GameObject obj = createGameObject("Basic Monkey");
+    GameObject obj2 = createGameObject("Floor");
+    GameObject obj3 = createGameObject("Wireframe Monkey");
     // std::cout << "Creating Grid" << std::endl;
     // obj.mesh = GraphicsMesh::createGrid(512, 512, {50.0f, 50.0f});
     // obj.materialID = 0;
-    obj->mesh = monkeyMesh;
+    obj->setMesh(monkeyMesh);
     // obj->mesh = graphics::GraphicsMesh::loadObj("internal/models/Nefertiti.obj");
     // obj->mesh->generateNormals();
     // obj->mesh->createBuffers();
-    obj->materialID = 1;
-    obj->transform.setPosition(glm::vec3(0, 1, 0));
+    obj->setMaterialID(1);
+    obj->getTransform().setPosition(glm::vec3(0, 1, 0));
     // obj->transform.scale = glm::vec3(0.01f);
     // obj->transform.scale = glm::vec3(-0.01f, 0.01f, 0.01f); // TODO: Make sure negative scaling doesn't turn models inside out
     // obj->transform.rotation.x = glm::radians(-90.0f);
 
     // obj2.mesh = GraphicsMesh::loadObj("internal/models/monkey_high_res.obj");
-    obj2->mesh = Mesh::createGrid(16,16, {50.0f, 50.0f});
-    obj2->materialID = 3;
-    obj2->transform.setPosition(glm::vec3(0, -3, 0));
-
-    obj3->mesh = monkeyMesh;
-    obj3->materialID = 2;
-    obj3->transform.setPosition(glm::vec3(-3, -1, 0));
-    obj3->transform.parent = &obj->transform;
+    obj2->setMesh(Mesh::createGrid(16,16, {50.0f, 50.0f}));
+    obj2->setMaterialID(3);
+    obj2->getTransform().setPosition(glm::vec3(0, -3, 0));
+
+    obj3->setMesh(monkeyMesh);
+    obj3->setMaterialID(2);
+    obj3->getTransform().setPosition(glm::vec3(-3, -1, 0));
+    obj3->getTransform().setParent(&obj->getTransform());
+    // The two monkeys turn, the wireframe one also follows its parent
+    registry.addComponent<Spin>(obj->getEntity(), Spin{0.25f * 6.28f, 0.0f, glm::vec3(1, 1, 1), 0.25f * 6.28f});
+    registry.addComponent<Spin>(obj3->getEntity(), Spin{0.0f, 0.6666f * 6.28f});
     // obj3.mesh = GraphicsMesh::createSierpinskiPyramid(12.0f, 8);
     // obj3.materialID = 2;
-    gameObjects.push_back(std::move(obj));
-    gameObjects.push_back(std::move(obj2));
-    gameObjects.push_back(std::move(obj3));
     std::cout << "Loaded game objects" << std::endl;
 }
 
-void Scene_t::update(double deltaTime)
+GameObject Scene_t::createGameObject(const std::string& name)
+{
+    return attachGameObject(ObjectManager::Instantiate<GameObject_t>(name));
+}
+
+std::vector<GameObject> Scene_t::createGameObjects(size_t count, const std::string& name)
 {
-    int counter = 0;
-    for(GameObject &obj : gameObjects)
+    registry.reserve<Transform, Mesh, MaterialComponent, ObjectLink, InterpolatedTransform>(registry.getEntityCount() + count);
+    gameObjects.reserve(gameObjects.size() + count);
+
+    std::vector<GameObject> created{};
+    created.reserve(count);
+    for(GameObject_t* objPtr : ObjectManager::InstantiateBulk<GameObject_t>(count, name))
     {
-        if(obj->getInstanceID() == 5)
-            obj->transform.rotateYaw(0.25f * deltaTime * 6.28f);
-        if(obj->getInstanceID() == 7)
-            obj->transform.rotatePitch(0.6666f * deltaTime * 6.28f);
-        if(obj->getInstanceID() == 5)
-            obj->transform.rotateAboutAxis(glm::vec3(1,1,1), 0.25f * deltaTime * 6.28f);
-        // if(obj.get_id() == 2) break;
-        // if(obj.get_id() == 1)
-        // {
-        //     obj.transform.rotation.y += 0.5f * deltaTime;
-        // }
-        // obj.transform.position = glm::vec3(glm::sin(glfwGetTime()) * (counter % 2 ? 1 : -1));
-        // obj.transform.position = glm::vec3(glm::sin(glm::radians(324.f)) * (counter % 2 ? 1 : -1));
-        // obj.transform.rotation = glm::vec3(glm::radians(glfwGetTime() * 90.0f) * (counter % 2 ? 1 : -1));
-        // obj.transform.rotation = glm::vec3(glm::radians(324.f) * (counter % 2 ? 1 : -1));
-        // obj.transform.rotation.x = glm::radians(-90.0f);
-        counter++;
+        created.push_back(attachGameObject(objPtr));
     }
+    return created;
+}
+
+GameObject Scene_t::attachGameObject(GameObject_t* objPtr)
+{
+    GameObject obj{objPtr};
+    obj->registry = &registry;
+    obj->entity = registry.create();
+    registry.addComponent<Transform>(obj->entity);
+    registry.addComponent<Mesh>(obj->entity);
+    registry.addComponent<MaterialComponent>(obj->entity);
+    registry.addComponent<ObjectLink>(obj->entity, ObjectLink{obj->getInstanceID()});
+    registry.addComponent<InterpolatedTransform>(obj->entity);
+    gameObjects.push_back(obj);
+    return obj;
 }
 
-void Scene_t::drawScene()
+void Scene_t::destroyGameObject(GameObject object)
 {
-    for(const GameObject& obj : gameObjects)
+    std::erase_if(gameObjects, [&](const GameObject& other) { return other.get() == object.get(); });
+    registry.destroy(object->entity);
+    ObjectManager::deleteObject(object->getInstanceID());
+}
+
+Entity Scene_t::createEntity(const Mesh& mesh, id_t materialID, const Transform& transform)
+{
+    Entity entity = registry.create();
+    registry.addComponent<Transform>(entity, transform);
+    registry.addComponent<Mesh>(entity, mesh);
+    registry.addComponent<MaterialComponent>(entity, MaterialComponent{materialID});
+    return entity;
+}
+
+void Scene_t::fixedUpdate(float stepTime)
+{
+    ComponentPool<InterpolatedTransform>& interpolations = registry.getPool<InterpolatedTransform>();
+    registry.view<RigidBody, Transform>().each([&](Entity entity, RigidBody&, Transform&)
     {
-        // std::vector<glm::mat4> transforms{};
-        // int gridSize = 30;
-        // for(int x = 0; x < gridSize; x++)
-        // {
-        // for(int y = 0; y < gridSize; y++)
-        // {
-        // for(int z = 0; z < gridSize; z++)
-        // {
-        //     Transform temp{};
-        //     temp.position = obj->transform.position + glm::vec3(x, y, z);
-        //     transforms.push_back(temp.getTransform());
-        // }
-        // }
-        // }
-        graphicsModule.drawMesh(obj->mesh, obj->materialID, obj->transform.getTransform(), obj->getInstanceID());
-        // graphicsModule.drawMeshInstanced(obj->mesh, obj->materialID, transforms);
-        if(obj->getInstanceID() == selectedObject)
-            graphicsModule.drawMeshOutline(obj->mesh, obj->transform.getTransform());
-    }
+        if(!interpolations.has(entity))
+        {
+            interpolations.add(entity);
+        }
+    });
+    registry.view<InterpolatedTransform, Transform>().each([](Entity, InterpolatedTransform& interpolation, Transform& transform)
+    {
+        interpolation.previous = transform.getTransform();
+        interpolation.captured = true;
+    });
 
+    registry.view<Spin, Transform>().each([&](Entity, Spin& spin, Transform& transform)
+    {
+        if(spin.yawSpeed != 0.0f)
+            transform.rotateYaw(spin.yawSpeed * stepTime);
+        if(spin.pitchSpeed != 0.0f)
+            transform.rotatePitch(spin.pitchSpeed * stepTime);
+        if(spin.axisSpeed != 0.0f)
+            transform.rotateAboutAxis(spin.axis, spin.axisSpeed * stepTime);
+    });
+
+    transformHierarchy.update(registry.getPool<Transform>().components());
+}
+
+void Scene_t::buildSnapshot(RenderSnapshot& snapshot, float alpha)
+{
+    // Physics writes its bodies back after the gameplay of the step
+    transformHierarchy.update(registry.getPool<Transform>().components());
+
+    ComponentPool<ObjectLink>& links = registry.getPool<ObjectLink>();
+    ComponentPool<InterpolatedTransform>& interpolations = registry.getPool<InterpolatedTransform>();
+    drawCandidates.clear();
+    frustumCuller.clear();
+    drawCandidates.reserve(registry.getPool<Mesh>().size());
+    frustumCuller.reserve(registry.getPool<Mesh>().size());
+    registry.view<Transform, Mesh, MaterialComponent>().each([&](Entity entity, Transform& transform, Mesh& mesh, MaterialComponent& material)
+    {
+        const ObjectLink* link = links.tryGet(entity);
+        id_t objectID = link != nullptr ? link->objectID : static_cast<id_t>(-1);
+
+        const glm::mat4& current = transform.getTransform();
+        InterpolatedTransform* interpolation = interpolations.tryGet(entity);
+        const bool interpolated = interpolation != nullptr && interpolation->captured && interpolation->previous != current;
+        if(interpolated)
+        {
+            interpolation->render = interpolateMatrix(interpolation->previous, current, alpha);
+        }
+        const glm::mat4& model = interpolated ? interpolation->render : current;
+
+        // The local sphere is moved into world space, scaled by the largest axis so it stays conservative
+        const MeshData::Bounds& bounds = mesh->getBounds();
+        float scaleSquared = std::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+            std::max(glm::dot(glm::vec3(model[1]), glm::vec3(model[1])), glm::dot(glm::vec3(model[2]), glm::vec3(model[2]))));
+        frustumCuller.add(glm::vec3(model * glm::vec4(bounds.center, 1.0f)), bounds.radius * glm::sqrt(scaleSquared));
+        drawCandidates.push_back({&mesh, material.materialID, &model, objectID});
+    });
+
+    frustumCuller.cull(Frustum::fromViewProjection(snapshot.camera.getViewProjection()), visibleCandidates);
+    cullingStats.visible = static_cast<uint32_t>(visibleCandidates.size());
+    cullingStats.culled = static_cast<uint32_t>(drawCandidates.size() - visibleCandidates.size());
+    snapshot.visible = cullingStats.visible;
+    snapshot.culled = cullingStats.culled;
+
+    snapshot.draws.clear();
+    snapshot.draws.reserve(visibleCandidates.size());
+    for(uint32_t index : visibleCandidates)
+    {
+        const DrawCandidate& candidate = drawCandidates[index];
+        bool outlined = candidate.objectID != static_cast<id_t>(-1) && candidate.objectID == selectedObject;
+        const MeshData& mesh = **candidate.mesh;
+        snapshot.draws.push_back({mesh.getInstanceID(), mesh.getBounds(), candidate.materialID, candidate.objectID, outlined, *candidate.transform});
+    }
 }
 
 Scene::Scene(const std::string& sceneName)
 {
-    ptr = ObjectManager::Instantiate<Scene_t>(sceneName);
+    reset(ObjectManager::Instantiate<Scene_t>(sceneName));
 }
 } // namespace core
\ No newline at end of file
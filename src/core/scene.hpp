@@ -2,6 +2,9 @@
 #include "asset.hpp"
 #include "game_object.hpp"
 #include "object_manager.hpp"
+#include "transform_hierarchy.hpp"
+#include "frustum_culling.hpp"
+#include "render_snapshot.hpp"
 
 namespace core
 {
@@ -18,21 +21,59 @@ class Scene_t : public Object
         Scene_t& operator=(Scene_t&&) = delete;
 
         void loadScene();
-        void update(double deltaTime);
+        // Gameplay of one simulation step, run by the step callbacks of a FixedTimestep before physics
+        // Also keeps the world matrices from before the step for every InterpolatedTransform
+        void fixedUpdate(float stepTime);
+
+        // Creates a GameObject backed by an entity with a Transform, Mesh and MaterialComponent
+        GameObject createGameObject(const std::string& name);
+        // Same as createGameObject, with every allocation for the batch made up front
+        std::vector<GameObject> createGameObjects(size_t count, const std::string& name);
+        // Destroys the entity and deletes the GameObject, other references to it can detect this with isAlive()
+        void destroyGameObject(GameObject object);
+        // Creates a bare entity without a GameObject, for large numbers of objects that need no editor presence
+        Entity createEntity(const Mesh& mesh, id_t materialID, const Transform& transform = Transform());
 
         std::vector<GameObject> &getGameObjects() { return gameObjects; }
+        EntityRegistry &getRegistry() { return registry; }
+
+        // Fills the draws of the snapshot with every entity whose bounding sphere intersects the frustum of its camera
+        // Entities with an InterpolatedTransform are placed alpha of the way through the last step, see FixedTimestep::getAlpha
+        void buildSnapshot(RenderSnapshot& snapshot, float alpha = 1.0f);
 
-        void drawScene();
+        struct CullingStats
+        {
+            uint32_t visible = 0;
+            uint32_t culled = 0;
+        };
+        const CullingStats& getCullingStats() const { return cullingStats; } // Of the last buildSnapshot
 
         std::vector<glm::mat4> transforms{};
 
-        int selectedObject = -1;
+        id_t selectedObject = -1; // Instance ID of the outlined GameObject
         
     protected:
         Scene_t(id_t newID) : Object(newID) {}
         friend class ObjectManager;
 
         std::vector<GameObject> gameObjects{};
+        GameObject attachGameObject(GameObject_t* objPtr); // Creates the object's entity and components
+
+        EntityRegistry registry{};
+        TransformHierarchy transformHierarchy{};
+
+        // Drawables gathered by buildSnapshot before culling, the buffers are kept between frames
+        struct DrawCandidate
+        {
+            const Mesh* mesh;
+            id_t materialID;
+            const glm::mat4* transform;
+            id_t objectID;
+        };
+        std::vector<DrawCandidate> drawCandidates{};
+        std::vector<uint32_t> visibleCandidates{};
+        FrustumCuller frustumCuller{};
+        CullingStats cullingStats{};
 };
 
 class Scene : public SmartRef<Scene_t>
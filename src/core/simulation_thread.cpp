@@ -0,0 +1,102 @@
+#include "simulation_thread.hpp"
+
+#include <utility>
+
+namespace core
+{
+SimulationThread::SimulationThread(FrameFunction _function, uint32_t _queueDepth) : function(std::move(_function)), queueDepth(_queueDepth)
+{
+    snapshots.resize(queueDepth + 2);
+    for(uint32_t i = 1; i < snapshots.size(); i++)
+    {
+        freeSnapshots.push_back(i);
+    }
+    if(queueDepth > 0)
+    {
+        thread = std::thread([this]() { threadLoop(); });
+    }
+}
+
+SimulationThread::~SimulationThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    inputQueued.notify_all();
+    if(thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+const RenderSnapshot& SimulationThread::advance(const FrameInput& input)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    inputs.push_back(input);
+    framesInFlight++;
+    if(queueDepth == 0)
+    {
+        simulateFrame(lock);
+    }
+    else
+    {
+        inputQueued.notify_one();
+    }
+
+    if(framesInFlight > queueDepth)
+    {
+        frameFinished.wait(lock, [this]() { return !finishedSnapshots.empty(); });
+        freeSnapshots.push_back(renderedSnapshot);
+        renderedSnapshot = finishedSnapshots.front();
+        finishedSnapshots.pop_front();
+        framesInFlight--;
+    }
+    if(error)
+    {
+        std::rethrow_exception(std::exchange(error, nullptr));
+    }
+    return snapshots[renderedSnapshot];
+}
+
+void SimulationThread::threadLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true)
+    {
+        inputQueued.wait(lock, [this]() { return stopping || !inputs.empty(); });
+        if(stopping) return;
+        simulateFrame(lock);
+    }
+}
+
+void SimulationThread::simulateFrame(std::unique_lock<std::mutex>& lock)
+{
+    // There is always a free snapshot, at most queueDepth + 1 frames are in flight besides the one being rendered
+    FrameInput input = std::move(inputs.front());
+    inputs.pop_front();
+    uint32_t index = freeSnapshots.back();
+    freeSnapshots.pop_back();
+    RenderSnapshot& snapshot = snapshots[index];
+    snapshot.frame = ++frameCount;
+
+    lock.unlock();
+    std::exception_ptr frameError{};
+    try
+    {
+        function(input, snapshot);
+    }
+    catch(...)
+    {
+        frameError = std::current_exception();
+    }
+    lock.lock();
+
+    if(frameError && !error)
+    {
+        error = frameError;
+    }
+    finishedSnapshots.push_back(index);
+    frameFinished.notify_one();
+}
+} // namespace core
@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <cstdint>
+
+#include "render_snapshot.hpp"
+
+namespace core
+{
+    // Runs the simulation on its own thread while the calling thread renders
+    // Every frame the render thread hands over its input and gets back the snapshot of an earlier frame, so frame N is
+    // recorded while the simulation already works on frame N + 1 and a frame takes the longer of the two instead of their sum
+    // The simulation thread owns everything the frame function touches until the object is destroyed
+    class SimulationThread
+    {
+        public:
+            using FrameFunction = std::function<void(const FrameInput& input, RenderSnapshot& snapshot)>;
+
+            // How many frames the simulation may run ahead of rendering, each one adds a frame of latency
+            static constexpr uint32_t DEFAULT_QUEUE_DEPTH = 1;
+
+            // A queue depth of 0 simulates on the calling thread, frames are then simulated and rendered one after the other
+            explicit SimulationThread(FrameFunction _function, uint32_t _queueDepth = DEFAULT_QUEUE_DEPTH);
+            // Frames that were not simulated yet are dropped
+            ~SimulationThread();
+
+            SimulationThread(const SimulationThread&) = delete;
+            SimulationThread& operator=(const SimulationThread&) = delete;
+
+            // Queues the input of the next frame and returns the snapshot of the frame queueDepth frames before it,
+            // waiting for the simulation if it is behind. The first frames return an empty snapshot
+            // The snapshot stays unchanged until the next call, exceptions thrown by the frame function are rethrown here
+            const RenderSnapshot& advance(const FrameInput& input);
+
+            uint32_t getQueueDepth() const { return queueDepth; }
+            // The thread the frame function runs on, the calling one for a queue depth of 0
+            std::thread::id getThreadID() const { return thread.joinable() ? thread.get_id() : std::this_thread::get_id(); }
+
+        private:
+            void threadLoop();
+            // Simulates the oldest queued input, the lock is released while the frame function runs
+            void simulateFrame(std::unique_lock<std::mutex>& lock);
+
+            FrameFunction function;
+            uint32_t queueDepth;
+
+            // queueDepth frames in flight, one more being queued and the one being rendered
+            std::vector<RenderSnapshot> snapshots{};
+            std::vector<uint32_t> freeSnapshots{};
+            std::deque<uint32_t> finishedSnapshots{};
+            uint32_t renderedSnapshot = 0;
+            std::deque<FrameInput> inputs{};
+            uint32_t framesInFlight = 0; // Queued and not returned by advance yet
+            uint64_t frameCount = 0;
+            std::exception_ptr error{};
+            bool stopping = false;
+
+            std::mutex mutex;
+            std::condition_variable inputQueued;
+            std::condition_variable frameFinished;
+            std::thread thread{};
+    };
+} // namespace core
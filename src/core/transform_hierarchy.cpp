@@ -0,0 +1,134 @@
+#include "transform_hierarchy.hpp"
+#include "utils/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace core
+{
+void TransformHierarchy::rebuild(std::span<Transform> transforms)
+{
+    const size_t count = transforms.size();
+    builtVersion = Transform::getHierarchyVersion();
+    builtData = transforms.data();
+    builtCount = count;
+
+    // Parents inside the array are found by address since the transforms are contiguous
+    std::vector<int32_t> localParents(count, -1);
+    for(size_t i = 0; i < count; i++)
+    {
+        const Transform* parent = transforms[i].getParent();
+        if(parent >= transforms.data() && parent < transforms.data() + count)
+        {
+            localParents[i] = static_cast<int32_t>(parent - transforms.data());
+        }
+    }
+
+    // Depth of every node, each chain is only walked until it reaches a node with a known depth
+    std::vector<int32_t> depths(count, -1);
+    std::vector<int32_t> path{};
+    int32_t maxDepth = 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        path.clear();
+        int32_t current = static_cast<int32_t>(i);
+        int32_t depth = 0;
+        while(true)
+        {
+            if(depths[current] >= 0)
+            {
+                depth = depths[current] + 1;
+                break;
+            }
+            path.push_back(current);
+            if(localParents[current] < 0)
+            {
+                depth = 0;
+                break;
+            }
+            current = localParents[current];
+        }
+        for(auto it = path.rbegin(); it != path.rend(); ++it)
+        {
+            depths[*it] = depth++;
+        }
+        maxDepth = std::max(maxDepth, depths[i]);
+    }
+
+    // Counting sort by depth
+    levelOffsets.assign(count > 0 ? maxDepth + 2 : 1, 0);
+    for(int32_t depth : depths)
+    {
+        levelOffsets[depth + 1]++;
+    }
+    for(size_t level = 1; level < levelOffsets.size(); level++)
+    {
+        levelOffsets[level] += levelOffsets[level - 1];
+    }
+
+    std::vector<int32_t> sortedIndices(count);
+    std::vector<size_t> cursors(levelOffsets.begin(), levelOffsets.end() - 1);
+    nodes.resize(count);
+    for(size_t i = 0; i < count; i++)
+    {
+        size_t sorted = cursors[depths[i]]++;
+        sortedIndices[i] = static_cast<int32_t>(sorted);
+        nodes[sorted] = &transforms[i];
+    }
+
+    parentIndices.resize(count);
+    for(size_t i = 0; i < count; i++)
+    {
+        parentIndices[sortedIndices[i]] = localParents[i] >= 0 ? sortedIndices[localParents[i]] : -1;
+    }
+}
+
+void TransformHierarchy::update(std::span<Transform> transforms, bool parallel)
+{
+    if(builtVersion != Transform::getHierarchyVersion() || builtData != transforms.data() || builtCount != transforms.size())
+    {
+        rebuild(transforms);
+    }
+    if(nodes.empty()) return;
+
+    // Parents outside of the set are resolved up front so the level passes only read them
+    for(size_t i = levelOffsets[0]; i < levelOffsets[1]; i++)
+    {
+        if(nodes[i]->parent != nullptr)
+        {
+            nodes[i]->parent->getTransform();
+        }
+    }
+
+    for(size_t level = 0; level + 1 < levelOffsets.size(); level++)
+    {
+        size_t begin = levelOffsets[level];
+        size_t end = levelOffsets[level + 1];
+        if(parallel && end - begin >= PARALLEL_LEVEL_SIZE)
+        {
+            ThreadPool::getGlobal().parallelFor(end - begin, PARALLEL_LEVEL_SIZE / 4, [this, begin](size_t rangeBegin, size_t rangeEnd)
+            {
+                updateRange(begin + rangeBegin, begin + rangeEnd);
+            });
+        }
+        else
+        {
+            updateRange(begin, end);
+        }
+    }
+}
+
+void TransformHierarchy::updateRange(size_t begin, size_t end)
+{
+    for(size_t i = begin; i < end; i++)
+    {
+        Transform* transform = nodes[i];
+        if(!transform->worldDirty) continue; // Clean transforms only ever have clean ancestors
+
+        const Transform* parent = parentIndices[i] >= 0 ? nodes[parentIndices[i]] : transform->parent;
+        transform->worldTransformationMatrix = parent != nullptr 
+            ? parent->worldTransformationMatrix * transform->localTransformationMatrix 
+            : transform->localTransformationMatrix;
+        transform->worldDirty = false;
+    }
+}
+} // namespace core
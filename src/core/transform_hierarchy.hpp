@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include <span>
+#include <cstdint>
+#include "components/transform.hpp"
+
+namespace core
+{
+    // Flattened, topologically sorted view of a contiguous array of transforms
+    // Parents always come before their children, so world matrices resolve in one linear pass
+    // Nodes are grouped by depth, letting each level be split across threads
+    class TransformHierarchy
+    {
+        public:
+            // Levels narrower than this are always updated on the calling thread
+            static constexpr size_t PARALLEL_LEVEL_SIZE = 4096;
+
+            // Rebuilds the ordering if the array moved, its size changed or any parent link changed since the last build
+            void update(std::span<Transform> transforms, bool parallel = true);
+            void rebuild(std::span<Transform> transforms);
+
+            size_t size() const { return nodes.size(); }
+            size_t getLevelCount() const { return levelOffsets.empty() ? 0 : levelOffsets.size() - 1; }
+
+        private:
+            void updateRange(size_t begin, size_t end);
+
+            std::vector<Transform*> nodes{};
+            std::vector<int32_t> parentIndices{}; // -1 when the parent is outside of the set
+            std::vector<size_t> levelOffsets{}; // Level i is nodes[levelOffsets[i], levelOffsets[i + 1])
+
+            uint64_t builtVersion = UINT64_MAX;
+            const Transform* builtData = nullptr;
+            size_t builtCount = 0;
+    };
+} // namespace core
@@ -7,6 +7,7 @@
 #include "modules.hpp"
 #include "core/input.hpp"
 #include "graphics/buffers/graphics_mesh.hpp"
+#include "physics/raycast.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -42,6 +43,10 @@ void Engine::init()
 {
     scene = Scene("Test");
     scene->loadScene();
+    physicsModule.setScene(scene.get());
+
+    simulation.addStepCallback([this](float stepTime) { scene->fixedUpdate(stepTime); });
+    simulation.addStepCallback([](float stepTime) { physicsModule.update(stepTime); });
 }
 
 void Engine::close()
@@ -49,8 +54,11 @@ void Engine::close()
     // graphicsModule.cleanup();
 }
 
-void Engine::update(double deltaTime)
+FrameInput Engine::update(double deltaTime)
 {
+    FrameInput input{};
+    input.deltaTime = deltaTime;
+
     glm::vec3 forward = camera.transform.forward();
     forward.y = 0;
     forward = glm::normalize(forward);
@@ -85,12 +93,7 @@ void Engine::update(double deltaTime)
 
     if(core::Input::getButtonDown(GLFW_MOUSE_BUTTON_LEFT) && !core::Input::getButton(GLFW_MOUSE_BUTTON_RIGHT))
     {
-        glm::vec2 mousePos = core::Input::getMousePosition();
-        int mouseXPos = mousePos.x;
-        int mouseYPos = mousePos.y;
-        Console::debug(std::to_string(mouseXPos) + " " + std::to_string(mouseYPos));
-        Console::debug(std::to_string(graphicsModule.getClickedObjID(mouseXPos, mouseYPos)));
-        scene->selectedObject = graphicsModule.getClickedObjID(mouseXPos, mouseYPos);
+        pickObject(core::Input::getMousePosition() - viewportOffset, input);
     }
 
     if(core::Input::getButtonDown(GLFW_MOUSE_BUTTON_RIGHT))
@@ -110,7 +113,71 @@ void Engine::update(double deltaTime)
         glfwSetInputMode(graphicsModule.getWindow()->getWindow(), GLFW_CURSOR, GLFW_CURSOR_NORMAL);
     }
 
-    scene->update(deltaTime);
+    // The camera moves every frame, the scene only in whole steps of the simulation
+    input.camera = camera;
+    return input;
+}
+
+void Engine::pickObject(glm::vec2 pixel, FrameInput& input)
+{
+    input.pickPixel = pixel;
+    input.pick = PickType::OBJECT;
+    const VkExtent2D& viewportSize = graphicsModule.viewportSize;
+    if(pixel.x < 0.0f || pixel.y < 0.0f || pixel.x >= viewportSize.width || pixel.y >= viewportSize.height)
+    {
+        input.pickedObject = -1;
+        return;
+    }
+    if(graphicsModule.isIdBufferEnabled())
+    {
+        std::unique_lock<std::mutex> meshLock = graphicsModule.lockMeshes(); // The readback submits to the queue
+        input.pickedObject = graphicsModule.getClickedObjID(static_cast<uint32_t>(pixel.x), static_cast<uint32_t>(pixel.y));
+        return;
+    }
+
+    // The physics scene belongs to the simulation thread, it casts the ray
+    // Both faces are hit, like the ID pass which draws without culling
+    input.pick = PickType::RAY;
+    camera.getPixelRay(pixel, glm::vec2(viewportSize.width, viewportSize.height), input.rayOrigin, input.rayDirection, input.rayLength);
+}
+
+void Engine::simulate(const FrameInput& input, RenderSnapshot& snapshot)
+{
+    if(input.pick != PickType::NONE)
+    {
+        scene->selectedObject = input.pick == PickType::RAY
+            ? physics::Raycast(input.rayOrigin, input.rayDirection, input.rayLength).hitObj
+            : input.pickedObject;
+        Console::debug(std::to_string(static_cast<int>(input.pickPixel.x)) + " " + std::to_string(static_cast<int>(input.pickPixel.y))
+            + " -> " + std::to_string(scene->selectedObject));
+    }
+
+    simulation.advance(input.deltaTime);
+    snapshot.camera = input.camera;
+    snapshot.simulationSteps = simulation.getStats().steps;
+    snapshot.droppedTime = simulation.getStats().droppedTime;
+    scene->buildSnapshot(snapshot, simulation.getAlpha());
+    ObjectManager::captureListing(snapshot.objects);
+}
+
+void Engine::render(const RenderSnapshot& snapshot)
+{
+    if(snapshot.frame > 0)
+    {
+        renderCamera = snapshot.camera;
+    }
+    // Meshes created by the simulation meanwhile wait until the frame is recorded
+    std::unique_lock<std::mutex> meshLock = graphicsModule.lockMeshes();
+    graphicsModule.drawSkybox();
+    for(const RenderSnapshot::Draw& draw : snapshot.draws)
+    {
+        graphicsModule.drawMesh(draw.meshID, draw.bounds, static_cast<uint32_t>(draw.materialID), draw.transform, draw.objectID);
+        if(draw.outlined)
+        {
+            graphicsModule.drawMeshOutline(draw.meshID, draw.bounds, draw.transform);
+        }
+    }
+    graphicsModule.drawFrame();
 }
 
 
@@ -156,9 +223,16 @@ void Engine::run()
     // );
     camera.transform.setPosition(glm::vec3(0.0f, 2.0f, -5.0f));
     camera.transform.setPosition(glm::vec3(glm::radians(20.0f), 0.0f, 0.0f));
-    // camera.transform.parent = &scene->getGameObjects()[0]->transform;
+    // camera.transform.setParent(&scene->getGameObjects()[0]->transform);
 
-    graphicsModule.setCamera(&camera);
+    renderCamera = camera;
+    graphicsModule.setCamera(&renderCamera);
+
+    // From here on the scene and physics are only touched by the simulation thread
+    simulationThread = std::make_unique<SimulationThread>(
+        [this](const FrameInput& input, RenderSnapshot& snapshot) { simulate(input, snapshot); }, FRAME_QUEUE_DEPTH);
+    ObjectManager::setOwningThread(simulationThread->getThreadID());
+    const RenderSnapshot* lastSnapshot = nullptr;
 
     VkDescriptorSet viewPortDS = nullptr;
 
@@ -172,6 +246,7 @@ void Engine::run()
         
         if(core::Input::getKeyDown(GLFW_KEY_R))
         {
+            std::unique_lock<std::mutex> meshLock = graphicsModule.lockMeshes();
             graphicsModule.reloadShaders();
         }
 
@@ -186,8 +261,17 @@ void Engine::run()
         ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0,0));
         ImGui::Begin("Viewport", nullptr, ImGuiWindowFlags_NoDecoration);
         ImVec2 size = ImGui::GetContentRegionAvail();
+        ImVec2 imagePos = ImGui::GetCursorScreenPos() - ImGui::GetMainViewport()->Pos;
+        viewportOffset = glm::vec2(imagePos.x, imagePos.y);
         graphicsModule.viewportSize = VkExtent2D{(uint32_t)size.x, (uint32_t)size.y};
-        graphicsModule.updateExtent();
+        {
+            std::unique_lock<std::mutex> meshLock = graphicsModule.lockMeshes(); // Resizing waits for the device to be idle
+            graphicsModule.updateExtent();
+        }
+        if(size.x >= 1.0f && size.y >= 1.0f)
+        {
+            camera.setAspectRatio(size.x / size.y); // updateExtent only sets the one being rendered
+        }
         viewPortDS = graphicsModule.getViewportDescriptorSet();
         if(viewPortDS != nullptr)
         {
@@ -197,7 +281,20 @@ void Engine::run()
         ImGui::PopStyleVar(2);
 
         Console::drawImGui();
-        ObjectManager::drawImGui();
+        if(lastSnapshot != nullptr)
+        {
+            ObjectManager::drawImGui(lastSnapshot->objects);
+        }
+        graphicsModule.drawImGui();
+        ImGui::Begin("Render Stats"); // Appends to the window of the graphics module
+        if(lastSnapshot != nullptr)
+        {
+            ImGui::Text("Scene culling: %u visible, %u culled", lastSnapshot->visible, lastSnapshot->culled);
+            ImGui::Text("Simulation: %u steps in frame %llu, %.1f ms dropped", lastSnapshot->simulationSteps,
+                static_cast<unsigned long long>(lastSnapshot->frame), lastSnapshot->droppedTime * 1000.0);
+        }
+        ImGui::Text("Frame queue depth: %u", simulationThread->getQueueDepth());
+        ImGui::End();
 
         ImGui::Begin("Material Properties");
 
@@ -218,12 +315,10 @@ void Engine::run()
             break;
         }
 
-        update(deltaTime);
-
-        graphicsModule.drawSkybox();
-        scene->drawScene();
-        // Render here
-        graphicsModule.drawFrame();
+        // The simulation starts on this frame while an earlier one is recorded
+        const RenderSnapshot& snapshot = simulationThread->advance(update(deltaTime));
+        lastSnapshot = &snapshot;
+        render(snapshot);
 
 
         // Update Time
@@ -232,6 +327,8 @@ void Engine::run()
         deltaTime = time - oldTime;
         // std::cout << "Delta time: " << deltaTime << std::endl;
     }
+    simulationThread.reset();
+    ObjectManager::setOwningThread(std::this_thread::get_id());
     close();
 }
 
@@ -14,6 +14,8 @@
 #include "utils/random.hpp"
 #include "utils/console.hpp"
 #include "core/scene.hpp"
+#include "core/fixed_timestep.hpp"
+#include "core/simulation_thread.hpp"
 
 namespace core
 {
@@ -38,7 +40,18 @@ public:
 
 private:
 
-    void update(double deltaTime);
+    // How many frames the simulation runs ahead of rendering, 0 simulates and renders one after the other
+    static constexpr uint32_t FRAME_QUEUE_DEPTH = SimulationThread::DEFAULT_QUEUE_DEPTH;
+
+    // Main thread, moves the camera and collects what the simulation needs for the frame
+    FrameInput update(double deltaTime);
+    // Picks the GameObject under a pixel of the viewport with the object ID pass of graphicsModule if it is enabled
+    // Otherwise leaves a raycast through the pixel to the simulation
+    void pickObject(glm::vec2 pixel, FrameInput& input);
+    // Simulation thread, steps the scene and fills the snapshot of the frame
+    void simulate(const FrameInput& input, RenderSnapshot& snapshot);
+    // Main thread, records and submits a snapshot
+    void render(const RenderSnapshot& snapshot);
 
     static void windowRefreshCallback(GLFWwindow *window);
 
@@ -46,8 +59,13 @@ private:
     VkApplicationInfo appInfo{};
 
     Scene scene;
+    // Steps the scene and then physics at a fixed rate, frames draw between the last two steps
+    FixedTimestep simulation{};
 
     graphics::Camera camera;
+    graphics::Camera renderCamera; // The camera of the snapshot being rendered, the one graphicsModule draws with
+    std::unique_ptr<SimulationThread> simulationThread{}; // Owns the scene and physics while run is looping
+    glm::vec2 viewportOffset{}; // Top left corner of the viewport image in window coordinates
 };
 
 } // namespace core
@@ -0,0 +1,131 @@
+#include "buffer_uploader.hpp"
+
+#include <algorithm>
+
+namespace graphics
+{
+namespace
+{
+    void memoryBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+    {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    bool overlaps(const VkBufferCopy& a, const VkBufferCopy& b)
+    {
+        return a.dstOffset < b.dstOffset + b.size && b.dstOffset < a.dstOffset + a.size;
+    }
+} // namespace
+
+BufferUploader::BufferUploader(Device& _device, uint32_t _frameCount) : device(_device), frameCount(_frameCount)
+{
+    staging = std::make_unique<FrameAllocator>(device, STAGING_SLICE_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, frameCount);
+}
+
+BufferUploader::~BufferUploader()
+{
+    retiredBuffers.clear();
+    staging.reset();
+}
+
+void BufferUploader::beginFrame(uint32_t frameIndex)
+{
+    staging->beginFrame(frameIndex);
+    copies.clear();
+    stagedBytes = 0;
+
+    for(size_t i = 0; i < retiredBuffers.size();)
+    {
+        if(--retiredBuffers[i].framesRemaining == 0)
+        {
+            retiredBuffers[i] = std::move(retiredBuffers.back());
+            retiredBuffers.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void* BufferUploader::stage(VkBuffer destination, VkDeviceSize offset, VkDeviceSize size)
+{
+    FrameAllocator::Allocation allocation = staging->allocate(size, 16);
+    copies.push_back({allocation.buffer, destination, {allocation.offset, offset, size}});
+    stagedBytes += size;
+    return allocation.mapped;
+}
+
+void BufferUploader::retire(std::unique_ptr<Buffer> buffer)
+{
+    if(buffer != nullptr)
+    {
+        retiredBuffers.push_back({std::move(buffer), frameCount + 1});
+    }
+}
+
+void BufferUploader::record(VkCommandBuffer commandBuffer)
+{
+    if(copies.empty())
+    {
+        return;
+    }
+
+    // Earlier frames may still be drawing from the ranges that are about to be overwritten
+    memoryBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, 0);
+
+    // Consecutive copies between the same buffers share a command, a range staged twice is ordered by a barrier
+    std::vector<VkBufferCopy> regions{};
+    std::vector<const Copy*> written{};
+    for(size_t first = 0; first < copies.size();)
+    {
+        size_t last = first;
+        regions.clear();
+        while(last < copies.size() && copies[last].source == copies[first].source && copies[last].destination == copies[first].destination)
+        {
+            const Copy& copy = copies[last];
+            bool rewritten = std::any_of(written.begin(), written.end(),
+                [&](const Copy* other) { return other->destination == copy.destination && overlaps(other->region, copy.region); });
+            if(rewritten)
+            {
+                break;
+            }
+            regions.push_back(copy.region);
+            written.push_back(&copy);
+            last++;
+        }
+
+        if(regions.empty())
+        {
+            memoryBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+            written.clear();
+            continue;
+        }
+        vkCmdCopyBuffer(commandBuffer, copies[first].source, copies[first].destination, static_cast<uint32_t>(regions.size()), regions.data());
+        first = last;
+    }
+
+    memoryBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
+    copies.clear();
+}
+
+void BufferUploader::flush()
+{
+    if(copies.empty())
+    {
+        return;
+    }
+    VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+    record(commandBuffer);
+    device.endSingleTimeCommands(commandBuffer);
+}
+} // namespace graphics
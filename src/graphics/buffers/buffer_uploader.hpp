@@ -0,0 +1,63 @@
+#pragma once
+
+#include "graphics/internal/device.hpp"
+#include "buffer.hpp"
+#include "frame_allocator.hpp"
+
+#include <vector>
+#include <memory>
+
+namespace graphics
+{
+    // Streams partial updates into device local buffers without stalling
+    // Data is written into a ring of per-frame staging slices and copied by the next recorded frame, ahead of its passes
+    // Buffers replaced while frames are in flight are handed over with retire() and destroyed once no frame can use them
+    class BufferUploader
+    {
+    public:
+        static constexpr VkDeviceSize STAGING_SLICE_SIZE = 8 * 1024 * 1024;
+
+        BufferUploader(Device& _device, uint32_t _frameCount);
+        ~BufferUploader();
+
+        BufferUploader(const BufferUploader&) = delete;
+        BufferUploader& operator=(const BufferUploader&) = delete;
+
+        // The GPU must be done with the frame, pending copies must have been recorded or flushed
+        void beginFrame(uint32_t frameIndex);
+
+        // Returns where to write size bytes that will be copied to destination at offset
+        void* stage(VkBuffer destination, VkDeviceSize offset, VkDeviceSize size);
+        void retire(std::unique_ptr<Buffer> buffer);
+
+        // Records every staged copy, guarded against the draws of earlier frames and visible to vertex input and shaders
+        // Must be called outside of a render pass
+        void record(VkCommandBuffer commandBuffer);
+        // Submits the staged copies on their own and waits for them, for frames that are skipped
+        void flush();
+
+        bool hasPendingCopies() const { return !copies.empty(); }
+        VkDeviceSize getStagedBytes() const { return stagedBytes; }
+
+    private:
+        struct Copy
+        {
+            VkBuffer source;
+            VkBuffer destination;
+            VkBufferCopy region;
+        };
+
+        Device& device;
+        uint32_t frameCount;
+        std::unique_ptr<FrameAllocator> staging{};
+        std::vector<Copy> copies{};
+        VkDeviceSize stagedBytes = 0; // Since the last beginFrame
+
+        struct RetiredBuffer
+        {
+            std::unique_ptr<Buffer> buffer;
+            uint32_t framesRemaining;
+        };
+        std::vector<RetiredBuffer> retiredBuffers{};
+    };
+} // namespace graphics
@@ -0,0 +1,95 @@
+#include "frame_allocator.hpp"
+#include "utils/console.hpp"
+
+#include <cassert>
+#include <algorithm>
+#include <string>
+
+namespace graphics
+{
+FrameAllocator::FrameAllocator(Device& _device, VkDeviceSize _sliceSize, VkBufferUsageFlags _usage, uint32_t _sliceCount)
+    : device(_device), usage(_usage), sliceSize(_sliceSize), sliceCount(_sliceCount)
+{
+    assert(sliceCount > 0 && "Frame allocator needs at least one slice");
+    buffer = std::make_unique<Buffer>(
+        device,
+        sliceSize,
+        sliceCount,
+        usage,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+    buffer->map(); // Stays mapped for the lifetime of the allocator
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    retiredBuffers.clear();
+    buffer.reset();
+}
+
+void FrameAllocator::beginFrame(uint32_t frameIndex)
+{
+    currentSlice = frameIndex % sliceCount;
+    sliceStart = sliceSize * currentSlice;
+    head = sliceStart;
+
+    for(size_t i = 0; i < retiredBuffers.size();)
+    {
+        if(--retiredBuffers[i].framesRemaining == 0)
+        {
+            retiredBuffers[i] = std::move(retiredBuffers.back());
+            retiredBuffers.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+FrameAllocator::Allocation FrameAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+    if(offset + size > sliceStart + sliceSize)
+    {
+        grow(offset - sliceStart + size);
+        offset = (head + alignment - 1) / alignment * alignment;
+    }
+    head = offset + size;
+    peakUsedBytes = std::max(peakUsedBytes, head - sliceStart);
+
+    Allocation allocation{};
+    allocation.buffer = buffer->getBuffer();
+    allocation.offset = offset;
+    allocation.size = size;
+    allocation.mapped = static_cast<char*>(buffer->getMappedMemory()) + offset;
+    return allocation;
+}
+
+void FrameAllocator::grow(VkDeviceSize minimumSliceSize)
+{
+    VkDeviceSize newSliceSize = sliceSize * 2;
+    while(newSliceSize < minimumSliceSize)
+    {
+        newSliceSize *= 2;
+    }
+    Console::warn("Frame allocator slice overflowed, growing from " + std::to_string(sliceSize) +
+        " to " + std::to_string(newSliceSize) + " bytes", "FrameAllocator");
+
+    // Allocations made earlier this frame still point at the old buffer
+    retiredBuffers.push_back({std::move(buffer), sliceCount + 1});
+
+    sliceSize = newSliceSize;
+    buffer = std::make_unique<Buffer>(
+        device,
+        sliceSize,
+        sliceCount,
+        usage,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+    buffer->map();
+
+    sliceStart = sliceSize * currentSlice;
+    head = sliceStart;
+}
+} // namespace graphics
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "graphics/internal/device.hpp"
+#include "buffer.hpp"
+
+#include <vector>
+#include <memory>
+#include <cstring>
+
+namespace graphics
+{
+    // Linear (bump) allocator for transient GPU data that only lives for one frame, such as instance matrices
+    // Backed by a single persistently mapped buffer that is split into one slice per frame in flight
+    class FrameAllocator
+    {
+    public:
+        struct Allocation
+        {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            VkDeviceSize offset = 0;
+            VkDeviceSize size = 0;
+            void* mapped = nullptr;
+
+            explicit operator bool() const { return mapped != nullptr; }
+        };
+
+        FrameAllocator(Device& _device, VkDeviceSize _sliceSize, VkBufferUsageFlags _usage, uint32_t _sliceCount);
+        ~FrameAllocator();
+
+        FrameAllocator(const FrameAllocator&) = delete;
+        FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+        // Rewinds the allocator to the start of the slice owned by frameIndex
+        // The caller must guarantee the GPU is no longer reading that slice
+        void beginFrame(uint32_t frameIndex);
+
+        Allocation allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+        template<class T>
+        Allocation write(const T* data, size_t count)
+        {
+            Allocation allocation = allocate(sizeof(T) * count, alignof(T));
+            memcpy(allocation.mapped, data, sizeof(T) * count);
+            return allocation;
+        }
+
+        VkDeviceSize getUsedBytes() const { return head - sliceStart; }
+        VkDeviceSize getPeakUsedBytes() const { return peakUsedBytes; }
+        VkDeviceSize getSliceSize() const { return sliceSize; }
+
+    private:
+        void grow(VkDeviceSize minimumSliceSize);
+
+        Device& device;
+        VkBufferUsageFlags usage;
+        VkDeviceSize sliceSize;
+        uint32_t sliceCount;
+
+        std::unique_ptr<Buffer> buffer{};
+        uint32_t currentSlice = 0;
+        VkDeviceSize sliceStart = 0;
+        VkDeviceSize head = 0;
+        VkDeviceSize peakUsedBytes = 0;
+
+        // Buffers replaced by grow() may still be referenced by frames in flight, so they are
+        // kept alive until every slice has been cycled through once
+        struct RetiredBuffer
+        {
+            std::unique_ptr<Buffer> buffer;
+            uint32_t framesRemaining;
+        };
+        std::vector<RetiredBuffer> retiredBuffers{};
+    };
+} // namespace graphics
@@ -1,13 +1,89 @@
 #include "graphics_mesh.hpp"
+#include "utils/thread_pool.hpp"
+#include "core/meshlet_builder.hpp"
 
+#include <glm/gtc/packing.hpp>
 #include <cassert>
 #include <cstring>
+#include <cstdio>
+#include <algorithm>
 
 using Vertex = core::MeshData::Vertex;
 using Triangle = core::MeshData::Triangle;
 
 namespace graphics
 {
+static_assert(sizeof(CompactVertex) == 28, "CompactVertex must match VertexData in shaderInputs.slang");
+static_assert(sizeof(GpuMeshlet) == 64, "GpuMeshlet must match Meshlet in meshlet_cull.slang");
+
+VertexFormat GraphicsMesh::vertexFormat = VertexFormat::COMPACT;
+
+namespace
+{
+    // Maps a unit vector onto the octahedron and unfolds it into [-1, 1]^2, decoded by octDecode in shaderInputs.slang
+    glm::vec2 octEncode(glm::vec3 vector)
+    {
+        float sum = glm::abs(vector.x) + glm::abs(vector.y) + glm::abs(vector.z);
+        if(sum <= 0.0f)
+        {
+            return glm::vec2(0.0f);
+        }
+        vector /= sum;
+        glm::vec2 encoded(vector.x, vector.y);
+        if(vector.z < 0.0f)
+        {
+            encoded.x = (1.0f - glm::abs(vector.y)) * (vector.x >= 0.0f ? 1.0f : -1.0f);
+            encoded.y = (1.0f - glm::abs(vector.x)) * (vector.y >= 0.0f ? 1.0f : -1.0f);
+        }
+        return encoded;
+    }
+
+    // Writes vertices in the layout of the vertex buffer, straight into mapped staging memory
+    void writeVertices(const Vertex* vertices, size_t count, void* destination, VertexFormat format)
+    {
+        if(format == VertexFormat::FULL)
+        {
+            memcpy(destination, vertices, sizeof(Vertex) * count);
+            return;
+        }
+        CompactVertex* compactVertices = static_cast<CompactVertex*>(destination);
+        ThreadPool::getGlobal().parallelFor(count, 16384, [&](size_t begin, size_t end)
+        {
+            for(size_t i = begin; i < end; i++)
+            {
+                compactVertices[i] = GraphicsMesh::encodeVertex(vertices[i]);
+            }
+        });
+    }
+
+    // Writes triangles as 16 or 32 bit indices
+    void writeIndices(const Triangle* triangles, size_t count, void* destination, VkIndexType indexType)
+    {
+        if(indexType == VK_INDEX_TYPE_UINT32)
+        {
+            memcpy(destination, triangles, sizeof(Triangle) * count);
+            return;
+        }
+        const uint32_t* indices = &triangles[0].v0;
+        uint16_t* shortIndices = static_cast<uint16_t*>(destination);
+        for(size_t i = 0; i < count * 3; i++)
+        {
+            shortIndices[i] = static_cast<uint16_t>(indices[i]);
+        }
+    }
+} // namespace
+
+CompactVertex GraphicsMesh::encodeVertex(const Vertex& vertex)
+{
+    CompactVertex compact{};
+    compact.position = vertex.position;
+    compact.normal = glm::packSnorm2x16(octEncode(vertex.normal));
+    compact.tangent = glm::packSnorm2x16(octEncode(glm::vec3(vertex.tangent)));
+    compact.texCoord = glm::packHalf2x16(vertex.texCoord);
+    compact.color = glm::packUnorm4x8(glm::vec4(vertex.color, vertex.tangent.w < 0.0f ? 0.0f : 1.0f));
+    return compact;
+}
+
 // GraphicsMesh::GraphicsMesh(Device& _device, const Builder& builder) : device(_device)
 // {
 //     createVertexBuffer(builder.vertices);
@@ -18,24 +94,28 @@ GraphicsMesh::GraphicsMesh(core::MeshData* mesh) : meshPtr(mesh)
 {
     vertexCount = mesh->vertices.size();
     indexCount = mesh->triangles.size() * 3;
+
     createBuffers();
 }
 
 GraphicsMesh::~GraphicsMesh(){}
 
-void GraphicsMesh::bind(VkCommandBuffer commandBuffer, const std::unique_ptr<Buffer> &instanceBuffer)
+void GraphicsMesh::bind(VkCommandBuffer commandBuffer, VkBuffer instanceBuffer, VkDeviceSize instanceOffset)
 {
-    VkBuffer buffers[] = {vertexBuffer->getBuffer(), instanceBuffer->getBuffer()};
-    VkDeviceSize offsets[] = {0, 0};
+    VkBuffer buffers[] = {vertexBuffer->getBuffer(), instanceBuffer};
+    VkDeviceSize offsets[] = {0, instanceOffset};
     vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
     if(useIndexBuffer)
-        vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, indexType);
 }
 
-void GraphicsMesh::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount)
+void GraphicsMesh::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t lod)
 {
     if(useIndexBuffer)
-        vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, 0);
+    {
+        const LodRange& range = lods[std::min(lod, getLodCount() - 1)];
+        vkCmdDrawIndexed(commandBuffer, range.indexCount, instanceCount, range.firstIndex, 0, 0);
+    }
     else
         vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, 0);
 }
@@ -51,8 +131,9 @@ void GraphicsMesh::createVertexBuffer()
     std::vector<Vertex> &vertices = meshPtr->vertices; // Reference to triangles array for easy access
 
     assert(vertexCount >= 3 && "Vertex count must be at least 3");
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-    uint32_t vertexSize = sizeof(vertices[0]);
+
+    uint32_t vertexSize = vertexFormat == VertexFormat::COMPACT ? sizeof(CompactVertex) : sizeof(Vertex);
+    VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexSize) * vertexCount;
 
     Buffer stagingBuffer{
         *Shared::device,
@@ -63,8 +144,9 @@ void GraphicsMesh::createVertexBuffer()
     };
 
     stagingBuffer.map();
-    stagingBuffer.writeToBuffer((void *)vertices.data());
+    writeVertices(vertices.data(), vertexCount, stagingBuffer.getMappedMemory(), vertexFormat);
 
+    vertexCapacity = vertexCount;
     vertexBuffer = std::make_unique<Buffer>(
         *Shared::device,
         vertexSize,
@@ -84,17 +166,62 @@ void GraphicsMesh::createIndexBuffer()
         return;
     }
     
-    std::vector<Triangle> &triangles = meshPtr->triangles; // Reference to triangles array for easy access
+    // Every level of detail goes into one buffer so switching levels only changes the draw range
+    // Dense meshes are also split into meshlets level by level, which reorders the triangles of each level
+    const bool buildMeshlets = meshPtr->triangles.size() >= MESHLET_MIN_TRIANGLES;
+    const bool concatenate = buildMeshlets || !meshPtr->lods.empty();
+    meshletOrdered = buildMeshlets;
+    std::vector<Triangle> allTriangles{};
+    std::vector<GpuMeshlet> meshlets{};
+    lods.clear();
+    auto addLevel = [&](const std::vector<Triangle>& levelTriangles, float error)
+    {
+        LodRange range{};
+        range.firstIndex = lods.empty() ? 0 : lods.back().firstIndex + lods.back().indexCount;
+        range.indexCount = static_cast<uint32_t>(levelTriangles.size()) * 3;
+        range.error = error;
+        if(buildMeshlets)
+        {
+            std::vector<Triangle> reordered = levelTriangles;
+            std::vector<core::Meshlet> levelMeshlets = core::MeshletBuilder::build(meshPtr->vertices, reordered);
+            range.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+            range.meshletCount = static_cast<uint32_t>(levelMeshlets.size());
+            for(const core::Meshlet& meshlet : levelMeshlets)
+            {
+                GpuMeshlet gpuMeshlet{};
+                gpuMeshlet.sphere = glm::vec4(meshlet.center, meshlet.radius);
+                gpuMeshlet.cone = glm::vec4(meshlet.coneAxis, meshlet.coneCutoff);
+                gpuMeshlet.coneApex = glm::vec4(meshlet.coneApex, 0.0f);
+                gpuMeshlet.firstIndex = range.firstIndex + meshlet.firstTriangle * 3;
+                gpuMeshlet.indexCount = meshlet.triangleCount * 3;
+                meshlets.push_back(gpuMeshlet);
+            }
+            allTriangles.insert(allTriangles.end(), reordered.begin(), reordered.end());
+        }
+        else if(concatenate)
+        {
+            allTriangles.insert(allTriangles.end(), levelTriangles.begin(), levelTriangles.end());
+        }
+        lods.push_back(range);
+    };
+
+    addLevel(meshPtr->triangles, 0.0f);
+    for(const core::MeshData::Lod& lod : meshPtr->lods)
+    {
+        addLevel(lod.triangles, lod.error);
+    }
+    std::vector<Triangle> &triangles = concatenate ? allTriangles : meshPtr->triangles;
 
     indexCount = static_cast<uint32_t>(triangles.size()) * 3;
-    useIndexBuffer = indexCount > 0;
+    useIndexBuffer = lods[0].indexCount > 0;
 
     if(!useIndexBuffer)
         return;
 
-    VkDeviceSize bufferSize = sizeof(triangles[0].v0) * indexCount;
-    
-    uint32_t indexSize = sizeof(triangles[0].v0);
+    // Halves the index memory and bandwidth for meshes where every index fits in 16 bits
+    indexType = vertexCount < 65536 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    uint32_t indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    VkDeviceSize bufferSize = static_cast<VkDeviceSize>(indexSize) * indexCount;
 
     Buffer stagingBuffer{
         *Shared::device,
@@ -105,8 +232,9 @@ void GraphicsMesh::createIndexBuffer()
     };
 
     stagingBuffer.map();
-    stagingBuffer.writeToBuffer((void *)triangles.data());
+    writeIndices(triangles.data(), triangles.size(), stagingBuffer.getMappedMemory(), indexType);
 
+    indexCapacity = indexCount;
     indexBuffer = std::make_unique<Buffer>(
         *Shared::device,
         indexSize,
@@ -116,69 +244,214 @@ void GraphicsMesh::createIndexBuffer()
     );
 
     Shared::device->copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+
+    if(buildMeshlets)
+    {
+        createMeshletBuffer(meshlets);
+    }
+}
+
+void GraphicsMesh::createMeshletBuffer(const std::vector<GpuMeshlet>& meshlets)
+{
+    char message[128];
+    snprintf(message, sizeof(message), "Split %u triangles into %u meshlets", lods[0].indexCount / 3, lods[0].meshletCount);
+    Console::log(message, "GraphicsMesh");
+
+    Buffer stagingBuffer{
+        *Shared::device,
+        sizeof(GpuMeshlet),
+        static_cast<uint32_t>(meshlets.size()),
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+    };
+
+    stagingBuffer.map();
+    stagingBuffer.writeToBuffer(const_cast<GpuMeshlet*>(meshlets.data()));
+
+    meshletBuffer = std::make_unique<Buffer>(
+        *Shared::device,
+        sizeof(GpuMeshlet),
+        static_cast<uint32_t>(meshlets.size()),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+    );
+
+    Shared::device->copyBuffer(stagingBuffer.getBuffer(), meshletBuffer->getBuffer(), sizeof(GpuMeshlet) * meshlets.size());
 }
 
 void GraphicsMesh::createBuffers()
 {
     createVertexBuffer();
     createIndexBuffer();
+    meshPtr->clearDirtyRanges();
+}
+
+bool GraphicsMesh::update(BufferUploader& uploader)
+{
+    using DirtyRange = core::MeshData::DirtyRange;
+    const std::vector<Vertex>& vertices = meshPtr->vertices;
+    const std::vector<Triangle>& triangles = meshPtr->triangles;
+    const uint32_t newVertexCount = static_cast<uint32_t>(vertices.size());
+    const uint32_t newIndexCount = static_cast<uint32_t>(triangles.size()) * 3;
+
+    // Levels of detail and meshlets are built from the whole index buffer, so their ranges can not be patched
+    // The meshlet order stays in the index buffer after the meshlets are retired, so triangle indices no longer match it
+    const bool trianglesChanged = !meshPtr->getDirtyTriangles().empty() || newIndexCount != lods[0].indexCount;
+    if((trianglesChanged && (lods.size() > 1 || meshletOrdered)) || meshPtr->lods.size() + 1 != lods.size())
+    {
+        return false;
+    }
+    // Widening the indices rewrites all of them
+    if(newVertexCount < 3 || (newIndexCount > 0 && indexType == VK_INDEX_TYPE_UINT16 && newVertexCount >= 65536))
+    {
+        return false;
+    }
+
+    // Appended elements are uploaded even if they were not marked
+    if(newVertexCount > vertexCount)
+    {
+        meshPtr->markVerticesDirty(vertexCount, newVertexCount - vertexCount);
+    }
+    if(newIndexCount > lods[0].indexCount)
+    {
+        meshPtr->markTrianglesDirty(lods[0].indexCount / 3, (newIndexCount - lods[0].indexCount) / 3);
+    }
+
+    const uint32_t vertexSize = vertexFormat == VertexFormat::COMPACT ? sizeof(CompactVertex) : sizeof(Vertex);
+    std::vector<DirtyRange> vertexRanges = meshPtr->getDirtyVertices();
+    if(newVertexCount > vertexCapacity)
+    {
+        // The new buffer starts out empty, so everything is uploaded once
+        vertexCapacity = std::max(newVertexCount, vertexCapacity * 2);
+        uploader.retire(std::move(vertexBuffer));
+        vertexBuffer = std::make_unique<Buffer>(
+            *Shared::device,
+            vertexSize,
+            vertexCapacity,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+        vertexRanges = {{0, newVertexCount}};
+    }
+    for(const DirtyRange& range : vertexRanges)
+    {
+        const uint32_t end = std::min(range.end, newVertexCount);
+        if(range.begin >= end)
+        {
+            continue;
+        }
+        void* staged = uploader.stage(vertexBuffer->getBuffer(), static_cast<VkDeviceSize>(vertexSize) * range.begin,
+            static_cast<VkDeviceSize>(vertexSize) * (end - range.begin));
+        writeVertices(vertices.data() + range.begin, end - range.begin, staged, vertexFormat);
+    }
+
+    // Meshlet bounds are only computed on creation, deforming meshes are drawn without meshlet culling from now on
+    if(hasMeshlets() && !vertexRanges.empty())
+    {
+        Console::log("Mesh " + meshPtr->name + " is deformed, meshlet culling is disabled for it", "GraphicsMesh");
+        uploader.retire(std::move(meshletBuffer));
+        for(LodRange& range : lods)
+        {
+            range.firstMeshlet = range.meshletCount = 0;
+        }
+    }
+
+    if(trianglesChanged)
+    {
+        // A mesh without triangles so far gets an index buffer in the same format createIndexBuffer would pick
+        if(indexBuffer == nullptr)
+        {
+            indexType = newVertexCount < 65536 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        }
+        const uint32_t indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+        std::vector<DirtyRange> triangleRanges = meshPtr->getDirtyTriangles();
+        if(newIndexCount > indexCapacity)
+        {
+            indexCapacity = std::max(newIndexCount, indexCapacity * 2);
+            uploader.retire(std::move(indexBuffer));
+            indexBuffer = std::make_unique<Buffer>(
+                *Shared::device,
+                indexSize,
+                indexCapacity,
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+            triangleRanges = {{0, newIndexCount / 3}};
+        }
+        for(const DirtyRange& range : triangleRanges)
+        {
+            const uint32_t end = std::min(range.end, newIndexCount / 3);
+            if(range.begin >= end)
+            {
+                continue;
+            }
+            void* staged = uploader.stage(indexBuffer->getBuffer(), static_cast<VkDeviceSize>(indexSize) * 3 * range.begin,
+                static_cast<VkDeviceSize>(indexSize) * 3 * (end - range.begin));
+            writeIndices(triangles.data() + range.begin, end - range.begin, staged, indexType);
+        }
+
+        indexCount = newIndexCount;
+        lods[0].indexCount = newIndexCount;
+        useIndexBuffer = newIndexCount > 0;
+    }
+    vertexCount = newVertexCount;
+
+    meshPtr->clearDirtyRanges();
+    return true;
 }
 
 std::vector<VkVertexInputBindingDescription> GraphicsMesh::getVertexBindingDescriptions()
 {
     std::vector<VkVertexInputBindingDescription> bindingDescriptions(2);
     bindingDescriptions[0].binding = 0;
-    bindingDescriptions[0].stride = sizeof(Vertex);
+    bindingDescriptions[0].stride = vertexFormat == VertexFormat::COMPACT ? sizeof(CompactVertex) : sizeof(Vertex);
     bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
     // Instance data
     bindingDescriptions[1].binding = 1;
-    bindingDescriptions[1].stride = sizeof(glm::mat4);
+    bindingDescriptions[1].stride = sizeof(InstanceData);
     bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
     return bindingDescriptions;
 }
 
 std::vector<VkVertexInputAttributeDescription> GraphicsMesh::getVertexAttributeDescriptions()
 {
-    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(10);
-    attributeDescriptions[0].binding = 0;
-    attributeDescriptions[0].location = 0;
-    attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-    attributeDescriptions[0].offset = offsetof(Vertex, position);
-
-    attributeDescriptions[1].binding = 0;
-    attributeDescriptions[1].location = 1;
-    attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-    attributeDescriptions[1].offset = offsetof(Vertex, normal);
-
-    attributeDescriptions[2].binding = 0;
-    attributeDescriptions[2].location = 2;
-    attributeDescriptions[2].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-    attributeDescriptions[2].offset = offsetof(Vertex, tangent);
-
-    attributeDescriptions[3].binding = 0;
-    attributeDescriptions[3].location = 3;
-    attributeDescriptions[3].format = VK_FORMAT_R32G32B32_SFLOAT;
-    attributeDescriptions[3].offset = offsetof(Vertex, bitangent);
-
-    attributeDescriptions[4].binding = 0;
-    attributeDescriptions[4].location = 4;
-    attributeDescriptions[4].format = VK_FORMAT_R32G32B32_SFLOAT;
-    attributeDescriptions[4].offset = offsetof(Vertex, color);
-
-    attributeDescriptions[5].binding = 0;
-    attributeDescriptions[5].location = 5;
-    attributeDescriptions[5].format = VK_FORMAT_R32G32_SFLOAT;
-    attributeDescriptions[5].offset = offsetof(Vertex, texCoord);
-
-    // Instance attributes
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+    auto addAttribute = [&](uint32_t binding, VkFormat format, uint32_t offset)
+    {
+        VkVertexInputAttributeDescription description{};
+        description.binding = binding;
+        description.location = static_cast<uint32_t>(attributeDescriptions.size());
+        description.format = format;
+        description.offset = offset;
+        attributeDescriptions.push_back(description);
+    };
+
+    if(vertexFormat == VertexFormat::COMPACT)
+    {
+        // The fixed function input unpacks these, only the octahedral vectors are decoded in the shader
+        addAttribute(0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(CompactVertex, position));
+        addAttribute(0, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, normal));
+        addAttribute(0, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, tangent));
+        addAttribute(0, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertex, texCoord));
+        addAttribute(0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(CompactVertex, color));
+    }
+    else
+    {
+        addAttribute(0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position));
+        addAttribute(0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal));
+        addAttribute(0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, tangent));
+        addAttribute(0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, bitangent));
+        addAttribute(0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color));
+        addAttribute(0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texCoord));
+    }
+
+    // Instance attributes, their locations follow the vertex attributes like in the shaders
     for(int i = 0; i < 4; i++)
     {
-        attributeDescriptions[i + 6].binding = 1;
-        attributeDescriptions[i + 6].location = i + 6;
-        attributeDescriptions[i + 6].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-        attributeDescriptions[i + 6].offset = sizeof(glm::vec4) * i;
+        addAttribute(1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(InstanceData, model) + sizeof(glm::vec4) * i);
     }
+    addAttribute(1, VK_FORMAT_R32_SINT, offsetof(InstanceData, objectID));
 
     return attributeDescriptions;
 }
@@ -2,10 +2,12 @@
 
 #include "graphics/internal/device.hpp"
 #include "buffer.hpp"
+#include "buffer_uploader.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <string>
@@ -16,36 +18,108 @@
 
 namespace graphics
 {
+    // Per-instance vertex input (binding 1), must match InstanceData in shaderInputs.slang
+    struct InstanceData
+    {
+        glm::mat4 model;
+        int32_t objectID = -1; // Index into the objects drawn in the frame, written to the object ID buffer
+        int32_t padding[3]{}; // Keeps the stride a multiple of 16 bytes
+    };
+
+    // Vertex layout uploaded to the GPU
+    // FULL uploads core::MeshData::Vertex as is (72 bytes), COMPACT packs it into CompactVertex (28 bytes)
+    enum class VertexFormat
+    {
+        FULL = 0,
+        COMPACT = 1
+    };
+
+    // Packed vertex (binding 0), must match the COMPACT_VERTICES VertexData in shaderInputs.slang
+    // The bitangent is rebuilt in the shader from the normal, the tangent and the handedness
+    struct CompactVertex
+    {
+        glm::vec3 position;
+        uint32_t normal;   // Octahedral, 2x SNORM16
+        uint32_t tangent;  // Octahedral, 2x SNORM16
+        uint32_t texCoord; // 2x half float
+        uint32_t color;    // RGBA8 UNORM, alpha is 1 for a tangent handedness of +1 and 0 for -1
+    };
+
+    // Meshlet bounds read by the culling compute shader, must match Meshlet in meshlet_cull.slang
+    struct GpuMeshlet
+    {
+        glm::vec4 sphere;    // Center and radius
+        glm::vec4 cone;      // Axis and cutoff, a cutoff of 1 disables the backface test
+        glm::vec4 coneApex;  // w is unused
+        uint32_t firstIndex; // Into the shared index buffer
+        uint32_t indexCount;
+        uint32_t padding[2]{};
+    };
+
     class GraphicsMesh // TODO: Replace with graphics.draw(Mesh, Material)
     {
     public:
+        // Part of the shared index buffer drawn for one level of detail, level 0 is the full mesh
+        // error is relative to the bounding radius, see core::MeshData::Lod
+        struct LodRange
+        {
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            float error = 0.0f;
+            uint32_t firstMeshlet = 0; // Into the meshlet buffer, the meshlets cover exactly the range above
+            uint32_t meshletCount = 0;
+        };
+
+        // Meshes with at least this many triangles are split into meshlets that can be culled on the GPU
+        static constexpr uint32_t MESHLET_MIN_TRIANGLES = 1 << 16;
+
         static std::vector<VkVertexInputBindingDescription> getVertexBindingDescriptions();
         static std::vector<VkVertexInputAttributeDescription> getVertexAttributeDescriptions();
 
+        // Must be chosen before any shader, pipeline or mesh is created as all of them depend on it
+        static void setVertexFormat(VertexFormat format) { vertexFormat = format; }
+        static VertexFormat getVertexFormat() { return vertexFormat; }
+        static CompactVertex encodeVertex(const core::MeshData::Vertex& vertex);
+
         GraphicsMesh(core::MeshData* meshptr);
         ~GraphicsMesh();
 
         GraphicsMesh(const GraphicsMesh&) = delete;
         GraphicsMesh& operator=(const GraphicsMesh&) = delete;
 
-        void bind(VkCommandBuffer commandBuffer, const std::unique_ptr<Buffer> &instanceBuffer); // TODO: Remove in favor of graphics.draw(Mesh)
-        void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount);
+        void bind(VkCommandBuffer commandBuffer, VkBuffer instanceBuffer, VkDeviceSize instanceOffset); // TODO: Remove in favor of graphics.draw(Mesh)
+        void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t lod = 0);
+
+        uint32_t getLodCount() const { return static_cast<uint32_t>(lods.size()); }
+        const LodRange& getLod(uint32_t lod) const { return lods[lod]; }
+        bool hasMeshlets() const { return meshletBuffer != nullptr; }
+        Buffer* getMeshletBuffer() const { return meshletBuffer.get(); }
 
         void createBuffers();
-        void createInstanceBuffer(const std::vector<glm::mat4> &transforms);
-        void updateInstanceBuffer(const std::vector<glm::mat4> &transforms);
+        // Uploads the dirty ranges of the mesh data into the existing buffers, which grow geometrically when too small
+        // Returns false if the buffers have to be recreated instead, the dirty ranges are then left untouched
+        bool update(BufferUploader& uploader);
 
     private:
+        static VertexFormat vertexFormat;
+
         std::unique_ptr<Buffer> vertexBuffer{};
         uint32_t vertexCount;
+        uint32_t vertexCapacity = 0;
         bool useIndexBuffer = true;
         std::unique_ptr<Buffer> indexBuffer{};
         uint32_t indexCount;
+        uint32_t indexCapacity = 0;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32; // 16 bit indices are used when every vertex fits
+        std::vector<LodRange> lods{}; // Every level is stored in indexBuffer, one after another
+        std::unique_ptr<Buffer> meshletBuffer{}; // Meshlets of every level, only created for dense meshes
+        bool meshletOrdered = false; // The triangles in indexBuffer are in meshlet order, even once meshletBuffer is retired
 
         core::MeshData* meshPtr;
 
         void createVertexBuffer();
         void createIndexBuffer();
+        void createMeshletBuffer(const std::vector<GpuMeshlet>& meshlets);
         
         void loadModelFromObj(const std::string& filename);
     };
@@ -1,5 +1,6 @@
 #include "material.hpp"
 #include "graphics/containers.hpp"
+#include "graphics/internal/swap_chain.hpp"
 
 namespace graphics
 {
@@ -7,6 +8,7 @@ namespace graphics
     {
         shaderInputs = shader->getInputs();
         inputValues.resize(shaderInputs.size());
+        frameDescriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
         // createShaderInputBuffer();
     }
 
@@ -197,6 +199,15 @@ namespace graphics
 
     void Material::createDescriptorSet()
     {
+        for(uint32_t i = 0; i < frameDescriptorSets.size(); i++)
+        {
+            createDescriptorSet(i);
+        }
+    }
+
+    void Material::createDescriptorSet(uint32_t frameIndex)
+    {
+        VkDescriptorSet &descriptorSet = frameDescriptorSets[frameIndex];
         std::vector<VkDescriptorSet> descriptorSets = {descriptorSet};
         if (descriptorSet != VK_NULL_HANDLE)
         {
@@ -38,9 +38,12 @@ namespace graphics
             void setTexture(uint32_t binding, Texture* texture);
 
             void createShaderInputBuffer();
-            void createDescriptorSet();
+            void createDescriptorSet(); // Rebuilds the descriptor sets of every frame in flight
+            void createDescriptorSet(uint32_t frameIndex); // Rebuilds only the set owned by frameIndex
             void updateValues();
 
+            VkDescriptorSet getDescriptorSet(uint32_t frameIndex) const { return frameDescriptorSets[frameIndex]; }
+
             uint32_t getId() const { return id; }
             const Shader* getShader() { return shader; }
 
@@ -56,6 +59,8 @@ namespace graphics
             uint32_t id;
             const Shader *shader;
             std::vector<ShaderInput> shaderInputs;
+            // One set per frame in flight so a frame can rebind textures while the previous one is still on the GPU
+            std::vector<VkDescriptorSet> frameDescriptorSets;
 
             bool initialized = false;
     };
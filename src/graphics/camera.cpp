@@ -47,6 +47,19 @@ namespace graphics
         updateCamera();
     }
     
+    void Camera::getPixelRay(glm::vec2 pixel, glm::vec2 viewportSize, glm::vec3& origin, glm::vec3& direction, float& length) const
+    {
+        // The projection flips y, so pixel rows map to normalized device coordinates without flipping them here
+        glm::vec2 ndc = (pixel + 0.5f) / viewportSize * 2.0f - 1.0f;
+        glm::mat4 inverseViewProjection = glm::inverse(getViewProjection());
+        glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, 0.0f, 1.0f);
+        glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+        origin = glm::vec3(nearPoint) / nearPoint.w;
+        direction = glm::vec3(farPoint) / farPoint.w - origin;
+        length = glm::length(direction);
+        direction /= length;
+    }
+
     void Camera::updateCamera()
     {
         if(isOrthographic)
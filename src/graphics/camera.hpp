@@ -31,9 +31,15 @@ namespace graphics
         void setVfov(const float vfov);
         void setAspectRatio(const float aspectRatio);
 
+        float getNear() const { return properties.near; }
+        float getFar() const { return properties.far; }
+
         glm::mat4 getView() const { return transform.getTransform(); }
         glm::mat4 getProjection() const { return projection; }
         glm::mat4 getViewProjection() const { return projection * glm::inverse(transform.getTransform()); }
+        // World space ray through the center of a pixel of a viewport, from the near plane to the far plane
+        // direction is normalized and length is the distance between the planes along it
+        void getPixelRay(glm::vec2 pixel, glm::vec2 viewportSize, glm::vec3& origin, glm::vec3& direction, float& length) const;
 
         core::Transform transform;
     private:
@@ -12,7 +12,7 @@ using namespace std;
 
 namespace graphics
 {
-    ComputePipeline::ComputePipeline(ComputeShader &_shader) : shader(_shader)
+    ComputePipeline::ComputePipeline(ComputeShader &_shader, uint32_t _pushConstantSize) : shader(_shader), pushConstantSize(_pushConstantSize)
     {
         createPipelineLayout();
         createComputePipeline();
@@ -32,7 +32,7 @@ namespace graphics
         VkPushConstantRange pushConstantRange{};
         pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
         pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(ErosionPushConstants);
+        pushConstantRange.size = pushConstantSize;
 
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
             // Descriptors::globalSetLayout->getDescriptorSetLayout()
@@ -46,7 +46,7 @@ namespace graphics
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
         pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0;
         pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
         if(vkCreatePipelineLayout(Shared::device->device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
         {
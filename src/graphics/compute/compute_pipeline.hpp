@@ -11,31 +11,7 @@ namespace graphics
     class ComputePipeline
     {
     public:
-        struct ErosionPushConstants
-        {
-            uint32_t numParticles;
-            uint32_t seed;
-
-            int maxLifetime;
-            float sedimentScale;
-            float sedimentCapacity;
-            float gravity;
-            float friction;
-            float deltaTime;
-            float evaporationRate;
-
-            // uint numParticles;
-            // uint seed;
-        
-            // int maxLifetime;
-            // float sedimentScale;
-            // float sedimentCapacity;
-            // float baseCapacity;
-            // float gravity;
-            // float friction;
-        };
-        
-        ComputePipeline(ComputeShader& _shader);
+        ComputePipeline(ComputeShader& _shader, uint32_t _pushConstantSize = 0);
         ComputePipeline(const std::string& vertPath, const std::string& fragPath, const PipelineConfigInfo& configInfo);
         ~ComputePipeline();
 
@@ -55,5 +31,6 @@ namespace graphics
         ComputeShader &shader;
         VkPipelineCache pipelineCache;
         VkPipelineLayout pipelineLayout;
+        uint32_t pushConstantSize;
     };
 }
\ No newline at end of file
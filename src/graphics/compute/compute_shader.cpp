@@ -6,26 +6,20 @@
 
 namespace graphics
 {
-    ComputeShader::ComputeShader(const std::string &_path, std::vector<ShaderInput> _inputs, uint32_t textureCount) : 
-        ShaderBase(_inputs), path(_path), configInfo(getDefaultConfigInfo())
+    ComputeShader::ComputeShader(const std::string &_path, std::vector<ShaderInput> _inputs, const std::vector<VkDescriptorType>& _bindings, uint32_t maxSets) : 
+        ShaderBase(_inputs), path(_path), configInfo(getDefaultConfigInfo()), bindings(_bindings)
     {
         reloadShader();
 
-
         DescriptorPool::Builder poolBuilder = DescriptorPool::Builder(*Shared::device)
-            .setMaxSets(GR_MAX_MATERIAL_COUNT)
-            .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, GR_MAX_MATERIAL_COUNT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, GR_MAX_MATERIAL_COUNT);
-        DescriptorSetLayout::Builder layoutBuilder = DescriptorSetLayout::Builder(*Shared::device)
-            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
-            .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
-        
-        // for(int i = 0; i < textureCount; i++)
-        // {
-        //     poolBuilder.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, GR_MAX_MATERIAL_COUNT);
-        //     layoutBuilder.addBinding(i + 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT);
-        // }
+            .setMaxSets(maxSets)
+            .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+        DescriptorSetLayout::Builder layoutBuilder = DescriptorSetLayout::Builder(*Shared::device);
+        for(uint32_t i = 0; i < bindings.size(); i++)
+        {
+            poolBuilder.addPoolSize(bindings[i], maxSets);
+            layoutBuilder.addBinding(i, bindings[i], VK_SHADER_STAGE_COMPUTE_BIT);
+        }
         descriptorPool = poolBuilder.build();
         descriptorSetLayout = layoutBuilder.build();
     }
@@ -43,16 +37,24 @@ namespace graphics
     
     void ComputeShader::reloadShader()
     {
+        Console::log("\tLoading compute shader from " + path, "ComputeShader");
+        std::vector<char> code = FileUtil::readFileToCharVector(path);
+        std::vector<uint32_t> codeSPV = SlangToSpirv(code, "ComputeShader", "csMain", SLANG_STAGE_COMPUTE);
+        if(codeSPV.size() == 0)
+        {
+            Console::error("Failed to load shader: " + path, "ComputeShader");
+            return;
+        }
+        std::vector<char> codeSPVChar(
+            reinterpret_cast<const char*>(codeSPV.data()),
+            reinterpret_cast<const char*>(codeSPV.data()) + codeSPV.size() * sizeof(uint32_t)
+        );
+
         if(computeShaderModule != VK_NULL_HANDLE)
         {
             dirty = true;
             vkDestroyShaderModule(Shared::device->device(), computeShaderModule, nullptr);
         }
-
-        std::vector<char> code = FileUtil::readFileToCharVector(path);
-        createShaderModule(code, &computeShaderModule);
-        
-        // std::vector<uint32_t> codeInts(code.begin(), code.end());
-        // createShaderModule(codeInts, &computeShaderModule);
+        createShaderModule(codeSPVChar, &computeShaderModule);
     }
 } // namespace graphics
\ No newline at end of file
@@ -19,12 +19,13 @@ namespace graphics
     };
 
     // Container to abstract away compute shader logic
+    // The Slang entry point is csMain, bindings lists the descriptor type of every binding of set 0 in order
     class ComputeShader : public ShaderBase
     {
         public:
             std::string path;
 
-            ComputeShader(const std::string &_path, std::vector<ShaderInput> inputs, uint32_t textureCount);
+            ComputeShader(const std::string &_path, std::vector<ShaderInput> inputs, const std::vector<VkDescriptorType>& _bindings, uint32_t maxSets);
             ~ComputeShader();
 
             // Disallow copying of shaders
@@ -36,6 +37,7 @@ namespace graphics
             ComputePipelineConfigInfo& getConfigInfo() { return configInfo; };
             VkShaderModule& getShaderModule() { return computeShaderModule; }
             const std::vector<ShaderInput>& getInputs() const { return inputs; }
+            const std::vector<VkDescriptorType>& getBindings() const { return bindings; }
             void reloadShader(); // Rereads the shader files and recreates the shader modules
 
             bool dirty = false;
@@ -44,6 +46,7 @@ namespace graphics
 
         private:
             ComputePipelineConfigInfo configInfo{};
+            std::vector<VkDescriptorType> bindings{};
 
             VkShaderModule computeShaderModule{};
     };
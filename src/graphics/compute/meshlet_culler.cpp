@@ -0,0 +1,183 @@
+#include "meshlet_culler.hpp"
+#include "utils/console.hpp"
+#include "core/frustum_culling.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace graphics
+{
+static_assert(sizeof(MeshletCuller::PushConstants) == 128, "Push constants must fit the 128 bytes every device supports");
+
+bool MeshletCuller::isSupported(Device& device)
+{
+    const VkPhysicalDeviceFeatures& features = device.getEnabledFeatures();
+    return features.multiDrawIndirect && features.drawIndirectFirstInstance;
+}
+
+MeshletCuller::MeshletCuller(Device& _device, uint32_t frameCount) : device(_device)
+{
+    shader = std::make_unique<ComputeShader>(
+        "internal/shaders/meshlet_cull.slang",
+        std::vector<ShaderInput>{},
+        std::vector<VkDescriptorType>{
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // Meshlets
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // Instances
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER  // Draw count and commands
+        },
+        1 // Sets come from the per-frame pools below
+    );
+    createPipeline();
+
+    drawAllocator = std::make_unique<FrameAllocator>(
+        device,
+        DRAW_SLICE_SIZE,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        frameCount
+    );
+
+    // Every set is rewritten each frame, so whole pools are reset instead of freeing sets one by one
+    descriptorPools.resize(frameCount);
+    for(std::unique_ptr<DescriptorPool>& pool : descriptorPools)
+    {
+        pool = DescriptorPool::Builder(device)
+            .setMaxSets(MAX_BATCHES_PER_FRAME)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MAX_BATCHES_PER_FRAME * 3)
+            .build();
+    }
+}
+
+MeshletCuller::~MeshletCuller()
+{
+    pipeline.reset();
+    shader.reset();
+}
+
+void MeshletCuller::reloadShader()
+{
+    vkDeviceWaitIdle(device.device()); // The old pipeline may still be used by frames in flight
+    pipeline.reset();
+    shader->reloadShader();
+    createPipeline();
+}
+
+void MeshletCuller::createPipeline()
+{
+    if(shader->getShaderModule() == VK_NULL_HANDLE)
+    {
+        Console::error("Meshlet culling shader failed to compile, dense meshes are drawn without culling", "MeshletCuller");
+        return;
+    }
+    pipeline = std::make_unique<ComputePipeline>(*shader, sizeof(PushConstants));
+}
+
+void MeshletCuller::beginFrame(uint32_t _frameIndex)
+{
+    frameIndex = _frameIndex % descriptorPools.size();
+    descriptorPools[frameIndex]->resetPool();
+    drawAllocator->beginFrame(frameIndex);
+    pipelineBound = false;
+    batchCount = 0;
+    meshletsTested = 0;
+}
+
+void MeshletCuller::setView(const glm::mat4& viewProjection, const glm::vec3& cameraPosition)
+{
+    // Same planes the scene culls its objects with, meshlet_cull.slang tests all six so their order does not matter
+    const core::Frustum frustum = core::Frustum::fromViewProjection(viewProjection);
+    std::copy(std::begin(frustum.planes), std::end(frustum.planes), push.frustumPlanes);
+    push.cameraPosition = cameraPosition;
+}
+
+MeshletCuller::DrawList MeshletCuller::cull(VkCommandBuffer commandBuffer, const GraphicsMesh& mesh, uint32_t lod, const FrameAllocator::Allocation& instances, uint32_t instanceCount)
+{
+    if(pipeline == nullptr || !mesh.hasMeshlets() || instanceCount == 0 || batchCount >= MAX_BATCHES_PER_FRAME)
+    {
+        return {};
+    }
+    const GraphicsMesh::LodRange& range = mesh.getLod(std::min(lod, mesh.getLodCount() - 1));
+    const VkPhysicalDeviceLimits& limits = device.properties.limits;
+    const uint64_t maxDrawCount = static_cast<uint64_t>(range.meshletCount) * instanceCount;
+    if(range.meshletCount == 0 || maxDrawCount > limits.maxDrawIndirectCount || instanceCount > limits.maxComputeWorkGroupCount[1])
+    {
+        return {};
+    }
+
+    const VkDeviceSize alignment = std::max<VkDeviceSize>(limits.minStorageBufferOffsetAlignment, sizeof(uint32_t));
+    FrameAllocator::Allocation output = drawAllocator->allocate(sizeof(uint32_t) + sizeof(VkDrawIndexedIndirectCommand) * maxDrawCount, alignment);
+    // Without a GPU side count every command is drawn, so the ones the shader does not write must be empty
+    memset(output.mapped, 0, device.isDrawIndirectCountEnabled() ? sizeof(uint32_t) : output.size);
+
+    // Instance data is only 16 byte aligned, so it is bound from the previous aligned offset and addressed in bytes
+    const VkDeviceSize instanceOffset = instances.offset / alignment * alignment;
+    VkDescriptorBufferInfo meshletInfo = mesh.getMeshletBuffer()->descriptorInfo();
+    VkDescriptorBufferInfo instanceInfo{instances.buffer, instanceOffset, instances.offset + instances.size - instanceOffset};
+    VkDescriptorBufferInfo outputInfo{output.buffer, output.offset, output.size};
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    if(!DescriptorWriter(*shader->getDescriptorSetLayout(), *descriptorPools[frameIndex])
+        .writeBuffer(0, &meshletInfo)
+        .writeBuffer(1, &instanceInfo)
+        .writeBuffer(2, &outputInfo)
+        .build(descriptorSet))
+    {
+        return {};
+    }
+    batchCount++;
+
+    if(!pipelineBound)
+    {
+        pipeline->bind(commandBuffer);
+        pipelineBound = true;
+    }
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->getPipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+
+    push.firstMeshlet = range.firstMeshlet;
+    push.meshletCount = range.meshletCount;
+    push.instanceCount = instanceCount;
+    push.instanceByteOffset = static_cast<uint32_t>(instances.offset - instanceOffset);
+    vkCmdPushConstants(commandBuffer, pipeline->getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &push);
+    vkCmdDispatch(commandBuffer, (range.meshletCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, instanceCount, 1);
+    meshletsTested += static_cast<uint32_t>(maxDrawCount);
+
+    DrawList drawList{};
+    drawList.buffer = output.buffer;
+    drawList.countOffset = output.offset;
+    drawList.commandOffset = output.offset + sizeof(uint32_t);
+    drawList.maxDrawCount = static_cast<uint32_t>(maxDrawCount);
+    return drawList;
+}
+
+void MeshletCuller::barrier(VkCommandBuffer commandBuffer)
+{
+    if(batchCount == 0)
+    {
+        return;
+    }
+    VkMemoryBarrier memoryBarrier{};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0,
+        1, &memoryBarrier,
+        0, nullptr,
+        0, nullptr
+    );
+}
+
+void MeshletCuller::draw(VkCommandBuffer commandBuffer, const DrawList& drawList)
+{
+    if(device.isDrawIndirectCountEnabled())
+    {
+        vkCmdDrawIndexedIndirectCount(commandBuffer, drawList.buffer, drawList.commandOffset, drawList.buffer, drawList.countOffset,
+            drawList.maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+    }
+    else
+    {
+        vkCmdDrawIndexedIndirect(commandBuffer, drawList.buffer, drawList.commandOffset, drawList.maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+} // namespace graphics
@@ -0,0 +1,90 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+#include "graphics/internal/device.hpp"
+#include "graphics/internal/descriptors.hpp"
+#include "graphics/buffers/frame_allocator.hpp"
+#include "graphics/buffers/graphics_mesh.hpp"
+#include "compute_shader.hpp"
+#include "compute_pipeline.hpp"
+
+namespace graphics
+{
+    // Culls the meshlets of instanced batches against the view frustum and their normal cones in a compute pass,
+    // the survivors are compacted into indexed indirect draws so hidden clusters never reach the rasterizer
+    // Only needs multiDrawIndirect and drawIndirectFirstInstance, the draw count is read on the GPU when drawIndirectCount
+    // is enabled, otherwise every possible draw is issued and the unused ones are left empty
+    class MeshletCuller
+    {
+    public:
+        // Must match PushConstants in meshlet_cull.slang
+        struct PushConstants
+        {
+            glm::vec4 frustumPlanes[6];
+            glm::vec3 cameraPosition;
+            uint32_t firstMeshlet;
+            uint32_t meshletCount;
+            uint32_t instanceCount;
+            uint32_t instanceByteOffset;
+            uint32_t padding;
+        };
+
+        // Draws produced for one batch, valid for the frame it was culled in
+        struct DrawList
+        {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            VkDeviceSize countOffset = 0;   // uint32 draw count
+            VkDeviceSize commandOffset = 0; // VkDrawIndexedIndirectCommand array
+            uint32_t maxDrawCount = 0;
+
+            explicit operator bool() const { return maxDrawCount > 0; }
+        };
+
+        static constexpr uint32_t WORKGROUP_SIZE = 64;        // numthreads in meshlet_cull.slang
+        static constexpr uint32_t MAX_BATCHES_PER_FRAME = 1024; // Further batches are drawn without culling
+        static constexpr VkDeviceSize DRAW_SLICE_SIZE = 1024 * 1024;
+
+        static bool isSupported(Device& device);
+
+        MeshletCuller(Device& _device, uint32_t frameCount);
+        ~MeshletCuller();
+
+        MeshletCuller(const MeshletCuller&) = delete;
+        MeshletCuller& operator=(const MeshletCuller&) = delete;
+
+        // The GPU must be done with the frame, resets its descriptor sets and draw lists
+        void beginFrame(uint32_t frameIndex);
+        void setView(const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+
+        // Records the culling dispatch for one batch, returns an empty list when the batch has to be drawn as is
+        DrawList cull(VkCommandBuffer commandBuffer, const GraphicsMesh& mesh, uint32_t lod, const FrameAllocator::Allocation& instances, uint32_t instanceCount);
+        // Makes the draw lists of every cull() recorded so far visible to indirect draws
+        void barrier(VkCommandBuffer commandBuffer);
+        // The mesh and the instances the list was culled with must be bound
+        void draw(VkCommandBuffer commandBuffer, const DrawList& drawList);
+
+        void reloadShader();
+
+        uint32_t getMeshletsTested() const { return meshletsTested; }
+
+    private:
+        void createPipeline();
+
+        Device& device;
+        std::unique_ptr<ComputeShader> shader{};
+        std::unique_ptr<ComputePipeline> pipeline{};
+        std::unique_ptr<FrameAllocator> drawAllocator{};
+        std::vector<std::unique_ptr<DescriptorPool>> descriptorPools{};
+        uint32_t frameIndex = 0;
+
+        PushConstants push{};
+        bool pipelineBound = false;
+        uint32_t batchCount = 0;
+        uint32_t meshletsTested = 0;
+    };
+} // namespace graphics
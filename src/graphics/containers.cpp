@@ -17,7 +17,7 @@ namespace Descriptors
 // Global Descriptor Set
 std::unique_ptr<DescriptorPool> globalPool;
 std::unique_ptr<DescriptorSetLayout> globalSetLayout;
-VkDescriptorSet globalDescriptorSet;
+std::vector<VkDescriptorSet> globalDescriptorSets;
 // Camera Descriptor Set
 std::unique_ptr<DescriptorPool> cameraPool;
 std::unique_ptr<DescriptorSetLayout> cameraSetLayout;
@@ -31,7 +31,7 @@ namespace graphics
     {
         extern std::unique_ptr<DescriptorPool> globalPool;
         extern std::unique_ptr<DescriptorSetLayout> globalSetLayout;
-        extern VkDescriptorSet globalDescriptorSet;
+        extern std::vector<VkDescriptorSet> globalDescriptorSets;
         // Camera Descriptor Set
         extern std::unique_ptr<DescriptorPool> cameraPool;
         extern std::unique_ptr<DescriptorSetLayout> cameraSetLayout;
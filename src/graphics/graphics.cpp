@@ -36,7 +36,8 @@ Graphics::~Graphics()
 void Graphics::init(const std::string& name, const std::string& engine_name)
 {
     Descriptors::globalPool = DescriptorPool::Builder(device)
-        .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1)
+        .setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT)
         .build();
 
     Descriptors::cameraPool = DescriptorPool::Builder(device)
@@ -52,24 +53,31 @@ void Graphics::init(const std::string& name, const std::string& engine_name)
 
     Console::log("Creating global UBO", "Graphics");
     // Global data
-    globalUboBuffer = std::make_unique<Buffer>(
-        device,
-        sizeof(GlobalUbo),
-        1,
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        device.properties.limits.minUniformBufferOffsetAlignment
-    );
-    globalUboBuffer->map();
+    globalUboBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    for(int i = 0; i < globalUboBuffers.size(); i++)
+    {
+        globalUboBuffers[i] = std::make_unique<Buffer>(
+            device,
+            sizeof(GlobalUbo),
+            1,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            device.properties.limits.minUniformBufferOffsetAlignment
+        );
+        globalUboBuffers[i]->map();
+    }
     Descriptors::globalSetLayout = DescriptorSetLayout::Builder(device)
         .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
         .build();
     
-    
-    VkDescriptorBufferInfo bufferInfo = globalUboBuffer->descriptorInfo();
-    DescriptorWriter(*Descriptors::globalSetLayout, *Descriptors::globalPool)
-        .writeBuffer(0, &bufferInfo)
-        .build(Descriptors::globalDescriptorSet);
+    Descriptors::globalDescriptorSets = std::vector<VkDescriptorSet>(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    for(int i = 0; i < Descriptors::globalDescriptorSets.size(); i++)
+    {
+        VkDescriptorBufferInfo bufferInfo = globalUboBuffers[i]->descriptorInfo();
+        DescriptorWriter(*Descriptors::globalSetLayout, *Descriptors::globalPool)
+            .writeBuffer(0, &bufferInfo)
+            .build(Descriptors::globalDescriptorSets[i]);
+    }
 
     // Camera
     Console::log("Creating camera UBO", "Graphics");
@@ -100,6 +108,23 @@ void Graphics::init(const std::string& name, const std::string& engine_name)
             .build(Descriptors::cameraDescriptorSets[i]);
     }
 
+    instanceAllocator = std::make_unique<FrameAllocator>(
+        device,
+        INSTANCE_SLICE_SIZE,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, // Also read by the meshlet culling
+        SwapChain::MAX_FRAMES_IN_FLIGHT
+    );
+    bufferUploader = std::make_unique<BufferUploader>(device, SwapChain::MAX_FRAMES_IN_FLIGHT);
+    if(MeshletCuller::isSupported(device))
+    {
+        meshletCuller = std::make_unique<MeshletCuller>(device, SwapChain::MAX_FRAMES_IN_FLIGHT);
+    }
+    else
+    {
+        Console::warn("Multi draw indirect is not supported, meshlet culling is disabled", "Graphics");
+    }
+    resetRenderQueues();
+
     createRenderPasses();
     loadTextures();
     loadShaders();
@@ -114,12 +139,20 @@ void Graphics::init(const std::string& name, const std::string& engine_name)
 
 void Graphics::cleanup()
 {
+    waitForDevice(); // Frames may still be in flight
     ImGui_ImplVulkan_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
     
-    globalUboBuffer.reset();
+    globalUboBuffers.clear();
     cameraUboBuffers.clear();
+    sceneDrawItems.clear();
+    outlineDrawItems.clear();
+    sceneRenderQueue.clear();
+    outlineRenderQueue.clear();
+    instanceAllocator.reset();
+    meshletCuller.reset();
+    bufferUploader.reset();
     Descriptors::globalPool.reset();
     Descriptors::globalSetLayout.reset();
     Descriptors::cameraPool.reset();
@@ -138,13 +171,23 @@ void Graphics::cleanup()
 void Graphics::drawFrame()
 {    
     VkExtent2D extent = renderer.getExtent();
-    if(extent.width <= 0 || extent.height <= 0) return; // Don't draw frame if minimized
+    if(extent.width <= 0 || extent.height <= 0) // Don't draw frame if minimized
+    {
+        bufferUploader->flush(); // Staged mesh updates would be lost with the staging slice
+        resetRenderQueues();
+        return;
+    }
     // std::cout << "Drawing Frame" << std::endl;
     std::vector<VkDescriptorSet> localDescriptorSets;
     if(VkCommandBuffer commandBuffer = renderer.startFrame())
     {
         uint32_t frameIndex = renderer.getFrameIndex();
-        FrameInfo frameInfo{frameIndex, 0.0, commandBuffer, Descriptors::globalDescriptorSet, Descriptors::cameraDescriptorSets[frameIndex]};
+        renderStats = {};
+        renderStats.uploadedBytes = bufferUploader->getStagedBytes();
+        bufferUploader->record(commandBuffer);
+        buildBatches(sceneDrawItems, sceneRenderQueue);
+        buildBatches(outlineDrawItems, outlineRenderQueue);
+        FrameInfo frameInfo{frameIndex, 0.0, commandBuffer, Descriptors::globalDescriptorSets[frameIndex], Descriptors::cameraDescriptorSets[frameIndex]};
 
         GlobalUbo globalUbo{};
         globalUbo.lights[0] = {glm::vec3(1, 1, 1), LightType::DIRECTIONAL, glm::vec3(1.0, 1.0, 1.0), 6.0};
@@ -154,7 +197,7 @@ void Graphics::drawFrame()
         globalUbo.numLights = 4;
         globalUbo.ambient = glm::vec3(0.04, 0.08, 0.2);
         // globalUbo.ambient = glm::vec3(1, 1, 1);
-        globalUboBuffer->writeToBuffer(&globalUbo);
+        globalUboBuffers[frameIndex]->writeToBuffer(&globalUbo);
 
         CameraUbo cameraUbo{};
         cameraUbo.view = camera->getView();
@@ -165,6 +208,15 @@ void Graphics::drawFrame()
         // std::cout << "Proj: " << glm::to_string(cameraUbo.proj) << std::endl;
         cameraUboBuffers[frameIndex]->writeToBuffer(&cameraUbo);
 
+        if(meshletCuller != nullptr && camera != nullptr)
+        {
+            meshletCuller->setView(cameraUbo.viewProj, glm::vec3(camera->getView()[3]));
+            cullMeshlets(commandBuffer, sceneRenderQueue);
+            cullMeshlets(commandBuffer, outlineRenderQueue);
+            meshletCuller->barrier(commandBuffer);
+            renderStats.meshletsTested = meshletCuller->getMeshletsTested();
+        }
+
         idBufferRenderPass->resetLayouts();
         sceneRenderPass->resetLayouts();
         outlineRenderPass->resetLayouts();
@@ -172,10 +224,14 @@ void Graphics::drawFrame()
         imguiRenderPass->resetLayouts();
         finalRenderPass->resetLayouts();
         
-        // Object IDs render pass
-        renderer.beginRenderPass(idBufferRenderPass->getRenderPass(), idBufferRenderPass->getFrameBuffer(), idBufferRenderPass->getExtent(), VkClearColorValue{-1, 0, 0, 0});
-        renderGameObjectIDs(frameInfo);
-        renderer.endRenderPass();
+        // Object IDs render pass, only needed for GPU picking
+        if(idBufferEnabled)
+        {
+            renderer.beginRenderPass(idBufferRenderPass->getRenderPass(), idBufferRenderPass->getFrameBuffer(), idBufferRenderPass->getExtent(), VkClearColorValue{-1, 0, 0, 0});
+            renderGameObjectIDs(frameInfo);
+            renderer.endRenderPass();
+            idBufferObjects.swap(frameObjects);
+        }
         
         // Objects render pass
         renderer.beginRenderPass(sceneRenderPass->getRenderPass(), sceneRenderPass->getFrameBuffer(), sceneRenderPass->getExtent(), defaultClearColor);
@@ -188,7 +244,7 @@ void Graphics::drawFrame()
         depthTexture->transitionImageLayout(VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, commandBuffer);
         ppMaterial->setTexture(0, colorTexture.get());
         ppMaterial->setTexture(1, depthTexture.get());
-        ppMaterial->createDescriptorSet();
+        ppMaterial->createDescriptorSet(frameIndex);
 
 // Outline
         renderer.beginRenderPass(outlineBaseRenderPass->getRenderPass(), outlineBaseRenderPass->getFrameBuffer(), outlineBaseRenderPass->getExtent(), {0,0,0,0});
@@ -198,12 +254,12 @@ void Graphics::drawFrame()
         std::unique_ptr<Texture> &outlineBaseTexture = outlineBaseRenderPass->getColorTexture();
         outlineBaseTexture->transitionImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer);
         outlineMaterial->setTexture(0, outlineBaseTexture.get());
-        outlineMaterial->createDescriptorSet();
+        outlineMaterial->createDescriptorSet(frameIndex);
         
         renderer.beginRenderPass(outlineRenderPass->getRenderPass(), outlineRenderPass->getFrameBuffer(), outlineRenderPass->getExtent(), {1.0,0.5,0,0});
         pipelineManager->getPipeline(2)->bind(commandBuffer); // Outline Pipeline
 
-        localDescriptorSets = { outlineMaterial->getDescriptorSet() };
+        localDescriptorSets = { outlineMaterial->getDescriptorSet(frameIndex) };
         vkCmdBindDescriptorSets(
             commandBuffer, 
             VK_PIPELINE_BIND_POINT_GRAPHICS, 
@@ -222,12 +278,12 @@ void Graphics::drawFrame()
         std::unique_ptr<Texture> &outlineTexture = outlineRenderPass->getColorTexture();
         outlineTexture->transitionImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer);
         outlineResultMaterial->setTexture(0, outlineTexture.get());
-        outlineResultMaterial->createDescriptorSet();
+        outlineResultMaterial->createDescriptorSet(frameIndex);
         
 // Final Render Pass
         renderer.beginRenderPass(finalRenderPass->getRenderPass(), finalRenderPass->getFrameBuffer(), finalRenderPass->getExtent(), defaultClearColor);
         pipelineManager->getPipeline(0)->bind(commandBuffer); // Post-processing pipeline
-        localDescriptorSets = { ppMaterial->getDescriptorSet() };
+        localDescriptorSets = { ppMaterial->getDescriptorSet(frameIndex) };
         vkCmdBindDescriptorSets(
             commandBuffer, 
             VK_PIPELINE_BIND_POINT_GRAPHICS, 
@@ -242,7 +298,7 @@ void Graphics::drawFrame()
         vkCmdDraw(commandBuffer, 6, 1, 0, 0);
 
         pipelineManager->getPipeline(1)->bind(commandBuffer); // Outline
-        localDescriptorSets = { outlineResultMaterial->getDescriptorSet() };
+        localDescriptorSets = { outlineResultMaterial->getDescriptorSet(frameIndex) };
         vkCmdBindDescriptorSets(
             commandBuffer, 
             VK_PIPELINE_BIND_POINT_GRAPHICS, 
@@ -266,16 +322,16 @@ void Graphics::drawFrame()
         std::unique_ptr<Texture> &imguiTexture = imguiRenderPass->getColorTexture();
         imguiTexture->transitionImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer);
         imguiMaterial->setTexture(0, imguiTexture.get());
-        imguiMaterial->createDescriptorSet();
+        imguiMaterial->createDescriptorSet(frameIndex);
 
         std::unique_ptr<Texture> &outputTexture = finalRenderPass->getColorTexture();
         outputTexture->transitionImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, commandBuffer);
         outputMaterial->setTexture(0, outputTexture.get());
-        outputMaterial->createDescriptorSet();
+        outputMaterial->createDescriptorSet(frameIndex);
 
         renderer.beginRenderPass(renderer.getSCRenderPass(), renderer.getSCFrameBuffer(), renderer.getExtent(), defaultClearColor);
         pipelineManager->getPipeline(1)->bind(commandBuffer); // ImGui
-        localDescriptorSets = { imguiMaterial->getDescriptorSet() };
+        localDescriptorSets = { imguiMaterial->getDescriptorSet(frameIndex) };
         vkCmdBindDescriptorSets(
             commandBuffer, 
             VK_PIPELINE_BIND_POINT_GRAPHICS, 
@@ -288,7 +344,7 @@ void Graphics::drawFrame()
         );
         vkCmdDraw(commandBuffer, 6, 1, 0, 0);
         // outputMaterial->getShader()->getPipeline()->bind(commandBuffer);
-        // localDescriptorSets = { outputMaterial->getDescriptorSet() };
+        // localDescriptorSets = { outputMaterial->getDescriptorSet(frameIndex) };
         // vkCmdBindDescriptorSets(
         //     commandBuffer, 
         //     VK_PIPELINE_BIND_POINT_GRAPHICS, 
@@ -305,9 +361,43 @@ void Graphics::drawFrame()
 
         renderer.endFrame();
     }
-    vkDeviceWaitIdle(Shared::device->device());
+    resetRenderQueues();
+}
+
+void Graphics::resetRenderQueues()
+{
+    // Queues are consumed while recording, only the instance data they point to is read by the GPU
+    sceneDrawItems.clear();
+    outlineDrawItems.clear();
     sceneRenderQueue.clear();
     outlineRenderQueue.clear();
+    // The ID pass has already swapped its objects into idBufferObjects by now
+    frameObjects.clear();
+    // Objects that were not drawn lose their level, so deleted and culled ones do not pile up
+    std::erase_if(lodHistory, [this](const auto& entry) { return entry.second.lastFrame != lodFrame; });
+    lodFrame++;
+
+    // Instance data for the next frame is written during the scene update, so its slice must be free by then
+    renderer.waitForFrameResources();
+    instanceAllocator->beginFrame(renderer.getPendingFrameIndex());
+    bufferUploader->beginFrame(renderer.getPendingFrameIndex());
+    if(meshletCuller != nullptr)
+    {
+        meshletCuller->beginFrame(renderer.getPendingFrameIndex());
+    }
+}
+
+void Graphics::cullMeshlets(VkCommandBuffer commandBuffer, std::vector<MeshRenderData>& renderQueue)
+{
+    for(MeshRenderData& renderData : renderQueue)
+    {
+        std::unique_ptr<GraphicsMesh>& graphicsMesh = graphicsMeshes[renderData.meshID];
+        if(graphicsMesh != nullptr && graphicsMesh->hasMeshlets())
+        {
+            renderData.drawList = meshletCuller->cull(commandBuffer, *graphicsMesh, renderData.lod, renderData.instances, renderData.instanceCount);
+            renderStats.culledBatches += renderData.drawList ? 1 : 0;
+        }
+    }
 }
 
 void Graphics::updateExtent()
@@ -318,8 +408,10 @@ void Graphics::updateExtent()
     {
         camera->setAspectRatio(static_cast<float>(viewportSize.width) / static_cast<float>(viewportSize.height));
     }
+    // Attachments are shared between frames in flight, so the GPU must be idle before any are recreated
     if(imguiRenderPass->getExtent().width != extent.width || imguiRenderPass->getExtent().height != extent.height)
     {
+        waitForDevice();
         imguiRenderPass->create(extent);
     }
 
@@ -331,16 +423,17 @@ void Graphics::updateExtent()
         static_cast<uint32_t>(viewportSize.height * frameScale)};
     if(sceneRenderPass->getExtent().width != scaledExtent.width || sceneRenderPass->getExtent().height != scaledExtent.height)
     {
+        waitForDevice();
         sceneRenderPass->create(scaledExtent);
     }
     // if(viewportSize.width <= 0 || viewportSize.height <= 0) return;
     if(imguiRenderPass->getExtent().width != viewportSize.width || imguiRenderPass->getExtent().height != viewportSize.height)
     {
+        waitForDevice();
         idBufferRenderPass->create(viewportSize); // Maybe render at low resolution
         outlineBaseRenderPass->create(viewportSize);
         outlineRenderPass->create(viewportSize);
         
-        waitForDevice();
         if(viewportDescriptorSet != VK_NULL_HANDLE)
         {
             ImGui_ImplVulkan_RemoveTexture(viewportDescriptorSet);
@@ -756,8 +849,10 @@ void Graphics::renderMeshes(FrameInfo& frameInfo, const std::vector<MeshRenderDa
             bindCameraDescriptor(frameInfo, pipeline);
             bindGlobalDescriptor(frameInfo, pipeline);
             prevPipeline = pipeline;
+            renderStats.pipelineBinds++;
+            renderStats.descriptorBinds += 2;
         }
-        localDescriptorSets = { Shared::materials[renderData.materialIndex].getDescriptorSet() };
+        localDescriptorSets = { Shared::materials[renderData.materialIndex].getDescriptorSet(frameInfo.frameIndex) };
 
         if(prevMaterial != renderData.materialIndex) // Bind material info if changed
         {
@@ -772,6 +867,7 @@ void Graphics::renderMeshes(FrameInfo& frameInfo, const std::vector<MeshRenderDa
                 nullptr
             );
             prevMaterial = renderData.materialIndex;
+            renderStats.descriptorBinds++;
         }
 
         PushConstants push{}; // TODO: Instance specific data
@@ -788,8 +884,17 @@ void Graphics::renderMeshes(FrameInfo& frameInfo, const std::vector<MeshRenderDa
         std::unique_ptr<GraphicsMesh> &graphicsMesh = graphicsMeshes[renderData.meshID];
         if(graphicsMesh != nullptr)
         {
-            graphicsMesh->bind(commandBuffer, renderData.instanceBuffer);
-            graphicsMesh->draw(commandBuffer, renderData.transforms.size());
+            graphicsMesh->bind(commandBuffer, renderData.instances.buffer, renderData.instances.offset);
+            if(renderData.drawList)
+            {
+                meshletCuller->draw(commandBuffer, renderData.drawList);
+            }
+            else
+            {
+                graphicsMesh->draw(commandBuffer, renderData.instanceCount, renderData.lod);
+            }
+            renderStats.drawCalls++;
+            renderStats.triangles += static_cast<uint64_t>(graphicsMesh->getLod(renderData.lod).indexCount / 3) * renderData.instanceCount;
         }
     }
 }
@@ -807,28 +912,26 @@ void Graphics::renderGameObjectIDs(FrameInfo& frameInfo)
 
     pipeline->bind(frameInfo.commandBuffer);
     bindCameraDescriptor(frameInfo, pipeline);
+    renderStats.pipelineBinds++;
+    renderStats.descriptorBinds++;
 
-
+    // Object IDs are read from the instance data, so the scene batches can be reused as is
     for(MeshRenderData &renderData : sceneRenderQueue)
     {
-        PushConstants push{};
-
-        push.objectID = renderData.objectID;
-        // Console::debug(std::to_string(push.objectID), "Graphics");
-        vkCmdPushConstants(
-            commandBuffer, 
-            pipelineLayout, 
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 
-            0, 
-            sizeof(PushConstants), 
-            &push
-        );
-
         std::unique_ptr<GraphicsMesh> &graphicsMesh = graphicsMeshes[renderData.meshID];
         if(graphicsMesh != nullptr)
         {
-            graphicsMesh->bind(commandBuffer, renderData.instanceBuffer);
-            graphicsMesh->draw(commandBuffer, renderData.transforms.size());
+            graphicsMesh->bind(commandBuffer, renderData.instances.buffer, renderData.instances.offset);
+            if(renderData.drawList)
+            {
+                meshletCuller->draw(commandBuffer, renderData.drawList);
+            }
+            else
+            {
+                graphicsMesh->draw(commandBuffer, renderData.instanceCount, renderData.lod);
+            }
+            renderStats.drawCalls++;
+            renderStats.triangles += static_cast<uint64_t>(graphicsMesh->getLod(renderData.lod).indexCount / 3) * renderData.instanceCount;
         }
     }
 }
@@ -880,6 +983,34 @@ void Graphics::graphicsInitImgui()
     );
 }
 
+void Graphics::drawImGui()
+{
+    const Renderer::FrameStats &stats = renderer.getFrameStats();
+    ImGui::Begin("Render Stats");
+    ImGui::Text("Frames: %llu", static_cast<unsigned long long>(stats.frameCount));
+    float overlapPercent = stats.frameCount > 0 ? 100.0f * stats.overlappedFrames / stats.frameCount : 0.0f;
+    ImGui::Text("CPU/GPU overlapped frames: %llu (%.1f%%)", static_cast<unsigned long long>(stats.overlappedFrames), overlapPercent);
+    ImGui::Text("Fence wait: %.3f ms (avg %.3f ms)", stats.lastFenceWaitMs, stats.frameCount > 0 ? stats.totalFenceWaitMs / stats.frameCount : 0.0);
+    ImGui::Text("Draw items: %u in %u batches", renderStats.drawItems, renderStats.batches);
+    ImGui::Text("Draw calls: %u", renderStats.drawCalls);
+    ImGui::Text("Triangles: %llu", static_cast<unsigned long long>(renderStats.triangles));
+    ImGui::Text("Mesh uploads: %llu KB", static_cast<unsigned long long>(renderStats.uploadedBytes / 1024));
+    ImGui::Text("Meshlet culled batches: %u (%u meshlets tested)", renderStats.culledBatches, renderStats.meshletsTested);
+    ImGui::Text("Pipeline binds: %u", renderStats.pipelineBinds);
+    ImGui::Text("Descriptor binds: %u", renderStats.descriptorBinds);
+    ImGui::Text("Instance data peak: %llu / %llu KB", 
+        static_cast<unsigned long long>(instanceAllocator->getPeakUsedBytes() / 1024), 
+        static_cast<unsigned long long>(instanceAllocator->getSliceSize() / 1024));
+
+    int latency = static_cast<int>(renderer.getFrameLatency());
+    if(ImGui::SliderInt("Frame latency", &latency, 1, SwapChain::MAX_FRAMES_IN_FLIGHT))
+    {
+        renderer.setFrameLatency(static_cast<uint32_t>(latency));
+    }
+    ImGui::Checkbox("GPU picking (object ID pass)", &idBufferEnabled);
+    ImGui::End();
+}
+
 void Graphics::reloadShaders()
 {
     Console::log("Reloading Shaders", "Graphics");
@@ -889,94 +1020,245 @@ void Graphics::reloadShaders()
     }
 
     pipelineManager->reloadPipelines();
+    if(meshletCuller != nullptr)
+    {
+        meshletCuller->reloadShader();
+    }
 }
 
-int Graphics::getClickedObjID(uint32_t x, uint32_t y)
+id_t Graphics::getClickedObjID(uint32_t x, uint32_t y)
 {
     idTexture = idBufferRenderPass->getColorTexture().get();
-    if(!idTexture)
+    if(!idBufferEnabled || !idTexture)
     {
         return -1;
     }
 
     idTexture->updatePixelOnCPU(x, y);
 
-    return idTexture->getPixelInt(x, y);
+    int index = idTexture->getPixelInt(x, y);
+    return index >= 0 && static_cast<size_t>(index) < idBufferObjects.size() ? idBufferObjects[index] : -1;
 }
 
 // Mesh management
 void Graphics::setGraphicsMesh(const core::Mesh& mesh)
 {
+    std::lock_guard<std::mutex> lock(meshMutex);
+    createGraphicsMesh(mesh);
+}
+
+void Graphics::createGraphicsMesh(const core::Mesh& mesh)
+{
+    bufferUploader->flush(); // Staged copies may target the buffers that are about to be destroyed
     graphicsMeshes[mesh->getInstanceID()] = std::make_unique<GraphicsMesh>(mesh.get());
+    if(meshSortIDs.try_emplace(mesh->getInstanceID(), nextMeshSortID).second)
+    {
+        nextMeshSortID++;
+    }
+}
+
+void Graphics::updateGraphicsMesh(const core::Mesh& mesh)
+{
+    std::lock_guard<std::mutex> lock(meshMutex);
+    auto it = graphicsMeshes.find(mesh->getInstanceID());
+    if(it == graphicsMeshes.end() || it->second == nullptr || !it->second->update(*bufferUploader))
+    {
+        createGraphicsMesh(mesh);
+    }
 }
 
 void Graphics::destroyGraphicsMeshes()
 {
+    std::lock_guard<std::mutex> lock(meshMutex);
     graphicsMeshes.clear(); // Destroy all graphicsmeshes
-    sceneRenderQueue.clear(); // Ensure no meshes are queued for drawing
+    lodHistory.clear();
+    sceneDrawItems.clear(); // Ensure no meshes are queued for drawing
+    sceneRenderQueue.clear();
 }
 
-void Graphics::drawMesh(const core::Mesh& mesh, uint32_t materialIndex, const glm::mat4& transform, uint32_t objectID)
+void Graphics::drawMesh(const core::Mesh& mesh, uint32_t materialIndex, const glm::mat4& transform, id_t objectID)
 {
-    if(!graphicsMeshes.contains(mesh->getInstanceID()))
-    {
-        Console::log("Mesh " + std::to_string(mesh->getInstanceID()) + " has no GraphicsMesh. Creating one now...", "Graphics");
-        setGraphicsMesh(mesh);
-    }
+    requireGraphicsMesh(mesh);
+    pushDrawItem(sceneDrawItems, mesh->getInstanceID(), mesh->getBounds(), materialIndex, transform, objectID);
+}
 
-    sceneRenderQueue.push_back(MeshRenderData(mesh->getInstanceID(), transform, materialIndex, objectID));
+void Graphics::drawMesh(id_t meshID, const core::MeshData::Bounds& bounds, uint32_t materialIndex, const glm::mat4& transform, id_t objectID)
+{
+    pushDrawItem(sceneDrawItems, meshID, bounds, materialIndex, transform, objectID);
 }
 
 void Graphics::drawMeshInstanced(const core::Mesh& mesh, uint32_t materialIndex, const std::vector<glm::mat4> &transforms)
 {
-    if(!graphicsMeshes.contains(mesh->getInstanceID()))
+    requireGraphicsMesh(mesh);
+    sceneDrawItems.reserve(sceneDrawItems.size() + transforms.size());
+    for(const glm::mat4& transform : transforms)
     {
-        Console::log("Mesh " + std::to_string(mesh->getInstanceID()) + " has no GraphicsMesh. Creating one now...", "Graphics");
-        setGraphicsMesh(mesh);
+        pushDrawItem(sceneDrawItems, mesh->getInstanceID(), mesh->getBounds(), materialIndex, transform, -1);
     }
-    if(transforms.size() == 0) return; // No work to do with no transforms
-
-    sceneRenderQueue.push_back(MeshRenderData(mesh->getInstanceID(), transforms, materialIndex));
 }
 
 void Graphics::drawMeshOutline(const core::Mesh& mesh, const glm::mat4& transform)
+{
+    requireGraphicsMesh(mesh);
+    pushDrawItem(outlineDrawItems, mesh->getInstanceID(), mesh->getBounds(), 0, transform, -1, false);
+}
+
+void Graphics::drawMeshOutline(id_t meshID, const core::MeshData::Bounds& bounds, const glm::mat4& transform)
+{
+    pushDrawItem(outlineDrawItems, meshID, bounds, 0, transform, -1, false);
+}
+
+void Graphics::requireGraphicsMesh(const core::Mesh& mesh)
 {
     if(!graphicsMeshes.contains(mesh->getInstanceID()))
     {
         Console::log("Mesh " + std::to_string(mesh->getInstanceID()) + " has no GraphicsMesh. Creating one now...", "Graphics");
-        setGraphicsMesh(mesh);
+        createGraphicsMesh(mesh);
     }
+}
 
-    outlineRenderQueue.push_back(MeshRenderData(mesh->getInstanceID(), transform, 0));
+void Graphics::pushDrawItem(std::vector<DrawItem>& drawItems, id_t meshID, const core::MeshData::Bounds& bounds, uint32_t materialIndex,
+    const glm::mat4& transform, id_t objectID, bool trackLod)
+{
+    auto graphicsMesh = graphicsMeshes.find(meshID);
+    if(graphicsMesh == graphicsMeshes.end() || graphicsMesh->second == nullptr)
+    {
+        return;
+    }
+
+    DrawItem item{};
+    item.meshID = meshID;
+    item.materialIndex = materialIndex;
+
+    const bool hasObject = objectID != static_cast<id_t>(-1);
+    if(trackLod && hasObject)
+    {
+        LodHistoryEntry& history = lodHistory[LodHistoryKey{item.meshID, objectID}];
+        history.lod = selectLod(*graphicsMesh->second, bounds, transform, history.lod);
+        history.lastFrame = lodFrame;
+        item.lod = history.lod;
+    }
+    else
+    {
+        item.lod = selectLod(*graphicsMesh->second, bounds, transform, 0);
+    }
+    item.instance.model = transform;
+    if(hasObject)
+    {
+        item.instance.objectID = static_cast<int32_t>(frameObjects.size());
+        frameObjects.push_back(objectID);
+    }
+    drawItems.push_back(item);
 }
 
-std::unique_ptr<Buffer> Graphics::createInstanceBuffer(const std::vector<glm::mat4>& transforms)
+uint32_t Graphics::selectLod(const GraphicsMesh& mesh, const core::MeshData::Bounds& bounds, const glm::mat4& transform, uint32_t previousLod) const
 {
-    uint32_t instanceCount = transforms.size();
-    VkDeviceSize bufferSize = sizeof(transforms[0]) * instanceCount;
-    uint32_t instanceSize = sizeof(transforms[0]);
+    if(camera == nullptr || sceneRenderPass == nullptr || mesh.getLodCount() <= 1)
+    {
+        return 0;
+    }
 
-    Buffer stagingBuffer{
-        *Shared::device,
-        instanceSize,
-        instanceCount,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+    // Pixels per world unit at the closest point of the bounding sphere, orthographic projections have no falloff
+    const glm::mat4 projection = camera->getProjection();
+    const float scale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+    const float radius = bounds.radius * scale;
+    float pixelsPerUnit = glm::abs(projection[1][1]) * 0.5f * static_cast<float>(sceneRenderPass->getExtent().height);
+    if(projection[3][3] == 0.0f)
+    {
+        glm::vec3 center = glm::vec3(transform * glm::vec4(bounds.center, 1.0f));
+        float distance = glm::length(center - glm::vec3(camera->getView()[3])) - radius;
+        pixelsPerUnit /= glm::max(distance, camera->getNear());
+    }
+    const float projectedRadius = radius * pixelsPerUnit;
+
+    // Errors grow with every level, so take the last one that is still below the threshold
+    uint32_t lod = 0;
+    for(uint32_t i = 1; i < mesh.getLodCount(); i++)
+    {
+        float threshold = i > previousLod ? LOD_ERROR_PIXELS * (1.0f - LOD_HYSTERESIS) : LOD_ERROR_PIXELS;
+        if(mesh.getLod(i).error * projectedRadius > threshold)
+        {
+            break;
+        }
+        lod = i;
+    }
+    return lod;
+}
+
+// Sort key layout, most significant bits first
+// Opaque:      pass (2) | pipeline (8) | material (14) | mesh (21) | lod (3) | depth (16), front-to-back
+// Transparent: pass (2) | inverted depth (16) | pipeline (8) | material (14) | mesh (21) | lod (3), back-to-front
+namespace
+{
+    enum SortPass : uint64_t
+    {
+        SORT_PASS_OPAQUE = 0,
+        SORT_PASS_TRANSPARENT = 1
     };
+    constexpr uint64_t SORT_PIPELINE_MASK = (1ull << 8) - 1;
+    constexpr uint64_t SORT_MATERIAL_MASK = (1ull << 14) - 1;
+    constexpr uint64_t SORT_MESH_MASK = (1ull << 21) - 1;
+    constexpr uint64_t SORT_LOD_MASK = (1ull << 3) - 1;
+    constexpr uint64_t SORT_DEPTH_MASK = (1ull << 16) - 1;
+}
+
+uint64_t Graphics::createSortKey(const DrawItem& item, const glm::vec3& cameraPosition, float depthScale) const
+{
+    const Shader* shader = Shared::materials[item.materialIndex].getShader();
+    uint64_t pipeline = static_cast<uint64_t>(shader->getPipeline()->getID()) & SORT_PIPELINE_MASK;
+    uint64_t material = static_cast<uint64_t>(item.materialIndex) & SORT_MATERIAL_MASK;
+    uint64_t mesh = (static_cast<uint64_t>(meshSortIDs.at(item.meshID)) & SORT_MESH_MASK) << 3 | (item.lod & SORT_LOD_MASK);
 
-    stagingBuffer.map();
-    stagingBuffer.writeToBuffer((void *)transforms.data());
+    // Logarithmic quantization keeps more precision close to the camera
+    float distance = glm::length(glm::vec3(item.instance.model[3]) - cameraPosition);
+    uint64_t depth = static_cast<uint64_t>(glm::clamp(glm::log2(1.0f + distance) * depthScale, 0.0f, 1.0f) * SORT_DEPTH_MASK);
 
-    std::unique_ptr<Buffer> instanceBuffer = std::make_unique<Buffer>(
-        *Shared::device,
-        instanceSize,
-        instanceCount,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-    );
+    if(shader->isTransparent())
+    {
+        return (SORT_PASS_TRANSPARENT << 62) | ((SORT_DEPTH_MASK - depth) << 46) | (pipeline << 38) | (material << 24) | mesh;
+    }
+    return (SORT_PASS_OPAQUE << 62) | (pipeline << 54) | (material << 40) | (mesh << 16) | depth;
+}
+
+void Graphics::buildBatches(const std::vector<DrawItem>& drawItems, std::vector<MeshRenderData>& renderQueue)
+{
+    renderQueue.clear();
+    if(drawItems.empty()) return;
+
+    glm::vec3 cameraPosition = camera != nullptr ? glm::vec3(camera->getView()[3]) : glm::vec3(0.0f);
+    float depthScale = 1.0f / glm::log2(1.0f + (camera != nullptr ? camera->getFar() : 1000.0f));
+
+    sortEntries.resize(drawItems.size());
+    for(size_t i = 0; i < drawItems.size(); i++)
+    {
+        sortEntries[i] = {createSortKey(drawItems[i], cameraPosition, depthScale), static_cast<uint32_t>(i)};
+    }
+    radixSort(sortEntries, sortScratch);
+
+    // Items are written in sorted order, so every run sharing a mesh, LOD and material is already contiguous
+    FrameAllocator::Allocation allocation = instanceAllocator->allocate(sizeof(InstanceData) * drawItems.size(), alignof(InstanceData));
+    InstanceData* instances = static_cast<InstanceData*>(allocation.mapped);
+    for(size_t i = 0; i < sortEntries.size(); i++)
+    {
+        const DrawItem& item = drawItems[sortEntries[i].index];
+        instances[i] = item.instance;
+
+        if(renderQueue.empty() || renderQueue.back().meshID != item.meshID || renderQueue.back().materialIndex != item.materialIndex
+            || renderQueue.back().lod != item.lod)
+        {
+            MeshRenderData batch{item.meshID, item.materialIndex, item.lod, 0};
+            batch.instances.buffer = allocation.buffer;
+            batch.instances.offset = allocation.offset + sizeof(InstanceData) * i;
+            batch.instances.mapped = instances + i;
+            renderQueue.push_back(batch);
+        }
+        MeshRenderData& batch = renderQueue.back();
+        batch.instanceCount++;
+        batch.instances.size += sizeof(InstanceData);
+    }
 
-    Shared::device->copyBuffer(stagingBuffer.getBuffer(), instanceBuffer->getBuffer(), bufferSize);
-    return std::move(instanceBuffer);
+    renderStats.drawItems += static_cast<uint32_t>(drawItems.size());
+    renderStats.batches += static_cast<uint32_t>(renderQueue.size());
 }
 
 } // namespace graphics
\ No newline at end of file
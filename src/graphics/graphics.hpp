@@ -5,6 +5,8 @@
 #include <GLFW/glfw3.h>
 #include <memory>
 #include <map>
+#include <unordered_map>
+#include <mutex>
 
 #include "engine_types.hpp"
 #include "utils/console.hpp"
@@ -17,12 +19,16 @@
 #include "internal/render_pass.hpp"
 #include "buffers/buffer.hpp"
 #include "buffers/texture.hpp"
+#include "buffers/frame_allocator.hpp"
+#include "buffers/buffer_uploader.hpp"
+#include "utils/radix_sort.hpp"
 #include "frame_info.hpp"
 
 #include "buffers/graphics_mesh.hpp"
 #include "camera.hpp"
 #include "shader.hpp"
 #include "compute/compute_shader.hpp"
+#include "compute/meshlet_culler.hpp"
 #include "shader_resource.hpp"
 #include "buffers/material.hpp"
 #include "core/game_object.hpp" // TODO: Remove dependencies on core
@@ -53,8 +59,10 @@ public:
     void updateExtent();
     void drawFrame();
     void setCamera(Camera* _camera) { camera = _camera; }
+    Camera* getCamera() const { return camera; }
 
     void waitForDevice() { vkDeviceWaitIdle(device.device()); }
+    void setFrameLatency(uint32_t latency) { renderer.setFrameLatency(latency); }
 
     Window *getWindow() { return &window; }
     Device *getDevice() { return &device; }
@@ -62,43 +70,136 @@ public:
     void bindGlobalDescriptor(FrameInfo& frameInfo, GraphicsPipeline* pipeline);
     
     void graphicsInitImgui();
+    void drawImGui();
     
     void reloadShaders();
     
-    int getClickedObjID(uint32_t x, uint32_t y);
+    // Instance ID of the object under a pixel of the viewport, read back from the object ID pass of the last recorded frame
+    // -1 for no object and while the pass is disabled
+    // The readback stalls on the GPU, core::Engine picks with a CPU raycast unless the pass is enabled
+    id_t getClickedObjID(uint32_t x, uint32_t y);
+    void setIdBufferEnabled(bool enabled) { idBufferEnabled = enabled; }
+    bool isIdBufferEnabled() const { return idBufferEnabled; }
     VkDescriptorSet getViewportDescriptorSet() const {
         return viewportDescriptorSet;
     };
     
     // Mesh management
+    // Meshes may be created on the simulation thread, which uploads them through the graphics queue
+    // The render thread holds this lock from the first draw of a frame until it is submitted and around anything else using the queue
+    std::unique_lock<std::mutex> lockMeshes() { return std::unique_lock<std::mutex>(meshMutex); }
     void setGraphicsMesh(const core::Mesh& mesh); // Create and update meshes
+    // Uploads only the ranges marked dirty on the mesh data, for meshes edited every frame
+    // Falls back to setGraphicsMesh when the buffers can not be patched, see GraphicsMesh::update
+    void updateGraphicsMesh(const core::Mesh& mesh);
     void destroyGraphicsMeshes();
-    void drawMesh(const core::Mesh& mesh, uint32_t materialIndex, const glm::mat4 &transform, uint32_t objectID = -1); // Draw to scene
+    void drawMesh(const core::Mesh& mesh, uint32_t materialIndex, const glm::mat4 &transform, id_t objectID = -1); // Draw to scene
     void drawMeshInstanced(const core::Mesh& mesh, uint32_t materialIndex, const std::vector<glm::mat4> &transforms); // Draw to scene
     void drawMeshOutline(const core::Mesh& mesh, const glm::mat4 &transform);
+    // For draws of meshes owned by another thread, nothing of the MeshData is read and bounds are the ones it had when the draw was made
+    // Meshes without a GraphicsMesh are skipped, the caller holds lockMeshes()
+    void drawMesh(id_t meshID, const core::MeshData::Bounds& bounds, uint32_t materialIndex, const glm::mat4& transform, id_t objectID = -1);
+    void drawMeshOutline(id_t meshID, const core::MeshData::Bounds& bounds, const glm::mat4& transform);
 
     void drawSkybox();
 
     VkExtent2D viewportSize{};
 
 private:
+    // A single submitted instance, sorted and merged into MeshRenderData batches before recording
+    struct DrawItem
+    {
+        id_t meshID;
+        uint32_t materialIndex;
+        uint32_t lod;
+        InstanceData instance;
+    };
+    // One instanced draw call
     struct MeshRenderData
     {
-        MeshRenderData(id_t id, const glm::mat4& _transform, uint32_t materialID = 0, id_t objID = -1)
-            : meshID(id), objectID(objID), transforms{_transform}, materialIndex{materialID}, instanceBuffer{createInstanceBuffer(transforms)} {}
-        MeshRenderData(id_t id, const std::vector<glm::mat4>& _transform, uint32_t materialID = 0, id_t objID = -1)
-            : meshID(id), objectID(objID), transforms{_transform}, materialIndex{materialID}, instanceBuffer{createInstanceBuffer(transforms)} {}
-
         id_t meshID;
-        uint32_t objectID;
         uint32_t materialIndex;
-        std::vector<glm::mat4> transforms{};
-        std::unique_ptr<Buffer> instanceBuffer{};
+        uint32_t lod;
+        uint32_t instanceCount;
+        FrameAllocator::Allocation instances{}; // Instance data, only valid for the frame it was submitted in
+        MeshletCuller::DrawList drawList{};     // Visible meshlets, drawn instead of the whole LOD when set
     };
+    std::vector<DrawItem> sceneDrawItems{};
+    std::vector<DrawItem> outlineDrawItems{};
     std::vector<MeshRenderData> sceneRenderQueue{};
     std::vector<MeshRenderData> outlineRenderQueue{};
+    std::vector<SortEntry> sortEntries{}; // Reused between frames to avoid allocating
+    std::vector<SortEntry> sortScratch{};
+
+    // Initial size of each per-frame slice of instance data, grows if a frame submits more
+    static constexpr VkDeviceSize INSTANCE_SLICE_SIZE = 4 * 1024 * 1024;
+    std::unique_ptr<FrameAllocator> instanceAllocator{};
+    // Partial mesh updates, copied at the start of the next recorded frame
+    std::unique_ptr<BufferUploader> bufferUploader{};
+    // Null when the device lacks multi draw indirect, dense meshes are then drawn whole
+    std::unique_ptr<MeshletCuller> meshletCuller{};
+
+    struct RenderStats
+    {
+        uint32_t drawItems = 0;
+        uint32_t batches = 0;
+        uint32_t pipelineBinds = 0;
+        uint32_t descriptorBinds = 0;
+        uint32_t drawCalls = 0;
+        uint64_t triangles = 0;     // Upper bound, meshlet culled batches count their whole LOD
+        uint32_t culledBatches = 0;
+        uint32_t meshletsTested = 0;
+        uint64_t uploadedBytes = 0;
+    };
+    RenderStats renderStats{};
 
-    static std::unique_ptr<Buffer> createInstanceBuffer(const std::vector<glm::mat4>& transforms);
+    std::mutex meshMutex;
+    // setGraphicsMesh for callers that already hold the mesh lock
+    void createGraphicsMesh(const core::Mesh& mesh);
+    // Creates the GraphicsMesh of a mesh drawn by the thread that owns it if there is none yet
+    void requireGraphicsMesh(const core::Mesh& mesh);
+    void pushDrawItem(std::vector<DrawItem>& drawItems, id_t meshID, const core::MeshData::Bounds& bounds, uint32_t materialIndex,
+        const glm::mat4& transform, id_t objectID, bool trackLod = true);
+
+    // Instance IDs only fit the ID buffer as an index into the objects drawn in the frame
+    std::vector<id_t> frameObjects{};
+    std::vector<id_t> idBufferObjects{}; // frameObjects of the frame the ID buffer was last rendered for
+
+    // A level of detail is used while its error projects to at most LOD_ERROR_PIXELS on screen
+    // Switching to a coarser level requires the error to drop HYSTERESIS below that, so levels do not flicker at the boundary
+    static constexpr float LOD_ERROR_PIXELS = 1.0f;
+    static constexpr float LOD_HYSTERESIS = 0.25f;
+    // Last level per object and mesh, anonymous draws are selected without history
+    // Keyed on the whole handles, so a reused slot starts over instead of inheriting the level of the object it held before
+    struct LodHistoryKey
+    {
+        id_t meshID;
+        id_t objectID;
+        bool operator==(const LodHistoryKey& other) const = default;
+    };
+    struct LodHistoryKeyHash
+    {
+        size_t operator()(const LodHistoryKey& key) const
+        {
+            uint64_t hash = key.meshID * 0x9E3779B97F4A7C15ull ^ key.objectID * 0xC2B2AE3D27D4EB4Full;
+            hash ^= hash >> 32;
+            return static_cast<size_t>(hash);
+        }
+    };
+    struct LodHistoryEntry
+    {
+        uint32_t lod = 0;
+        uint64_t lastFrame = 0; // Entries not drawn in a frame are dropped when its queues are reset
+    };
+    std::unordered_map<LodHistoryKey, LodHistoryEntry, LodHistoryKeyHash> lodHistory{};
+    uint64_t lodFrame = 0;
+    uint32_t selectLod(const GraphicsMesh& mesh, const core::MeshData::Bounds& bounds, const glm::mat4& transform, uint32_t previousLod) const;
+    uint64_t createSortKey(const DrawItem& item, const glm::vec3& cameraPosition, float depthScale) const;
+    // Sorts draw items by state and depth, then merges runs sharing a mesh and material into instanced draws
+    void buildBatches(const std::vector<DrawItem>& drawItems, std::vector<MeshRenderData>& renderQueue);
+    void resetRenderQueues();
+    // Records the meshlet culling of every batch with a dense mesh, must run outside of a render pass
+    void cullMeshlets(VkCommandBuffer commandBuffer, std::vector<MeshRenderData>& renderQueue);
 
 
     void createRenderPasses();
@@ -122,7 +223,7 @@ private:
     std::unique_ptr<PipelineManager> pipelineManager;
     PipelineConfigInfo configInfo;
 
-    std::unique_ptr<Buffer> globalUboBuffer;
+    std::vector<std::unique_ptr<Buffer>> globalUboBuffers;
     std::vector<std::unique_ptr<Buffer>> cameraUboBuffers;
     std::vector<std::shared_ptr<Texture>> textures;
 
@@ -142,10 +243,14 @@ private:
     std::unique_ptr<Material> outlineResultMaterial{};
     core::Mesh skyboxMesh{};
     Texture *idTexture = nullptr;
+    bool idBufferEnabled = false;
     Texture *viewportTexture = nullptr;
 
     // Store graphics meshes based on instance ID
     std::unordered_map<id_t, std::unique_ptr<GraphicsMesh>> graphicsMeshes{};
+    // Compact per-mesh IDs that fit in the sort key, assigned once per mesh
+    std::unordered_map<id_t, uint32_t> meshSortIDs{};
+    uint32_t nextMeshSortID = 0;
 
     VkClearColorValue defaultClearColor{0.04f, 0.08f, 0.2f, 1.0f};
 
@@ -178,9 +178,30 @@ void Device::createLogicalDevice() {
   // atomicFloatFeatures.shaderImageFloat32Atomics = VK_TRUE; // Enable float32 atomics on images
   // atomicFloatFeatures.shaderImageFloat32AtomicAdd = VK_TRUE; // Enable float32 atomics on images
 
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
   deviceFeatures.fillModeNonSolid = VK_TRUE; // Allow wireframe rendering
+  // Optional, GPU meshlet culling draws its output with indirect draws starting at arbitrary instances
+  deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+  deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
+  // Optional, lets culled indirect draws read their draw count from the GPU
+  VkPhysicalDeviceVulkan12Features supportedVulkan12Features = {};
+  supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  if (properties.apiVersion >= VK_API_VERSION_1_2) {
+    VkPhysicalDeviceFeatures2 supportedFeatures2 = {};
+    supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures2.pNext = &supportedVulkan12Features;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+    vulkan12Features.drawIndirectCount = supportedVulkan12Features.drawIndirectCount;
+  }
+  enabledFeatures = deviceFeatures;
+  drawIndirectCountEnabled = vulkan12Features.drawIndirectCount == VK_TRUE;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -191,7 +212,7 @@ void Device::createLogicalDevice() {
   createInfo.pEnabledFeatures = &deviceFeatures;
   createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
   createInfo.ppEnabledExtensionNames = deviceExtensions.data();
-  createInfo.pNext = nullptr;//&atomicFloatFeatures; // Add the atomic float features to the device create info
+  createInfo.pNext = properties.apiVersion >= VK_API_VERSION_1_2 ? &vulkan12Features : nullptr;//&atomicFloatFeatures; // Add the atomic float features to the device create info
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -50,6 +50,8 @@ class Device {
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
   QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
+  const VkPhysicalDeviceFeatures &getEnabledFeatures() const { return enabledFeatures; }
+  bool isDrawIndirectCountEnabled() const { return drawIndirectCountEnabled; }
   VkFormat findSupportedFormat(
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
@@ -102,6 +104,8 @@ class Device {
   VkSurfaceKHR surface_;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  VkPhysicalDeviceFeatures enabledFeatures{};
+  bool drawIndirectCountEnabled = false;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_SHADER_NON_SEMANTIC_INFO_EXTENSION_NAME};//, VK_EXT_FILTER_CUBIC_EXTENSION_NAME }; //, VK_EXT_SHADER_ATOMIC_FLOAT_EXTENSION_NAME };
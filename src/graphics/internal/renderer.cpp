@@ -1,6 +1,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <array>
+#include <algorithm>
 #include <GLFW/glfw3.h>
 
 #include "renderer.hpp"
@@ -28,6 +29,13 @@ VkCommandBuffer Renderer::startFrame()
 {
     assert(!frameInProgress && "Can't start new frame while one is still in progress");
 
+    // If the frame submitted last is still executing, the CPU work for this frame ran in parallel with it
+    size_t previousFrame = (swapChain->getCurrentFrame() + SwapChain::MAX_FRAMES_IN_FLIGHT - 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+    if(frameStats.frameCount > 0 && !swapChain->isFrameComplete(previousFrame))
+    {
+        frameStats.overlappedFrames++;
+    }
+
     VkResult result = swapChain->acquireNextImage(&currentImageIndex);
     if(result == VK_ERROR_OUT_OF_DATE_KHR)
     {
@@ -76,10 +84,34 @@ void Renderer::endFrame()
 
     frameInProgress = false;
     currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+    frameStats.frameCount++;
 
     currentCommandBuffer = nullptr; // Clear current command buffer pointer, still tracked in vector
 }
 
+void Renderer::waitForFrameResources()
+{
+    assert(!frameInProgress && "Can't wait for frame resources while a frame is being recorded");
+
+    double start = glfwGetTime();
+
+    // The slot about to be reused is always waited on, lower latencies also wait on more recent frames
+    size_t pendingFrame = swapChain->getCurrentFrame();
+    for(uint32_t framesAgo = SwapChain::MAX_FRAMES_IN_FLIGHT; framesAgo >= frameLatency; framesAgo--)
+    {
+        size_t frame = (pendingFrame + SwapChain::MAX_FRAMES_IN_FLIGHT - framesAgo) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+        swapChain->waitForFrame(frame);
+    }
+
+    frameStats.lastFenceWaitMs = (glfwGetTime() - start) * 1000.0;
+    frameStats.totalFenceWaitMs += frameStats.lastFenceWaitMs;
+}
+
+void Renderer::setFrameLatency(uint32_t latency)
+{
+    frameLatency = std::clamp<uint32_t>(latency, 1, SwapChain::MAX_FRAMES_IN_FLIGHT);
+}
+
 void Renderer::beginRenderPass(VkRenderPass renderPass, VkFramebuffer frameBuffer, VkExtent2D extent, VkClearColorValue clearColor)
 {
     assert(frameInProgress && "Can't begin render pass when frame is not in progress");
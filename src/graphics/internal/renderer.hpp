@@ -46,6 +46,14 @@ struct GlobalUbo
 class Renderer
 {
 public:
+    struct FrameStats
+    {
+        uint64_t frameCount = 0;
+        uint64_t overlappedFrames = 0; // Frames that started recording while the previous frame was still on the GPU
+        double lastFenceWaitMs = 0.0;
+        double totalFenceWaitMs = 0.0;
+    };
+
     Renderer(Window& _window, Device& _device);
     ~Renderer();
 
@@ -59,6 +67,13 @@ public:
     void endRenderPass();
 
     void waitForDevice() { vkDeviceWaitIdle(device.device()); }
+    // Blocks until the resources owned by the pending frame may be overwritten by the CPU
+    void waitForFrameResources();
+
+    // Maximum number of submitted frames the GPU may still be working on while the CPU prepares the next one
+    void setFrameLatency(uint32_t latency);
+    uint32_t getFrameLatency() const { return frameLatency; }
+    const FrameStats& getFrameStats() const { return frameStats; }
 
     // Getters
     bool isFrameInProgress() const { return frameInProgress; }
@@ -76,6 +91,8 @@ public:
         assert(frameInProgress && "Cannot get frame index as frame is not in progress");
         return currentFrameIndex; 
     }
+    // Index of the frame that the next call to startFrame() will record
+    uint32_t getPendingFrameIndex() const { return currentFrameIndex; }
 
     static void windowRefreshCallback(GLFWwindow *window);
 
@@ -98,6 +115,9 @@ private:
     uint32_t currentImageIndex = 0;
     uint32_t currentFrameIndex = 0;
     bool frameInProgress = false;
+
+    uint32_t frameLatency = SwapChain::MAX_FRAMES_IN_FLIGHT;
+    FrameStats frameStats{};
 };
 
 } // namespace graphics
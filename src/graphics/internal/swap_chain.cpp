@@ -84,6 +84,19 @@ VkResult SwapChain::acquireNextImage(uint32_t *imageIndex) {
   return result;
 }
 
+void SwapChain::waitForFrame(size_t frame) {
+  vkWaitForFences(
+      device.device(),
+      1,
+      &inFlightFences[frame],
+      VK_TRUE,
+      std::numeric_limits<uint64_t>::max());
+}
+
+bool SwapChain::isFrameComplete(size_t frame) const {
+  return vkGetFenceStatus(device.device(), inFlightFences[frame]) == VK_SUCCESS;
+}
+
 VkResult SwapChain::submitCommandBuffers(
     const VkCommandBuffer *buffers, uint32_t *imageIndex) {
   if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
@@ -42,6 +42,12 @@ class SwapChain {
     VkResult acquireNextImage(uint32_t *imageIndex);
     VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
 
+    // Frame slot that the next acquireNextImage/submitCommandBuffers pair will use
+    size_t getCurrentFrame() const { return currentFrame; }
+    // Blocks until the last submission made in the given frame slot has finished on the GPU
+    void waitForFrame(size_t frame);
+    bool isFrameComplete(size_t frame) const;
+
     bool compareSwapFormats(const SwapChain& swapChain) const
     {
         return swapChain.swapChainDepthFormat == swapChainDepthFormat && 
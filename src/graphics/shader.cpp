@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include "containers.hpp"
+#include "internal/swap_chain.hpp"
 #include <format>
 
 namespace graphics
@@ -18,15 +19,15 @@ namespace graphics
         reloadShader();
 
         DescriptorPool::Builder poolBuilder = DescriptorPool::Builder(*Shared::device)
-            .setMaxSets(GR_MAX_MATERIAL_COUNT)
+            .setMaxSets(GR_MAX_MATERIAL_COUNT * SwapChain::MAX_FRAMES_IN_FLIGHT)
             .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
         DescriptorSetLayout::Builder layoutBuilder = DescriptorSetLayout::Builder(*Shared::device)
             .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
         
-        poolBuilder.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, GR_MAX_MATERIAL_COUNT);
+        poolBuilder.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, GR_MAX_MATERIAL_COUNT * SwapChain::MAX_FRAMES_IN_FLIGHT);
         for(int i = 0; i < textureCount; i++)
         {
-            poolBuilder.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, GR_MAX_MATERIAL_COUNT);
+            poolBuilder.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, GR_MAX_MATERIAL_COUNT * SwapChain::MAX_FRAMES_IN_FLIGHT);
             layoutBuilder.addBinding(i + 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
         }
         descriptorPool = poolBuilder.build();
@@ -44,15 +45,15 @@ namespace graphics
 
 
         DescriptorPool::Builder poolBuilder = DescriptorPool::Builder(*Shared::device)
-            .setMaxSets(GR_MAX_MATERIAL_COUNT)
+            .setMaxSets(GR_MAX_MATERIAL_COUNT * SwapChain::MAX_FRAMES_IN_FLIGHT)
             .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
         DescriptorSetLayout::Builder layoutBuilder = DescriptorSetLayout::Builder(*Shared::device)
             .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
         
-        poolBuilder.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, GR_MAX_MATERIAL_COUNT);
+        poolBuilder.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, GR_MAX_MATERIAL_COUNT * SwapChain::MAX_FRAMES_IN_FLIGHT);
         for(int i = 0; i < textureCount; i++)
         {
-            poolBuilder.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, GR_MAX_MATERIAL_COUNT);
+            poolBuilder.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, GR_MAX_MATERIAL_COUNT * SwapChain::MAX_FRAMES_IN_FLIGHT);
             layoutBuilder.addBinding(i + 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
         }
         descriptorPool = poolBuilder.build();
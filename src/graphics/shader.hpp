@@ -58,6 +58,7 @@ namespace graphics
             Shader& operator=(const Shader&) = delete;
 
             PipelineConfigInfo& getConfigInfo() { return configInfo; };
+            bool isTransparent() const { return configInfo.colorBlendAttachment.blendEnable == VK_TRUE; }
             VkShaderModule& getVertexModule() { return vertShaderModule; }
             VkShaderModule& getFragmentModule() { return fragShaderModule; }
             const std::vector<ShaderInput>& getInputs() const { return inputs; }
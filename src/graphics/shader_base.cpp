@@ -1,5 +1,6 @@
 #include "shader_base.hpp"
 #include "containers.hpp"
+#include "buffers/graphics_mesh.hpp"
 
 namespace graphics
 {
@@ -38,6 +39,14 @@ namespace graphics
         sessionDesc.searchPaths = paths;
         sessionDesc.searchPathCount = 2;
 
+        // Selects the VertexData layout in shaderInputs.slang
+        const slang::PreprocessorMacroDesc compactVertices = { "COMPACT_VERTICES", "1" };
+        if(GraphicsMesh::getVertexFormat() == VertexFormat::COMPACT)
+        {
+            sessionDesc.preprocessorMacros = &compactVertices;
+            sessionDesc.preprocessorMacroCount = 1;
+        }
+
         Slang::ComPtr<slang::ISession> session;
         if (SLANG_FAILED(globalSession->createSession(sessionDesc, session.writeRef())))
             throw std::runtime_error("Slang: failed to create session");
@@ -13,6 +13,7 @@
 #include "graphics/internal/window.hpp"
 #include "graphics/graphics.hpp"
 #include "core/input.hpp"
+#include "benchmarks/benchmarks.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -85,8 +86,13 @@ void SetTitleBarColor(GLFWwindow* window, COLORREF titleBarColor, COLORREF borde
 }
 #endif
 
-int main() 
+int main(int argc, char** argv)
 {
+    if(argc > 1 && std::string(argv[1]) == "--benchmark")
+    {
+        return benchmarks::run(argc > 2 ? argv[2] : "");
+    }
+
     graphicsModule.init(APPLICATION_NAME, ENGINE_NAME);
 
     // Set window icon
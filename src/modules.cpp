@@ -1,3 +1,4 @@
 #include "modules.hpp"
 
-graphics::Graphics graphicsModule{};
\ No newline at end of file
+graphics::Graphics graphicsModule{};
+physics::Physics physicsModule{};
\ No newline at end of file
@@ -1,4 +1,6 @@
 #pragma once
 #include "graphics/graphics.hpp"
+#include "physics/physics.hpp"
 
-extern graphics::Graphics graphicsModule;
\ No newline at end of file
+extern graphics::Graphics graphicsModule;
+extern physics::Physics physicsModule;
\ No newline at end of file
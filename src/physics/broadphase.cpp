@@ -0,0 +1,137 @@
+#include "broadphase.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+namespace physics
+{
+uint32_t Broadphase::createProxy(const glm::vec3& min, const glm::vec3& max, uint64_t userData)
+{
+    uint32_t proxy = tree.createProxy(min, max, userData);
+    if(proxy >= proxyFlags.size())
+    {
+        proxyFlags.resize(proxy + 1, 0);
+    }
+    proxyFlags[proxy] = 0;
+    markMoved(proxy);
+    return proxy;
+}
+
+void Broadphase::destroyProxy(uint32_t proxy)
+{
+    if(proxyFlags[proxy] & DESTROYED)
+    {
+        return;
+    }
+    proxyFlags[proxy] |= DESTROYED;
+    destroyedProxies.push_back(proxy);
+}
+
+void Broadphase::moveProxy(uint32_t proxy, const glm::vec3& min, const glm::vec3& max, const glm::vec3& displacement)
+{
+    if(tree.moveProxy(proxy, min, max, displacement))
+    {
+        markMoved(proxy);
+    }
+}
+
+void Broadphase::clear()
+{
+    tree.clear();
+    proxyFlags.clear();
+    movedProxies.clear();
+    destroyedProxies.clear();
+    pairs.clear();
+    pairKeys.clear();
+    beganPairs.clear();
+    endedPairs.clear();
+}
+
+void Broadphase::markMoved(uint32_t proxy)
+{
+    if((proxyFlags[proxy] & MOVED) == 0)
+    {
+        proxyFlags[proxy] |= MOVED;
+        movedProxies.push_back(proxy);
+    }
+}
+
+void Broadphase::updatePairs(ThreadPool& pool)
+{
+    beganPairs.clear();
+    endedPairs.clear();
+
+    // Fat boxes of proxies that were not reinserted did not change, so only pairs with a moved side can have separated
+    size_t keptCount = 0;
+    for(const Pair& pair : pairs)
+    {
+        uint8_t flags = proxyFlags[pair.proxyA] | proxyFlags[pair.proxyB];
+        bool ended = (flags & DESTROYED) != 0 || ((flags & MOVED) != 0 && !DynamicTree::overlaps(
+            tree.getFatMin(pair.proxyA), tree.getFatMax(pair.proxyA), tree.getFatMin(pair.proxyB), tree.getFatMax(pair.proxyB)));
+        if(ended)
+        {
+            endedPairs.push_back(pair);
+            pairKeys.erase(getPairKey(pair.proxyA, pair.proxyB));
+        }
+        else
+        {
+            pairs[keptCount++] = pair;
+        }
+    }
+    pairs.resize(keptCount);
+
+    // Moved proxies look for overlaps, the ones already known are filtered out below
+    // Two moved proxies find each other, the pair is only taken from the query of the smaller one
+    std::vector<Pair> candidates{};
+    std::mutex candidatesMutex;
+    pool.parallelFor(movedProxies.size(), PARALLEL_QUERY_SIZE, [&](size_t begin, size_t end)
+    {
+        std::vector<Pair> rangeCandidates{};
+        for(size_t i = begin; i < end; i++)
+        {
+            uint32_t proxy = movedProxies[i];
+            if(proxyFlags[proxy] & DESTROYED)
+            {
+                continue;
+            }
+            tree.query(tree.getFatMin(proxy), tree.getFatMax(proxy), [&](uint32_t other)
+            {
+                uint8_t otherFlags = proxyFlags[other];
+                if(other != proxy && (otherFlags & DESTROYED) == 0 && ((otherFlags & MOVED) == 0 || proxy < other))
+                {
+                    rangeCandidates.push_back({std::min(proxy, other), std::max(proxy, other)});
+                }
+                return true;
+            });
+        }
+        std::lock_guard<std::mutex> lock(candidatesMutex);
+        candidates.insert(candidates.end(), rangeCandidates.begin(), rangeCandidates.end());
+    });
+
+    // Ranges finish in any order, sorting keeps the reported pairs deterministic
+    std::sort(candidates.begin(), candidates.end(), [](const Pair& a, const Pair& b)
+    {
+        return getPairKey(a.proxyA, a.proxyB) < getPairKey(b.proxyA, b.proxyB);
+    });
+    for(const Pair& candidate : candidates)
+    {
+        if(pairKeys.insert(getPairKey(candidate.proxyA, candidate.proxyB)).second)
+        {
+            pairs.push_back(candidate);
+            beganPairs.push_back(candidate);
+        }
+    }
+
+    for(uint32_t proxy : movedProxies)
+    {
+        proxyFlags[proxy] &= ~MOVED;
+    }
+    movedProxies.clear();
+    for(uint32_t proxy : destroyedProxies)
+    {
+        tree.destroyProxy(proxy);
+        proxyFlags[proxy] = 0;
+    }
+    destroyedProxies.clear();
+}
+} // namespace physics
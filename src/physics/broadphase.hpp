@@ -0,0 +1,65 @@
+#pragma once
+#include "dynamic_tree.hpp"
+#include "utils/thread_pool.hpp"
+
+#include <unordered_set>
+#include <vector>
+
+namespace physics
+{
+    // Pairs of proxies whose fat boxes overlap, kept up to date incrementally on a DynamicTree
+    // Only proxies that were created or reinserted since the last updatePairs query the tree, and only pairs involving them
+    // are tested for separation, so a step costs in proportion to what moved rather than to the number of proxies squared
+    class Broadphase
+    {
+        public:
+            struct Pair
+            {
+                uint32_t proxyA; // Always the smaller of the two
+                uint32_t proxyB;
+            };
+
+            // Moved proxies are queried in parallel once there are this many of them
+            static constexpr size_t PARALLEL_QUERY_SIZE = 256;
+
+            uint32_t createProxy(const glm::vec3& min, const glm::vec3& max, uint64_t userData);
+            // The pairs of the proxy are ended by the next updatePairs, its index is not reused before that
+            void destroyProxy(uint32_t proxy);
+            // displacement is how far the proxy moved since the last step, fat boxes stretch ahead of it
+            void moveProxy(uint32_t proxy, const glm::vec3& min, const glm::vec3& max, const glm::vec3& displacement);
+            void clear();
+
+            // Finds the pairs that began or ended since the last call
+            void updatePairs(ThreadPool& pool = ThreadPool::getGlobal());
+
+            // Every current pair, in no particular order
+            const std::vector<Pair>& getPairs() const { return pairs; }
+            // Changes made by the last updatePairs, ended pairs may reference proxies destroyed since
+            const std::vector<Pair>& getBeganPairs() const { return beganPairs; }
+            const std::vector<Pair>& getEndedPairs() const { return endedPairs; }
+
+            uint64_t getUserData(uint32_t proxy) const { return tree.getUserData(proxy); }
+            const DynamicTree& getTree() const { return tree; }
+            size_t getProxyCount() const { return tree.getProxyCount() - destroyedProxies.size(); }
+
+        private:
+            enum ProxyFlags : uint8_t
+            {
+                MOVED = 1,
+                DESTROYED = 2
+            };
+
+            static uint64_t getPairKey(uint32_t proxyA, uint32_t proxyB) { return static_cast<uint64_t>(proxyA) << 32 | proxyB; }
+            void markMoved(uint32_t proxy);
+
+            DynamicTree tree{};
+            std::vector<uint8_t> proxyFlags{};
+            std::vector<uint32_t> movedProxies{};
+            std::vector<uint32_t> destroyedProxies{};
+
+            std::vector<Pair> pairs{};
+            std::unordered_set<uint64_t> pairKeys{};
+            std::vector<Pair> beganPairs{};
+            std::vector<Pair> endedPairs{};
+    };
+} // namespace physics
@@ -0,0 +1,653 @@
+#include "bvh.hpp"
+#include "bvh_kernels.hpp"
+#include "core/mesh.hpp"
+#include "core/mesh_processing.hpp"
+#include "utils/thread_pool.hpp"
+
+#include <bit>
+#include <cmath>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BVH_X86
+#endif
+
+namespace physics
+{
+namespace
+{
+    constexpr size_t PARALLEL_RANGE_SIZE = 4096;
+
+    struct Box
+    {
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+        void grow(const glm::vec3& point)
+        {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+        void grow(const glm::vec3& otherMin, const glm::vec3& otherMax)
+        {
+            min = glm::min(min, otherMin);
+            max = glm::max(max, otherMax);
+        }
+        void grow(const Box& other) { grow(other.min, other.max); }
+
+        // Half the surface area, only ever compared
+        float area() const
+        {
+            glm::vec3 extent = max - min;
+            if(extent.x < 0.0f || extent.y < 0.0f || extent.z < 0.0f)
+            {
+                return 0.0f;
+            }
+            return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+        }
+    };
+
+    struct Bin
+    {
+        Box bounds{};
+        uint32_t count = 0;
+    };
+
+    struct BuildTask
+    {
+        uint32_t node;
+        uint32_t begin;
+        uint32_t end;
+        uint32_t depth;
+        Box bounds;
+        Box centroids;
+    };
+
+    void runRanges(bool parallel, size_t count, size_t minRangeSize, const std::function<void(size_t begin, size_t end)>& function)
+    {
+        if(parallel)
+        {
+            ThreadPool::getGlobal().parallelFor(count, minRangeSize, function);
+        }
+        else
+        {
+            function(0, count);
+        }
+    }
+
+    // Splits tasks top down, reordering indices so every node covers a contiguous range of them
+    class Builder
+    {
+        public:
+            Builder(std::span<const glm::vec3> _boundsMin, std::span<const glm::vec3> _boundsMax, const std::vector<glm::vec3>& _centroids,
+                std::vector<uint32_t>& _indices, uint32_t _maxLeafSize, float _traversalCost)
+                : boundsMin(_boundsMin), boundsMax(_boundsMax), centroids(_centroids), indices(_indices), maxLeafSize(_maxLeafSize),
+                  traversalCost(_traversalCost) {}
+
+            // Builds the subtree of root into nodes, subtrees of at most deferSize primitives are handed to deferred instead when it is set
+            void build(std::vector<Bvh::Node>& nodes, const BuildTask& root, bool parallel, size_t deferSize, std::vector<BuildTask>* deferred) const
+            {
+                std::vector<BuildTask> stack{root};
+                while(!stack.empty())
+                {
+                    BuildTask task = stack.back();
+                    stack.pop_back();
+                    if(deferred != nullptr && task.end - task.begin <= deferSize)
+                    {
+                        deferred->push_back(task);
+                        continue;
+                    }
+
+                    nodes[task.node].min = task.bounds.min;
+                    nodes[task.node].max = task.bounds.max;
+                    BuildTask left{};
+                    BuildTask right{};
+                    if(task.depth + 1 >= Bvh::MAX_DEPTH || !split(task, left, right, parallel))
+                    {
+                        nodes[task.node].index = task.begin;
+                        nodes[task.node].count = task.end - task.begin;
+                        continue;
+                    }
+
+                    uint32_t firstChild = static_cast<uint32_t>(nodes.size());
+                    nodes[task.node].index = firstChild;
+                    nodes[task.node].count = 0;
+                    nodes.resize(nodes.size() + 2);
+                    left.node = firstChild;
+                    right.node = firstChild + 1;
+                    left.depth = right.depth = task.depth + 1;
+                    stack.push_back(right);
+                    stack.push_back(left);
+                }
+            }
+
+        private:
+            // Returns false when the task is better off as a leaf
+            bool split(const BuildTask& task, BuildTask& left, BuildTask& right, bool parallel) const
+            {
+                const uint32_t count = task.end - task.begin;
+                if(count <= 1)
+                {
+                    return false;
+                }
+
+                const glm::vec3 extent = task.centroids.max - task.centroids.min;
+                glm::vec3 scale{};
+                for(int axis = 0; axis < 3; axis++)
+                {
+                    scale[axis] = extent[axis] > 0.0f ? Bvh::BIN_COUNT * 0.9999f / extent[axis] : 0.0f;
+                }
+                auto binIndex = [&](uint32_t primitive, int axis)
+                {
+                    uint32_t bin = static_cast<uint32_t>((centroids[primitive][axis] - task.centroids.min[axis]) * scale[axis]);
+                    return std::min(bin, Bvh::BIN_COUNT - 1);
+                };
+
+                Bin bins[3][Bvh::BIN_COUNT]{};
+                auto fillBins = [&](size_t begin, size_t end, Bin (&target)[3][Bvh::BIN_COUNT])
+                {
+                    for(size_t i = begin; i < end; i++)
+                    {
+                        uint32_t primitive = indices[i];
+                        for(int axis = 0; axis < 3; axis++)
+                        {
+                            Bin& bin = target[axis][binIndex(primitive, axis)];
+                            bin.bounds.grow(boundsMin[primitive], boundsMax[primitive]);
+                            bin.count++;
+                        }
+                    }
+                };
+                if(parallel && count >= Bvh::PARALLEL_BIN_SIZE)
+                {
+                    std::mutex mutex;
+                    ThreadPool::getGlobal().parallelFor(count, Bvh::PARALLEL_BIN_SIZE / 4, [&](size_t begin, size_t end)
+                    {
+                        Bin local[3][Bvh::BIN_COUNT]{};
+                        fillBins(task.begin + begin, task.begin + end, local);
+                        std::lock_guard<std::mutex> lock(mutex);
+                        for(int axis = 0; axis < 3; axis++)
+                        {
+                            for(uint32_t i = 0; i < Bvh::BIN_COUNT; i++)
+                            {
+                                bins[axis][i].bounds.grow(local[axis][i].bounds);
+                                bins[axis][i].count += local[axis][i].count;
+                            }
+                        }
+                    });
+                }
+                else
+                {
+                    fillBins(task.begin, task.end, bins);
+                }
+
+                // Every plane between two bins is scored by the areas of both sides weighted by their primitive counts
+                float bestCost = std::numeric_limits<float>::max();
+                int bestAxis = -1;
+                uint32_t bestBin = 0;
+                for(int axis = 0; axis < 3; axis++)
+                {
+                    if(scale[axis] == 0.0f)
+                    {
+                        continue;
+                    }
+                    float leftAreas[Bvh::BIN_COUNT];
+                    uint32_t leftCounts[Bvh::BIN_COUNT];
+                    Box accumulated{};
+                    uint32_t accumulatedCount = 0;
+                    for(uint32_t i = 0; i + 1 < Bvh::BIN_COUNT; i++)
+                    {
+                        accumulated.grow(bins[axis][i].bounds);
+                        accumulatedCount += bins[axis][i].count;
+                        leftAreas[i] = accumulated.area();
+                        leftCounts[i] = accumulatedCount;
+                    }
+                    accumulated = {};
+                    accumulatedCount = 0;
+                    for(uint32_t i = Bvh::BIN_COUNT - 1; i > 0; i--)
+                    {
+                        accumulated.grow(bins[axis][i].bounds);
+                        accumulatedCount += bins[axis][i].count;
+                        if(accumulatedCount == 0 || leftCounts[i - 1] == 0)
+                        {
+                            continue;
+                        }
+                        float cost = leftAreas[i - 1] * leftCounts[i - 1] + accumulated.area() * accumulatedCount;
+                        if(cost < bestCost)
+                        {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestBin = i;
+                        }
+                    }
+                }
+
+                if(bestAxis < 0)
+                {
+                    // Every centroid is in the same spot, halving the range at least keeps the leaves small
+                    if(count <= maxLeafSize)
+                    {
+                        return false;
+                    }
+                    uint32_t middle = task.begin + count / 2;
+                    left = {0, task.begin, middle, 0, {}, {}};
+                    right = {0, middle, task.end, 0, {}, {}};
+                    for(BuildTask* half : {&left, &right})
+                    {
+                        for(uint32_t i = half->begin; i < half->end; i++)
+                        {
+                            half->bounds.grow(boundsMin[indices[i]], boundsMax[indices[i]]);
+                        }
+                        half->centroids = task.centroids;
+                    }
+                    return true;
+                }
+
+                float parentArea = task.bounds.area();
+                float splitCost = parentArea > 0.0f ? traversalCost + bestCost / parentArea : static_cast<float>(count);
+                if(count <= maxLeafSize && splitCost >= static_cast<float>(count))
+                {
+                    return false;
+                }
+
+                auto middle = std::partition(indices.begin() + task.begin, indices.begin() + task.end,
+                    [&](uint32_t primitive) { return binIndex(primitive, bestAxis) < bestBin; });
+                uint32_t middleIndex = static_cast<uint32_t>(middle - indices.begin());
+                left = {0, task.begin, middleIndex, 0, {}, {}};
+                right = {0, middleIndex, task.end, 0, {}, {}};
+                for(uint32_t i = 0; i < Bvh::BIN_COUNT; i++)
+                {
+                    (i < bestBin ? left : right).bounds.grow(bins[bestAxis][i].bounds);
+                }
+                // Only one side of the split is known per primitive after partitioning, so the centroids are bounded in a second pass
+                for(uint32_t i = task.begin; i < task.end; i++)
+                {
+                    (i < middleIndex ? left : right).centroids.grow(centroids[indices[i]]);
+                }
+                return true;
+            }
+
+            std::span<const glm::vec3> boundsMin;
+            std::span<const glm::vec3> boundsMax;
+            const std::vector<glm::vec3>& centroids;
+            std::vector<uint32_t>& indices;
+            uint32_t maxLeafSize;
+            float traversalCost;
+    };
+
+    // Scalar version of kernels::intersectTriangleBlock
+    size_t intersectTriangleBlockScalar(const float* block, const float* origin, const float* direction, float maxDistance, float* distances, uint32_t* hits)
+    {
+        const glm::vec3 rayOrigin(origin[0], origin[1], origin[2]);
+        const glm::vec3 rayDirection(direction[0], direction[1], direction[2]);
+        size_t hitCount = 0;
+        for(size_t slot = 0; slot < TRIANGLE_BLOCK_SIZE; slot++)
+        {
+            auto component = [&](size_t index) { return block[index * TRIANGLE_BLOCK_SIZE + slot]; };
+            const glm::vec3 vertex(component(0), component(1), component(2));
+            const glm::vec3 edge1(component(3), component(4), component(5));
+            const glm::vec3 edge2(component(6), component(7), component(8));
+
+            glm::vec3 p = glm::cross(rayDirection, edge2);
+            float inverseDeterminant = 1.0f / glm::dot(edge1, p);
+            glm::vec3 s = rayOrigin - vertex;
+            float u = glm::dot(s, p) * inverseDeterminant;
+            glm::vec3 q = glm::cross(s, edge1);
+            float v = glm::dot(rayDirection, q) * inverseDeterminant;
+            float t = glm::dot(edge2, q) * inverseDeterminant;
+            if(u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f && t < maxDistance)
+            {
+                distances[hitCount] = t;
+                hits[hitCount++] = static_cast<uint32_t>(slot);
+            }
+        }
+        return hitCount;
+    }
+
+    // Scalar version of kernels::intersectBoxPacket
+    uint32_t intersectBoxPacketScalar(const RayPacket& packet, const float* boxMin, const float* boxMax, float* entries)
+    {
+        const glm::vec3 min(boxMin[0], boxMin[1], boxMin[2]);
+        const glm::vec3 max(boxMax[0], boxMax[1], boxMax[2]);
+        uint32_t mask = 0;
+        for(size_t lane = 0; lane < PACKET_SIZE; lane++)
+        {
+            float enter = getPacketRay(packet, lane).intersectBox(min, max, packet.maxDistance[lane]);
+            entries[lane] = enter;
+            if(enter != std::numeric_limits<float>::infinity())
+            {
+                mask |= 1u << lane;
+            }
+        }
+        return mask;
+    }
+} // namespace
+
+Ray::Ray(const glm::vec3& _origin, const glm::vec3& _direction) : origin(_origin), direction(_direction)
+{
+    for(int axis = 0; axis < 3; axis++)
+    {
+        float component = std::abs(direction[axis]) > 1e-20f ? direction[axis] : std::copysign(1e-20f, direction[axis]);
+        inverseDirection[axis] = 1.0f / component;
+    }
+}
+
+void Bvh::build(std::span<const glm::vec3> boundsMin, std::span<const glm::vec3> boundsMax, const BuildSettings& settings)
+{
+    clear();
+    traversalCost = settings.traversalCost;
+    const size_t count = boundsMin.size();
+    if(count == 0)
+    {
+        return;
+    }
+    const bool parallel = settings.parallel && count >= PARALLEL_BUILD_SIZE && ThreadPool::getGlobal().getThreadCount() > 0;
+
+    std::vector<glm::vec3> centroids(count);
+    primitiveIndices.resize(count);
+    BuildTask root{0, 0, static_cast<uint32_t>(count), 0, {}, {}};
+    std::mutex mutex;
+    runRanges(parallel, count, PARALLEL_RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        Box bounds{};
+        Box centroidBounds{};
+        for(size_t i = begin; i < end; i++)
+        {
+            centroids[i] = (boundsMin[i] + boundsMax[i]) * 0.5f;
+            primitiveIndices[i] = static_cast<uint32_t>(i);
+            bounds.grow(boundsMin[i], boundsMax[i]);
+            centroidBounds.grow(centroids[i]);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        root.bounds.grow(bounds);
+        root.centroids.grow(centroidBounds);
+    });
+
+    const uint32_t maxLeafSize = std::max(settings.maxLeafSize, 1u);
+    Builder builder(boundsMin, boundsMax, centroids, primitiveIndices, maxLeafSize, traversalCost);
+    nodes.reserve(count / std::max(maxLeafSize / 2, 1u) * 2 + 1);
+    nodes.resize(1);
+    if(!parallel)
+    {
+        builder.build(nodes, root, false, 0, nullptr);
+        alignLeaves(settings.leafAlignment);
+        return;
+    }
+
+    // The top of the tree is split on this thread, with the binning of large nodes spread over the pool,
+    // until there are enough subtrees to keep every thread busy, those are then built independently and appended
+    const size_t threadCount = ThreadPool::getGlobal().getThreadCount() + 1;
+    std::vector<BuildTask> subtrees{};
+    builder.build(nodes, root, true, std::max<size_t>(count / (threadCount * 4), 1024), &subtrees);
+
+    std::vector<std::vector<Node>> subtreeNodes(subtrees.size());
+    ThreadPool::getGlobal().parallelFor(subtrees.size(), 1, [&](size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            BuildTask task = subtrees[i];
+            task.node = 0;
+            subtreeNodes[i].resize(1);
+            builder.build(subtreeNodes[i], task, false, 0, nullptr);
+        }
+    });
+
+    for(size_t i = 0; i < subtrees.size(); i++)
+    {
+        // Local node j > 0 lands at base + j - 1, the local root replaces the placeholder left by the top level
+        const uint32_t base = static_cast<uint32_t>(nodes.size());
+        auto relocate = [base](Node node)
+        {
+            if(!node.isLeaf())
+            {
+                node.index = base + node.index - 1;
+            }
+            return node;
+        };
+        nodes[subtrees[i].node] = relocate(subtreeNodes[i][0]);
+        for(size_t j = 1; j < subtreeNodes[i].size(); j++)
+        {
+            nodes.push_back(relocate(subtreeNodes[i][j]));
+        }
+    }
+    alignLeaves(settings.leafAlignment);
+}
+
+void Bvh::alignLeaves(uint32_t alignment)
+{
+    if(alignment <= 1)
+    {
+        return;
+    }
+    std::vector<uint32_t> aligned{};
+    aligned.reserve(primitiveIndices.size() + primitiveIndices.size() / 2);
+    for(Node& node : nodes)
+    {
+        if(node.isLeaf())
+        {
+            uint32_t first = static_cast<uint32_t>(aligned.size());
+            aligned.insert(aligned.end(), primitiveIndices.begin() + node.index, primitiveIndices.begin() + node.index + node.count);
+            aligned.resize((aligned.size() + alignment - 1) / alignment * alignment, INVALID_PRIMITIVE);
+            node.index = first;
+        }
+    }
+    primitiveIndices = std::move(aligned);
+}
+
+void Bvh::refit(std::span<const glm::vec3> boundsMin, std::span<const glm::vec3> boundsMax)
+{
+    for(size_t i = nodes.size(); i-- > 0;)
+    {
+        Node& node = nodes[i];
+        Box bounds{};
+        if(node.isLeaf())
+        {
+            for(uint32_t j = node.index; j < node.index + node.count; j++)
+            {
+                bounds.grow(boundsMin[primitiveIndices[j]], boundsMax[primitiveIndices[j]]);
+            }
+        }
+        else
+        {
+            bounds.grow(nodes[node.index].min, nodes[node.index].max);
+            bounds.grow(nodes[node.index + 1].min, nodes[node.index + 1].max);
+        }
+        node.min = bounds.min;
+        node.max = bounds.max;
+    }
+}
+
+void Bvh::clear()
+{
+    nodes.clear();
+    primitiveIndices.clear();
+}
+
+uint32_t Bvh::intersectPacket(const RayPacket& packet, uint32_t node, float* entries) const
+{
+    const float* min = &nodes[node].min.x;
+    const float* max = &nodes[node].max.x;
+    switch(core::MeshProcessing::getSimdLevel())
+    {
+#ifdef BVH_X86
+        case core::MeshProcessing::SimdLevel::AVX2:
+            return intersectBoxPacketAvx2(packet, min, max, entries);
+        case core::MeshProcessing::SimdLevel::SSE:
+            return intersectBoxPacketSse(packet, min, max, entries);
+#endif
+        default:
+            return intersectBoxPacketScalar(packet, min, max, entries);
+    }
+}
+
+float Bvh::computeCost() const
+{
+    if(nodes.empty())
+    {
+        return 0.0f;
+    }
+    float cost = 0.0f;
+    for(const Node& node : nodes)
+    {
+        Box bounds{node.min, node.max};
+        cost += bounds.area() * (node.isLeaf() ? static_cast<float>(node.count) : traversalCost);
+    }
+    float rootArea = Box{nodes[0].min, nodes[0].max}.area();
+    return rootArea > 0.0f ? cost / rootArea : cost;
+}
+
+MeshBvh::MeshBvh(const core::MeshData& mesh, bool parallel) : triangleCount(mesh.triangles.size()), vertexCount(mesh.vertices.size())
+{
+    parallel = parallel && triangleCount >= Bvh::PARALLEL_BUILD_SIZE;
+    std::vector<glm::vec3> boundsMin(triangleCount);
+    std::vector<glm::vec3> boundsMax(triangleCount);
+    runRanges(parallel, triangleCount, PARALLEL_RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            const core::MeshData::Triangle& triangle = mesh.triangles[i];
+            const glm::vec3& p0 = mesh.vertices[triangle.v0].position;
+            const glm::vec3& p1 = mesh.vertices[triangle.v1].position;
+            const glm::vec3& p2 = mesh.vertices[triangle.v2].position;
+            boundsMin[i] = glm::min(p0, glm::min(p1, p2));
+            boundsMax[i] = glm::max(p0, glm::max(p1, p2));
+        }
+    });
+    Bvh::BuildSettings settings{};
+    settings.maxLeafSize = MAX_LEAF_SIZE;
+    settings.leafAlignment = TRIANGLE_BLOCK_SIZE;
+    settings.traversalCost = TRAVERSAL_COST;
+    settings.parallel = parallel;
+    bvh.build(boundsMin, boundsMax, settings);
+
+    // Every leaf starts a new block, a slot of the primitive order maps to block slot / 8 and lane slot % 8
+    const std::vector<uint32_t>& order = bvh.getPrimitiveIndices();
+    triangleData.assign(order.size() / TRIANGLE_BLOCK_SIZE * TRIANGLE_BLOCK_FLOATS, 0.0f);
+    runRanges(parallel, order.size(), PARALLEL_RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        for(size_t slot = begin; slot < end; slot++)
+        {
+            if(order[slot] == Bvh::INVALID_PRIMITIVE)
+            {
+                continue;
+            }
+            const core::MeshData::Triangle& triangle = mesh.triangles[order[slot]];
+            const glm::vec3& p0 = mesh.vertices[triangle.v0].position;
+            const glm::vec3 edge1 = mesh.vertices[triangle.v1].position - p0;
+            const glm::vec3 edge2 = mesh.vertices[triangle.v2].position - p0;
+            const float values[9] = {p0.x, p0.y, p0.z, edge1.x, edge1.y, edge1.z, edge2.x, edge2.y, edge2.z};
+            float* block = triangleData.data() + slot / TRIANGLE_BLOCK_SIZE * TRIANGLE_BLOCK_FLOATS + slot % TRIANGLE_BLOCK_SIZE;
+            for(size_t component = 0; component < 9; component++)
+            {
+                block[component * TRIANGLE_BLOCK_SIZE] = values[component];
+            }
+        }
+    });
+}
+
+size_t MeshBvh::intersectBlock(const float* origin, const float* direction, size_t block, float maxDistance, float* distances, uint32_t* hits) const
+{
+    const float* data = triangleData.data() + block * TRIANGLE_BLOCK_FLOATS;
+    switch(core::MeshProcessing::getSimdLevel())
+    {
+#ifdef BVH_X86
+        case core::MeshProcessing::SimdLevel::AVX2:
+            return intersectTriangleBlockAvx2(data, origin, direction, maxDistance, distances, hits);
+        case core::MeshProcessing::SimdLevel::SSE:
+            return intersectTriangleBlockSse(data, origin, direction, maxDistance, distances, hits);
+#endif
+        default:
+            return intersectTriangleBlockScalar(data, origin, direction, maxDistance, distances, hits);
+    }
+}
+
+MeshBvh::Hit MeshBvh::makeHit(float distance, size_t slot) const
+{
+    const float* block = triangleData.data() + slot / TRIANGLE_BLOCK_SIZE * TRIANGLE_BLOCK_FLOATS + slot % TRIANGLE_BLOCK_SIZE;
+    glm::vec3 edge1(block[TRIANGLE_BLOCK_SIZE * 3], block[TRIANGLE_BLOCK_SIZE * 4], block[TRIANGLE_BLOCK_SIZE * 5]);
+    glm::vec3 edge2(block[TRIANGLE_BLOCK_SIZE * 6], block[TRIANGLE_BLOCK_SIZE * 7], block[TRIANGLE_BLOCK_SIZE * 8]);
+    return {distance, bvh.getPrimitiveIndices()[slot], glm::cross(edge1, edge2)};
+}
+
+bool MeshBvh::raycast(const Ray& ray, float& maxDistance, Hit& hit) const
+{
+    float distances[TRIANGLE_BLOCK_SIZE];
+    uint32_t hits[TRIANGLE_BLOCK_SIZE];
+    size_t closest = SIZE_MAX;
+    bvh.traverse(ray, maxDistance, [&](uint32_t first, uint32_t count)
+    {
+        // Only leaves made at the depth limit span more than one block
+        for(size_t block = first / TRIANGLE_BLOCK_SIZE; block * TRIANGLE_BLOCK_SIZE < first + count; block++)
+        {
+            size_t hitCount = intersectBlock(&ray.origin.x, &ray.direction.x, block, maxDistance, distances, hits);
+            for(size_t i = 0; i < hitCount; i++)
+            {
+                if(distances[i] < maxDistance)
+                {
+                    maxDistance = distances[i];
+                    closest = block * TRIANGLE_BLOCK_SIZE + hits[i];
+                }
+            }
+        }
+    });
+    if(closest == SIZE_MAX)
+    {
+        return false;
+    }
+    hit = makeHit(maxDistance, closest);
+    return true;
+}
+
+void MeshBvh::raycastAll(const Ray& ray, float maxDistance, std::vector<Hit>& hits) const
+{
+    float blockDistances[TRIANGLE_BLOCK_SIZE];
+    uint32_t blockHits[TRIANGLE_BLOCK_SIZE];
+    bvh.traverse(ray, maxDistance, [&](uint32_t first, uint32_t count)
+    {
+        for(size_t block = first / TRIANGLE_BLOCK_SIZE; block * TRIANGLE_BLOCK_SIZE < first + count; block++)
+        {
+            size_t hitCount = intersectBlock(&ray.origin.x, &ray.direction.x, block, maxDistance, blockDistances, blockHits);
+            for(size_t i = 0; i < hitCount; i++)
+            {
+                hits.push_back(makeHit(blockDistances[i], block * TRIANGLE_BLOCK_SIZE + blockHits[i]));
+            }
+        }
+    });
+}
+
+uint32_t MeshBvh::raycastPacket(RayPacket& packet, uint32_t mask, Hit* hits) const
+{
+    float distances[TRIANGLE_BLOCK_SIZE];
+    uint32_t blockHits[TRIANGLE_BLOCK_SIZE];
+    size_t closest[PACKET_SIZE];
+    uint32_t hitMask = 0;
+    bvh.traversePacket(packet, mask, [&](uint32_t first, uint32_t count, uint32_t leafMask)
+    {
+        for(size_t block = first / TRIANGLE_BLOCK_SIZE; block * TRIANGLE_BLOCK_SIZE < first + count; block++)
+        {
+            // The block stays in cache while every lane that reached the leaf is tested against it
+            for(uint32_t lanes = leafMask; lanes != 0; lanes &= lanes - 1)
+            {
+                uint32_t lane = static_cast<uint32_t>(std::countr_zero(lanes));
+                const float origin[3] = {packet.originX[lane], packet.originY[lane], packet.originZ[lane]};
+                const float direction[3] = {packet.directionX[lane], packet.directionY[lane], packet.directionZ[lane]};
+                size_t hitCount = intersectBlock(origin, direction, block, packet.maxDistance[lane], distances, blockHits);
+                for(size_t i = 0; i < hitCount; i++)
+                {
+                    if(distances[i] < packet.maxDistance[lane])
+                    {
+                        packet.maxDistance[lane] = distances[i];
+                        closest[lane] = block * TRIANGLE_BLOCK_SIZE + blockHits[i];
+                        hitMask |= 1u << lane;
+                    }
+                }
+            }
+        }
+    });
+    for(uint32_t lanes = hitMask; lanes != 0; lanes &= lanes - 1)
+    {
+        uint32_t lane = static_cast<uint32_t>(std::countr_zero(lanes));
+        hits[lane] = makeHit(packet.maxDistance[lane], closest[lane]);
+    }
+    return hitMask;
+}
+} // namespace physics
@@ -0,0 +1,323 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <limits>
+#include <bit>
+
+#include "bvh_kernels.hpp"
+
+namespace core
+{
+    class MeshData;
+}
+
+namespace physics
+{
+    // Distances along a ray are in units of its direction, which does not have to be normalized
+    struct Ray
+    {
+        glm::vec3 origin{};
+        glm::vec3 direction{};
+        glm::vec3 inverseDirection{}; // Zero components are nudged to a tiny value so slab tests never produce NaNs
+
+        Ray() = default;
+        Ray(const glm::vec3& _origin, const glm::vec3& _direction);
+
+        // Distance at which the ray enters the box, infinity when it misses it or only reaches it past maxDistance
+        float intersectBox(const glm::vec3& min, const glm::vec3& max, float maxDistance) const
+        {
+            glm::vec3 t0 = (min - origin) * inverseDirection;
+            glm::vec3 t1 = (max - origin) * inverseDirection;
+            glm::vec3 entries = glm::min(t0, t1);
+            glm::vec3 exits = glm::max(t0, t1);
+            float enter = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+            float exit = std::min(std::min(exits.x, exits.y), std::min(exits.z, maxDistance));
+            return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+        }
+    };
+
+    // Box around a box moved by an affine transform, its half extents are projected onto every axis
+    inline void transformBounds(const glm::vec3& min, const glm::vec3& max, const glm::mat4& transform, glm::vec3& transformedMin, glm::vec3& transformedMax)
+    {
+        glm::vec3 center = (min + max) * 0.5f;
+        glm::vec3 halfExtent = (max - min) * 0.5f;
+        glm::vec3 transformedCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+        glm::vec3 transformedHalfExtent = glm::abs(glm::vec3(transform[0])) * halfExtent.x
+            + glm::abs(glm::vec3(transform[1])) * halfExtent.y
+            + glm::abs(glm::vec3(transform[2])) * halfExtent.z;
+        transformedMin = transformedCenter - transformedHalfExtent;
+        transformedMax = transformedCenter + transformedHalfExtent;
+    }
+
+    // Lanes of a RayPacket are filled and read back as Rays
+    inline void setPacketRay(RayPacket& packet, size_t lane, const Ray& ray, float maxDistance)
+    {
+        packet.originX[lane] = ray.origin.x;
+        packet.originY[lane] = ray.origin.y;
+        packet.originZ[lane] = ray.origin.z;
+        packet.directionX[lane] = ray.direction.x;
+        packet.directionY[lane] = ray.direction.y;
+        packet.directionZ[lane] = ray.direction.z;
+        packet.inverseDirectionX[lane] = ray.inverseDirection.x;
+        packet.inverseDirectionY[lane] = ray.inverseDirection.y;
+        packet.inverseDirectionZ[lane] = ray.inverseDirection.z;
+        packet.maxDistance[lane] = maxDistance;
+    }
+
+    // Fills a lane that no box test will report
+    inline void clearPacketRay(RayPacket& packet, size_t lane)
+    {
+        Ray ray{};
+        ray.inverseDirection = glm::vec3(1.0f);
+        setPacketRay(packet, lane, ray, -1.0f);
+    }
+
+    inline Ray getPacketRay(const RayPacket& packet, size_t lane)
+    {
+        Ray ray{};
+        ray.origin = glm::vec3(packet.originX[lane], packet.originY[lane], packet.originZ[lane]);
+        ray.direction = glm::vec3(packet.directionX[lane], packet.directionY[lane], packet.directionZ[lane]);
+        ray.inverseDirection = glm::vec3(packet.inverseDirectionX[lane], packet.inverseDirectionY[lane], packet.inverseDirectionZ[lane]);
+        return ray;
+    }
+
+    // Bounding volume hierarchy over primitives given as boxes, split by the surface area heuristic over binned centroids
+    // Large builds are spread over the global ThreadPool
+    // Children are always stored after their parent, so refitting is a single reverse pass
+    class Bvh
+    {
+        public:
+            struct Node
+            {
+                glm::vec3 min;
+                uint32_t index; // First child of an interior node with the second right after it, first primitive of a leaf
+                glm::vec3 max;
+                uint32_t count; // Primitives of a leaf, 0 for interior nodes
+
+                bool isLeaf() const { return count > 0; }
+            };
+
+            static constexpr uint32_t BIN_COUNT = 16;
+            // Deeper nodes are made leaves whatever their size, which bounds the traversal stack
+            static constexpr uint32_t MAX_DEPTH = 64;
+            // Builds with fewer primitives stay on the calling thread
+            static constexpr size_t PARALLEL_BUILD_SIZE = 16 * 1024;
+            // Nodes with fewer primitives are binned on one thread
+            static constexpr size_t PARALLEL_BIN_SIZE = 64 * 1024;
+
+            static constexpr uint32_t INVALID_PRIMITIVE = UINT32_MAX;
+
+            struct BuildSettings
+            {
+                uint32_t maxLeafSize = 4;    // Only exceeded by leaves at the depth limit
+                uint32_t leafAlignment = 1;  // Every leaf starts at a multiple of this in the primitive order, gaps hold INVALID_PRIMITIVE
+                float traversalCost = 1.0f;  // Of visiting a node, relative to testing one primitive
+                bool parallel = true;
+            };
+
+            void build(std::span<const glm::vec3> boundsMin, std::span<const glm::vec3> boundsMax, const BuildSettings& settings);
+            // Keeps the topology and fits every node to the new bounds of its primitives
+            void refit(std::span<const glm::vec3> boundsMin, std::span<const glm::vec3> boundsMax);
+            void clear();
+
+            bool empty() const { return nodes.empty(); }
+            const std::vector<Node>& getNodes() const { return nodes; }
+            // A leaf covers primitiveIndices[index, index + count)
+            const std::vector<uint32_t>& getPrimitiveIndices() const { return primitiveIndices; }
+            // Expected cost of a ray query relative to testing the root, grows as refitting loosens the tree
+            float computeCost() const;
+
+            // Calls leafFunction(first, count) for every leaf the ray enters before maxDistance, nearest first
+            // The function may lower maxDistance, nodes entered past it are then skipped
+            template<class LeafFunction>
+            void traverse(const Ray& ray, float& maxDistance, LeafFunction&& leafFunction) const
+            {
+                if(nodes.empty() || ray.intersectBox(nodes[0].min, nodes[0].max, maxDistance) == std::numeric_limits<float>::infinity())
+                {
+                    return;
+                }
+
+                struct Entry
+                {
+                    uint32_t node;
+                    float distance;
+                };
+                Entry stack[MAX_DEPTH];
+                uint32_t stackSize = 0;
+                uint32_t current = 0;
+                while(true)
+                {
+                    const Node& node = nodes[current];
+                    if(node.isLeaf())
+                    {
+                        leafFunction(node.index, node.count);
+                    }
+                    else
+                    {
+                        uint32_t nearChild = node.index;
+                        uint32_t farChild = node.index + 1;
+                        float nearDistance = ray.intersectBox(nodes[nearChild].min, nodes[nearChild].max, maxDistance);
+                        float farDistance = ray.intersectBox(nodes[farChild].min, nodes[farChild].max, maxDistance);
+                        if(farDistance < nearDistance)
+                        {
+                            std::swap(nearChild, farChild);
+                            std::swap(nearDistance, farDistance);
+                        }
+                        if(nearDistance != std::numeric_limits<float>::infinity())
+                        {
+                            if(farDistance != std::numeric_limits<float>::infinity())
+                            {
+                                stack[stackSize++] = {farChild, farDistance};
+                            }
+                            current = nearChild;
+                            continue;
+                        }
+                    }
+
+                    do
+                    {
+                        if(stackSize == 0)
+                        {
+                            return;
+                        }
+                        stackSize--;
+                    } while(stack[stackSize].distance > maxDistance);
+                    current = stack[stackSize].node;
+                }
+            }
+
+            // Packet version of traverse, the lanes of mask go down the tree together and leafFunction(first, count, leafMask)
+            // is called for every leaf entered by one of them, leafMask holding those that enter it
+            // The function may lower the maxDistance of lanes of the packet, nodes entered past it are then skipped for them
+            // Leaves are visited front to back along the first lane that enters both children of a node, which is the order
+            // of every lane when the packet is coherent
+            template<class LeafFunction>
+            void traversePacket(const RayPacket& packet, uint32_t mask, LeafFunction&& leafFunction) const
+            {
+                float entries[PACKET_SIZE];
+                if(nodes.empty() || (mask &= intersectPacket(packet, 0, entries)) == 0)
+                {
+                    return;
+                }
+
+                struct Entry
+                {
+                    uint32_t node;
+                    uint32_t mask;
+                };
+                Entry stack[MAX_DEPTH];
+                uint32_t stackSize = 0;
+                uint32_t current = 0;
+                while(true)
+                {
+                    const Node& node = nodes[current];
+                    if(node.isLeaf())
+                    {
+                        leafFunction(node.index, node.count, mask);
+                    }
+                    else
+                    {
+                        float nearEntries[PACKET_SIZE];
+                        float farEntries[PACKET_SIZE];
+                        uint32_t nearChild = node.index;
+                        uint32_t farChild = node.index + 1;
+                        uint32_t nearMask = mask & intersectPacket(packet, nearChild, nearEntries);
+                        uint32_t farMask = mask & intersectPacket(packet, farChild, farEntries);
+                        uint32_t bothMask = nearMask & farMask;
+                        if(bothMask != 0)
+                        {
+                            int lane = std::countr_zero(bothMask);
+                            if(farEntries[lane] < nearEntries[lane])
+                            {
+                                std::swap(nearChild, farChild);
+                                std::swap(nearMask, farMask);
+                            }
+                        }
+                        else if(nearMask == 0)
+                        {
+                            std::swap(nearChild, farChild);
+                            std::swap(nearMask, farMask);
+                        }
+                        if(nearMask != 0)
+                        {
+                            if(farMask != 0)
+                            {
+                                stack[stackSize++] = {farChild, farMask};
+                            }
+                            current = nearChild;
+                            mask = nearMask;
+                            continue;
+                        }
+                    }
+
+                    // Lanes that found a closer hit meanwhile are dropped by the box tests below the popped node
+                    if(stackSize == 0)
+                    {
+                        return;
+                    }
+                    stackSize--;
+                    current = stack[stackSize].node;
+                    mask = stack[stackSize].mask;
+                }
+            }
+
+        private:
+            // Tests every lane of the packet against a node, following MeshProcessing::getSimdLevel
+            uint32_t intersectPacket(const RayPacket& packet, uint32_t node, float* entries) const;
+
+            void alignLeaves(uint32_t alignment);
+
+            std::vector<Node> nodes{};
+            std::vector<uint32_t> primitiveIndices{};
+            float traversalCost = 1.0f;
+    };
+
+    // Collision BVH over the triangles of a mesh, a snapshot that has to be rebuilt when the mesh is edited
+    // Every leaf is one block of triangles (see bvh_kernels.hpp) stored in leaf order, so a leaf is a single contiguous read
+    // tested 8 (AVX2) or 4 (SSE) triangles at a time, following MeshProcessing::getSimdLevel
+    class MeshBvh
+    {
+        public:
+            static constexpr uint32_t MAX_LEAF_SIZE = TRIANGLE_BLOCK_SIZE;
+            // A whole block is tested for the price of a few node visits, so the builder is told nodes are expensive
+            static constexpr float TRAVERSAL_COST = 4.0f;
+
+            struct Hit
+            {
+                float distance;
+                uint32_t triangle; // Index into MeshData::triangles
+                glm::vec3 normal;  // Geometric, not normalized, in mesh space and following the winding of the triangle
+            };
+
+            explicit MeshBvh(const core::MeshData& mesh, bool parallel = true);
+
+            // Finds the closest hit in (0, maxDistance) and lowers maxDistance to it
+            bool raycast(const Ray& ray, float& maxDistance, Hit& hit) const;
+            // Appends every hit in (0, maxDistance), unordered
+            void raycastAll(const Ray& ray, float maxDistance, std::vector<Hit>& hits) const;
+            // Packet version of raycast for the lanes of mask, those that find a closer hit than their maxDistance lower it
+            // and get it in hits[lane], the returned mask holds them
+            uint32_t raycastPacket(RayPacket& packet, uint32_t mask, Hit* hits) const;
+
+            size_t getTriangleCount() const { return triangleCount; }
+            size_t getVertexCount() const { return vertexCount; }
+            glm::vec3 getBoundsMin() const { return bvh.empty() ? glm::vec3(0.0f) : bvh.getNodes()[0].min; }
+            glm::vec3 getBoundsMax() const { return bvh.empty() ? glm::vec3(0.0f) : bvh.getNodes()[0].max; }
+            const Bvh& getBvh() const { return bvh; }
+
+        private:
+            size_t intersectBlock(const float* origin, const float* direction, size_t block, float maxDistance, float* distances, uint32_t* hits) const;
+            Hit makeHit(float distance, size_t slot) const;
+
+            Bvh bvh{};
+            std::vector<float> triangleData{}; // One block per TRIANGLE_BLOCK_SIZE slots of the primitive order
+            size_t triangleCount = 0;
+            size_t vertexCount = 0;
+    };
+} // namespace physics
@@ -0,0 +1,44 @@
+// Built with -mavx2 (see CMakeLists.txt), only called after a runtime check for AVX2 support
+#include "bvh_kernels.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace physics
+{
+namespace
+{
+    struct Avx2Ops
+    {
+        using Vec = __m256;
+        static constexpr size_t WIDTH = 8;
+
+        static Vec load(const float* source) { return _mm256_loadu_ps(source); }
+        static void store(float* destination, Vec a) { _mm256_storeu_ps(destination, a); }
+        static Vec set(float value) { return _mm256_set1_ps(value); }
+        static Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+        static Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+        static Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+        static Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+        static Vec min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+        static Vec max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+        static Vec greater(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        static Vec greaterEqual(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+        static Vec less(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static Vec lessEqual(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+        static Vec bitAnd(Vec a, Vec b) { return _mm256_and_ps(a, b); }
+        static uint32_t moveMask(Vec a) { return static_cast<uint32_t>(_mm256_movemask_ps(a)); }
+    };
+} // namespace
+
+size_t intersectTriangleBlockAvx2(const float* block, const float* origin, const float* direction, float maxDistance, float* distances, uint32_t* hits)
+{
+    return kernels::intersectTriangleBlock<Avx2Ops>(block, origin, direction, maxDistance, distances, hits);
+}
+
+uint32_t intersectBoxPacketAvx2(const RayPacket& packet, const float* boxMin, const float* boxMax, float* entries)
+{
+    return kernels::intersectBoxPacket<Avx2Ops>(packet, boxMin, boxMax, entries);
+}
+} // namespace physics
+#endif
@@ -0,0 +1,144 @@
+#pragma once
+// SIMD ray/triangle kernels used by MeshBvh
+// Like core/mesh_processing_kernels.hpp this header must stay free of anything but intrinsics, the templates are instantiated
+// by translation units built with wider instruction sets
+#include <cstddef>
+#include <cstdint>
+
+namespace physics
+{
+    // Triangles are stored in blocks of TRIANGLE_BLOCK_SIZE, each one a vertex and the two edges leaving it, one component
+    // at a time: the vertex x of every triangle of the block, then their vertex y, and so on up to the z of the second edge
+    // Unused slots are all zero, their determinant is zero and they are never hit
+    constexpr size_t TRIANGLE_BLOCK_SIZE = 8;
+    constexpr size_t TRIANGLE_BLOCK_FLOATS = TRIANGLE_BLOCK_SIZE * 9;
+
+    // Rays traced together through a BVH, one array per component
+    // A lane is ignored by every box test while its maxDistance is negative, which is how unused lanes are filled
+    constexpr size_t PACKET_SIZE = 8;
+    struct RayPacket
+    {
+        float originX[PACKET_SIZE];
+        float originY[PACKET_SIZE];
+        float originZ[PACKET_SIZE];
+        float directionX[PACKET_SIZE];
+        float directionY[PACKET_SIZE];
+        float directionZ[PACKET_SIZE];
+        float inverseDirectionX[PACKET_SIZE];
+        float inverseDirectionY[PACKET_SIZE];
+        float inverseDirectionZ[PACKET_SIZE];
+        float maxDistance[PACKET_SIZE];
+    };
+
+    // Moller-Trumbore against one block, both faces are hit
+    // Writes the distance and slot of every hit in (0, maxDistance) to distances and hits and returns how many were written
+    size_t intersectTriangleBlockSse(const float* block, const float* origin, const float* direction, float maxDistance, float* distances, uint32_t* hits);
+    size_t intersectTriangleBlockAvx2(const float* block, const float* origin, const float* direction, float maxDistance, float* distances, uint32_t* hits);
+
+    // Slab test of every lane of the packet against one box, given as min xyz and max xyz
+    // Returns a bit per lane that enters the box before its maxDistance and writes the entry distances to entries
+    uint32_t intersectBoxPacketSse(const RayPacket& packet, const float* boxMin, const float* boxMax, float* entries);
+    uint32_t intersectBoxPacketAvx2(const RayPacket& packet, const float* boxMin, const float* boxMax, float* entries);
+
+    namespace kernels
+    {
+        template<class Ops>
+        size_t intersectTriangleBlock(const float* block, const float* origin, const float* direction, float maxDistance, float* distances, uint32_t* hits)
+        {
+            using Vec = typename Ops::Vec;
+            constexpr size_t WIDTH = Ops::WIDTH;
+            const Vec directionX = Ops::set(direction[0]);
+            const Vec directionY = Ops::set(direction[1]);
+            const Vec directionZ = Ops::set(direction[2]);
+            const Vec zero = Ops::set(0.0f);
+            const Vec one = Ops::set(1.0f);
+
+            size_t hitCount = 0;
+            for(size_t first = 0; first < TRIANGLE_BLOCK_SIZE; first += WIDTH)
+            {
+                const float* lanes = block + first;
+                Vec edge1X = Ops::load(lanes + TRIANGLE_BLOCK_SIZE * 3);
+                Vec edge1Y = Ops::load(lanes + TRIANGLE_BLOCK_SIZE * 4);
+                Vec edge1Z = Ops::load(lanes + TRIANGLE_BLOCK_SIZE * 5);
+                Vec edge2X = Ops::load(lanes + TRIANGLE_BLOCK_SIZE * 6);
+                Vec edge2Y = Ops::load(lanes + TRIANGLE_BLOCK_SIZE * 7);
+                Vec edge2Z = Ops::load(lanes + TRIANGLE_BLOCK_SIZE * 8);
+
+                Vec pX = Ops::sub(Ops::mul(directionY, edge2Z), Ops::mul(directionZ, edge2Y));
+                Vec pY = Ops::sub(Ops::mul(directionZ, edge2X), Ops::mul(directionX, edge2Z));
+                Vec pZ = Ops::sub(Ops::mul(directionX, edge2Y), Ops::mul(directionY, edge2X));
+                Vec inverseDeterminant = Ops::div(one, Ops::add(Ops::add(Ops::mul(edge1X, pX), Ops::mul(edge1Y, pY)), Ops::mul(edge1Z, pZ)));
+
+                Vec sX = Ops::sub(Ops::set(origin[0]), Ops::load(lanes));
+                Vec sY = Ops::sub(Ops::set(origin[1]), Ops::load(lanes + TRIANGLE_BLOCK_SIZE));
+                Vec sZ = Ops::sub(Ops::set(origin[2]), Ops::load(lanes + TRIANGLE_BLOCK_SIZE * 2));
+                Vec u = Ops::mul(Ops::add(Ops::add(Ops::mul(sX, pX), Ops::mul(sY, pY)), Ops::mul(sZ, pZ)), inverseDeterminant);
+
+                Vec qX = Ops::sub(Ops::mul(sY, edge1Z), Ops::mul(sZ, edge1Y));
+                Vec qY = Ops::sub(Ops::mul(sZ, edge1X), Ops::mul(sX, edge1Z));
+                Vec qZ = Ops::sub(Ops::mul(sX, edge1Y), Ops::mul(sY, edge1X));
+                Vec v = Ops::mul(Ops::add(Ops::add(Ops::mul(directionX, qX), Ops::mul(directionY, qY)), Ops::mul(directionZ, qZ)), inverseDeterminant);
+                Vec t = Ops::mul(Ops::add(Ops::add(Ops::mul(edge2X, qX), Ops::mul(edge2Y, qY)), Ops::mul(edge2Z, qZ)), inverseDeterminant);
+
+                // A zero determinant turns the barycentrics into infinities or NaNs, which fail the ordered compares below
+                Vec hit = Ops::bitAnd(Ops::greaterEqual(u, zero), Ops::greaterEqual(v, zero));
+                hit = Ops::bitAnd(hit, Ops::lessEqual(Ops::add(u, v), one));
+                hit = Ops::bitAnd(hit, Ops::bitAnd(Ops::greater(t, zero), Ops::less(t, Ops::set(maxDistance))));
+
+                uint32_t mask = Ops::moveMask(hit);
+                if(mask != 0)
+                {
+                    float laneDistances[WIDTH];
+                    Ops::store(laneDistances, t);
+                    for(size_t lane = 0; mask != 0; lane++, mask >>= 1)
+                    {
+                        if(mask & 1)
+                        {
+                            distances[hitCount] = laneDistances[lane];
+                            hits[hitCount++] = static_cast<uint32_t>(first + lane);
+                        }
+                    }
+                }
+            }
+            return hitCount;
+        }
+
+        template<class Ops>
+        uint32_t intersectBoxPacket(const RayPacket& packet, const float* boxMin, const float* boxMax, float* entries)
+        {
+            using Vec = typename Ops::Vec;
+            constexpr size_t WIDTH = Ops::WIDTH;
+            const Vec minX = Ops::set(boxMin[0]);
+            const Vec minY = Ops::set(boxMin[1]);
+            const Vec minZ = Ops::set(boxMin[2]);
+            const Vec maxX = Ops::set(boxMax[0]);
+            const Vec maxY = Ops::set(boxMax[1]);
+            const Vec maxZ = Ops::set(boxMax[2]);
+
+            uint32_t mask = 0;
+            for(size_t first = 0; first < PACKET_SIZE; first += WIDTH)
+            {
+                Vec originX = Ops::load(packet.originX + first);
+                Vec originY = Ops::load(packet.originY + first);
+                Vec originZ = Ops::load(packet.originZ + first);
+                Vec inverseX = Ops::load(packet.inverseDirectionX + first);
+                Vec inverseY = Ops::load(packet.inverseDirectionY + first);
+                Vec inverseZ = Ops::load(packet.inverseDirectionZ + first);
+
+                Vec t0X = Ops::mul(Ops::sub(minX, originX), inverseX);
+                Vec t1X = Ops::mul(Ops::sub(maxX, originX), inverseX);
+                Vec t0Y = Ops::mul(Ops::sub(minY, originY), inverseY);
+                Vec t1Y = Ops::mul(Ops::sub(maxY, originY), inverseY);
+                Vec t0Z = Ops::mul(Ops::sub(minZ, originZ), inverseZ);
+                Vec t1Z = Ops::mul(Ops::sub(maxZ, originZ), inverseZ);
+
+                Vec enter = Ops::max(Ops::max(Ops::min(t0X, t1X), Ops::min(t0Y, t1Y)), Ops::max(Ops::min(t0Z, t1Z), Ops::set(0.0f)));
+                Vec exit = Ops::min(Ops::min(Ops::max(t0X, t1X), Ops::max(t0Y, t1Y)),
+                    Ops::min(Ops::max(t0Z, t1Z), Ops::load(packet.maxDistance + first)));
+                Ops::store(entries + first, enter);
+                mask |= Ops::moveMask(Ops::lessEqual(enter, exit)) << first;
+            }
+            return mask;
+        }
+    } // namespace kernels
+} // namespace physics
@@ -0,0 +1,43 @@
+#include "bvh_kernels.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+
+namespace physics
+{
+namespace
+{
+    struct SseOps
+    {
+        using Vec = __m128;
+        static constexpr size_t WIDTH = 4;
+
+        static Vec load(const float* source) { return _mm_loadu_ps(source); }
+        static void store(float* destination, Vec a) { _mm_storeu_ps(destination, a); }
+        static Vec set(float value) { return _mm_set1_ps(value); }
+        static Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+        static Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+        static Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+        static Vec div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+        static Vec min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+        static Vec max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+        static Vec greater(Vec a, Vec b) { return _mm_cmpgt_ps(a, b); }
+        static Vec greaterEqual(Vec a, Vec b) { return _mm_cmpge_ps(a, b); }
+        static Vec less(Vec a, Vec b) { return _mm_cmplt_ps(a, b); }
+        static Vec lessEqual(Vec a, Vec b) { return _mm_cmple_ps(a, b); }
+        static Vec bitAnd(Vec a, Vec b) { return _mm_and_ps(a, b); }
+        static uint32_t moveMask(Vec a) { return static_cast<uint32_t>(_mm_movemask_ps(a)); }
+    };
+} // namespace
+
+size_t intersectTriangleBlockSse(const float* block, const float* origin, const float* direction, float maxDistance, float* distances, uint32_t* hits)
+{
+    return kernels::intersectTriangleBlock<SseOps>(block, origin, direction, maxDistance, distances, hits);
+}
+
+uint32_t intersectBoxPacketSse(const RayPacket& packet, const float* boxMin, const float* boxMax, float* entries)
+{
+    return kernels::intersectBoxPacket<SseOps>(packet, boxMin, boxMax, entries);
+}
+} // namespace physics
+#endif
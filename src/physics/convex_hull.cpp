@@ -0,0 +1,573 @@
+#include "convex_hull.hpp"
+#include "core/mesh.hpp"
+#include "utils/thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace physics
+{
+namespace
+{
+    constexpr uint32_t NO_FACE = UINT32_MAX;
+    constexpr uint32_t NO_POINT = UINT32_MAX;
+
+    struct Face
+    {
+        uint32_t vertices[3];
+        uint32_t neighbors[3]; // Across the edge from vertices[i] to vertices[(i + 1) % 3]
+        glm::vec3 normal;
+        float offset;
+        std::vector<uint32_t> outside{}; // Points in front of this face and no other earlier one
+        uint32_t furthest = NO_POINT;
+        float furthestDistance = 0.0f;
+        uint32_t visitStamp = 0;
+        bool alive = true;
+    };
+
+    struct HorizonEdge
+    {
+        uint32_t from;
+        uint32_t to;
+        uint32_t face; // Hidden face on the other side
+    };
+
+    class Builder
+    {
+        public:
+            Builder(std::span<const glm::vec3> _points, const QuickHull::Settings& _settings) : points(_points), settings(_settings)
+            {
+            }
+
+            ConvexHull build()
+            {
+                if(points.empty())
+                {
+                    return {};
+                }
+                glm::vec3 min = points[0];
+                glm::vec3 max = points[0];
+                for(const glm::vec3& point : points)
+                {
+                    min = glm::min(min, point);
+                    max = glm::max(max, point);
+                }
+                glm::vec3 extent = glm::max(glm::abs(min), glm::abs(max));
+                epsilon = std::max((extent.x + extent.y + extent.z) * QuickHull::RELATIVE_EPSILON, std::numeric_limits<float>::min());
+                if(!createSimplex())
+                {
+                    return createBox(min, max);
+                }
+
+                uint32_t vertexCount = 4;
+                while(!queue.empty())
+                {
+                    auto [distance, face] = queue.top();
+                    queue.pop();
+                    // Entries are not removed when their face dies or loses points, so stale ones are skipped here
+                    if(!faces[face].alive || faces[face].furthest == NO_POINT || faces[face].furthestDistance != distance)
+                    {
+                        continue;
+                    }
+                    if(settings.maxVertices != 0 && vertexCount >= settings.maxVertices)
+                    {
+                        break;
+                    }
+                    addPoint(face);
+                    vertexCount++;
+                }
+                return extract();
+            }
+
+        private:
+            float distance(const Face& face, uint32_t point) const
+            {
+                return glm::dot(face.normal, points[point]) - face.offset;
+            }
+
+            uint32_t addFace(uint32_t a, uint32_t b, uint32_t c)
+            {
+                Face face{};
+                face.vertices[0] = a;
+                face.vertices[1] = b;
+                face.vertices[2] = c;
+                face.neighbors[0] = face.neighbors[1] = face.neighbors[2] = NO_FACE;
+                glm::vec3 normal = glm::cross(points[b] - points[a], points[c] - points[a]);
+                float length = glm::length(normal);
+                face.normal = length > 0.0f ? normal / length : glm::vec3(0.0f);
+                face.offset = glm::dot(face.normal, points[a]);
+                faces.push_back(std::move(face));
+                return static_cast<uint32_t>(faces.size() - 1);
+            }
+
+            // Tetrahedron of extreme points, false when the points are all on a plane
+            bool createSimplex()
+            {
+                uint32_t extremes[6] = {0, 0, 0, 0, 0, 0};
+                for(uint32_t i = 0; i < points.size(); i++)
+                {
+                    for(int axis = 0; axis < 3; axis++)
+                    {
+                        if(points[i][axis] < points[extremes[axis * 2]][axis]) extremes[axis * 2] = i;
+                        if(points[i][axis] > points[extremes[axis * 2 + 1]][axis]) extremes[axis * 2 + 1] = i;
+                    }
+                }
+                uint32_t v0 = 0;
+                uint32_t v1 = 0;
+                float longest = 0.0f;
+                for(int a = 0; a < 6; a++)
+                {
+                    for(int b = a + 1; b < 6; b++)
+                    {
+                        float length = glm::length(points[extremes[a]] - points[extremes[b]]);
+                        if(length > longest)
+                        {
+                            longest = length;
+                            v0 = extremes[a];
+                            v1 = extremes[b];
+                        }
+                    }
+                }
+                if(longest <= epsilon)
+                {
+                    return false;
+                }
+
+                glm::vec3 axis = (points[v1] - points[v0]) / longest;
+                uint32_t v2 = NO_POINT;
+                float furthest = epsilon;
+                for(uint32_t i = 0; i < points.size(); i++)
+                {
+                    glm::vec3 offset = points[i] - points[v0];
+                    float lineDistance = glm::length(offset - axis * glm::dot(offset, axis));
+                    if(lineDistance > furthest)
+                    {
+                        furthest = lineDistance;
+                        v2 = i;
+                    }
+                }
+                if(v2 == NO_POINT)
+                {
+                    return false;
+                }
+
+                glm::vec3 normal = glm::normalize(glm::cross(points[v1] - points[v0], points[v2] - points[v0]));
+                uint32_t v3 = NO_POINT;
+                furthest = epsilon;
+                for(uint32_t i = 0; i < points.size(); i++)
+                {
+                    float planeDistance = std::abs(glm::dot(normal, points[i] - points[v0]));
+                    if(planeDistance > furthest)
+                    {
+                        furthest = planeDistance;
+                        v3 = i;
+                    }
+                }
+                if(v3 == NO_POINT)
+                {
+                    return false;
+                }
+
+                // Wound so that the first face looks away from the fourth point, the others follow from it
+                if(glm::dot(normal, points[v3] - points[v0]) > 0.0f)
+                {
+                    std::swap(v1, v2);
+                }
+                uint32_t simplex[4] = {addFace(v0, v1, v2), addFace(v0, v3, v1), addFace(v1, v3, v2), addFace(v2, v3, v0)};
+                for(uint32_t face : simplex)
+                {
+                    for(int edge = 0; edge < 3; edge++)
+                    {
+                        uint32_t from = faces[face].vertices[edge];
+                        uint32_t to = faces[face].vertices[(edge + 1) % 3];
+                        for(uint32_t other : simplex)
+                        {
+                            const Face& otherFace = faces[other];
+                            for(int otherEdge = 0; otherEdge < 3; otherEdge++)
+                            {
+                                if(otherFace.vertices[otherEdge] == to && otherFace.vertices[(otherEdge + 1) % 3] == from)
+                                {
+                                    faces[face].neighbors[edge] = other;
+                                }
+                            }
+                        }
+                    }
+                }
+
+                std::vector<uint32_t> candidates(points.size());
+                for(uint32_t i = 0; i < points.size(); i++)
+                {
+                    candidates[i] = i;
+                }
+                faceStartingAt.assign(points.size(), NO_FACE);
+                assignPoints(candidates, simplex);
+                return true;
+            }
+
+            // Moves every candidate into the outside set of the first face it is in front of, the others are inside the hull
+            void assignPoints(std::span<const uint32_t> candidates, std::span<const uint32_t> newFaces)
+            {
+                auto findFace = [&](uint32_t point, float& pointDistance)
+                {
+                    for(uint32_t face : newFaces)
+                    {
+                        pointDistance = distance(faces[face], point);
+                        if(pointDistance > epsilon)
+                        {
+                            return face;
+                        }
+                    }
+                    return NO_FACE;
+                };
+                auto addToFace = [&](uint32_t point, uint32_t face, float pointDistance)
+                {
+                    Face& target = faces[face];
+                    target.outside.push_back(point);
+                    if(pointDistance > target.furthestDistance)
+                    {
+                        target.furthestDistance = pointDistance;
+                        target.furthest = point;
+                    }
+                };
+
+                if(settings.parallel && candidates.size() >= QuickHull::PARALLEL_POINT_COUNT)
+                {
+                    assignedFaces.resize(candidates.size());
+                    assignedDistances.resize(candidates.size());
+                    ThreadPool::getGlobal().parallelFor(candidates.size(), QuickHull::PARALLEL_POINT_COUNT / 4, [&](size_t begin, size_t end)
+                    {
+                        for(size_t i = begin; i < end; i++)
+                        {
+                            assignedFaces[i] = findFace(candidates[i], assignedDistances[i]);
+                        }
+                    });
+                    for(size_t i = 0; i < candidates.size(); i++)
+                    {
+                        if(assignedFaces[i] != NO_FACE)
+                        {
+                            addToFace(candidates[i], assignedFaces[i], assignedDistances[i]);
+                        }
+                    }
+                }
+                else
+                {
+                    for(uint32_t point : candidates)
+                    {
+                        float pointDistance = 0.0f;
+                        uint32_t face = findFace(point, pointDistance);
+                        if(face != NO_FACE)
+                        {
+                            addToFace(point, face, pointDistance);
+                        }
+                    }
+                }
+
+                for(uint32_t face : newFaces)
+                {
+                    if(faces[face].furthest != NO_POINT)
+                    {
+                        queue.push({faces[face].furthestDistance, face});
+                    }
+                }
+            }
+
+            // Replaces the faces the furthest point of face can see with a cone from the point to their horizon
+            void addPoint(uint32_t face)
+            {
+                const uint32_t eye = faces[face].furthest;
+                stamp++;
+                visible.clear();
+                horizon.clear();
+                visible.push_back(face);
+                faces[face].visitStamp = stamp;
+                for(size_t i = 0; i < visible.size(); i++)
+                {
+                    uint32_t current = visible[i];
+                    for(int edge = 0; edge < 3; edge++)
+                    {
+                        uint32_t neighbor = faces[current].neighbors[edge];
+                        if(faces[neighbor].visitStamp == stamp)
+                        {
+                            continue;
+                        }
+                        // No tolerance here, a face the point is barely in front of would leave a concave edge next to the new cone
+                        // and thin new faces turn that into large errors in their planes
+                        if(distance(faces[neighbor], eye) > 0.0f)
+                        {
+                            faces[neighbor].visitStamp = stamp;
+                            visible.push_back(neighbor);
+                        }
+                        else
+                        {
+                            horizon.push_back({faces[current].vertices[edge], faces[current].vertices[(edge + 1) % 3], neighbor});
+                        }
+                    }
+                }
+
+                orphans.clear();
+                for(uint32_t visibleFace : visible)
+                {
+                    Face& dead = faces[visibleFace];
+                    dead.alive = false;
+                    for(uint32_t point : dead.outside)
+                    {
+                        if(point != eye)
+                        {
+                            orphans.push_back(point);
+                        }
+                    }
+                    dead.outside = {};
+                }
+
+                // The horizon is a loop, so every new face shares its side edges with the faces starting and ending at its horizon edge
+                newFaces.clear();
+                for(const HorizonEdge& edge : horizon)
+                {
+                    uint32_t newFace = addFace(edge.from, edge.to, eye);
+                    faces[newFace].neighbors[0] = edge.face;
+                    Face& hidden = faces[edge.face];
+                    for(int hiddenEdge = 0; hiddenEdge < 3; hiddenEdge++)
+                    {
+                        if(hidden.vertices[hiddenEdge] == edge.to && hidden.vertices[(hiddenEdge + 1) % 3] == edge.from)
+                        {
+                            hidden.neighbors[hiddenEdge] = newFace;
+                        }
+                    }
+                    faceStartingAt[edge.from] = newFace;
+                    newFaces.push_back(newFace);
+                }
+                for(uint32_t newFace : newFaces)
+                {
+                    uint32_t next = faceStartingAt[faces[newFace].vertices[1]];
+                    faces[newFace].neighbors[1] = next;
+                    faces[next].neighbors[2] = newFace;
+                }
+                for(const HorizonEdge& edge : horizon)
+                {
+                    faceStartingAt[edge.from] = NO_FACE;
+                }
+
+                assignPoints(orphans, newFaces);
+            }
+
+            ConvexHull extract() const
+            {
+                ConvexHull hull{};
+                std::vector<uint32_t> remap(points.size(), NO_POINT);
+                for(const Face& face : faces)
+                {
+                    if(!face.alive)
+                    {
+                        continue;
+                    }
+                    for(uint32_t vertex : face.vertices)
+                    {
+                        if(remap[vertex] == NO_POINT)
+                        {
+                            remap[vertex] = static_cast<uint32_t>(hull.vertices.size());
+                            hull.vertices.push_back(points[vertex]);
+                        }
+                        hull.indices.push_back(remap[vertex]);
+                    }
+                }
+                hull.computePlanes();
+                return hull;
+            }
+
+            // Slightly inflated so flat inputs still give a closed hull with a volume
+            ConvexHull createBox(glm::vec3 min, glm::vec3 max) const
+            {
+                min -= glm::vec3(epsilon);
+                max += glm::vec3(epsilon);
+                ConvexHull hull{};
+                for(int corner = 0; corner < 8; corner++)
+                {
+                    hull.vertices.emplace_back(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z);
+                }
+                hull.indices = {
+                    0, 4, 6,  0, 6, 2, // -x
+                    1, 3, 7,  1, 7, 5, // +x
+                    0, 1, 5,  0, 5, 4, // -y
+                    2, 6, 7,  2, 7, 3, // +y
+                    0, 2, 3,  0, 3, 1, // -z
+                    4, 5, 7,  4, 7, 6  // +z
+                };
+                hull.computePlanes();
+                return hull;
+            }
+
+            std::span<const glm::vec3> points;
+            const QuickHull::Settings& settings;
+            float epsilon = 0.0f;
+            std::vector<Face> faces{};
+            std::priority_queue<std::pair<float, uint32_t>> queue{};
+            uint32_t stamp = 0;
+
+            // Scratch reused by every step
+            std::vector<uint32_t> visible{};
+            std::vector<HorizonEdge> horizon{};
+            std::vector<uint32_t> orphans{};
+            std::vector<uint32_t> newFaces{};
+            std::vector<uint32_t> faceStartingAt{}; // Per point, only set while the faces of one step are linked
+            std::vector<uint32_t> assignedFaces{};
+            std::vector<float> assignedDistances{};
+    };
+
+    struct Part
+    {
+        std::vector<uint32_t> triangles{};
+        ConvexHull hull{};
+        glm::vec3 min{};
+        glm::vec3 max{};
+        float concavity = 0.0f; // Depth of the deepest vertex of the part under its hull
+        bool splittable = true;
+    };
+} // namespace
+
+void ConvexHull::computePlanes()
+{
+    planes.resize(indices.size() / 3);
+    for(size_t face = 0; face < planes.size(); face++)
+    {
+        const glm::vec3& a = vertices[indices[face * 3]];
+        const glm::vec3& b = vertices[indices[face * 3 + 1]];
+        const glm::vec3& c = vertices[indices[face * 3 + 2]];
+        glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+        planes[face] = glm::vec4(normal, glm::dot(normal, a));
+    }
+}
+
+glm::vec3 ConvexHull::support(const glm::vec3& direction) const
+{
+    glm::vec3 best(0.0f);
+    float bestDistance = -std::numeric_limits<float>::infinity();
+    for(const glm::vec3& vertex : vertices)
+    {
+        float vertexDistance = glm::dot(vertex, direction);
+        if(vertexDistance > bestDistance)
+        {
+            bestDistance = vertexDistance;
+            best = vertex;
+        }
+    }
+    return best;
+}
+
+float ConvexHull::signedDistance(const glm::vec3& point) const
+{
+    float result = planes.empty() ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+    for(const glm::vec4& plane : planes)
+    {
+        result = std::max(result, glm::dot(glm::vec3(plane), point) - plane.w);
+    }
+    return result;
+}
+
+ConvexHull QuickHull::build(std::span<const glm::vec3> points, const Settings& settings)
+{
+    return Builder(points, settings).build();
+}
+
+std::vector<ConvexHull> QuickHull::build(const core::MeshData& mesh, const Settings& settings)
+{
+    std::vector<glm::vec3> positions(mesh.vertices.size());
+    for(size_t i = 0; i < positions.size(); i++)
+    {
+        positions[i] = mesh.vertices[i].position;
+    }
+    if(settings.maxHulls <= 1 || mesh.triangles.empty())
+    {
+        return {build(positions, settings)};
+    }
+
+    std::vector<uint32_t> vertexStamps(positions.size(), 0);
+    uint32_t stamp = 0;
+    std::vector<glm::vec3> partPoints{};
+    auto createPart = [&](std::vector<uint32_t> triangles)
+    {
+        Part part{};
+        part.triangles = std::move(triangles);
+        stamp++;
+        partPoints.clear();
+        for(uint32_t triangle : part.triangles)
+        {
+            const core::MeshData::Triangle& corners = mesh.triangles[triangle];
+            for(uint32_t vertex : {corners.v0, corners.v1, corners.v2})
+            {
+                if(vertexStamps[vertex] != stamp)
+                {
+                    vertexStamps[vertex] = stamp;
+                    partPoints.push_back(positions[vertex]);
+                }
+            }
+        }
+        part.min = partPoints[0];
+        part.max = partPoints[0];
+        for(const glm::vec3& point : partPoints)
+        {
+            part.min = glm::min(part.min, point);
+            part.max = glm::max(part.max, point);
+        }
+        part.hull = build(partPoints, settings);
+        for(const glm::vec3& point : partPoints)
+        {
+            part.concavity = std::max(part.concavity, -part.hull.signedDistance(point));
+        }
+        part.splittable = part.triangles.size() > 1;
+        return part;
+    };
+
+    std::vector<uint32_t> allTriangles(mesh.triangles.size());
+    for(uint32_t i = 0; i < allTriangles.size(); i++)
+    {
+        allTriangles[i] = i;
+    }
+    std::vector<Part> parts{};
+    parts.push_back(createPart(std::move(allTriangles)));
+    const float maxConcavity = settings.maxConcavity * glm::length(parts[0].max - parts[0].min);
+
+    while(parts.size() < settings.maxHulls)
+    {
+        size_t worst = parts.size();
+        for(size_t i = 0; i < parts.size(); i++)
+        {
+            if(parts[i].splittable && parts[i].concavity > maxConcavity && (worst == parts.size() || parts[i].concavity > parts[worst].concavity))
+            {
+                worst = i;
+            }
+        }
+        if(worst == parts.size())
+        {
+            break;
+        }
+
+        // Median of the triangle centroids along the longest axis, so both halves get triangles
+        Part& part = parts[worst];
+        glm::vec3 size = part.max - part.min;
+        int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+        auto centroid = [&](uint32_t triangle)
+        {
+            const core::MeshData::Triangle& corners = mesh.triangles[triangle];
+            return positions[corners.v0][axis] + positions[corners.v1][axis] + positions[corners.v2][axis];
+        };
+        std::vector<uint32_t> triangles = std::move(part.triangles);
+        auto middle = triangles.begin() + triangles.size() / 2;
+        std::nth_element(triangles.begin(), middle, triangles.end(), [&](uint32_t a, uint32_t b) { return centroid(a) < centroid(b); });
+
+        Part second = createPart(std::vector<uint32_t>(middle, triangles.end()));
+        triangles.erase(middle, triangles.end());
+        parts[worst] = createPart(std::move(triangles));
+        parts.push_back(std::move(second));
+    }
+
+    std::vector<ConvexHull> hulls{};
+    hulls.reserve(parts.size());
+    for(Part& part : parts)
+    {
+        hulls.push_back(std::move(part.hull));
+    }
+    return hulls;
+}
+} // namespace physics
@@ -0,0 +1,58 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <vector>
+#include <span>
+#include <cstdint>
+
+namespace core
+{
+    class MeshData;
+}
+
+namespace physics
+{
+    // Convex polyhedron for narrowphase tests, in the space of the points it was built from
+    // Faces are triangles wound counterclockwise seen from outside, coplanar neighbours are not merged
+    struct ConvexHull
+    {
+        std::vector<glm::vec3> vertices{};
+        std::vector<uint32_t> indices{}; // 3 per face
+        std::vector<glm::vec4> planes{}; // Outward unit normal and its dot product with any point of the face, per face
+
+        // Fills planes from the vertices and indices
+        void computePlanes();
+        // Vertex furthest along direction, the support mapping used by GJK and similar tests
+        glm::vec3 support(const glm::vec3& direction) const;
+        // How far the point is outside of the hull along the nearest face plane, negative inside
+        float signedDistance(const glm::vec3& point) const;
+    };
+
+    // 3D quickhull, every step adds the point furthest outside the current hull
+    // Stopping after maxVertices steps therefore keeps the points that matter most, which makes the vertex cap a simplification
+    // Assigning the points to faces is spread over the global ThreadPool for large inputs
+    class QuickHull
+    {
+        public:
+            struct Settings
+            {
+                uint32_t maxVertices = 64;  // 0 for no limit
+                // Convex decomposition, 1 hulls the whole mesh
+                // Otherwise the part with the deepest vertex under its hull is split in two along its longest axis
+                // until no vertex is deeper than maxConcavity or there are maxHulls parts
+                uint32_t maxHulls = 1;
+                float maxConcavity = 0.05f; // Relative to the diagonal of the mesh bounds
+                bool parallel = true;
+            };
+
+            // Points closer to the hull than this, relative to the extent of the input, count as on it
+            static constexpr float RELATIVE_EPSILON = 1e-5f;
+            static constexpr size_t PARALLEL_POINT_COUNT = 16 * 1024;
+
+            // Fewer than 4 points or points that are all in a plane give the box around them
+            static ConvexHull build(std::span<const glm::vec3> points, const Settings& settings);
+            // Hulls of the vertex positions of the mesh, one unless settings ask for a decomposition
+            static std::vector<ConvexHull> build(const core::MeshData& mesh, const Settings& settings);
+    };
+} // namespace physics
@@ -0,0 +1,277 @@
+#include "dynamic_tree.hpp"
+
+#include <algorithm>
+
+namespace physics
+{
+namespace
+{
+    float surfaceArea(const glm::vec3& min, const glm::vec3& max)
+    {
+        glm::vec3 size = max - min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    float unionArea(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB)
+    {
+        return surfaceArea(glm::min(minA, minB), glm::max(maxA, maxB));
+    }
+
+    bool contains(const glm::vec3& outerMin, const glm::vec3& outerMax, const glm::vec3& min, const glm::vec3& max)
+    {
+        return glm::all(glm::lessThanEqual(outerMin, min)) && glm::all(glm::lessThanEqual(max, outerMax));
+    }
+} // namespace
+
+uint32_t DynamicTree::createProxy(const glm::vec3& min, const glm::vec3& max, uint64_t userData)
+{
+    uint32_t proxy = allocateNode();
+    Node& node = nodes[proxy];
+    node.min = min - glm::vec3(FAT_MARGIN);
+    node.max = max + glm::vec3(FAT_MARGIN);
+    node.userData = userData;
+    node.height = 0;
+    insertLeaf(proxy);
+    proxyCount++;
+    return proxy;
+}
+
+void DynamicTree::destroyProxy(uint32_t proxy)
+{
+    removeLeaf(proxy);
+    freeNode(proxy);
+    proxyCount--;
+}
+
+bool DynamicTree::moveProxy(uint32_t proxy, const glm::vec3& min, const glm::vec3& max, const glm::vec3& displacement)
+{
+    glm::vec3 fatMin = min - glm::vec3(FAT_MARGIN);
+    glm::vec3 fatMax = max + glm::vec3(FAT_MARGIN);
+    glm::vec3 prediction = displacement * DISPLACEMENT_MULTIPLIER;
+    fatMin += glm::min(prediction, glm::vec3(0.0f));
+    fatMax += glm::max(prediction, glm::vec3(0.0f));
+
+    const Node& node = nodes[proxy];
+    if(contains(node.min, node.max, min, max))
+    {
+        // Still inside, unless the fat box grew so large that it reports pairs far away from the proxy
+        glm::vec3 hugeMin = fatMin - glm::vec3(4.0f * FAT_MARGIN);
+        glm::vec3 hugeMax = fatMax + glm::vec3(4.0f * FAT_MARGIN);
+        if(contains(hugeMin, hugeMax, node.min, node.max))
+        {
+            return false;
+        }
+    }
+
+    removeLeaf(proxy);
+    nodes[proxy].min = fatMin;
+    nodes[proxy].max = fatMax;
+    insertLeaf(proxy);
+    return true;
+}
+
+void DynamicTree::clear()
+{
+    nodes.clear();
+    root = NULL_NODE;
+    freeList = NULL_NODE;
+    proxyCount = 0;
+}
+
+uint32_t DynamicTree::allocateNode()
+{
+    if(freeList == NULL_NODE)
+    {
+        nodes.emplace_back();
+        nodes.back().parent = NULL_NODE;
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+    uint32_t node = freeList;
+    freeList = nodes[node].parent;
+    nodes[node] = Node{};
+    nodes[node].parent = NULL_NODE;
+    return node;
+}
+
+void DynamicTree::freeNode(uint32_t node)
+{
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+void DynamicTree::insertLeaf(uint32_t leaf)
+{
+    if(root == NULL_NODE)
+    {
+        root = leaf;
+        nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Walks down to the sibling that makes the cheapest tree by the surface area heuristic
+    // Every ancestor of the new leaf grows to contain it, which is paid for on the way down as the inherited cost
+    const glm::vec3 leafMin = nodes[leaf].min;
+    const glm::vec3 leafMax = nodes[leaf].max;
+    uint32_t sibling = root;
+    while(!nodes[sibling].isLeaf())
+    {
+        const Node& node = nodes[sibling];
+        float area = surfaceArea(node.min, node.max);
+        float combinedArea = unionArea(node.min, node.max, leafMin, leafMax);
+        // A new parent for this node and the leaf
+        float cost = 2.0f * combinedArea;
+        float inheritedCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](uint32_t child)
+        {
+            const Node& childNode = nodes[child];
+            float childCost = unionArea(childNode.min, childNode.max, leafMin, leafMax);
+            if(!childNode.isLeaf())
+            {
+                childCost -= surfaceArea(childNode.min, childNode.max);
+            }
+            return childCost + inheritedCost;
+        };
+        float cost1 = descendCost(node.child1);
+        float cost2 = descendCost(node.child2);
+        if(cost < cost1 && cost < cost2)
+        {
+            break;
+        }
+        sibling = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    uint32_t oldParent = nodes[sibling].parent;
+    uint32_t newParent = allocateNode();
+    Node& parent = nodes[newParent];
+    parent.parent = oldParent;
+    parent.min = glm::min(leafMin, nodes[sibling].min);
+    parent.max = glm::max(leafMax, nodes[sibling].max);
+    parent.height = nodes[sibling].height + 1;
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+    if(oldParent == NULL_NODE)
+    {
+        root = newParent;
+    }
+    else if(nodes[oldParent].child1 == sibling)
+    {
+        nodes[oldParent].child1 = newParent;
+    }
+    else
+    {
+        nodes[oldParent].child2 = newParent;
+    }
+
+    refitAncestors(nodes[leaf].parent);
+}
+
+void DynamicTree::removeLeaf(uint32_t leaf)
+{
+    if(leaf == root)
+    {
+        root = NULL_NODE;
+        return;
+    }
+
+    uint32_t parent = nodes[leaf].parent;
+    uint32_t grandParent = nodes[parent].parent;
+    uint32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+    freeNode(parent);
+    nodes[sibling].parent = grandParent;
+    if(grandParent == NULL_NODE)
+    {
+        root = sibling;
+        return;
+    }
+    if(nodes[grandParent].child1 == parent)
+    {
+        nodes[grandParent].child1 = sibling;
+    }
+    else
+    {
+        nodes[grandParent].child2 = sibling;
+    }
+    refitAncestors(grandParent);
+}
+
+void DynamicTree::refitAncestors(uint32_t node)
+{
+    while(node != NULL_NODE)
+    {
+        node = balance(node);
+        fitToChildren(nodes[node]);
+        node = nodes[node].parent;
+    }
+}
+
+void DynamicTree::fitToChildren(Node& node)
+{
+    const Node& child1 = nodes[node.child1];
+    const Node& child2 = nodes[node.child2];
+    node.min = glm::min(child1.min, child2.min);
+    node.max = glm::max(child1.max, child2.max);
+    node.height = 1 + std::max(child1.height, child2.height);
+}
+
+uint32_t DynamicTree::balance(uint32_t a)
+{
+    Node& nodeA = nodes[a];
+    if(nodeA.isLeaf() || nodeA.height < 2)
+    {
+        return a;
+    }
+
+    int32_t difference = nodes[nodeA.child2].height - nodes[nodeA.child1].height;
+    if(difference >= -1 && difference <= 1)
+    {
+        return a;
+    }
+
+    // The taller child takes the place of a, which keeps its shorter sibling and the shorter of the grandchildren
+    // while the taller grandchild stays under the promoted child
+    bool secondIsTaller = difference > 1;
+    uint32_t up = secondIsTaller ? nodeA.child2 : nodeA.child1;
+    Node& nodeUp = nodes[up];
+    uint32_t tallGrandChild = nodeUp.child1;
+    uint32_t shortGrandChild = nodeUp.child2;
+    if(nodes[tallGrandChild].height < nodes[shortGrandChild].height)
+    {
+        std::swap(tallGrandChild, shortGrandChild);
+    }
+
+    nodeUp.parent = nodeA.parent;
+    nodeA.parent = up;
+    if(nodeUp.parent == NULL_NODE)
+    {
+        root = up;
+    }
+    else if(nodes[nodeUp.parent].child1 == a)
+    {
+        nodes[nodeUp.parent].child1 = up;
+    }
+    else
+    {
+        nodes[nodeUp.parent].child2 = up;
+    }
+
+    nodeUp.child1 = a;
+    nodeUp.child2 = tallGrandChild;
+    if(secondIsTaller)
+    {
+        nodeA.child2 = shortGrandChild;
+    }
+    else
+    {
+        nodeA.child1 = shortGrandChild;
+    }
+    nodes[shortGrandChild].parent = a;
+
+    fitToChildren(nodeA);
+    fitToChildren(nodeUp);
+    return up;
+}
+} // namespace physics
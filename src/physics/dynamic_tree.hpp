@@ -0,0 +1,104 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace physics
+{
+    // Incremental AABB tree over moving proxies, in the style of the Box2D and Bullet broadphases
+    // Leaves hold fattened boxes, so a proxy that moves a little stays where it is and only proxies that leave their fat box
+    // are reinserted, which is O(log n) like insertion and removal thanks to rotations that keep the tree balanced
+    class DynamicTree
+    {
+        public:
+            static constexpr uint32_t NULL_NODE = UINT32_MAX;
+            // Added around every side of a box, in world units
+            static constexpr float FAT_MARGIN = 0.1f;
+            // Fat boxes also stretch this many displacements ahead of a moving proxy
+            static constexpr float DISPLACEMENT_MULTIPLIER = 4.0f;
+
+            uint32_t createProxy(const glm::vec3& min, const glm::vec3& max, uint64_t userData);
+            void destroyProxy(uint32_t proxy);
+            // Returns true when the box left the fat box of the proxy and it was reinserted with a new one
+            // Fat boxes much larger than needed, e.g. after a proxy stopped, are also shrunk
+            bool moveProxy(uint32_t proxy, const glm::vec3& min, const glm::vec3& max, const glm::vec3& displacement);
+            void clear();
+
+            uint64_t getUserData(uint32_t proxy) const { return nodes[proxy].userData; }
+            const glm::vec3& getFatMin(uint32_t proxy) const { return nodes[proxy].min; }
+            const glm::vec3& getFatMax(uint32_t proxy) const { return nodes[proxy].max; }
+            size_t getProxyCount() const { return proxyCount; }
+            uint32_t getHeight() const { return root == NULL_NODE ? 0 : static_cast<uint32_t>(nodes[root].height); }
+
+            // Calls callback(proxy) for every proxy whose fat box overlaps the box, stops when it returns false
+            template<class Callback>
+            void query(const glm::vec3& min, const glm::vec3& max, Callback&& callback) const
+            {
+                if(root == NULL_NODE)
+                {
+                    return;
+                }
+                // Balanced trees stay far below this height, it only grows past it with billions of proxies
+                uint32_t stack[MAX_STACK_SIZE];
+                uint32_t stackSize = 0;
+                stack[stackSize++] = root;
+                while(stackSize > 0)
+                {
+                    const Node& node = nodes[stack[--stackSize]];
+                    if(!overlaps(node.min, node.max, min, max))
+                    {
+                        continue;
+                    }
+                    if(node.isLeaf())
+                    {
+                        if(!callback(static_cast<uint32_t>(&node - nodes.data())))
+                        {
+                            return;
+                        }
+                        continue;
+                    }
+                    stack[stackSize++] = node.child1;
+                    stack[stackSize++] = node.child2;
+                }
+            }
+
+            static bool overlaps(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB)
+            {
+                return minA.x <= maxB.x && minB.x <= maxA.x && minA.y <= maxB.y && minB.y <= maxA.y && minA.z <= maxB.z && minB.z <= maxA.z;
+            }
+
+        private:
+            static constexpr uint32_t MAX_STACK_SIZE = 128;
+
+            struct Node
+            {
+                glm::vec3 min;
+                uint32_t parent;            // Next free node while on the free list
+                glm::vec3 max;
+                uint32_t child1 = NULL_NODE; // NULL_NODE for leaves
+                uint32_t child2 = NULL_NODE;
+                int32_t height = 0;          // 0 for leaves, -1 for free nodes
+                uint64_t userData = 0;
+
+                bool isLeaf() const { return child1 == NULL_NODE; }
+            };
+
+            uint32_t allocateNode();
+            void freeNode(uint32_t node);
+            void insertLeaf(uint32_t leaf);
+            void removeLeaf(uint32_t leaf);
+            // Refits the boxes and heights from the node to the root, rotating unbalanced nodes on the way
+            void refitAncestors(uint32_t node);
+            // Rotates the taller grandchild up when the children of the node differ in height by more than one
+            // Returns the node now at the place of the given one
+            uint32_t balance(uint32_t node);
+            void fitToChildren(Node& node);
+
+            std::vector<Node> nodes{};
+            uint32_t root = NULL_NODE;
+            uint32_t freeList = NULL_NODE;
+            size_t proxyCount = 0;
+    };
+} // namespace physics
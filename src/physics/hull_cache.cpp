@@ -0,0 +1,134 @@
+#include "hull_cache.hpp"
+#include "core/mesh_cache.hpp"
+#include "utils/mapped_file.hpp"
+#include "utils/console.hpp"
+
+#include <filesystem>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <utility>
+
+namespace physics
+{
+static_assert(sizeof(HullCache::Header) == 48, "Changing the cooked hull header requires a version bump");
+static_assert(sizeof(HullCache::HullEntry) == 24, "Changing the cooked hull entries requires a version bump");
+static_assert(sizeof(glm::vec3) == 12, "Cooked hull vertices are tightly packed floats");
+
+bool HullCache::load(const std::string& sourcePath, const QuickHull::Settings& settings, std::vector<ConvexHull>& hulls)
+{
+    const std::string cookedPath = getCookedPath(sourcePath);
+    if(!std::filesystem::is_regular_file(cookedPath)) return false;
+
+    MappedFile cooked{};
+    if(!cooked.open(cookedPath)) return false;
+
+    if(cooked.size() < sizeof(Header))
+    {
+        Console::warn("Cooked hulls " + cookedPath + " are truncated, re-cooking", "Hull Cache");
+        return false;
+    }
+    Header header{};
+    memcpy(&header, cooked.data(), sizeof(Header));
+    if(memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION)
+    {
+        Console::log("Cooked hulls " + cookedPath + " are from an older format, re-cooking", "Hull Cache");
+        return false;
+    }
+    if(header.maxVertices != settings.maxVertices || header.maxHulls != settings.maxHulls || header.maxConcavity != settings.maxConcavity)
+    {
+        Console::log("Cooked hulls " + cookedPath + " were built with other settings, re-cooking", "Hull Cache");
+        return false;
+    }
+
+    const uint64_t entryTableOffset = core::MeshCache::alignOffset(sizeof(Header));
+    const uint64_t entryTableBytes = static_cast<uint64_t>(header.hullCount) * sizeof(HullEntry);
+    bool truncated = !core::MeshCache::blobFits(entryTableOffset, entryTableBytes, cooked.size());
+    std::vector<HullEntry> entries{};
+    if(!truncated)
+    {
+        entries.resize(header.hullCount);
+        memcpy(entries.data(), cooked.data() + entryTableOffset, entryTableBytes);
+        for(const HullEntry& entry : entries)
+        {
+            truncated |= !core::MeshCache::blobFits(entry.vertexOffset, static_cast<uint64_t>(entry.vertexCount) * sizeof(glm::vec3), cooked.size())
+                || !core::MeshCache::blobFits(entry.indexOffset, static_cast<uint64_t>(entry.indexCount) * sizeof(uint32_t), cooked.size());
+        }
+    }
+    if(truncated)
+    {
+        Console::warn("Cooked hulls " + cookedPath + " are truncated, re-cooking", "Hull Cache");
+        return false;
+    }
+
+    if(!core::MeshCache::checkSource(sourcePath, cookedPath, cooked, header.sourceSize, header.sourceWriteTime, header.sourceHash, offsetof(Header, sourceWriteTime), "Hull Cache"))
+    {
+        return false;
+    }
+
+    // The hulls are only handed out once every face indexes a vertex of its hull, computePlanes would read out of bounds otherwise
+    std::vector<ConvexHull> loaded(header.hullCount);
+    for(size_t i = 0; i < entries.size(); i++)
+    {
+        ConvexHull& hull = loaded[i];
+        hull.vertices.resize(entries[i].vertexCount);
+        hull.indices.resize(entries[i].indexCount);
+        memcpy(hull.vertices.data(), cooked.data() + entries[i].vertexOffset, entries[i].vertexCount * sizeof(glm::vec3));
+        memcpy(hull.indices.data(), cooked.data() + entries[i].indexOffset, entries[i].indexCount * sizeof(uint32_t));
+        const uint32_t vertexCount = entries[i].vertexCount;
+        if(hull.indices.size() % 3 != 0 || !std::all_of(hull.indices.begin(), hull.indices.end(), [vertexCount](uint32_t index) { return index < vertexCount; }))
+        {
+            Console::warn("Cooked hulls " + cookedPath + " have indices past their vertices, re-cooking", "Hull Cache");
+            return false;
+        }
+        hull.computePlanes();
+    }
+    hulls = std::move(loaded);
+    return true;
+}
+
+bool HullCache::cook(const std::string& sourcePath, const QuickHull::Settings& settings, const std::vector<ConvexHull>& hulls)
+{
+    const std::string cookedPath = getCookedPath(sourcePath);
+
+    Header header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.hullCount = static_cast<uint32_t>(hulls.size());
+    header.maxVertices = settings.maxVertices;
+    header.maxHulls = settings.maxHulls;
+    header.maxConcavity = settings.maxConcavity;
+
+    core::MeshCache::SourceInfo source{};
+    if(!core::MeshCache::getSourceInfo(sourcePath, source) || !core::MeshCache::hashFile(sourcePath, header.sourceHash))
+    {
+        Console::warn("Could not read source " + sourcePath + ", hulls were not cooked", "Hull Cache");
+        return false;
+    }
+    header.sourceSize = source.size;
+    header.sourceWriteTime = source.writeTime;
+
+    const uint64_t entryTableOffset = core::MeshCache::alignOffset(sizeof(Header));
+    std::vector<HullEntry> entries(hulls.size());
+    uint64_t endOffset = entryTableOffset + entries.size() * sizeof(HullEntry);
+    for(size_t i = 0; i < entries.size(); i++)
+    {
+        entries[i].vertexCount = static_cast<uint32_t>(hulls[i].vertices.size());
+        entries[i].indexCount = static_cast<uint32_t>(hulls[i].indices.size());
+        entries[i].vertexOffset = core::MeshCache::alignOffset(endOffset);
+        entries[i].indexOffset = core::MeshCache::alignOffset(entries[i].vertexOffset + hulls[i].vertices.size() * sizeof(glm::vec3));
+        endOffset = entries[i].indexOffset + hulls[i].indices.size() * sizeof(uint32_t);
+    }
+
+    std::vector<core::MeshCache::Blob> blobs{
+        {0, &header, sizeof(Header)},
+        {entryTableOffset, entries.data(), entries.size() * sizeof(HullEntry)}
+    };
+    for(size_t i = 0; i < entries.size(); i++)
+    {
+        blobs.push_back({entries[i].vertexOffset, hulls[i].vertices.data(), hulls[i].vertices.size() * sizeof(glm::vec3)});
+        blobs.push_back({entries[i].indexOffset, hulls[i].indices.data(), hulls[i].indices.size() * sizeof(uint32_t)});
+    }
+    return core::MeshCache::writeCooked(cookedPath, blobs, "Hull Cache");
+}
+} // namespace physics
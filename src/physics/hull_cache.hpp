@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "convex_hull.hpp"
+
+namespace physics
+{
+    // Cooked convex hulls (.vhull) stored next to the source file of the mesh, beside its .vmesh
+    // Layout: Header | HullEntry per hull | vertex blob (glm::vec3) and index blob (uint32_t) per hull
+    // Blobs are 16 byte aligned, planes are not stored and recomputed on load
+    class HullCache
+    {
+        public:
+            static constexpr char MAGIC[4] = {'V', 'H', 'U', 'L'};
+            static constexpr uint32_t VERSION = 1; // Bump whenever the layout or QuickHull changes
+
+            struct Header
+            {
+                char magic[4];
+                uint32_t version;
+                uint32_t hullCount;
+                // Settings the hulls were built with, other settings force a re-cook
+                uint32_t maxVertices;
+                uint32_t maxHulls;
+                float maxConcavity;
+                uint64_t sourceSize;
+                int64_t sourceWriteTime;
+                uint64_t sourceHash; // Checked when the size or write time no longer match
+            };
+
+            struct HullEntry
+            {
+                uint32_t vertexCount;
+                uint32_t indexCount;
+                uint64_t vertexOffset;
+                uint64_t indexOffset;
+            };
+
+            static std::string getCookedPath(const std::string& sourcePath) { return sourcePath + ".vhull"; }
+
+            // Reads the cooked hulls for sourcePath if they exist, were built with the same settings and are up to date with the source
+            // If the source file is missing the cooked hulls are used as is
+            static bool load(const std::string& sourcePath, const QuickHull::Settings& settings, std::vector<ConvexHull>& hulls);
+            static bool cook(const std::string& sourcePath, const QuickHull::Settings& settings, const std::vector<ConvexHull>& hulls);
+    };
+} // namespace physics
@@ -0,0 +1,732 @@
+#include "narrowphase.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace physics
+{
+namespace
+{
+    // The reference face replaces the EPA normal when they are less than about 3 degrees apart
+    constexpr float FACE_NORMAL_COSINE = 0.9985f;
+    // GJK tetrahedra with less volume than this fraction of the product of their edge lengths are treated as flat
+    constexpr float FLAT_SIMPLEX_VOLUME = 1e-5f;
+    // New EPA points this close to the plane of a face do not see it, resting shapes put many points in the planes through the
+    // origin and removing faces on rounding noise folds the polytope inside out
+    constexpr float EPA_VISIBILITY_TOLERANCE = 1e-6f;
+
+    // Newest point first
+    struct Simplex
+    {
+        glm::vec3 points[4];
+        uint32_t count = 0;
+
+        void push(const glm::vec3& point)
+        {
+            points[3] = points[2];
+            points[2] = points[1];
+            points[1] = points[0];
+            points[0] = point;
+            count = std::min(count + 1, 4u);
+        }
+
+        void set(const glm::vec3& a, const glm::vec3& b)
+        {
+            points[0] = a;
+            points[1] = b;
+            count = 2;
+        }
+
+        void set(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+        {
+            points[0] = a;
+            points[1] = b;
+            points[2] = c;
+            count = 3;
+        }
+    };
+
+    struct EpaFace
+    {
+        uint32_t a, b, c;
+        glm::vec3 normal;
+        float distance;
+    };
+
+    struct EpaEdge
+    {
+        uint32_t from, to;
+    };
+
+    glm::vec3 support(std::span<const glm::vec3> points, const glm::vec3& direction)
+    {
+        glm::vec3 best = points[0];
+        float bestDistance = glm::dot(best, direction);
+        for(size_t i = 1; i < points.size(); i++)
+        {
+            float distance = glm::dot(points[i], direction);
+            if(distance > bestDistance)
+            {
+                bestDistance = distance;
+                best = points[i];
+            }
+        }
+        return best;
+    }
+
+    // Support point of the Minkowski difference a - b
+    glm::vec3 support(std::span<const glm::vec3> a, std::span<const glm::vec3> b, const glm::vec3& direction)
+    {
+        return support(a, direction) - support(b, -direction);
+    }
+
+    glm::vec3 anyPerpendicular(const glm::vec3& vector)
+    {
+        return std::abs(vector.x) < 0.57735f ? glm::cross(vector, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(vector, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    bool sameDirection(const glm::vec3& a, const glm::vec3& b)
+    {
+        return glm::dot(a, b) > 0.0f;
+    }
+
+    // Direction from the line through a and b towards the origin, any perpendicular one if the origin is on the line
+    glm::vec3 towardsOrigin(const glm::vec3& ab, const glm::vec3& ao)
+    {
+        glm::vec3 direction = glm::cross(glm::cross(ab, ao), ab);
+        if(glm::dot(direction, direction) <= 1e-12f * glm::dot(ab, ab) * glm::dot(ab, ab) * glm::dot(ao, ao))
+        {
+            return anyPerpendicular(ab);
+        }
+        return direction;
+    }
+
+    // Each case reduces the simplex to its feature closest to the origin and points direction from there to the origin
+    bool line(Simplex& simplex, glm::vec3& direction)
+    {
+        glm::vec3 a = simplex.points[0];
+        glm::vec3 ab = simplex.points[1] - a;
+        glm::vec3 ao = -a;
+        if(sameDirection(ab, ao))
+        {
+            direction = towardsOrigin(ab, ao);
+        }
+        else
+        {
+            simplex.count = 1;
+            direction = ao;
+        }
+        return false;
+    }
+
+    bool triangle(Simplex& simplex, glm::vec3& direction)
+    {
+        glm::vec3 a = simplex.points[0];
+        glm::vec3 b = simplex.points[1];
+        glm::vec3 c = simplex.points[2];
+        glm::vec3 ab = b - a;
+        glm::vec3 ac = c - a;
+        glm::vec3 ao = -a;
+        glm::vec3 abc = glm::cross(ab, ac);
+
+        if(sameDirection(glm::cross(abc, ac), ao))
+        {
+            if(sameDirection(ac, ao))
+            {
+                simplex.set(a, c);
+                direction = towardsOrigin(ac, ao);
+                return false;
+            }
+            simplex.set(a, b);
+            return line(simplex, direction);
+        }
+        if(sameDirection(glm::cross(ab, abc), ao))
+        {
+            simplex.set(a, b);
+            return line(simplex, direction);
+        }
+        if(glm::dot(abc, ao) >= 0.0f)
+        {
+            direction = abc;
+        }
+        else
+        {
+            simplex.set(a, c, b);
+            direction = -abc;
+        }
+        return false;
+    }
+
+    bool tetrahedron(Simplex& simplex, glm::vec3& direction)
+    {
+        glm::vec3 a = simplex.points[0];
+        glm::vec3 b = simplex.points[1];
+        glm::vec3 c = simplex.points[2];
+        glm::vec3 d = simplex.points[3];
+        glm::vec3 ab = b - a;
+        glm::vec3 ac = c - a;
+        glm::vec3 ad = d - a;
+        glm::vec3 ao = -a;
+
+        if(sameDirection(glm::cross(ab, ac), ao))
+        {
+            simplex.set(a, b, c);
+            return triangle(simplex, direction);
+        }
+        if(sameDirection(glm::cross(ac, ad), ao))
+        {
+            simplex.set(a, c, d);
+            return triangle(simplex, direction);
+        }
+        if(sameDirection(glm::cross(ad, ab), ao))
+        {
+            simplex.set(a, d, b);
+            return triangle(simplex, direction);
+        }
+        return true;
+    }
+
+    bool gjk(std::span<const glm::vec3> a, std::span<const glm::vec3> b, Simplex& simplex)
+    {
+        glm::vec3 direction = a[0] - b[0];
+        if(glm::dot(direction, direction) < 1e-12f)
+        {
+            direction = glm::vec3(1.0f, 0.0f, 0.0f);
+        }
+        simplex.count = 0;
+        simplex.push(support(a, b, direction));
+        direction = -simplex.points[0];
+
+        for(uint32_t iteration = 0; iteration < Narrowphase::GJK_MAX_ITERATIONS; iteration++)
+        {
+            if(glm::dot(direction, direction) < 1e-20f)
+            {
+                return false; // The origin is on the simplex, the shapes only touch
+            }
+            glm::vec3 point = support(a, b, direction);
+            if(glm::dot(point, direction) <= 0.0f)
+            {
+                return false;
+            }
+            simplex.push(point);
+            bool enclosed = false;
+            switch(simplex.count)
+            {
+                case 2: enclosed = line(simplex, direction); break;
+                case 3: enclosed = triangle(simplex, direction); break;
+                default: enclosed = tetrahedron(simplex, direction); break;
+            }
+            if(enclosed)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Grows the GJK tetrahedron inside the Minkowski difference until its face closest to the origin is on its surface
+    bool epa(std::span<const glm::vec3> a, std::span<const glm::vec3> b, const Simplex& simplex, glm::vec3& normal, float& depth)
+    {
+        thread_local std::vector<glm::vec3> polytope{};
+        thread_local std::vector<EpaFace> faces{};
+        thread_local std::vector<EpaEdge> edges{};
+        polytope.assign(simplex.points, simplex.points + 4);
+        faces.clear();
+
+        auto createFace = [&](uint32_t i, uint32_t j, uint32_t k, EpaFace& face)
+        {
+            glm::vec3 faceNormal = glm::cross(polytope[j] - polytope[i], polytope[k] - polytope[i]);
+            float length = glm::length(faceNormal);
+            if(length < 1e-12f)
+            {
+                return false;
+            }
+            face = {i, j, k, faceNormal / length, 0.0f};
+            face.distance = glm::dot(face.normal, polytope[i]);
+            return true;
+        };
+
+        // The origin can lie exactly in a face plane of the Minkowski difference, as it does for boxes resting side by side at the
+        // same height, and GJK then ends on a flat tetrahedron. Its outline is closed off with the support points on either side instead
+        const glm::vec3 ab = polytope[1] - polytope[0];
+        const glm::vec3 ac = polytope[2] - polytope[0];
+        const glm::vec3 ad = polytope[3] - polytope[0];
+        const float volume = glm::dot(ab, glm::cross(ac, ad));
+        const float volumeScale = glm::length(ab) * glm::length(ac) * glm::length(ad);
+        thread_local std::vector<uint32_t> outline{};
+        outline.clear();
+        if(std::abs(volume) > FLAT_SIMPLEX_VOLUME * volumeScale)
+        {
+            const uint32_t tetrahedronFaces[4][3] = {{0, 1, 2}, {0, 3, 1}, {0, 2, 3}, {1, 3, 2}};
+            for(const uint32_t* corners : tetrahedronFaces)
+            {
+                EpaFace face{};
+                if(!createFace(corners[0], corners[1], corners[2], face))
+                {
+                    return false;
+                }
+                faces.push_back(face);
+            }
+        }
+        else
+        {
+            glm::vec3 planeNormal = glm::cross(ab, ac);
+            for(const glm::vec3& candidate : {glm::cross(ab, ad), glm::cross(ac, ad)})
+            {
+                if(glm::dot(candidate, candidate) > glm::dot(planeNormal, planeNormal))
+                {
+                    planeNormal = candidate;
+                }
+            }
+            float length = glm::length(planeNormal);
+            if(length < 1e-12f)
+            {
+                return false;
+            }
+            planeNormal /= length;
+            const glm::vec3 above = support(a, b, planeNormal);
+            const glm::vec3 below = support(a, b, -planeNormal);
+            if(glm::dot(above - polytope[0], planeNormal) < Narrowphase::EPA_TOLERANCE || glm::dot(polytope[0] - below, planeNormal) < Narrowphase::EPA_TOLERANCE)
+            {
+                return false; // Flat shapes, or the origin is on the surface and they only touch
+            }
+
+            // Convex outline of the flat simplex, counterclockwise around the normal
+            glm::vec3 center = (polytope[0] + polytope[1] + polytope[2] + polytope[3]) * 0.25f;
+            glm::vec3 tangent = glm::normalize(anyPerpendicular(planeNormal));
+            glm::vec3 bitangent = glm::cross(planeNormal, tangent);
+            float angles[4];
+            for(uint32_t i = 0; i < 4; i++)
+            {
+                angles[i] = std::atan2(glm::dot(polytope[i] - center, bitangent), glm::dot(polytope[i] - center, tangent));
+                outline.push_back(i);
+            }
+            std::sort(outline.begin(), outline.end(), [&](uint32_t i, uint32_t j) { return angles[i] < angles[j]; });
+            for(size_t i = 0; outline.size() > 3 && i < outline.size();)
+            {
+                const glm::vec3& previous = polytope[outline[(i + outline.size() - 1) % outline.size()]];
+                const glm::vec3& next = polytope[outline[(i + 1) % outline.size()]];
+                if(glm::dot(glm::cross(polytope[outline[i]] - previous, next - polytope[outline[i]]), planeNormal) <= 0.0f)
+                {
+                    outline.erase(outline.begin() + i);
+                    i = 0;
+                }
+                else
+                {
+                    i++;
+                }
+            }
+
+            polytope.push_back(above);
+            polytope.push_back(below);
+            for(size_t i = 0; i < outline.size(); i++)
+            {
+                uint32_t from = outline[i];
+                uint32_t to = outline[(i + 1) % outline.size()];
+                EpaFace upper{};
+                EpaFace lower{};
+                if(!createFace(from, to, 4, upper) || !createFace(to, from, 5, lower))
+                {
+                    return false;
+                }
+                faces.push_back(upper);
+                faces.push_back(lower);
+            }
+        }
+
+        // Wound so the inside of the polytope is behind every face
+        glm::vec3 inside(0.0f);
+        for(const glm::vec3& point : polytope)
+        {
+            inside += point;
+        }
+        inside /= static_cast<float>(polytope.size());
+        for(EpaFace& face : faces)
+        {
+            if(glm::dot(face.normal, inside - polytope[face.a]) > 0.0f)
+            {
+                std::swap(face.b, face.c);
+                face.normal = -face.normal;
+                face.distance = -face.distance;
+            }
+        }
+
+        size_t closest = 0;
+        for(uint32_t iteration = 0; iteration < Narrowphase::EPA_MAX_ITERATIONS; iteration++)
+        {
+            closest = 0;
+            for(size_t i = 1; i < faces.size(); i++)
+            {
+                if(faces[i].distance < faces[closest].distance)
+                {
+                    closest = i;
+                }
+            }
+            const EpaFace nearest = faces[closest];
+            glm::vec3 point = support(a, b, nearest.normal);
+            if(glm::dot(point, nearest.normal) - nearest.distance < Narrowphase::EPA_TOLERANCE)
+            {
+                break;
+            }
+
+            // Faces the new point is in front of are replaced by a fan from the point to their boundary
+            edges.clear();
+            auto addEdge = [&](uint32_t from, uint32_t to)
+            {
+                for(size_t i = 0; i < edges.size(); i++)
+                {
+                    if(edges[i].from == to && edges[i].to == from)
+                    {
+                        edges[i] = edges.back();
+                        edges.pop_back();
+                        return;
+                    }
+                }
+                edges.push_back({from, to});
+            };
+            for(size_t i = 0; i < faces.size();)
+            {
+                const EpaFace& face = faces[i];
+                if(glm::dot(face.normal, point - polytope[face.a]) > EPA_VISIBILITY_TOLERANCE)
+                {
+                    addEdge(face.a, face.b);
+                    addEdge(face.b, face.c);
+                    addEdge(face.c, face.a);
+                    faces[i] = faces.back();
+                    faces.pop_back();
+                }
+                else
+                {
+                    i++;
+                }
+            }
+
+            uint32_t index = static_cast<uint32_t>(polytope.size());
+            polytope.push_back(point);
+            for(const EpaEdge& edge : edges)
+            {
+                EpaFace face{};
+                if(createFace(edge.from, edge.to, index, face))
+                {
+                    faces.push_back(face);
+                }
+            }
+            if(faces.empty())
+            {
+                return false;
+            }
+            closest = 0;
+            for(size_t i = 1; i < faces.size(); i++)
+            {
+                if(faces[i].distance < faces[closest].distance)
+                {
+                    closest = i;
+                }
+            }
+        }
+
+        normal = faces[closest].normal;
+        depth = faces[closest].distance;
+        return true;
+    }
+
+    // Vertices within the tolerance of the furthest along direction, as a convex polygon wound counterclockwise around it
+    // Collinear vertices leave only the ends of the segment
+    void findFeature(std::span<const glm::vec3> points, const glm::vec3& direction, std::vector<glm::vec3>& feature)
+    {
+        float furthest = -std::numeric_limits<float>::infinity();
+        for(const glm::vec3& point : points)
+        {
+            furthest = std::max(furthest, glm::dot(point, direction));
+        }
+        thread_local std::vector<glm::vec3> candidates{};
+        candidates.clear();
+        for(const glm::vec3& point : points)
+        {
+            if(glm::dot(point, direction) >= furthest - Narrowphase::FEATURE_TOLERANCE)
+            {
+                candidates.push_back(point);
+            }
+        }
+        feature.clear();
+        if(candidates.size() <= 2)
+        {
+            feature = candidates;
+            return;
+        }
+
+        // Monotone chain on the points projected to the plane
+        glm::vec3 tangent = glm::normalize(anyPerpendicular(direction));
+        glm::vec3 bitangent = glm::cross(direction, tangent);
+        auto u = [&](const glm::vec3& point) { return glm::dot(point, tangent); };
+        auto v = [&](const glm::vec3& point) { return glm::dot(point, bitangent); };
+        std::sort(candidates.begin(), candidates.end(), [&](const glm::vec3& p, const glm::vec3& q)
+        {
+            return u(p) < u(q) || (u(p) == u(q) && v(p) < v(q));
+        });
+        auto turn = [&](const glm::vec3& o, const glm::vec3& p, const glm::vec3& q)
+        {
+            return (u(p) - u(o)) * (v(q) - v(o)) - (v(p) - v(o)) * (u(q) - u(o));
+        };
+        feature.resize(candidates.size() * 2);
+        size_t count = 0;
+        for(size_t i = 0; i < candidates.size(); i++)
+        {
+            while(count >= 2 && turn(feature[count - 2], feature[count - 1], candidates[i]) <= 0.0f) count--;
+            feature[count++] = candidates[i];
+        }
+        for(size_t i = candidates.size() - 1, lower = count + 1; i-- > 0;)
+        {
+            while(count >= lower && turn(feature[count - 2], feature[count - 1], candidates[i]) <= 0.0f) count--;
+            feature[count++] = candidates[i];
+        }
+        feature.resize(count - 1);
+    }
+
+    // Newell's method, unit length and facing the same way as the winding of the polygon
+    glm::vec3 polygonNormal(const std::vector<glm::vec3>& polygon)
+    {
+        glm::vec3 normal(0.0f);
+        for(size_t i = 0; i < polygon.size(); i++)
+        {
+            normal += glm::cross(polygon[i], polygon[(i + 1) % polygon.size()]);
+        }
+        float length = glm::length(normal);
+        return length > 0.0f ? normal / length : normal;
+    }
+
+    // Keeps the part of polygon behind the plane through origin with the given normal
+    void clipPolygon(std::vector<glm::vec3>& polygon, const glm::vec3& origin, const glm::vec3& normal)
+    {
+        thread_local std::vector<glm::vec3> clipped{};
+        clipped.clear();
+        auto distance = [&](const glm::vec3& point) { return glm::dot(normal, point - origin); };
+        if(polygon.size() == 1)
+        {
+            if(distance(polygon[0]) > 0.0f)
+            {
+                polygon.clear();
+            }
+            return;
+        }
+        if(polygon.size() == 2)
+        {
+            float distance0 = distance(polygon[0]);
+            float distance1 = distance(polygon[1]);
+            if(distance0 > 0.0f && distance1 > 0.0f)
+            {
+                polygon.clear();
+            }
+            else if(distance0 > 0.0f)
+            {
+                polygon[0] += (polygon[1] - polygon[0]) * (distance0 / (distance0 - distance1));
+            }
+            else if(distance1 > 0.0f)
+            {
+                polygon[1] += (polygon[0] - polygon[1]) * (distance1 / (distance1 - distance0));
+            }
+            return;
+        }
+
+        for(size_t i = 0; i < polygon.size(); i++)
+        {
+            const glm::vec3& start = polygon[i];
+            const glm::vec3& end = polygon[(i + 1) % polygon.size()];
+            float startDistance = distance(start);
+            float endDistance = distance(end);
+            if(startDistance <= 0.0f)
+            {
+                clipped.push_back(start);
+            }
+            if((startDistance <= 0.0f) != (endDistance <= 0.0f))
+            {
+                clipped.push_back(start + (end - start) * (startDistance / (startDistance - endDistance)));
+            }
+        }
+        polygon = clipped;
+    }
+
+    // Closest points of the segments p0 p1 and q0 q1
+    void closestPoints(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& q0, const glm::vec3& q1, glm::vec3& onP, glm::vec3& onQ)
+    {
+        glm::vec3 d1 = p1 - p0;
+        glm::vec3 d2 = q1 - q0;
+        glm::vec3 r = p0 - q0;
+        float a = glm::dot(d1, d1);
+        float e = glm::dot(d2, d2);
+        float f = glm::dot(d2, r);
+        float s = 0.0f;
+        float t = 0.0f;
+        if(a > 1e-12f && e > 1e-12f)
+        {
+            float b = glm::dot(d1, d2);
+            float c = glm::dot(d1, r);
+            float denominator = a * e - b * b;
+            s = denominator > 1e-12f ? std::clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0.0f;
+            t = (b * s + f) / e;
+            if(t < 0.0f)
+            {
+                t = 0.0f;
+                s = std::clamp(-c / a, 0.0f, 1.0f);
+            }
+            else if(t > 1.0f)
+            {
+                t = 1.0f;
+                s = std::clamp((b - c) / a, 0.0f, 1.0f);
+            }
+        }
+        else if(e > 1e-12f)
+        {
+            t = std::clamp(f / e, 0.0f, 1.0f);
+        }
+        else if(a > 1e-12f)
+        {
+            s = std::clamp(-glm::dot(d1, r) / a, 0.0f, 1.0f);
+        }
+        onP = p0 + d1 * s;
+        onQ = q0 + d2 * t;
+    }
+
+    // The deepest point, the one furthest from it and the two spanning the largest triangles with them on either side
+    void reducePoints(std::vector<ContactManifold::Point>& points, const glm::vec3& normal, ContactManifold& manifold)
+    {
+        if(points.size() <= ContactManifold::MAX_POINTS)
+        {
+            std::copy(points.begin(), points.end(), manifold.points);
+            manifold.pointCount = static_cast<uint32_t>(points.size());
+            return;
+        }
+        size_t chosen[4] = {0, 0, 0, 0};
+        for(size_t i = 1; i < points.size(); i++)
+        {
+            if(points[i].depth > points[chosen[0]].depth) chosen[0] = i;
+        }
+        const glm::vec3 first = points[chosen[0]].position;
+        float furthest = -1.0f;
+        for(size_t i = 0; i < points.size(); i++)
+        {
+            float distance = glm::dot(points[i].position - first, points[i].position - first);
+            if(distance > furthest)
+            {
+                furthest = distance;
+                chosen[1] = i;
+            }
+        }
+        const glm::vec3 second = points[chosen[1]].position;
+        float largest = -std::numeric_limits<float>::infinity();
+        float smallest = std::numeric_limits<float>::infinity();
+        for(size_t i = 0; i < points.size(); i++)
+        {
+            float area = glm::dot(glm::cross(second - first, points[i].position - first), normal);
+            if(area > largest)
+            {
+                largest = area;
+                chosen[2] = i;
+            }
+            if(area < smallest)
+            {
+                smallest = area;
+                chosen[3] = i;
+            }
+        }
+        manifold.pointCount = 0;
+        for(size_t i = 0; i < 4; i++)
+        {
+            if(std::find(chosen, chosen + i, chosen[i]) == chosen + i)
+            {
+                manifold.points[manifold.pointCount++] = points[chosen[i]];
+            }
+        }
+    }
+} // namespace
+
+bool Narrowphase::intersect(std::span<const glm::vec3> a, std::span<const glm::vec3> b)
+{
+    Simplex simplex{};
+    return gjk(a, b, simplex);
+}
+
+bool Narrowphase::penetration(std::span<const glm::vec3> a, std::span<const glm::vec3> b, glm::vec3& normal, float& depth)
+{
+    Simplex simplex{};
+    return gjk(a, b, simplex) && epa(a, b, simplex, normal, depth);
+}
+
+bool Narrowphase::collide(std::span<const glm::vec3> a, std::span<const glm::vec3> b, ContactManifold& manifold)
+{
+    glm::vec3 normal{};
+    float depth = 0.0f;
+    if(!penetration(a, b, normal, depth))
+    {
+        return false;
+    }
+    manifold.normal = normal;
+    manifold.pointCount = 0;
+
+    thread_local std::vector<glm::vec3> featureA{};
+    thread_local std::vector<glm::vec3> featureB{};
+    thread_local std::vector<glm::vec3> clipped{};
+    thread_local std::vector<ContactManifold::Point> points{};
+    findFeature(a, normal, featureA);
+    findFeature(b, -normal, featureB);
+    points.clear();
+
+    // The feature with more vertices is the reference the other one is clipped against
+    const bool referenceIsA = featureA.size() >= featureB.size();
+    const std::vector<glm::vec3>& reference = referenceIsA ? featureA : featureB;
+    const std::vector<glm::vec3>& incident = referenceIsA ? featureB : featureA;
+    glm::vec3 referenceNormal = referenceIsA ? normal : -normal;
+    if(reference.size() >= 3)
+    {
+        // EPA normals are only as exact as its tolerance, the plane of the reference face is exact and keeps stacks from drifting sideways
+        glm::vec3 faceNormal = polygonNormal(reference);
+        if(glm::dot(faceNormal, referenceNormal) < 0.0f)
+        {
+            faceNormal = -faceNormal;
+        }
+        if(glm::dot(faceNormal, referenceNormal) > FACE_NORMAL_COSINE)
+        {
+            referenceNormal = faceNormal;
+            normal = referenceIsA ? faceNormal : -faceNormal;
+            manifold.normal = normal;
+        }
+        clipped = incident;
+        for(size_t i = 0; i < reference.size() && !clipped.empty(); i++)
+        {
+            const glm::vec3& start = reference[i];
+            const glm::vec3& end = reference[(i + 1) % reference.size()];
+            clipPolygon(clipped, start, glm::cross(end - start, referenceNormal));
+        }
+        float surface = -std::numeric_limits<float>::infinity();
+        for(const glm::vec3& vertex : reference)
+        {
+            surface = std::max(surface, glm::dot(referenceNormal, vertex));
+        }
+        for(const glm::vec3& point : clipped)
+        {
+            float pointDepth = surface - glm::dot(referenceNormal, point);
+            if(pointDepth >= -FEATURE_TOLERANCE)
+            {
+                points.push_back({point + referenceNormal * (pointDepth * 0.5f), pointDepth});
+            }
+        }
+    }
+    else if(reference.size() == 2 && incident.size() == 2)
+    {
+        glm::vec3 onReference, onIncident;
+        closestPoints(reference[0], reference[1], incident[0], incident[1], onReference, onIncident);
+        points.push_back({(onReference + onIncident) * 0.5f, depth});
+    }
+
+    if(points.empty())
+    {
+        // A vertex, or clipping lost every point to rounding, the EPA result alone gives one point
+        glm::vec3 position = featureB.size() == 1 ? featureB[0] + normal * (depth * 0.5f) : support(a, normal) - normal * (depth * 0.5f);
+        points.push_back({position, depth});
+    }
+    reducePoints(points, normal, manifold);
+    return true;
+}
+} // namespace physics
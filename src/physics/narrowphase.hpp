@@ -0,0 +1,46 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <span>
+#include <cstdint>
+
+namespace physics
+{
+    // Where two convex shapes touch, all points share one normal
+    struct ContactManifold
+    {
+        static constexpr uint32_t MAX_POINTS = 4;
+
+        struct Point
+        {
+            glm::vec3 position; // Midway between the two surfaces
+            float depth;        // How far the surfaces overlap along the normal, negative for a small gap
+        };
+
+        glm::vec3 normal{}; // Unit length, pointing from the first shape to the second
+        Point points[MAX_POINTS]{};
+        uint32_t pointCount = 0;
+    };
+
+    // Contact generation between convex shapes given as the world space vertices of their hulls
+    // GJK finds whether they overlap, EPA the direction of least overlap, and the features of both shapes
+    // facing each other along it are clipped against each other for a manifold that keeps resting boxes flat
+    class Narrowphase
+    {
+        public:
+            static constexpr uint32_t GJK_MAX_ITERATIONS = 32;
+            static constexpr uint32_t EPA_MAX_ITERATIONS = 64;
+            static constexpr float EPA_TOLERANCE = 1e-4f;
+            // Vertices within this distance of the deepest one along the normal form the touching feature, in world units
+            // Also how far apart clipped points may be and still be reported, as contacts with a negative depth
+            static constexpr float FEATURE_TOLERANCE = 0.02f;
+
+            // GJK, touching shapes do not count as overlapping
+            static bool intersect(std::span<const glm::vec3> a, std::span<const glm::vec3> b);
+            // GJK and EPA, normal points from a to b and moving b by depth along it separates the shapes
+            static bool penetration(std::span<const glm::vec3> a, std::span<const glm::vec3> b, glm::vec3& normal, float& depth);
+            // Fills the manifold when the shapes overlap
+            static bool collide(std::span<const glm::vec3> a, std::span<const glm::vec3> b, ContactManifold& manifold);
+    };
+} // namespace physics
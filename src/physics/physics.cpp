@@ -0,0 +1,201 @@
+#include "physics.hpp"
+#include "hull_cache.hpp"
+#include "core/scene.hpp"
+#include "utils/console.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace physics
+{
+namespace
+{
+    // Dynamic bodies drive their Transform as a root transform, static ones follow it wherever it is in the hierarchy
+    void getPose(const core::Transform& transform, bool dynamic, glm::vec3& position, glm::quat& rotation, glm::vec3& scale)
+    {
+        if(dynamic)
+        {
+            position = transform.getLocalPosition();
+            rotation = transform.getLocalRotation();
+            scale = transform.getLocalScale();
+            return;
+        }
+        const glm::mat4& matrix = transform.getTransform();
+        position = glm::vec3(matrix[3]);
+        scale = glm::vec3(glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2])));
+        rotation = glm::quat_cast(glm::mat3(glm::vec3(matrix[0]) / scale.x, glm::vec3(matrix[1]) / scale.y, glm::vec3(matrix[2]) / scale.z));
+    }
+} // namespace
+
+void Physics::setScene(core::Scene_t* _scene)
+{
+    scene = _scene;
+    sceneBvh.clear();
+    world.clear();
+    colliderBodies.clear();
+    update();
+}
+
+void Physics::update(float deltaTime)
+{
+    if(scene != nullptr)
+    {
+        updateColliders();
+    }
+    world.step(std::min(deltaTime, MAX_STEP_TIME));
+    if(scene != nullptr)
+    {
+        writeBack();
+        sceneBvh.update(*scene);
+    }
+}
+
+core::Entity Physics::getColliderEntity(uint32_t proxy) const
+{
+    uint32_t body = static_cast<uint32_t>(world.getBroadphase().getUserData(proxy));
+    return world.isValid(body) && world.getProxy(body) == proxy ? getBodyEntity(body) : core::Entity{};
+}
+
+void Physics::setHullSettings(const QuickHull::Settings& settings)
+{
+    hullSettings = settings;
+    meshHulls.clear();
+}
+
+std::shared_ptr<const std::vector<ConvexHull>> Physics::getHulls(const core::Mesh& mesh)
+{
+    auto cached = meshHulls.find(mesh.getHandle());
+    if(cached != meshHulls.end())
+    {
+        return cached->second;
+    }
+
+    auto hulls = std::make_shared<std::vector<ConvexHull>>();
+    const std::string& sourcePath = mesh->sourcePath;
+    if(sourcePath.empty() || !HullCache::load(sourcePath, hullSettings, *hulls))
+    {
+        auto start = std::chrono::steady_clock::now();
+        *hulls = QuickHull::build(*mesh, hullSettings);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t vertexCount = 0;
+        for(const ConvexHull& hull : *hulls)
+        {
+            vertexCount += hull.vertices.size();
+        }
+        char line[256];
+        snprintf(line, sizeof(line), "Built %zu convex hulls with %zu vertices for %s in %.2f ms", hulls->size(), vertexCount, mesh->name.c_str(), seconds * 1000.0);
+        Console::log(line, "Physics");
+        if(!sourcePath.empty())
+        {
+            HullCache::cook(sourcePath, hullSettings, *hulls);
+        }
+    }
+    meshHulls[mesh.getHandle()] = hulls;
+    return hulls;
+}
+
+void Physics::updateColliders()
+{
+    updateIndex++;
+    core::EntityRegistry& registry = scene->getRegistry();
+    registry.view<core::Transform, core::MeshCollider>().each([&](core::Entity entity, core::Transform& transform, core::MeshCollider& collider)
+    {
+        if(!collider.mesh)
+        {
+            return;
+        }
+        if(!collider.hulls)
+        {
+            collider.hulls = getHulls(collider.mesh);
+        }
+        const core::RigidBody* rigidBody = registry.tryGetComponent<core::RigidBody>(entity);
+        const bool dynamic = rigidBody != nullptr;
+        glm::vec3 position, scale;
+        glm::quat rotation;
+        getPose(transform, dynamic, position, rotation, scale);
+
+        // Bodies of another scene or of a component copied from another entity are not this collider's
+        uint32_t body = collider.body;
+        if(body < colliderBodies.size() && colliderBodies[body].entity == entity)
+        {
+            ColliderBody& colliderBody = colliderBodies[body];
+            if(colliderBody.dynamic == dynamic && colliderBody.scale == scale)
+            {
+                if(colliderBody.position != position || colliderBody.rotation != rotation)
+                {
+                    world.setTransform(body, position, rotation);
+                    colliderBody.position = position;
+                    colliderBody.rotation = rotation;
+                }
+                colliderBody.lastUpdate = updateIndex;
+                return;
+            }
+            // Scale and type are fixed for the lifetime of a body
+            world.destroyBody(body);
+            colliderBody.entity = {};
+        }
+
+        BodySettings settings{};
+        settings.type = dynamic ? BodyType::DYNAMIC : BodyType::STATIC;
+        settings.hulls = collider.hulls;
+        settings.position = position;
+        settings.rotation = rotation;
+        settings.scale = scale;
+        settings.mass = dynamic ? rigidBody->mass : 0.0f;
+        settings.friction = collider.friction;
+        settings.restitution = collider.restitution;
+        settings.userData = static_cast<uint64_t>(entity.index) << 32 | entity.generation;
+        if(dynamic)
+        {
+            settings.linearVelocity = rigidBody->linearVelocity;
+            settings.angularVelocity = rigidBody->angularVelocity;
+        }
+        body = world.createBody(settings);
+        if(body >= colliderBodies.size())
+        {
+            colliderBodies.resize(body + 1);
+        }
+        colliderBodies[body] = {entity, position, rotation, scale, dynamic, updateIndex};
+        collider.body = body;
+    });
+
+    // Colliders that were not seen were removed, or their entity destroyed
+    for(uint32_t body = 0; body < colliderBodies.size(); body++)
+    {
+        ColliderBody& colliderBody = colliderBodies[body];
+        if(colliderBody.entity && colliderBody.lastUpdate != updateIndex)
+        {
+            world.destroyBody(body);
+            colliderBody.entity = {};
+        }
+    }
+}
+
+void Physics::writeBack()
+{
+    core::EntityRegistry& registry = scene->getRegistry();
+    registry.view<core::Transform, core::MeshCollider, core::RigidBody>().each(
+        [&](core::Entity entity, core::Transform& transform, core::MeshCollider& collider, core::RigidBody& rigidBody)
+    {
+        uint32_t body = collider.body;
+        if(body >= colliderBodies.size() || colliderBodies[body].entity != entity)
+        {
+            return;
+        }
+        rigidBody.linearVelocity = world.getLinearVelocity(body);
+        rigidBody.angularVelocity = world.getAngularVelocity(body);
+        // Sleeping bodies did not move, leaving their Transforms alone keeps them out of the BVH refit
+        if(!world.isAwake(body))
+        {
+            return;
+        }
+        ColliderBody& colliderBody = colliderBodies[body];
+        colliderBody.position = world.getPosition(body);
+        colliderBody.rotation = world.getRotation(body);
+        transform.setPosition(colliderBody.position, false);
+        transform.setRotation(colliderBody.rotation);
+    });
+}
+} // namespace physics
@@ -0,0 +1,73 @@
+#pragma once
+#include "scene_bvh.hpp"
+#include "rigid_body_world.hpp"
+#include "convex_hull.hpp"
+
+#include <memory>
+#include <unordered_map>
+
+namespace core
+{
+    class Scene_t;
+    class Mesh;
+}
+
+namespace physics
+{
+    // Keeps the acceleration structures that physics queries such as Raycast run against
+    // and simulates every entity with a Transform and a MeshCollider as a rigid body, made of the convex hulls it builds for the mesh
+    class Physics
+    {
+        public:
+            // Longest step taken in one update, slower frames run the simulation in slow motion rather than let it explode
+            static constexpr float MAX_STEP_TIME = 1.0f / 30.0f;
+
+            // Scene the queries run against, nullptr leaves them nothing to hit
+            void setScene(core::Scene_t* _scene);
+            core::Scene_t* getScene() const { return scene; }
+
+            // Syncs the bodies with the colliders, steps the simulation by deltaTime and writes the dynamic bodies back to their Transforms
+            // Then brings the query structures up to date, queries see the transforms as of the last update
+            // The engine calls it from the step callbacks of its FixedTimestep, so deltaTime is the same every step
+            void update(float deltaTime = 0.0f);
+
+            const SceneBvh& getSceneBvh() const { return sceneBvh; }
+            // For impulses, velocities and settings, MeshCollider::body is the body of a collider
+            RigidBodyWorld& getWorld() { return world; }
+            const RigidBodyWorld& getWorld() const { return world; }
+            // Proxy user data is the body index
+            const Broadphase& getBroadphase() const { return world.getBroadphase(); }
+            // Entity whose MeshCollider owns a body, invalid once the body was destroyed
+            core::Entity getBodyEntity(uint32_t body) const { return body < colliderBodies.size() ? colliderBodies[body].entity : core::Entity{}; }
+            // Entity whose MeshCollider owns a proxy of the broadphase, invalid once the proxy was destroyed
+            core::Entity getColliderEntity(uint32_t proxy) const;
+
+            // Used for the hulls of colliders without any, colliders that already have hulls keep them
+            void setHullSettings(const QuickHull::Settings& settings);
+            const QuickHull::Settings& getHullSettings() const { return hullSettings; }
+
+        private:
+            struct ColliderBody
+            {
+                core::Entity entity;
+                glm::vec3 position; // Last synced with the Transform, a different one means it was moved from elsewhere
+                glm::quat rotation;
+                glm::vec3 scale;
+                bool dynamic;
+                uint32_t lastUpdate;
+            };
+
+            void updateColliders();
+            void writeBack();
+            // Built once per mesh, loaded from or cooked to the .vhull next to the source file of loaded meshes
+            std::shared_ptr<const std::vector<ConvexHull>> getHulls(const core::Mesh& mesh);
+
+            core::Scene_t* scene = nullptr;
+            SceneBvh sceneBvh{};
+            RigidBodyWorld world{};
+            std::vector<ColliderBody> colliderBodies{}; // Indexed by body
+            uint32_t updateIndex = 0;
+            QuickHull::Settings hullSettings{};
+            std::unordered_map<uint64_t, std::shared_ptr<const std::vector<ConvexHull>>> meshHulls{}; // By mesh handle
+    };
+} // namespace physics
@@ -0,0 +1,72 @@
+#include "raycast.hpp"
+#include "modules.hpp"
+
+#include <stdexcept>
+
+namespace physics
+{
+namespace
+{
+    RaycastHit toRaycastHit(const SceneBvh::Hit& hit)
+    {
+        const SceneBvh::Instance& instance = physicsModule.getSceneBvh().getInstances()[hit.instance];
+        return {hit.point, hit.normal, instance.meshID, instance.objectID, hit.distance};
+    }
+} // namespace
+
+RaycastHit Raycast(glm::vec3 origin, glm::vec3 direction, float distance)
+{
+    // The direction is normalized so distances are in world units
+    float length = glm::length(direction);
+    SceneBvh::Hit hit{};
+    if(length == 0.0f || !physicsModule.getSceneBvh().raycast(origin, direction / length, distance, hit))
+    {
+        return {};
+    }
+    return toRaycastHit(hit);
+}
+
+RaycastResult RaycastAll(glm::vec3 origin, glm::vec3 direction, float distance)
+{
+    RaycastResult result{};
+    float length = glm::length(direction);
+    if(length == 0.0f)
+    {
+        return result;
+    }
+    std::vector<SceneBvh::Hit> hits{};
+    physicsModule.getSceneBvh().raycastAll(origin, direction / length, distance, hits);
+    result.hitInfo.reserve(hits.size());
+    for(const SceneBvh::Hit& hit : hits)
+    {
+        result.hitInfo.push_back(toRaycastHit(hit));
+    }
+    return result;
+}
+
+void RaycastBatch(std::span<const glm::vec3> origins, std::span<const glm::vec3> directions, float distance, std::span<RaycastHit> hits)
+{
+    if(origins.size() != directions.size() || origins.size() != hits.size())
+    {
+        throw std::runtime_error("RaycastBatch: origins, directions and hits must have the same size");
+    }
+
+    // Reused by every batch cast from the same thread
+    thread_local std::vector<glm::vec3> normalizedDirections{};
+    thread_local std::vector<SceneBvh::Hit> sceneHits{};
+    normalizedDirections.resize(directions.size());
+    sceneHits.resize(directions.size());
+    for(size_t i = 0; i < directions.size(); i++)
+    {
+        // Zero directions stay zero and never hit anything
+        float length = glm::length(directions[i]);
+        normalizedDirections[i] = length > 0.0f ? directions[i] / length : glm::vec3(0.0f);
+    }
+
+    physicsModule.getSceneBvh().raycastBatch(origins, normalizedDirections, distance, sceneHits);
+    for(size_t i = 0; i < hits.size(); i++)
+    {
+        hits[i] = sceneHits[i].instance != SceneBvh::NO_HIT ? toRaycastHit(sceneHits[i]) : RaycastHit{};
+    }
+}
+} // namespace physics
@@ -1,5 +1,7 @@
+#pragma once
 #include <glm/glm.hpp>
 #include <vector>
+#include <span>
 #include "core/object.hpp"
 
 // Reinventing the wheel, for fun
@@ -16,17 +18,18 @@ namespace physics
     {
         glm::vec3 hitPos{};
         glm::vec3 hitNormal{};
-        core::Object::id_t hitCollider = -1;
-        core::Object::id_t hitObj = -1;
+        id_t hitCollider = -1; // Instance ID of the MeshData that was hit, -1 on a miss
+        id_t hitObj = -1;      // Instance ID of the GameObject, also -1 for entities without one
+        float distance = 0.0f;
     };
     
     struct RaycastResult
     {
-        std::vector<RaycastHit> hitInfo;
+        std::vector<RaycastHit> hitInfo; // Nearest first
     };
 
-    
-
+    // Queries the scene set on physicsModule, as of its last update, with a two level BVH (see SceneBvh)
+    // Both faces of every triangle are hit, direction does not need to be normalized
     RaycastHit Raycast(
         glm::vec3 origin,
         glm::vec3 direction,
@@ -38,4 +41,13 @@ namespace physics
         glm::vec3 direction,
         float distance
     );
+
+    // Raycast for many rays at once, hits[i] is what Raycast(origins[i], directions[i], distance) returns
+    // Meant for callers that cast hundreds of rays a frame (occlusion, sensor fans, spreads), see SceneBvh::raycastBatch
+    void RaycastBatch(
+        std::span<const glm::vec3> origins,
+        std::span<const glm::vec3> directions,
+        float distance,
+        std::span<RaycastHit> hits
+    );
 } // namespace physics
\ No newline at end of file
@@ -0,0 +1,786 @@
+#include "rigid_body_world.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace physics
+{
+namespace
+{
+    constexpr uint32_t NO_ISLAND = UINT32_MAX;
+
+    glm::vec3 anyPerpendicular(const glm::vec3& vector)
+    {
+        return std::abs(vector.x) < 0.57735f ? glm::cross(vector, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(vector, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    // 1 / (effective mass of the bodies along direction at the offsets)
+    float getInverseEffectiveMass(float inverseMassA, const glm::mat3& inverseInertiaA, const glm::vec3& offsetA,
+        float inverseMassB, const glm::mat3& inverseInertiaB, const glm::vec3& offsetB, const glm::vec3& direction)
+    {
+        glm::vec3 angularA = glm::cross(inverseInertiaA * glm::cross(offsetA, direction), offsetA);
+        glm::vec3 angularB = glm::cross(inverseInertiaB * glm::cross(offsetB, direction), offsetB);
+        return inverseMassA + inverseMassB + glm::dot(angularA + angularB, direction);
+    }
+} // namespace
+
+uint32_t RigidBodyWorld::createBody(const BodySettings& bodySettings)
+{
+    if(!bodySettings.hulls || bodySettings.hulls->empty())
+    {
+        throw std::runtime_error("Rigid bodies need at least one convex hull");
+    }
+
+    uint32_t index = freeBody;
+    if(index == NO_BODY)
+    {
+        index = static_cast<uint32_t>(bodies.size());
+        bodies.emplace_back();
+    }
+    else
+    {
+        freeBody = bodies[index].nextFree;
+        bodies[index] = Body{};
+    }
+
+    Body& body = bodies[index];
+    body.alive = true;
+    body.type = bodySettings.type;
+    body.position = bodySettings.position;
+    body.rotation = glm::normalize(bodySettings.rotation);
+    body.scale = bodySettings.scale;
+    body.friction = bodySettings.friction;
+    body.restitution = bodySettings.restitution;
+    body.userData = bodySettings.userData;
+    body.hulls = bodySettings.hulls;
+    body.hullOffsets.push_back(0);
+    for(const ConvexHull& hull : *body.hulls)
+    {
+        body.hullOffsets.push_back(body.hullOffsets.back() + static_cast<uint32_t>(hull.vertices.size()));
+    }
+    body.worldVertices.resize(body.hullOffsets.back());
+
+    if(body.type == BodyType::DYNAMIC)
+    {
+        body.inverseMass = bodySettings.mass > 0.0f ? 1.0f / bodySettings.mass : 1.0f;
+        body.linearVelocity = bodySettings.linearVelocity;
+        body.angularVelocity = bodySettings.angularVelocity;
+        body.awake = true;
+        awakeBodies.push_back(index);
+    }
+    updateInertia(body);
+    updateShape(body);
+    body.proxy = broadphase.createProxy(body.boundsMin, body.boundsMax, index);
+    bodyCount++;
+    return index;
+}
+
+void RigidBodyWorld::destroyBody(uint32_t index)
+{
+    wake(index);
+    wakeTouching(index);
+    Body& body = bodies[index];
+    if(body.awake)
+    {
+        awakeBodies.erase(std::find(awakeBodies.begin(), awakeBodies.end(), index));
+    }
+    // Its contacts end with the proxy in the next step
+    broadphase.destroyProxy(body.proxy);
+    body = Body{};
+    body.nextFree = freeBody;
+    freeBody = index;
+    bodyCount--;
+}
+
+void RigidBodyWorld::clear()
+{
+    broadphase.clear();
+    bodies.clear();
+    freeBody = NO_BODY;
+    bodyCount = 0;
+    awakeBodies.clear();
+    contacts.clear();
+    contactIndices.clear();
+    sleepingIslands.clear();
+    freeSleepingIslands.clear();
+    stats = {};
+}
+
+void RigidBodyWorld::setTransform(uint32_t index, const glm::vec3& position, const glm::quat& rotation)
+{
+    Body& body = bodies[index];
+    glm::vec3 displacement = position - body.position;
+    body.position = position;
+    body.rotation = glm::normalize(rotation);
+    body.sleepTime = 0.0f;
+    updateShape(body);
+    broadphase.moveProxy(body.proxy, body.boundsMin, body.boundsMax, displacement);
+    wake(index);
+    wakeTouching(index);
+}
+
+void RigidBodyWorld::setVelocity(uint32_t index, const glm::vec3& linearVelocity, const glm::vec3& angularVelocity)
+{
+    Body& body = bodies[index];
+    if(body.type != BodyType::DYNAMIC)
+    {
+        return;
+    }
+    body.linearVelocity = linearVelocity;
+    body.angularVelocity = angularVelocity;
+    body.sleepTime = 0.0f;
+    wake(index);
+}
+
+void RigidBodyWorld::applyImpulse(uint32_t index, const glm::vec3& impulse, const glm::vec3& point)
+{
+    Body& body = bodies[index];
+    if(body.type != BodyType::DYNAMIC)
+    {
+        return;
+    }
+    body.linearVelocity += impulse * body.inverseMass;
+    body.angularVelocity += body.inverseInertia * glm::cross(point - body.position, impulse);
+    body.sleepTime = 0.0f;
+    wake(index);
+}
+
+void RigidBodyWorld::wake(uint32_t index)
+{
+    Body& body = bodies[index];
+    if(body.type != BodyType::DYNAMIC || body.awake)
+    {
+        return;
+    }
+    uint32_t island = body.sleepingIsland;
+    for(uint32_t member : sleepingIslands[island])
+    {
+        Body& memberBody = bodies[member];
+        memberBody.awake = true;
+        memberBody.sleepTime = 0.0f;
+        memberBody.sleepingIsland = UINT32_MAX;
+        awakeBodies.push_back(member);
+    }
+    sleepingIslands[island].clear();
+    freeSleepingIslands.push_back(island);
+}
+
+void RigidBodyWorld::wakeTouching(uint32_t index)
+{
+    for(const Contact& contact : contacts)
+    {
+        if(!contact.manifolds.empty() && (contact.bodyA == index || contact.bodyB == index))
+        {
+            wake(contact.bodyA == index ? contact.bodyB : contact.bodyA);
+        }
+    }
+}
+
+void RigidBodyWorld::updateInertia(Body& body)
+{
+    if(body.type != BodyType::DYNAMIC)
+    {
+        body.localInverseInertia = glm::vec3(0.0f);
+        return;
+    }
+    // Inertia of the box around the scaled hulls, moved to the origin of the body
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(std::numeric_limits<float>::lowest());
+    for(const ConvexHull& hull : *body.hulls)
+    {
+        for(const glm::vec3& vertex : hull.vertices)
+        {
+            min = glm::min(min, vertex * body.scale);
+            max = glm::max(max, vertex * body.scale);
+        }
+    }
+    glm::vec3 size = max - min;
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 squared = size * size / 12.0f + center * center;
+    float mass = 1.0f / body.inverseMass;
+    glm::vec3 inertia = mass * glm::vec3(squared.y + squared.z, squared.x + squared.z, squared.x + squared.y);
+    body.localInverseInertia = glm::vec3(inertia.x > 0.0f ? 1.0f / inertia.x : 0.0f, inertia.y > 0.0f ? 1.0f / inertia.y : 0.0f,
+        inertia.z > 0.0f ? 1.0f / inertia.z : 0.0f);
+}
+
+void RigidBodyWorld::updateShape(Body& body)
+{
+    glm::mat3 rotation = glm::mat3_cast(body.rotation);
+    body.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    body.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+    glm::vec3* world = body.worldVertices.data();
+    for(const ConvexHull& hull : *body.hulls)
+    {
+        for(const glm::vec3& vertex : hull.vertices)
+        {
+            *world = body.position + rotation * (vertex * body.scale);
+            body.boundsMin = glm::min(body.boundsMin, *world);
+            body.boundsMax = glm::max(body.boundsMax, *world);
+            world++;
+        }
+    }
+    glm::mat3 localInverseInertia(0.0f);
+    localInverseInertia[0][0] = body.localInverseInertia.x;
+    localInverseInertia[1][1] = body.localInverseInertia.y;
+    localInverseInertia[2][2] = body.localInverseInertia.z;
+    body.inverseInertia = rotation * localInverseInertia * glm::transpose(rotation);
+}
+
+void RigidBodyWorld::step(float deltaTime, ThreadPool& pool)
+{
+    if(deltaTime <= 0.0f)
+    {
+        return;
+    }
+    stats = {};
+
+    broadphase.updatePairs(pool);
+    updateContacts();
+    // Bodies woken by a touch bring their own contacts along, which are collided in the next round
+    size_t collided = 0;
+    while(collided < activeContacts.size())
+    {
+        const size_t first = collided;
+        pool.parallelFor(activeContacts.size() - first, PARALLEL_PAIR_COUNT, [&](size_t begin, size_t end)
+        {
+            for(size_t i = first + begin; i < first + end; i++)
+            {
+                collide(contacts[activeContacts[i]]);
+            }
+        });
+        collided = activeContacts.size();
+        if(!wakeTouchedIslands(first, collided))
+        {
+            break;
+        }
+        for(uint32_t i = 0; i < contacts.size(); i++)
+        {
+            Contact& contact = contacts[i];
+            if(!contact.active && (bodies[contact.bodyA].awake || bodies[contact.bodyB].awake))
+            {
+                contact.active = true;
+                activeContacts.push_back(i);
+            }
+        }
+    }
+
+    const float linearDamping = 1.0f / (1.0f + deltaTime * settings.linearDamping);
+    const float angularDamping = 1.0f / (1.0f + deltaTime * settings.angularDamping);
+    pool.parallelFor(awakeBodies.size(), PARALLEL_BODY_COUNT, [&](size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            Body& body = bodies[awakeBodies[i]];
+            body.linearVelocity = (body.linearVelocity + settings.gravity * deltaTime) * linearDamping;
+            body.angularVelocity *= angularDamping;
+        }
+    });
+
+    buildIslands(pool.getThreadCount() + 1);
+    pool.parallelFor(islandBatches.size(), 1, [&](size_t begin, size_t end)
+    {
+        for(size_t batch = begin; batch < end; batch++)
+        {
+            for(uint32_t island : islandBatches[batch].islands)
+            {
+                solveIsland(island, deltaTime);
+            }
+        }
+    });
+
+    for(uint32_t index : awakeBodies)
+    {
+        Body& body = bodies[index];
+        broadphase.moveProxy(body.proxy, body.boundsMin, body.boundsMax, body.linearVelocity * deltaTime);
+    }
+    putIslandsToSleep();
+    stats.awakeBodies = static_cast<uint32_t>(awakeBodies.size());
+}
+
+void RigidBodyWorld::updateContacts()
+{
+    for(const Broadphase::Pair& pair : broadphase.getEndedPairs())
+    {
+        auto found = contactIndices.find(getPairKey(pair.proxyA, pair.proxyB));
+        if(found == contactIndices.end())
+        {
+            continue;
+        }
+        uint32_t index = found->second;
+        contactIndices.erase(found);
+        if(index != contacts.size() - 1)
+        {
+            contacts[index] = std::move(contacts.back());
+            contactIndices[contacts[index].key] = index;
+        }
+        contacts.pop_back();
+    }
+    for(const Broadphase::Pair& pair : broadphase.getBeganPairs())
+    {
+        uint32_t bodyA = static_cast<uint32_t>(broadphase.getUserData(pair.proxyA));
+        uint32_t bodyB = static_cast<uint32_t>(broadphase.getUserData(pair.proxyB));
+        if(bodies[bodyA].type == BodyType::STATIC && bodies[bodyB].type == BodyType::STATIC)
+        {
+            continue;
+        }
+        uint64_t key = getPairKey(pair.proxyA, pair.proxyB);
+        contactIndices[key] = static_cast<uint32_t>(contacts.size());
+        contacts.push_back({key, bodyA, bodyB, false, {}});
+    }
+
+    // Contacts between sleeping or static bodies keep their manifolds from when they were last collided
+    activeContacts.clear();
+    for(uint32_t i = 0; i < contacts.size(); i++)
+    {
+        Contact& contact = contacts[i];
+        contact.active = bodies[contact.bodyA].awake || bodies[contact.bodyB].awake;
+        if(contact.active)
+        {
+            activeContacts.push_back(i);
+        }
+    }
+}
+
+void RigidBodyWorld::collide(Contact& contact)
+{
+    const Body& bodyA = bodies[contact.bodyA];
+    const Body& bodyB = bodies[contact.bodyB];
+    thread_local std::vector<Manifold> previous{};
+    previous.swap(contact.manifolds);
+    contact.manifolds.clear();
+
+    const glm::quat inverseRotationA = glm::conjugate(bodyA.rotation);
+    for(uint32_t hullA = 0; hullA + 1 < bodyA.hullOffsets.size(); hullA++)
+    {
+        std::span<const glm::vec3> verticesA(bodyA.worldVertices.data() + bodyA.hullOffsets[hullA], bodyA.hullOffsets[hullA + 1] - bodyA.hullOffsets[hullA]);
+        for(uint32_t hullB = 0; hullB + 1 < bodyB.hullOffsets.size(); hullB++)
+        {
+            std::span<const glm::vec3> verticesB(bodyB.worldVertices.data() + bodyB.hullOffsets[hullB], bodyB.hullOffsets[hullB + 1] - bodyB.hullOffsets[hullB]);
+            ContactManifold found{};
+            if(!Narrowphase::collide(verticesA, verticesB, found))
+            {
+                continue;
+            }
+
+            Manifold manifold{};
+            manifold.hullA = hullA;
+            manifold.hullB = hullB;
+            manifold.normal = found.normal;
+            manifold.pointCount = found.pointCount;
+            const Manifold* old = nullptr;
+            for(const Manifold& candidate : previous)
+            {
+                if(candidate.hullA == hullA && candidate.hullB == hullB)
+                {
+                    old = &candidate;
+                }
+            }
+            for(uint32_t i = 0; i < found.pointCount; i++)
+            {
+                ContactPoint& point = manifold.points[i];
+                point.position = found.points[i].position;
+                point.depth = found.points[i].depth;
+                point.localPosition = inverseRotationA * (point.position - bodyA.position);
+                point.normalImpulse = 0.0f;
+                point.tangentImpulse[0] = point.tangentImpulse[1] = 0.0f;
+
+                // Warm started from the closest point of the last step
+                float closest = CONTACT_MATCH_DISTANCE * CONTACT_MATCH_DISTANCE;
+                for(uint32_t j = 0; old != nullptr && j < old->pointCount; j++)
+                {
+                    glm::vec3 offset = old->points[j].localPosition - point.localPosition;
+                    float distance = glm::dot(offset, offset);
+                    if(distance < closest)
+                    {
+                        closest = distance;
+                        point.normalImpulse = old->points[j].normalImpulse;
+                        point.tangentImpulse[0] = old->points[j].tangentImpulse[0];
+                        point.tangentImpulse[1] = old->points[j].tangentImpulse[1];
+                    }
+                }
+            }
+            contact.manifolds.push_back(manifold);
+        }
+    }
+}
+
+bool RigidBodyWorld::wakeTouchedIslands(size_t begin, size_t end)
+{
+    const size_t awakeCount = awakeBodies.size();
+    for(size_t i = begin; i < end; i++)
+    {
+        const Contact& contact = contacts[activeContacts[i]];
+        if(!contact.manifolds.empty())
+        {
+            wake(contact.bodyA);
+            wake(contact.bodyB);
+        }
+    }
+    return awakeBodies.size() != awakeCount;
+}
+
+uint32_t RigidBodyWorld::findRoot(uint32_t body)
+{
+    while(islandParents[body] != body)
+    {
+        islandParents[body] = islandParents[islandParents[body]];
+        body = islandParents[body];
+    }
+    return body;
+}
+
+void RigidBodyWorld::buildIslands(size_t batchCount)
+{
+    // Dynamic bodies touching each other share an island, static bodies do not join the islands they touch
+    islandParents.resize(bodies.size());
+    bodyIslands.resize(bodies.size());
+    for(uint32_t index : awakeBodies)
+    {
+        islandParents[index] = index;
+        bodyIslands[index] = NO_ISLAND;
+    }
+    touchingContacts.clear();
+    for(uint32_t index : activeContacts)
+    {
+        const Contact& contact = contacts[index];
+        if(contact.manifolds.empty())
+        {
+            continue;
+        }
+        touchingContacts.push_back(index);
+        if(bodies[contact.bodyA].type == BodyType::DYNAMIC && bodies[contact.bodyB].type == BodyType::DYNAMIC)
+        {
+            uint32_t rootA = findRoot(contact.bodyA);
+            uint32_t rootB = findRoot(contact.bodyB);
+            if(rootA != rootB)
+            {
+                islandParents[std::max(rootA, rootB)] = std::min(rootA, rootB);
+            }
+        }
+    }
+
+    uint32_t islandCount = 0;
+    for(uint32_t index : awakeBodies)
+    {
+        uint32_t root = findRoot(index);
+        if(bodyIslands[root] == NO_ISLAND)
+        {
+            bodyIslands[root] = islandCount++;
+        }
+    }
+    for(uint32_t index : awakeBodies)
+    {
+        bodyIslands[index] = bodyIslands[findRoot(index)];
+    }
+
+    // Counting sort of the bodies and constraints by island
+    islandBodyOffsets.assign(islandCount + 1, 0);
+    islandConstraintOffsets.assign(islandCount + 1, 0);
+    for(uint32_t index : awakeBodies)
+    {
+        islandBodyOffsets[bodyIslands[index] + 1]++;
+    }
+    auto getIsland = [&](const Contact& contact)
+    {
+        return bodyIslands[bodies[contact.bodyA].type == BodyType::DYNAMIC ? contact.bodyA : contact.bodyB];
+    };
+    size_t constraintCount = 0;
+    for(uint32_t index : touchingContacts)
+    {
+        const Contact& contact = contacts[index];
+        islandConstraintOffsets[getIsland(contact) + 1] += static_cast<uint32_t>(contact.manifolds.size());
+        constraintCount += contact.manifolds.size();
+    }
+    for(uint32_t island = 0; island < islandCount; island++)
+    {
+        islandBodyOffsets[island + 1] += islandBodyOffsets[island];
+        islandConstraintOffsets[island + 1] += islandConstraintOffsets[island];
+    }
+
+    islandBodies.resize(awakeBodies.size());
+    std::vector<uint32_t> cursors(islandBodyOffsets.begin(), islandBodyOffsets.end() - 1);
+    for(uint32_t index : awakeBodies)
+    {
+        islandBodies[cursors[bodyIslands[index]]++] = index;
+    }
+    constraints.resize(constraintCount);
+    cursors.assign(islandConstraintOffsets.begin(), islandConstraintOffsets.end() - 1);
+    for(uint32_t index : touchingContacts)
+    {
+        Contact& contact = contacts[index];
+        uint32_t island = getIsland(contact);
+        for(Manifold& manifold : contact.manifolds)
+        {
+            Constraint& constraint = constraints[cursors[island]++];
+            constraint.bodyA = contact.bodyA;
+            constraint.bodyB = contact.bodyB;
+            constraint.manifold = &manifold;
+            stats.contactPoints += manifold.pointCount;
+        }
+    }
+
+    // Largest islands first, each to the batch with the least work so far
+    std::vector<uint32_t> order(islandCount);
+    for(uint32_t island = 0; island < islandCount; island++)
+    {
+        order[island] = island;
+    }
+    auto getWork = [&](uint32_t island)
+    {
+        return static_cast<size_t>(islandBodyOffsets[island + 1] - islandBodyOffsets[island])
+            + 4 * static_cast<size_t>(islandConstraintOffsets[island + 1] - islandConstraintOffsets[island]);
+    };
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+    {
+        size_t workA = getWork(a);
+        size_t workB = getWork(b);
+        return workA > workB || (workA == workB && a < b);
+    });
+    islandBatches.resize(std::min<size_t>(batchCount, islandCount));
+    for(IslandBatch& batch : islandBatches)
+    {
+        batch.islands.clear();
+        batch.work = 0;
+    }
+    for(uint32_t island : order)
+    {
+        IslandBatch& lightest = *std::min_element(islandBatches.begin(), islandBatches.end(), [](const IslandBatch& a, const IslandBatch& b) { return a.work < b.work; });
+        lightest.islands.push_back(island);
+        lightest.work += getWork(island);
+    }
+    islandSleepy.assign(islandCount, 0);
+
+    stats.islands = islandCount;
+    stats.touchingPairs = static_cast<uint32_t>(touchingContacts.size());
+}
+
+void RigidBodyWorld::prepareConstraint(Constraint& constraint, float deltaTime)
+{
+    Body& bodyA = bodies[constraint.bodyA];
+    Body& bodyB = bodies[constraint.bodyB];
+    const Manifold& manifold = *constraint.manifold;
+    constraint.normal = manifold.normal;
+    constraint.tangents[0] = glm::normalize(anyPerpendicular(manifold.normal));
+    constraint.tangents[1] = glm::cross(manifold.normal, constraint.tangents[0]);
+    constraint.friction = std::sqrt(bodyA.friction * bodyB.friction);
+    constraint.pointCount = manifold.pointCount;
+    const float restitution = std::max(bodyA.restitution, bodyB.restitution);
+
+    glm::vec3 linearImpulse(0.0f);
+    glm::vec3 angularImpulseA(0.0f);
+    glm::vec3 angularImpulseB(0.0f);
+    for(uint32_t i = 0; i < constraint.pointCount; i++)
+    {
+        const ContactPoint& contactPoint = manifold.points[i];
+        ConstraintPoint& point = constraint.points[i];
+        point.offsetA = contactPoint.position - bodyA.position;
+        point.offsetB = contactPoint.position - bodyB.position;
+        float inverseMass = getInverseEffectiveMass(bodyA.inverseMass, bodyA.inverseInertia, point.offsetA,
+            bodyB.inverseMass, bodyB.inverseInertia, point.offsetB, constraint.normal);
+        point.normalMass = inverseMass > 0.0f ? 1.0f / inverseMass : 0.0f;
+        for(int tangent = 0; tangent < 2; tangent++)
+        {
+            inverseMass = getInverseEffectiveMass(bodyA.inverseMass, bodyA.inverseInertia, point.offsetA,
+                bodyB.inverseMass, bodyB.inverseInertia, point.offsetB, constraint.tangents[tangent]);
+            point.tangentMass[tangent] = inverseMass > 0.0f ? 1.0f / inverseMass : 0.0f;
+        }
+
+        // Lets a small gap close within the step and bounces off fast impacts, what is deeper than the slop is pushed out by the split impulse
+        glm::vec3 relativeVelocity = bodyB.linearVelocity + glm::cross(bodyB.angularVelocity, point.offsetB)
+            - bodyA.linearVelocity - glm::cross(bodyA.angularVelocity, point.offsetA);
+        float normalVelocity = glm::dot(relativeVelocity, constraint.normal);
+        point.velocityBias = contactPoint.depth < 0.0f ? contactPoint.depth / deltaTime : 0.0f;
+        point.positionBias = std::min(BAUMGARTE / deltaTime * std::max(contactPoint.depth - LINEAR_SLOP, 0.0f), MAX_CORRECTION_VELOCITY);
+        point.pushImpulse = 0.0f;
+        if(normalVelocity < -RESTITUTION_VELOCITY)
+        {
+            point.velocityBias = std::max(point.velocityBias, -restitution * normalVelocity);
+        }
+
+        point.normalImpulse = contactPoint.normalImpulse;
+        point.tangentImpulse[0] = contactPoint.tangentImpulse[0];
+        point.tangentImpulse[1] = contactPoint.tangentImpulse[1];
+        glm::vec3 impulse = constraint.normal * point.normalImpulse + constraint.tangents[0] * point.tangentImpulse[0]
+            + constraint.tangents[1] * point.tangentImpulse[1];
+        linearImpulse += impulse;
+        angularImpulseA += glm::cross(point.offsetA, impulse);
+        angularImpulseB += glm::cross(point.offsetB, impulse);
+    }
+
+    // Warm start with the impulses of the last step, only dynamic bodies are written since static ones are shared between islands
+    if(bodyA.type == BodyType::DYNAMIC)
+    {
+        bodyA.linearVelocity -= linearImpulse * bodyA.inverseMass;
+        bodyA.angularVelocity -= bodyA.inverseInertia * angularImpulseA;
+    }
+    if(bodyB.type == BodyType::DYNAMIC)
+    {
+        bodyB.linearVelocity += linearImpulse * bodyB.inverseMass;
+        bodyB.angularVelocity += bodyB.inverseInertia * angularImpulseB;
+    }
+}
+
+void RigidBodyWorld::solveConstraint(Constraint& constraint)
+{
+    Body& bodyA = bodies[constraint.bodyA];
+    Body& bodyB = bodies[constraint.bodyB];
+    const bool dynamicA = bodyA.type == BodyType::DYNAMIC;
+    const bool dynamicB = bodyB.type == BodyType::DYNAMIC;
+    auto apply = [&](const ConstraintPoint& point, const glm::vec3& impulse)
+    {
+        if(dynamicA)
+        {
+            bodyA.linearVelocity -= impulse * bodyA.inverseMass;
+            bodyA.angularVelocity -= bodyA.inverseInertia * glm::cross(point.offsetA, impulse);
+        }
+        if(dynamicB)
+        {
+            bodyB.linearVelocity += impulse * bodyB.inverseMass;
+            bodyB.angularVelocity += bodyB.inverseInertia * glm::cross(point.offsetB, impulse);
+        }
+    };
+    auto getRelativeVelocity = [&](const ConstraintPoint& point)
+    {
+        return bodyB.linearVelocity + glm::cross(bodyB.angularVelocity, point.offsetB) - bodyA.linearVelocity - glm::cross(bodyA.angularVelocity, point.offsetA);
+    };
+
+    // Friction first, bounded by the normal impulses of the last iteration
+    for(uint32_t i = 0; i < constraint.pointCount; i++)
+    {
+        ConstraintPoint& point = constraint.points[i];
+        float maxFriction = constraint.friction * point.normalImpulse;
+        for(int tangent = 0; tangent < 2; tangent++)
+        {
+            float tangentVelocity = glm::dot(getRelativeVelocity(point), constraint.tangents[tangent]);
+            float impulse = -point.tangentMass[tangent] * tangentVelocity;
+            float accumulated = std::clamp(point.tangentImpulse[tangent] + impulse, -maxFriction, maxFriction);
+            impulse = accumulated - point.tangentImpulse[tangent];
+            point.tangentImpulse[tangent] = accumulated;
+            apply(point, constraint.tangents[tangent] * impulse);
+        }
+    }
+
+    for(uint32_t i = 0; i < constraint.pointCount; i++)
+    {
+        ConstraintPoint& point = constraint.points[i];
+        float normalVelocity = glm::dot(getRelativeVelocity(point), constraint.normal);
+        float impulse = -point.normalMass * (normalVelocity - point.velocityBias);
+        float accumulated = std::max(point.normalImpulse + impulse, 0.0f);
+        impulse = accumulated - point.normalImpulse;
+        point.normalImpulse = accumulated;
+        apply(point, constraint.normal * impulse);
+    }
+
+    for(uint32_t i = 0; i < constraint.pointCount; i++)
+    {
+        ConstraintPoint& point = constraint.points[i];
+        if(point.positionBias <= 0.0f && point.pushImpulse <= 0.0f)
+        {
+            continue;
+        }
+        glm::vec3 pushVelocity = bodyB.pushLinearVelocity + glm::cross(bodyB.pushAngularVelocity, point.offsetB)
+            - bodyA.pushLinearVelocity - glm::cross(bodyA.pushAngularVelocity, point.offsetA);
+        float impulse = -point.normalMass * (glm::dot(pushVelocity, constraint.normal) - point.positionBias);
+        float accumulated = std::max(point.pushImpulse + impulse, 0.0f);
+        impulse = accumulated - point.pushImpulse;
+        point.pushImpulse = accumulated;
+        glm::vec3 push = constraint.normal * impulse;
+        if(dynamicA)
+        {
+            bodyA.pushLinearVelocity -= push * bodyA.inverseMass;
+            bodyA.pushAngularVelocity -= bodyA.inverseInertia * glm::cross(point.offsetA, push);
+        }
+        if(dynamicB)
+        {
+            bodyB.pushLinearVelocity += push * bodyB.inverseMass;
+            bodyB.pushAngularVelocity += bodyB.inverseInertia * glm::cross(point.offsetB, push);
+        }
+    }
+}
+
+void RigidBodyWorld::solveIsland(uint32_t island, float deltaTime)
+{
+    const uint32_t firstConstraint = islandConstraintOffsets[island];
+    const uint32_t endConstraint = islandConstraintOffsets[island + 1];
+    for(uint32_t i = firstConstraint; i < endConstraint; i++)
+    {
+        prepareConstraint(constraints[i], deltaTime);
+    }
+    for(uint32_t iteration = 0; iteration < settings.velocityIterations; iteration++)
+    {
+        for(uint32_t i = firstConstraint; i < endConstraint; i++)
+        {
+            solveConstraint(constraints[i]);
+        }
+    }
+    for(uint32_t i = firstConstraint; i < endConstraint; i++)
+    {
+        const Constraint& constraint = constraints[i];
+        Manifold& manifold = *constraint.manifold;
+        for(uint32_t j = 0; j < constraint.pointCount; j++)
+        {
+            manifold.points[j].normalImpulse = constraint.points[j].normalImpulse;
+            manifold.points[j].tangentImpulse[0] = constraint.points[j].tangentImpulse[0];
+            manifold.points[j].tangentImpulse[1] = constraint.points[j].tangentImpulse[1];
+        }
+    }
+
+    float minSleepTime = std::numeric_limits<float>::max();
+    for(uint32_t i = islandBodyOffsets[island]; i < islandBodyOffsets[island + 1]; i++)
+    {
+        Body& body = bodies[islandBodies[i]];
+        glm::vec3 angularVelocity = body.angularVelocity + body.pushAngularVelocity;
+        body.position += (body.linearVelocity + body.pushLinearVelocity) * deltaTime;
+        glm::quat spin(0.0f, angularVelocity.x, angularVelocity.y, angularVelocity.z);
+        body.rotation = glm::normalize(body.rotation + spin * body.rotation * (0.5f * deltaTime));
+        body.pushLinearVelocity = glm::vec3(0.0f);
+        body.pushAngularVelocity = glm::vec3(0.0f);
+        updateShape(body);
+
+        bool resting = glm::dot(body.linearVelocity, body.linearVelocity) < SLEEP_LINEAR_VELOCITY * SLEEP_LINEAR_VELOCITY
+            && glm::dot(body.angularVelocity, body.angularVelocity) < SLEEP_ANGULAR_VELOCITY * SLEEP_ANGULAR_VELOCITY;
+        body.sleepTime = resting ? body.sleepTime + deltaTime : 0.0f;
+        minSleepTime = std::min(minSleepTime, body.sleepTime);
+    }
+    islandSleepy[island] = settings.allowSleep && minSleepTime >= TIME_TO_SLEEP;
+}
+
+void RigidBodyWorld::putIslandsToSleep()
+{
+    bool sleeping = false;
+    for(uint32_t island = 0; island < islandSleepy.size(); island++)
+    {
+        if(!islandSleepy[island])
+        {
+            continue;
+        }
+        uint32_t slot;
+        if(freeSleepingIslands.empty())
+        {
+            slot = static_cast<uint32_t>(sleepingIslands.size());
+            sleepingIslands.emplace_back();
+        }
+        else
+        {
+            slot = freeSleepingIslands.back();
+            freeSleepingIslands.pop_back();
+        }
+        for(uint32_t i = islandBodyOffsets[island]; i < islandBodyOffsets[island + 1]; i++)
+        {
+            Body& body = bodies[islandBodies[i]];
+            body.awake = false;
+            body.linearVelocity = glm::vec3(0.0f);
+            body.angularVelocity = glm::vec3(0.0f);
+            body.sleepingIsland = slot;
+            sleepingIslands[slot].push_back(islandBodies[i]);
+        }
+        sleeping = true;
+    }
+    if(sleeping)
+    {
+        std::erase_if(awakeBodies, [&](uint32_t index) { return !bodies[index].awake; });
+    }
+}
+} // namespace physics
@@ -0,0 +1,242 @@
+#pragma once
+#include "broadphase.hpp"
+#include "convex_hull.hpp"
+#include "narrowphase.hpp"
+#include "utils/thread_pool.hpp"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtc/quaternion.hpp>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace physics
+{
+    enum class BodyType
+    {
+        STATIC = 0,
+        DYNAMIC = 1
+    };
+
+    struct BodySettings
+    {
+        BodyType type = BodyType::DYNAMIC;
+        std::shared_ptr<const std::vector<ConvexHull>> hulls{}; // Shape in the local space of the body, may be shared between bodies
+        glm::vec3 position{};
+        glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+        glm::vec3 scale{1.0f};
+        glm::vec3 linearVelocity{};
+        glm::vec3 angularVelocity{};
+        float mass = 1.0f; // Ignored for static bodies
+        float friction = 0.5f;
+        float restitution = 0.0f;
+        uint64_t userData = 0;
+    };
+
+    // Rigid bodies made of convex hulls, simulated with a sequential impulse solver
+    // Bodies in contact form islands, which are solved independently of each other on the worker threads and
+    // fall asleep together once all their bodies come to rest. Sleeping islands are skipped entirely until
+    // something awake touches them. The origin of a body is its center of mass
+    // Results do not depend on the number of threads, islands never share a dynamic body
+    class RigidBodyWorld
+    {
+        public:
+            struct Settings
+            {
+                glm::vec3 gravity{0.0f, -9.81f, 0.0f};
+                uint32_t velocityIterations = 8;
+                float linearDamping = 0.0f; // Fraction of the velocity lost per second
+                float angularDamping = 0.05f;
+                bool allowSleep = true;
+            };
+
+            struct Stats
+            {
+                uint32_t awakeBodies = 0;
+                uint32_t islands = 0;
+                uint32_t touchingPairs = 0;
+                uint32_t contactPoints = 0;
+            };
+
+            static constexpr uint32_t NO_BODY = UINT32_MAX;
+            // Penetration the solver leaves in place so resting contacts keep touching, in world units
+            static constexpr float LINEAR_SLOP = 0.005f;
+            // Fraction of the remaining penetration resolved per step
+            static constexpr float BAUMGARTE = 0.2f;
+            static constexpr float MAX_CORRECTION_VELOCITY = 3.0f;
+            // Slower impacts do not bounce, which keeps piles from jittering
+            static constexpr float RESTITUTION_VELOCITY = 1.0f;
+            // New contact points this close to one of the last step take over its impulses
+            static constexpr float CONTACT_MATCH_DISTANCE = 0.05f;
+            static constexpr float SLEEP_LINEAR_VELOCITY = 0.05f;
+            static constexpr float SLEEP_ANGULAR_VELOCITY = 0.05f;
+            static constexpr float TIME_TO_SLEEP = 0.5f;
+            // Work per task on the worker threads
+            static constexpr size_t PARALLEL_BODY_COUNT = 256;
+            static constexpr size_t PARALLEL_PAIR_COUNT = 64;
+
+            uint32_t createBody(const BodySettings& settings);
+            // Wakes the bodies the destroyed body was resting on or supporting
+            void destroyBody(uint32_t body);
+            void clear();
+
+            void step(float deltaTime, ThreadPool& pool = ThreadPool::getGlobal());
+
+            // Teleports the body and wakes it
+            void setTransform(uint32_t body, const glm::vec3& position, const glm::quat& rotation);
+            void setVelocity(uint32_t body, const glm::vec3& linearVelocity, const glm::vec3& angularVelocity);
+            void applyImpulse(uint32_t body, const glm::vec3& impulse, const glm::vec3& point);
+            // Wakes the whole island of a sleeping body
+            void wake(uint32_t body);
+
+            bool isValid(uint32_t body) const { return body < bodies.size() && bodies[body].alive; }
+            BodyType getType(uint32_t body) const { return bodies[body].type; }
+            const glm::vec3& getPosition(uint32_t body) const { return bodies[body].position; }
+            const glm::quat& getRotation(uint32_t body) const { return bodies[body].rotation; }
+            const glm::vec3& getLinearVelocity(uint32_t body) const { return bodies[body].linearVelocity; }
+            const glm::vec3& getAngularVelocity(uint32_t body) const { return bodies[body].angularVelocity; }
+            bool isAwake(uint32_t body) const { return bodies[body].awake; }
+            uint64_t getUserData(uint32_t body) const { return bodies[body].userData; }
+            uint32_t getProxy(uint32_t body) const { return bodies[body].proxy; }
+            const std::shared_ptr<const std::vector<ConvexHull>>& getHulls(uint32_t body) const { return bodies[body].hulls; }
+            uint32_t getBodyCount() const { return bodyCount; }
+
+            // Proxy user data is the body index
+            const Broadphase& getBroadphase() const { return broadphase; }
+            void setSettings(const Settings& _settings) { settings = _settings; }
+            const Settings& getSettings() const { return settings; }
+            // Of the last step
+            const Stats& getStats() const { return stats; }
+
+        private:
+            struct Body
+            {
+                glm::vec3 position{};
+                glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+                glm::vec3 linearVelocity{};
+                glm::vec3 angularVelocity{};
+                // Split impulses push bodies apart in the step they overlap without adding to their momentum, so nothing bounces out of a pile
+                glm::vec3 pushLinearVelocity{};
+                glm::vec3 pushAngularVelocity{};
+                glm::mat3 inverseInertia{0.0f}; // World space
+                glm::vec3 localInverseInertia{}; // Diagonal in body space
+                float inverseMass = 0.0f;
+                float friction = 0.5f;
+                float restitution = 0.0f;
+                glm::vec3 scale{1.0f};
+                BodyType type = BodyType::STATIC;
+                bool alive = false;
+                bool awake = false;
+                float sleepTime = 0.0f;
+                uint32_t proxy = UINT32_MAX;
+                uint32_t sleepingIsland = UINT32_MAX;
+                uint32_t nextFree = NO_BODY;
+                uint64_t userData = 0;
+                std::shared_ptr<const std::vector<ConvexHull>> hulls{};
+                std::vector<glm::vec3> worldVertices{}; // Of every hull, one after the other
+                std::vector<uint32_t> hullOffsets{}; // First world vertex of each hull, then the total count
+                glm::vec3 boundsMin{};
+                glm::vec3 boundsMax{};
+            };
+
+            struct ContactPoint
+            {
+                glm::vec3 position;
+                glm::vec3 localPosition; // In the space of the first body, to find the same point in the next step
+                float depth;
+                float normalImpulse;
+                float tangentImpulse[2];
+            };
+
+            struct Manifold
+            {
+                uint32_t hullA;
+                uint32_t hullB;
+                glm::vec3 normal;
+                uint32_t pointCount;
+                ContactPoint points[ContactManifold::MAX_POINTS];
+            };
+
+            // One per broadphase pair, bodyA is the one with the smaller proxy
+            struct Contact
+            {
+                uint64_t key; // Pair key of the proxies, bodies may be destroyed before the pair ends
+                uint32_t bodyA;
+                uint32_t bodyB;
+                bool active;
+                std::vector<Manifold> manifolds{};
+            };
+
+            struct ConstraintPoint
+            {
+                glm::vec3 offsetA; // From the bodies to the contact point
+                glm::vec3 offsetB;
+                float normalMass;
+                float tangentMass[2];
+                float velocityBias; // Restitution and speculative gaps
+                float positionBias; // Penetration recovery, only for the split impulse
+                float normalImpulse;
+                float tangentImpulse[2];
+                float pushImpulse;
+            };
+
+            struct Constraint
+            {
+                uint32_t bodyA;
+                uint32_t bodyB;
+                Manifold* manifold;
+                glm::vec3 normal;
+                glm::vec3 tangents[2];
+                float friction;
+                uint32_t pointCount;
+                ConstraintPoint points[ContactManifold::MAX_POINTS];
+            };
+
+            // Islands handed to one worker, dealt largest first to balance the load
+            struct IslandBatch
+            {
+                std::vector<uint32_t> islands{};
+                size_t work = 0;
+            };
+
+            static uint64_t getPairKey(uint32_t proxyA, uint32_t proxyB) { return static_cast<uint64_t>(proxyA) << 32 | proxyB; }
+            void updateShape(Body& body);
+            void updateInertia(Body& body);
+            void updateContacts();
+            void collide(Contact& contact);
+            bool wakeTouchedIslands(size_t begin, size_t end);
+            void wakeTouching(uint32_t body);
+            void buildIslands(size_t batchCount);
+            void solveIsland(uint32_t island, float deltaTime);
+            void prepareConstraint(Constraint& constraint, float deltaTime);
+            void solveConstraint(Constraint& constraint);
+            void putIslandsToSleep();
+            uint32_t findRoot(uint32_t body);
+
+            Settings settings{};
+            Stats stats{};
+            Broadphase broadphase{};
+            std::vector<Body> bodies{};
+            uint32_t freeBody = NO_BODY;
+            uint32_t bodyCount = 0;
+            std::vector<uint32_t> awakeBodies{};
+
+            std::vector<Contact> contacts{};
+            std::unordered_map<uint64_t, uint32_t> contactIndices{}; // By pair key of the proxies
+            std::vector<uint32_t> activeContacts{}; // With an awake body, collided this step
+            std::vector<uint32_t> touchingContacts{}; // Solved this step
+
+            // Islands of the current step, bodies and constraints of island i are at islandBodyOffsets[i] and islandConstraintOffsets[i]
+            std::vector<uint32_t> islandParents{}; // Union find over body indices, only set for awake bodies
+            std::vector<uint32_t> bodyIslands{};
+            std::vector<uint32_t> islandBodies{};
+            std::vector<uint32_t> islandBodyOffsets{};
+            std::vector<Constraint> constraints{};
+            std::vector<uint32_t> islandConstraintOffsets{};
+            std::vector<uint8_t> islandSleepy{};
+            std::vector<IslandBatch> islandBatches{};
+
+            std::vector<std::vector<uint32_t>> sleepingIslands{}; // Bodies of each sleeping island, woken as a whole
+            std::vector<uint32_t> freeSleepingIslands{};
+    };
+} // namespace physics
@@ -0,0 +1,300 @@
+#include "scene_bvh.hpp"
+#include "core/scene.hpp"
+#include "core/mesh_processing.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/radix_sort.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace physics
+{
+namespace
+{
+    constexpr size_t PARALLEL_RANGE_SIZE = 1024;
+
+    // Interleaves the components, each quantized to 10 bits over [0, 1], into a 30 bit Morton code
+    uint64_t mortonCode(const glm::vec3& position)
+    {
+        auto expandBits = [](float component)
+        {
+            // NaNs fail the compare and go to 0
+            uint64_t bits = static_cast<uint64_t>((component >= 0.0f ? std::min(component, 1.0f) : 0.0f) * 1023.0f);
+            bits = (bits | bits << 16) & 0x30000ffull;
+            bits = (bits | bits << 8) & 0x300f00full;
+            bits = (bits | bits << 4) & 0x30c30c3ull;
+            bits = (bits | bits << 2) & 0x9249249ull;
+            return bits;
+        };
+        return expandBits(position.x) << 2 | expandBits(position.y) << 1 | expandBits(position.z);
+    }
+} // namespace
+
+void SceneBvh::update(core::Scene_t& scene)
+{
+    core::EntityRegistry& registry = scene.getRegistry();
+    core::ComponentPool<core::ObjectLink>& links = registry.getPool<core::ObjectLink>();
+
+    // Instances are matched in view order, any difference from the last update means the tree no longer fits them
+    bool changed = bvh.empty();
+    size_t count = 0;
+    registry.view<core::Transform, core::Mesh>().each([&](core::Entity entity, core::Transform& transform, core::Mesh& mesh)
+    {
+        if(!mesh || mesh->triangles.empty())
+        {
+            return;
+        }
+        std::shared_ptr<const MeshBvh> meshBvh = mesh->getBvh();
+        if(count == instances.size())
+        {
+            instances.emplace_back();
+        }
+        Instance& instance = instances[count++];
+        if(instance.entity != entity || instance.mesh != meshBvh)
+        {
+            instance.entity = entity;
+            instance.mesh = std::move(meshBvh);
+            changed = true;
+        }
+        const core::ObjectLink* link = links.tryGet(entity);
+        instance.meshID = mesh->getInstanceID();
+        instance.objectID = link != nullptr ? link->objectID : static_cast<id_t>(-1);
+        instance.localToWorld = transform.getTransform();
+    });
+    if(count != instances.size())
+    {
+        instances.resize(count);
+        changed = true;
+    }
+
+    boundsMin.resize(count);
+    boundsMax.resize(count);
+    ThreadPool::getGlobal().parallelFor(count, PARALLEL_RANGE_SIZE, [&](size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; i++)
+        {
+            Instance& instance = instances[i];
+            instance.worldToLocal = glm::inverse(instance.localToWorld);
+            transformBounds(instance.mesh->getBoundsMin(), instance.mesh->getBoundsMax(), instance.localToWorld, boundsMin[i], boundsMax[i]);
+        }
+    });
+
+    if(changed)
+    {
+        rebuild();
+        return;
+    }
+    bvh.refit(boundsMin, boundsMax);
+    if(bvh.computeCost() > builtCost * REBUILD_COST_RATIO)
+    {
+        rebuild();
+    }
+}
+
+void SceneBvh::rebuild()
+{
+    Bvh::BuildSettings settings{};
+    settings.maxLeafSize = MAX_LEAF_SIZE;
+    bvh.build(boundsMin, boundsMax, settings);
+    builtCost = bvh.computeCost();
+    rebuildCount++;
+}
+
+void SceneBvh::clear()
+{
+    bvh.clear();
+    instances.clear();
+    boundsMin.clear();
+    boundsMax.clear();
+    builtCost = 0.0f;
+}
+
+bool SceneBvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Hit& hit) const
+{
+    const Ray ray(origin, direction);
+    const std::vector<uint32_t>& order = bvh.getPrimitiveIndices();
+    uint32_t closestInstance = UINT32_MAX;
+    MeshBvh::Hit closest{};
+    bvh.traverse(ray, maxDistance, [&](uint32_t first, uint32_t count)
+    {
+        for(uint32_t i = first; i < first + count; i++)
+        {
+            // Affine transforms keep distances along the ray, so the mesh space hit needs no rescaling
+            const Instance& instance = instances[order[i]];
+            const Ray localRay(glm::vec3(instance.worldToLocal * glm::vec4(origin, 1.0f)), glm::vec3(instance.worldToLocal * glm::vec4(direction, 0.0f)));
+            if(instance.mesh->raycast(localRay, maxDistance, closest))
+            {
+                closestInstance = order[i];
+            }
+        }
+    });
+    if(closestInstance == UINT32_MAX)
+    {
+        return false;
+    }
+    hit = makeHit(ray, closestInstance, closest);
+    return true;
+}
+
+void SceneBvh::raycastAll(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<Hit>& hits) const
+{
+    hits.clear();
+    const Ray ray(origin, direction);
+    const std::vector<uint32_t>& order = bvh.getPrimitiveIndices();
+    std::vector<MeshBvh::Hit> meshHits{};
+    bvh.traverse(ray, maxDistance, [&](uint32_t first, uint32_t count)
+    {
+        for(uint32_t i = first; i < first + count; i++)
+        {
+            const Instance& instance = instances[order[i]];
+            const Ray localRay(glm::vec3(instance.worldToLocal * glm::vec4(origin, 1.0f)), glm::vec3(instance.worldToLocal * glm::vec4(direction, 0.0f)));
+            meshHits.clear();
+            instance.mesh->raycastAll(localRay, maxDistance, meshHits);
+            for(const MeshBvh::Hit& meshHit : meshHits)
+            {
+                hits.push_back(makeHit(ray, order[i], meshHit));
+            }
+        }
+    });
+    std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.distance < b.distance; });
+}
+
+SceneBvh::Hit SceneBvh::makeHit(const Ray& ray, uint32_t instance, const MeshBvh::Hit& meshHit) const
+{
+    // Normals go through the inverse transpose to stay perpendicular under non uniform scale
+    glm::vec3 normal = glm::normalize(glm::transpose(glm::mat3(instances[instance].worldToLocal)) * meshHit.normal);
+    if(glm::dot(normal, ray.direction) > 0.0f)
+    {
+        normal = -normal;
+    }
+    return {meshHit.distance, ray.origin + ray.direction * meshHit.distance, normal, instance, meshHit.triangle};
+}
+
+void SceneBvh::raycastBatch(std::span<const glm::vec3> origins, std::span<const glm::vec3> directions, float maxDistance, std::span<Hit> hits) const
+{
+    if(origins.size() != directions.size() || origins.size() != hits.size())
+    {
+        throw std::runtime_error("SceneBvh::raycastBatch: origins, directions and hits must have the same size");
+    }
+    std::fill(hits.begin(), hits.end(), Hit{});
+    size_t count = origins.size();
+    if(count == 0 || bvh.empty())
+    {
+        return;
+    }
+
+    // Sorted by octant, then direction, then origin, so neighbours in the order make the tightest packets
+    glm::vec3 originMin = origins[0];
+    glm::vec3 originMax = origins[0];
+    for(const glm::vec3& origin : origins)
+    {
+        originMin = glm::min(originMin, origin);
+        originMax = glm::max(originMax, origin);
+    }
+    glm::vec3 originScale = 1.0f / glm::max(originMax - originMin, glm::vec3(1e-20f));
+    std::vector<SortEntry> order(count);
+    std::vector<SortEntry> scratch{};
+    for(size_t i = 0; i < count; i++)
+    {
+        const glm::vec3& direction = directions[i];
+        uint64_t octant = (direction.x < 0.0f ? 1 : 0) | (direction.y < 0.0f ? 2 : 0) | (direction.z < 0.0f ? 4 : 0);
+        glm::vec3 unitDirection = glm::abs(direction) / glm::length(direction);
+        order[i] = {octant << 60 | mortonCode(unitDirection) << 30 | mortonCode((origins[i] - originMin) * originScale), static_cast<uint32_t>(i)};
+    }
+    radixSort(order, scratch);
+    std::vector<uint32_t> rays(count);
+    for(size_t i = 0; i < count; i++)
+    {
+        rays[i] = order[i].index;
+    }
+
+    // Without SIMD box tests a packet costs more than its rays traced one by one
+    const bool usePackets = core::MeshProcessing::getSimdLevel() != core::MeshProcessing::SimdLevel::SCALAR;
+    size_t packetCount = (count + PACKET_SIZE - 1) / PACKET_SIZE;
+    ThreadPool::getGlobal().parallelFor(packetCount, PARALLEL_PACKET_COUNT, [&](size_t begin, size_t end)
+    {
+        for(size_t packet = begin; packet < end; packet++)
+        {
+            const uint32_t* packetRays = rays.data() + packet * PACKET_SIZE;
+            size_t packetSize = std::min(PACKET_SIZE, count - packet * PACKET_SIZE);
+
+            // Zero directions normalize to NaNs and fail the compare, so they are traced alone
+            glm::vec3 reference = glm::normalize(directions[packetRays[0]]);
+            bool coherent = usePackets && packetSize > 1;
+            for(size_t lane = 1; lane < packetSize && coherent; lane++)
+            {
+                coherent = glm::dot(glm::normalize(directions[packetRays[lane]]), reference) >= PACKET_COHERENCE;
+            }
+
+            if(coherent)
+            {
+                raycastPacket(packetRays, packetSize, origins, directions, maxDistance, hits);
+                continue;
+            }
+            for(size_t lane = 0; lane < packetSize; lane++)
+            {
+                uint32_t ray = packetRays[lane];
+                raycast(origins[ray], directions[ray], maxDistance, hits[ray]);
+            }
+        }
+    });
+}
+
+void SceneBvh::raycastPacket(const uint32_t* rays, size_t count, std::span<const glm::vec3> origins, std::span<const glm::vec3> directions,
+    float maxDistance, std::span<Hit> hits) const
+{
+    RayPacket packet;
+    for(size_t lane = 0; lane < PACKET_SIZE; lane++)
+    {
+        if(lane < count)
+        {
+            setPacketRay(packet, lane, Ray(origins[rays[lane]], directions[rays[lane]]), maxDistance);
+        }
+        else
+        {
+            clearPacketRay(packet, lane);
+        }
+    }
+
+    const std::vector<uint32_t>& order = bvh.getPrimitiveIndices();
+    uint32_t closestInstances[PACKET_SIZE];
+    std::fill(std::begin(closestInstances), std::end(closestInstances), NO_HIT);
+    MeshBvh::Hit closest[PACKET_SIZE];
+    MeshBvh::Hit meshHits[PACKET_SIZE];
+    RayPacket localPacket;
+    bvh.traversePacket(packet, (1u << count) - 1, [&](uint32_t first, uint32_t primitiveCount, uint32_t leafMask)
+    {
+        for(uint32_t i = first; i < first + primitiveCount; i++)
+        {
+            const Instance& instance = instances[order[i]];
+            for(size_t lane = 0; lane < PACKET_SIZE; lane++)
+            {
+                if((leafMask >> lane & 1) == 0)
+                {
+                    clearPacketRay(localPacket, lane);
+                    continue;
+                }
+                const Ray ray = getPacketRay(packet, lane);
+                const Ray localRay(glm::vec3(instance.worldToLocal * glm::vec4(ray.origin, 1.0f)), glm::vec3(instance.worldToLocal * glm::vec4(ray.direction, 0.0f)));
+                setPacketRay(localPacket, lane, localRay, packet.maxDistance[lane]);
+            }
+            for(uint32_t lanes = instance.mesh->raycastPacket(localPacket, leafMask, meshHits); lanes != 0; lanes &= lanes - 1)
+            {
+                int lane = std::countr_zero(lanes);
+                packet.maxDistance[lane] = localPacket.maxDistance[lane];
+                closest[lane] = meshHits[lane];
+                closestInstances[lane] = order[i];
+            }
+        }
+    });
+
+    for(size_t lane = 0; lane < count; lane++)
+    {
+        if(closestInstances[lane] != NO_HIT)
+        {
+            hits[rays[lane]] = makeHit(getPacketRay(packet, lane), closestInstances[lane], closest[lane]);
+        }
+    }
+}
+} // namespace physics
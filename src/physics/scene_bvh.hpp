@@ -0,0 +1,80 @@
+#pragma once
+#include "bvh.hpp"
+#include "core/entity_registry.hpp"
+#include "engine_types.hpp"
+
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace core
+{
+    class Scene_t;
+}
+
+namespace physics
+{
+    // Top level of the raycast BVH, one instance per entity of a scene with a Transform and a Mesh
+    // Instances reference the MeshBvh cached on their MeshData, rays are moved into mesh space to traverse it
+    // update() refits the tree to the current transforms, it is rebuilt when entities or meshes change
+    // or when refitting made it REBUILD_COST_RATIO times as expensive to traverse as right after the last build
+    class SceneBvh
+    {
+        public:
+            static constexpr uint32_t MAX_LEAF_SIZE = 2;
+            static constexpr float REBUILD_COST_RATIO = 1.5f;
+            // Rays of a batch are traced as one packet when every direction is within about 25 degrees of the first one
+            static constexpr float PACKET_COHERENCE = 0.9f;
+            // Packets of a batch handed to one worker thread
+            static constexpr size_t PARALLEL_PACKET_COUNT = 16;
+
+            static constexpr uint32_t NO_HIT = UINT32_MAX;
+
+            struct Instance
+            {
+                std::shared_ptr<const MeshBvh> mesh;
+                glm::mat4 localToWorld;
+                glm::mat4 worldToLocal;
+                core::Entity entity;
+                id_t meshID;
+                id_t objectID; // -1 for entities without a GameObject
+            };
+
+            struct Hit
+            {
+                float distance;
+                glm::vec3 point;
+                glm::vec3 normal;  // Normalized and facing against the ray
+                uint32_t instance = NO_HIT; // Index into getInstances()
+                uint32_t triangle;
+            };
+
+            void update(core::Scene_t& scene);
+            void clear();
+
+            // Closest hit in (0, maxDistance), distances are in units of direction
+            bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Hit& hit) const;
+            // Replaces hits with every hit in (0, maxDistance), nearest first
+            void raycastAll(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<Hit>& hits) const;
+            // raycast for every pair of origins and directions, hits[i] is left with instance NO_HIT when ray i misses
+            // Rays are sorted by direction and origin, coherent runs of PACKET_SIZE are traced as packets and the rest one by one,
+            // batches of more than PARALLEL_PACKET_COUNT packets are spread over the global ThreadPool
+            void raycastBatch(std::span<const glm::vec3> origins, std::span<const glm::vec3> directions, float maxDistance, std::span<Hit> hits) const;
+
+            const std::vector<Instance>& getInstances() const { return instances; }
+            uint32_t getRebuildCount() const { return rebuildCount; }
+
+        private:
+            void rebuild();
+            Hit makeHit(const Ray& ray, uint32_t instance, const MeshBvh::Hit& meshHit) const;
+            void raycastPacket(const uint32_t* rays, size_t count, std::span<const glm::vec3> origins, std::span<const glm::vec3> directions,
+                float maxDistance, std::span<Hit> hits) const;
+
+            Bvh bvh{};
+            std::vector<Instance> instances{};
+            std::vector<glm::vec3> boundsMin{}; // World space, per instance
+            std::vector<glm::vec3> boundsMax{};
+            float builtCost = 0.0f;
+            uint32_t rebuildCount = 0;
+    };
+} // namespace physics
@@ -6,6 +6,7 @@
 using namespace std;
 
 std::queue<Console::ConsoleMessage> Console::messages{};
+std::mutex Console::messageMutex{};
 bool Console::scrollToBottom = true;
 
 Console::ConsoleMessage Console::constructMessage(const string& message, const string& source, ConsoleMessage::Type type)
@@ -22,6 +23,7 @@ Console::ConsoleMessage Console::constructMessage(const string& message, const s
 
 void Console::pushMessage(ConsoleMessage& message)
 {
+    std::lock_guard<std::mutex> lock(messageMutex);
     messages.push(message);
     if(messages.size() > maxMessages)
     {
@@ -71,7 +73,11 @@ void Console::error(const string& message, const string& source, bool terminalOn
 
 void Console::drawImGui()
 {
-    queue<ConsoleMessage> tempQueue = messages;
+    queue<ConsoleMessage> tempQueue{};
+    {
+        std::lock_guard<std::mutex> lock(messageMutex);
+        tempQueue = messages;
+    }
     vector<ConsoleMessage> messageVector{};
 
     while(!tempQueue.empty())
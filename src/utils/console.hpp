@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <queue>
+#include <mutex>
 
 class Console
 {
@@ -28,6 +29,7 @@ class Console
     private:
         static const size_t maxMessages = 100; // If exceeded, remove oldest
         static std::queue<ConsoleMessage> messages;
+        static std::mutex messageMutex; // Messages come from the simulation thread as well
         static bool scrollToBottom;
 
         static ConsoleMessage constructMessage(const std::string& message, const std::string& source, ConsoleMessage::Type type);
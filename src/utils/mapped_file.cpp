@@ -0,0 +1,121 @@
+#include "mapped_file.hpp"
+#include "console.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if(this == &other) return *this;
+    close();
+    mappedData = std::exchange(other.mappedData, nullptr);
+    mappedSize = std::exchange(other.mappedSize, 0);
+#ifdef _WIN32
+    fileHandle = std::exchange(other.fileHandle, nullptr);
+    mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#endif
+    return *this;
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path)
+{
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        Console::error("Could not open file: " + path, "Mapped File");
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        // Empty files can't be mapped
+        CloseHandle(file);
+        Console::error("Could not map empty file: " + path, "Mapped File");
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if(view == nullptr)
+    {
+        if(mapping != nullptr) CloseHandle(mapping);
+        CloseHandle(file);
+        Console::error("Could not map file: " + path, "Mapped File");
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    mappedData = view;
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(mappedData != nullptr) UnmapViewOfFile(mappedData);
+    if(mappingHandle != nullptr) CloseHandle(mappingHandle);
+    if(fileHandle != nullptr) CloseHandle(fileHandle);
+    mappedData = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+    mappedSize = 0;
+}
+#else
+bool MappedFile::open(const std::string& path)
+{
+    close();
+    int file = ::open(path.c_str(), O_RDONLY);
+    if(file < 0)
+    {
+        Console::error("Could not open file: " + path, "Mapped File");
+        return false;
+    }
+
+    struct stat fileStat{};
+    if(fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        // Empty files can't be mapped
+        ::close(file);
+        Console::error("Could not map empty file: " + path, "Mapped File");
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file); // The mapping keeps its own reference to the file
+    if(view == MAP_FAILED)
+    {
+        Console::error("Could not map file: " + path, "Mapped File");
+        return false;
+    }
+
+    mappedData = view;
+    mappedSize = static_cast<size_t>(fileStat.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(mappedData != nullptr) munmap(mappedData, mappedSize);
+    mappedData = nullptr;
+    mappedSize = 0;
+}
+#endif
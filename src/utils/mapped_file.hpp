@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file, unmapped when destroyed
+class MappedFile
+{
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string& path) { open(path); }
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        // Returns false and logs an error if the file could not be mapped
+        bool open(const std::string& path);
+        void close();
+
+        bool isOpen() const { return mappedData != nullptr; }
+        const std::byte* data() const { return static_cast<const std::byte*>(mappedData); }
+        size_t size() const { return mappedSize; }
+
+    private:
+        void* mappedData = nullptr;
+        size_t mappedSize = 0;
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+class PoolAllocatorBase
+{
+    public:
+        struct Stats
+        {
+            size_t liveCount = 0;
+            size_t peakLiveCount = 0;
+            size_t capacity = 0; // Slots allocated across all blocks
+            size_t blockCount = 0;
+            size_t slotSize = 0;
+        };
+
+        virtual ~PoolAllocatorBase() = default;
+        const Stats& getStats() const { return stats; }
+
+    protected:
+        Stats stats{};
+};
+
+// Slab allocator for a single type, memory is handed out in slot sized chunks from large blocks
+// Allocation and deallocation pop and push an intrusive free list, blocks are only released when the pool is destroyed
+// Not thread safe, a pool is meant to be used by the thread that owns it
+template<class T>
+class PoolAllocator : public PoolAllocatorBase
+{
+    public:
+        explicit PoolAllocator(size_t _blockSize = 256) : blockSize(_blockSize)
+        {
+            stats.slotSize = sizeof(Slot);
+        }
+
+        PoolAllocator(const PoolAllocator&) = delete;
+        PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+        // Returns uninitialized storage for one T
+        void* allocate()
+        {
+            if(freeList == nullptr)
+            {
+                addBlock(blockSize);
+            }
+            Slot* slot = freeList;
+            freeList = slot->next;
+            stats.liveCount++;
+            if(stats.liveCount > stats.peakLiveCount) stats.peakLiveCount = stats.liveCount;
+            return slot->storage;
+        }
+
+        // Takes back storage from allocate(), the object must already be destroyed
+        void deallocate(void* pointer)
+        {
+            Slot* slot = reinterpret_cast<Slot*>(pointer);
+            slot->next = freeList;
+            freeList = slot;
+            stats.liveCount--;
+        }
+
+        // Makes sure count more allocations can be made without allocating, using a single block
+        void reserve(size_t count)
+        {
+            size_t available = stats.capacity - stats.liveCount;
+            if(available < count)
+            {
+                addBlock(count - available);
+            }
+        }
+
+    private:
+        union Slot
+        {
+            Slot* next;
+            alignas(T) std::byte storage[sizeof(T)];
+        };
+
+        void addBlock(size_t slotCount)
+        {
+            blocks.push_back(std::unique_ptr<Slot[]>(new Slot[slotCount]));
+            Slot* block = blocks.back().get();
+            // Linked back to front so the block is handed out in address order
+            for(size_t i = slotCount; i-- > 0;)
+            {
+                block[i].next = freeList;
+                freeList = &block[i];
+            }
+            stats.capacity += slotCount;
+            stats.blockCount++;
+        }
+
+        size_t blockSize;
+        Slot* freeList = nullptr;
+        std::vector<std::unique_ptr<Slot[]>> blocks{};
+};
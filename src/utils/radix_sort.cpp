@@ -0,0 +1,54 @@
+#include "radix_sort.hpp"
+
+#include <array>
+#include <utility>
+
+void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch)
+{
+    constexpr uint32_t RADIX_BITS = 8;
+    constexpr uint32_t BUCKET_COUNT = 1 << RADIX_BITS;
+    constexpr uint32_t PASS_COUNT = 64 / RADIX_BITS;
+
+    const size_t count = entries.size();
+    if(count < 2) return;
+    scratch.resize(count);
+
+    // Build every histogram in a single read of the input
+    std::array<std::array<uint32_t, BUCKET_COUNT>, PASS_COUNT> histograms{};
+    for(const SortEntry& entry : entries)
+    {
+        for(uint32_t pass = 0; pass < PASS_COUNT; pass++)
+        {
+            histograms[pass][(entry.key >> (pass * RADIX_BITS)) & (BUCKET_COUNT - 1)]++;
+        }
+    }
+
+    SortEntry* src = entries.data();
+    SortEntry* dst = scratch.data();
+    for(uint32_t pass = 0; pass < PASS_COUNT; pass++)
+    {
+        std::array<uint32_t, BUCKET_COUNT>& histogram = histograms[pass];
+        uint32_t shift = pass * RADIX_BITS;
+
+        // All keys share this digit, the pass would not change the order
+        if(histogram[(src[0].key >> shift) & (BUCKET_COUNT - 1)] == count) continue;
+
+        uint32_t offset = 0;
+        for(uint32_t& bucket : histogram)
+        {
+            uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+        for(size_t i = 0; i < count; i++)
+        {
+            dst[histogram[(src[i].key >> shift) & (BUCKET_COUNT - 1)]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    if(src != entries.data())
+    {
+        entries.swap(scratch);
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Key/payload pair sorted by radixSort, the payload is usually an index into the array being ordered
+struct SortEntry
+{
+    uint64_t key;
+    uint32_t index;
+};
+
+// Stable LSD radix sort on 64-bit keys, 8 bits per pass
+// Passes where every key has the same byte are skipped, so sparsely used keys sort in fewer passes
+// scratch is resized as needed and can be reused between calls to avoid allocating
+void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
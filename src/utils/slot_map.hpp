@@ -0,0 +1,108 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+// Dense array of values addressed by 64-bit handles, the low 32 bits are the slot index and the high 32 bits its generation
+// Removing a value bumps the slot's generation so old handles stop resolving, freed slots are reused through a free list
+// T must be default constructible, removed slots are reset to T{}
+template<typename T>
+class SlotMap
+{
+    public:
+        static constexpr uint64_t INVALID_HANDLE = UINT64_MAX;
+
+        static constexpr uint64_t makeHandle(uint32_t index, uint32_t generation) { return (static_cast<uint64_t>(generation) << 32) | index; }
+        static constexpr uint32_t getIndex(uint64_t handle) { return static_cast<uint32_t>(handle); }
+        static constexpr uint32_t getGeneration(uint64_t handle) { return static_cast<uint32_t>(handle >> 32); }
+
+        uint64_t insert(T value)
+        {
+            uint32_t index;
+            if(!freeIndices.empty())
+            {
+                index = freeIndices.back();
+                freeIndices.pop_back();
+            }
+            else
+            {
+                index = static_cast<uint32_t>(slots.size());
+                slots.emplace_back();
+            }
+            Slot& slot = slots[index];
+            slot.value = std::move(value);
+            slot.occupied = true;
+            count++;
+            return makeHandle(index, slot.generation);
+        }
+
+        bool remove(uint64_t handle)
+        {
+            if(!contains(handle)) return false;
+            uint32_t index = getIndex(handle);
+            Slot& slot = slots[index];
+            // The value is destroyed after the slot is released, so a destructor can safely insert or remove other values
+            T removed = std::move(slot.value);
+            slot.value = T{};
+            slot.occupied = false;
+            count--;
+            // A slot whose generation would wrap is retired rather than risk an old handle matching again
+            if(++slot.generation != UINT32_MAX)
+            {
+                freeIndices.push_back(index);
+            }
+            return true;
+        }
+
+        bool contains(uint64_t handle) const
+        {
+            uint32_t index = getIndex(handle);
+            return index < slots.size() && slots[index].occupied && slots[index].generation == getGeneration(handle);
+        }
+
+        T* get(uint64_t handle) { return contains(handle) ? &slots[getIndex(handle)].value : nullptr; }
+        const T* get(uint64_t handle) const { return contains(handle) ? &slots[getIndex(handle)].value : nullptr; }
+
+        // Calls function(handle, value) for every live value in slot order
+        template<class Function>
+        void forEach(Function&& function)
+        {
+            for(uint32_t i = 0; i < slots.size(); i++)
+            {
+                if(slots[i].occupied)
+                {
+                    function(makeHandle(i, slots[i].generation), slots[i].value);
+                }
+            }
+        }
+
+        void reserve(size_t capacity) { slots.reserve(capacity); }
+
+        size_t size() const { return count; }
+        size_t capacity() const { return slots.size(); }
+        size_t freeCount() const { return freeIndices.size(); }
+
+        void clear()
+        {
+            for(uint32_t i = 0; i < slots.size(); i++)
+            {
+                if(slots[i].occupied)
+                {
+                    remove(makeHandle(i, slots[i].generation));
+                }
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            T value{};
+            uint32_t generation = 0;
+            bool occupied = false;
+        };
+
+        std::vector<Slot> slots{};
+        std::vector<uint32_t> freeIndices{};
+        size_t count = 0;
+};
@@ -1,17 +1,36 @@
 #ifndef SMART_REFERENCE_DEFINED
 #define SMART_REFERENCE_DEFINED
+#include <cstdint>
+
+// Maps a handle back to a pointer, defined by the object system
+template<typename T>
+struct SmartRefResolver;
+
 // Wrapper for raw pointer of type T
 // Can be used like a raw pointer
 // Can define additional methods to allow for useful behaviors
+// Also keeps the object's handle, so a reference to a deleted object can be detected with isAlive()
 template<typename T>
 class SmartRef
 {
 protected:
     T* ptr;
+    uint64_t handle;
+
+    // For derived constructors that create the object themselves
+    void reset(T* p)
+    {
+        ptr = p;
+        handle = p != nullptr ? p->getInstanceID() : INVALID_HANDLE;
+    }
 
 public:
+    static constexpr uint64_t INVALID_HANDLE = UINT64_MAX;
+
     // Constructor from pointer
-    explicit SmartRef(T* p = nullptr) : ptr(p) {}
+    explicit SmartRef(T* p = nullptr) : ptr(p), handle(p != nullptr ? p->getInstanceID() : INVALID_HANDLE) {}
+    // Resolves a handle, the reference is empty if the handle is stale
+    static SmartRef fromHandle(uint64_t handle) { return SmartRef(SmartRefResolver<T>::resolve(handle)); }
 
     // Allow usage like a raw pointer
     T& operator*() { return *ptr; }
@@ -22,7 +41,10 @@ public:
     bool operator!=(const SmartRef& other) const { return ptr != other.ptr; }
 
     T* get() const { return ptr; }
+    uint64_t getHandle() const { return handle; }
     // Easy existence check
     explicit operator bool() const { return ptr != nullptr; }
+    // Slower than the bool check, but also false once the object has been deleted
+    bool isAlive() const { return ptr != nullptr && SmartRefResolver<T>::resolve(handle) == ptr; }
 };
-#endif
\ No newline at end of file
+#endif
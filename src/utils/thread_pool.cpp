@@ -0,0 +1,134 @@
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <exception>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    if(threadCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    workers.reserve(threadCount);
+    for(uint32_t i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for(std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::getGlobal()
+{
+    static ThreadPool pool{};
+    return pool;
+}
+
+void ThreadPool::workerLoop()
+{
+    while(true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if(stopping && tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t minRangeSize, const std::function<void(size_t begin, size_t end)>& function)
+{
+    if(count == 0) return;
+    minRangeSize = std::max<size_t>(minRangeSize, 1);
+
+    size_t rangeCount = std::min<size_t>((count + minRangeSize - 1) / minRangeSize, workers.size() + 1);
+    if(rangeCount <= 1)
+    {
+        function(0, count);
+        return;
+    }
+
+    // Ranges are claimed through an atomic counter, so helpers that start late simply find nothing left
+    // The state is shared because a helper may still be popped off the queue after this call returns
+    struct SharedState
+    {
+        std::atomic<size_t> nextRange{0};
+        std::atomic<size_t> completedRanges{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error{}; // The first one thrown, guarded by mutex
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    std::shared_ptr<SharedState> state = std::make_shared<SharedState>();
+    size_t rangeSize = (count + rangeCount - 1) / rangeCount;
+
+    auto runRanges = [state, rangeCount, rangeSize, count, &function]()
+    {
+        size_t range;
+        while((range = state->nextRange.fetch_add(1)) < rangeCount)
+        {
+            size_t begin = range * rangeSize;
+            size_t end = std::min(begin + rangeSize, count);
+            // Once a range threw the rest are only counted, the call still waits for every range so no helper
+            // can run function after it returned
+            if(begin < end && !state->failed.load())
+            {
+                try
+                {
+                    function(begin, end);
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if(!state->error)
+                    {
+                        state->error = std::current_exception();
+                    }
+                    state->failed.store(true);
+                }
+            }
+            if(state->completedRanges.fetch_add(1) + 1 == rangeCount)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(size_t i = 0; i < rangeCount - 1; i++)
+        {
+            tasks.push_back(runRanges);
+        }
+    }
+    condition.notify_all();
+
+    runRanges();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state, rangeCount]() { return state->completedRanges.load() == rangeCount; });
+    if(state->error)
+    {
+        std::rethrow_exception(state->error);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+// Fixed set of worker threads for data-parallel loops
+class ThreadPool
+{
+    public:
+        // A thread count of 0 uses one worker per hardware thread, minus the calling thread
+        explicit ThreadPool(uint32_t threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Shared pool used by engine systems, created on first use
+        static ThreadPool& getGlobal();
+
+        uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+
+        // Splits [0, count) into ranges of at least minRangeSize and calls function(begin, end) for each
+        // The calling thread works on ranges too and the call returns once every range is finished
+        // If function throws, the ranges not started yet are skipped and the first exception is rethrown here
+        void parallelFor(size_t count, size_t minRangeSize, const std::function<void(size_t begin, size_t end)>& function);
+
+    private:
+        void workerLoop();
+
+        std::vector<std::thread> workers{};
+        std::deque<std::function<void()>> tasks{};
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool stopping = false;
+};